@@ -30,6 +30,12 @@ LOCAL_SRC_FILES := libmpeg/obj/local/$(TARGET_ARCH_ABI)/libmpeg.a
 include $(PREBUILT_STATIC_LIBRARY)
 
 
+include $(CLEAR_VARS)
+LOCAL_MODULE    := remux 
+LOCAL_SRC_FILES := libremux/obj/local/$(TARGET_ARCH_ABI)/libremux.a
+include $(PREBUILT_STATIC_LIBRARY)
+
+
 include $(CLEAR_VARS)
 LOCAL_MODULE    := rtmp 
 LOCAL_SRC_FILES := librtmp/obj/local/$(TARGET_ARCH_ABI)/librtmp.a
@@ -0,0 +1,230 @@
+// FLV muxer/demuxer and RTMP chunk benchmarks
+
+#include "bench.h"
+#include "flv-muxer.h"
+#include "flv-demuxer.h"
+#include "flv-proto.h"
+extern "C" {
+#include "rtmp-internal.h"
+#include "rtmp-msgtypeid.h"
+}
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+struct bench_flv_t
+{
+	std::vector<struct bench_tag_t>* tags; // NULL-drop
+	std::vector<uint8_t>* chunks; // RTMP chunk stream, NULL-drop
+	size_t frames;
+	uint64_t bytes;
+};
+
+static int bench_flv_onmuxer(void* param, int type, const void* data, size_t bytes, uint32_t timestamp)
+{
+	struct bench_flv_t* ctx = (struct bench_flv_t*)param;
+	if (ctx->tags)
+	{
+		struct bench_tag_t tag;
+		tag.type = type;
+		tag.timestamp = timestamp;
+		tag.data.assign((const uint8_t*)data, (const uint8_t*)data + bytes);
+		ctx->tags->push_back(tag);
+	}
+	ctx->frames++;
+	return 0;
+}
+
+static int bench_flv_ondemuxer(void* param, int codec, const void* data, size_t bytes, uint32_t pts, uint32_t dts, int flags)
+{
+	(void)codec, (void)data, (void)pts, (void)dts, (void)flags;
+	((struct bench_flv_t*)param)->frames++;
+	((struct bench_flv_t*)param)->bytes += bytes;
+	return 0;
+}
+
+static void bench_flv_mux(const struct bench_media_t* m, struct bench_flv_t* ctx)
+{
+	size_t i;
+	flv_muxer_t* flv;
+
+	flv = flv_muxer_create(bench_flv_onmuxer, ctx);
+	for (i = 0; i < m->frames.size(); i++)
+	{
+		const bench_frame_t& f = m->frames[i];
+		if (!f.video)
+			flv_muxer_aac(flv, f.annexb.data(), f.annexb.size(), (uint32_t)f.pts, (uint32_t)f.dts);
+		else if (m->h265)
+			flv_muxer_hevc(flv, f.annexb.data(), f.annexb.size(), (uint32_t)f.pts, (uint32_t)f.dts);
+		else
+			flv_muxer_avc(flv, f.annexb.data(), f.annexb.size(), (uint32_t)f.pts, (uint32_t)f.dts);
+	}
+	flv_muxer_destroy(flv);
+}
+
+void bench_media_flv(int h265, std::vector<struct bench_tag_t>& tags)
+{
+	struct bench_flv_t ctx;
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.tags = &tags;
+	bench_flv_mux(bench_media(h265), &ctx);
+}
+
+static void bench_flv_mux(struct bench_state_t* state, int h265)
+{
+	struct bench_flv_t ctx;
+	const struct bench_media_t* m = bench_media(h265);
+
+	memset(&ctx, 0, sizeof(ctx));
+	while (bench_next(state))
+	{
+		bench_flv_mux(m, &ctx);
+		state->bytes += m->bytes;
+	}
+}
+
+static void bench_flv_demux(struct bench_state_t* state, int h265)
+{
+	size_t i;
+	uint64_t bytes;
+	flv_demuxer_t* flv;
+	struct bench_flv_t ctx;
+	std::vector<struct bench_tag_t> tags;
+
+	bench_media_flv(h265, tags);
+	for (bytes = i = 0; i < tags.size(); i++)
+		bytes += tags[i].data.size();
+
+	memset(&ctx, 0, sizeof(ctx));
+	while (bench_next(state))
+	{
+		flv = flv_demuxer_create(bench_flv_ondemuxer, &ctx);
+		for (i = 0; i < tags.size(); i++)
+			flv_demuxer_input(flv, tags[i].type, tags[i].data.data(), tags[i].data.size(), tags[i].timestamp);
+		flv_demuxer_destroy(flv);
+		state->bytes += bytes;
+	}
+}
+
+void bench_flv_mux_h264(struct bench_state_t* state)
+{
+	bench_flv_mux(state, 0);
+}
+
+void bench_flv_mux_h265(struct bench_state_t* state)
+{
+	bench_flv_mux(state, 1);
+}
+
+void bench_flv_demux_h264(struct bench_state_t* state)
+{
+	bench_flv_demux(state, 0);
+}
+
+void bench_flv_demux_h265(struct bench_state_t* state)
+{
+	bench_flv_demux(state, 1);
+}
+
+static int bench_rtmp_send(void* param, const uint8_t* header, uint32_t len, const uint8_t* data, uint32_t bytes)
+{
+	struct bench_flv_t* ctx = (struct bench_flv_t*)param;
+	if (ctx->chunks)
+	{
+		ctx->chunks->insert(ctx->chunks->end(), header, header + len);
+		ctx->chunks->insert(ctx->chunks->end(), data, data + bytes);
+	}
+	ctx->bytes += len + bytes;
+	return 0;
+}
+
+static int bench_rtmp_onmedia(void* param, const uint8_t* data, size_t bytes, uint32_t timestamp)
+{
+	(void)data, (void)timestamp;
+	((struct bench_flv_t*)param)->frames++;
+	((struct bench_flv_t*)param)->bytes += bytes;
+	return 0;
+}
+
+static void bench_rtmp_init(struct rtmp_t* rtmp, struct bench_flv_t* ctx)
+{
+	memset(rtmp, 0, sizeof(*rtmp));
+	rtmp->parser.state = RTMP_PARSE_INIT;
+	rtmp->in_chunk_size = 4096;
+	rtmp->out_chunk_size = 4096;
+	rtmp->param = ctx;
+	rtmp->send = bench_rtmp_send;
+	rtmp->onaudio = bench_rtmp_onmedia;
+	rtmp->onvideo = bench_rtmp_onmedia;
+	rtmp->onscript = bench_rtmp_onmedia;
+	rtmp->out_packets[RTMP_CHANNEL_AUDIO].header.cid = RTMP_CHANNEL_AUDIO;
+	rtmp->out_packets[RTMP_CHANNEL_VIDEO].header.cid = RTMP_CHANNEL_VIDEO;
+	rtmp->out_packets[RTMP_CHANNEL_DATA].header.cid = RTMP_CHANNEL_DATA;
+}
+
+static void bench_rtmp_write(struct rtmp_t* rtmp, const std::vector<struct bench_tag_t>& tags)
+{
+	size_t i;
+	struct rtmp_chunk_header_t header;
+	for (i = 0; i < tags.size(); i++)
+	{
+		header.fmt = RTMP_CHUNK_TYPE_1; // enable compact header
+		header.cid = FLV_TYPE_AUDIO == tags[i].type ? RTMP_CHANNEL_AUDIO : (FLV_TYPE_VIDEO == tags[i].type ? RTMP_CHANNEL_VIDEO : RTMP_CHANNEL_DATA);
+		header.timestamp = tags[i].timestamp;
+		header.length = (uint32_t)tags[i].data.size();
+		header.type = FLV_TYPE_AUDIO == tags[i].type ? RTMP_TYPE_AUDIO : (FLV_TYPE_VIDEO == tags[i].type ? RTMP_TYPE_VIDEO : RTMP_TYPE_DATA);
+		header.stream_id = 1;
+		rtmp_chunk_write(rtmp, &header, tags[i].data.data());
+	}
+}
+
+static void bench_rtmp_free(struct rtmp_t* rtmp)
+{
+	size_t i;
+	for (i = 0; i < sizeof(rtmp->in_packets) / sizeof(rtmp->in_packets[0]); i++)
+		free(rtmp->in_packets[i].payload);
+}
+
+// one op: FLV tags of the H.264 clip => RTMP chunks(one connection per op)
+void bench_rtmp_chunk_write(struct bench_state_t* state)
+{
+	static struct rtmp_t s_rtmp;
+	struct bench_flv_t ctx;
+	std::vector<struct bench_tag_t> tags;
+
+	bench_media_flv(0, tags);
+	memset(&ctx, 0, sizeof(ctx));
+	while (bench_next(state))
+	{
+		ctx.bytes = 0;
+		bench_rtmp_init(&s_rtmp, &ctx);
+		bench_rtmp_write(&s_rtmp, tags);
+		state->bytes += ctx.bytes;
+	}
+}
+
+// one op: RTMP chunks of the H.264 clip => FLV tags(payload buffers reused as a long-lived connection)
+void bench_rtmp_chunk_read(struct bench_state_t* state)
+{
+	static struct rtmp_t s_rtmp;
+	struct bench_flv_t ctx;
+	std::vector<uint8_t> chunks;
+	std::vector<struct bench_tag_t> tags;
+
+	bench_media_flv(0, tags);
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.chunks = &chunks;
+	bench_rtmp_init(&s_rtmp, &ctx);
+	bench_rtmp_write(&s_rtmp, tags);
+	ctx.chunks = NULL;
+
+	while (bench_next(state))
+	{
+		ctx.frames = 0;
+		s_rtmp.parser.state = RTMP_PARSE_INIT;
+		rtmp_chunk_read(&s_rtmp, chunks.data(), chunks.size());
+		assert(ctx.frames == tags.size());
+		state->bytes += chunks.size();
+	}
+	bench_rtmp_free(&s_rtmp);
+}
@@ -0,0 +1,165 @@
+// Synthetic H.264/H.265/AAC elementary streams
+// random slice/frame payload without start code emulation(no zero byte), real parameter sets(same as mpeg4_avc_test/mpeg4_hevc_test)
+
+#include "bench.h"
+#include "mpeg4-avc.h"
+#include "mpeg4-hevc.h"
+#include "mpeg4-aac.h"
+#include <string.h>
+#include <assert.h>
+
+#define BENCH_SECONDS		2
+#define BENCH_FPS			25
+#define BENCH_GOP			25
+#define BENCH_IDR_BYTES		20000
+#define BENCH_P_BYTES		4000
+#define BENCH_AAC_BYTES		300
+
+static const uint8_t s_h264_sps[] = { 0x67,0x42,0xe0,0x1e,0xab,0x40,0xf0,0x28,0xd0,0x80,0x00,0x00,0x00,0x80,0x00,0x00,0x19,0x70,0x20,0x00,0x78,0x00,0x00,0x0f,0x00,0x16,0xb1,0xb0,0x3c,0x50,0xaa,0x80,0x80 };
+static const uint8_t s_h264_pps[] = { 0x28,0xce,0x3c,0x80 };
+static const uint8_t s_h265_vps[] = { 0x40,0x01,0x0c,0x01,0xff,0xff,0x01,0x60,0x00,0x00,0x03,0x00,0x80,0x00,0x00,0x03,0x00,0x00,0x03,0x00,0xb4,0x9d,0xc0,0x90 };
+static const uint8_t s_h265_sps[] = { 0x42,0x01,0x01,0x01,0x60,0x00,0x00,0x03,0x00,0x80,0x00,0x00,0x03,0x00,0x00,0x03,0x00,0xb4,0xa0,0x01,0xe0,0x20,0x02,0x1c,0x59,0x67,0x79,0x24,0x6d,0xae,0x01,0x00,0x00,0x03,0x03,0xe8,0x00,0x00,0x5d,0xc0,0x08 };
+static const uint8_t s_h265_pps[] = { 0x44,0x01,0xc1,0x73,0xd1,0x89 };
+
+static uint32_t bench_random(uint32_t* seed)
+{
+	// xorshift32
+	*seed ^= *seed << 13;
+	*seed ^= *seed >> 17;
+	*seed ^= *seed << 5;
+	return *seed;
+}
+
+static void bench_append(std::vector<uint8_t>& v, const uint8_t* data, size_t bytes)
+{
+	v.insert(v.end(), data, data + bytes);
+}
+
+static void bench_nalu(std::vector<uint8_t>& v, const uint8_t* nalu, size_t bytes)
+{
+	static const uint8_t startcode[] = { 0x00, 0x00, 0x00, 0x01 };
+	bench_append(v, startcode, sizeof(startcode));
+	bench_append(v, nalu, bytes);
+}
+
+// size +/-25%, payload bytes [1, 255]
+static void bench_payload(std::vector<uint8_t>& v, size_t bytes, uint32_t* seed)
+{
+	size_t i, n;
+	n = bytes * 3 / 4 + bench_random(seed) % (bytes / 2);
+	for (i = 0; i < n; i++)
+		v.push_back((uint8_t)(bench_random(seed) % 255 + 1));
+}
+
+static void bench_video(struct bench_media_t* m, bench_frame_t* frame, uint32_t* seed)
+{
+	static uint8_t s_buffer[BENCH_IDR_BYTES * 2];
+	int r, vcl, update;
+	struct mpeg4_avc_t avc;
+	struct mpeg4_hevc_t hevc;
+
+	if (m->h265)
+	{
+		if (frame->keyframe)
+		{
+			bench_nalu(frame->annexb, s_h265_vps, sizeof(s_h265_vps));
+			bench_nalu(frame->annexb, s_h265_sps, sizeof(s_h265_sps));
+			bench_nalu(frame->annexb, s_h265_pps, sizeof(s_h265_pps));
+		}
+		bench_nalu(frame->annexb, frame->keyframe ? (const uint8_t*)"\x26\x01\xaf" : (const uint8_t*)"\x02\x01\xd0", 3); // IDR_W_RADL/TRAIL_R, first_slice_segment_in_pic_flag
+	}
+	else
+	{
+		if (frame->keyframe)
+		{
+			bench_nalu(frame->annexb, s_h264_sps, sizeof(s_h264_sps));
+			bench_nalu(frame->annexb, s_h264_pps, sizeof(s_h264_pps));
+		}
+		bench_nalu(frame->annexb, frame->keyframe ? (const uint8_t*)"\x65\x88" : (const uint8_t*)"\x41\x9a", 2); // IDR/non-IDR, first_mb_in_slice = 0
+	}
+	bench_payload(frame->annexb, frame->keyframe ? BENCH_IDR_BYTES : BENCH_P_BYTES, seed);
+
+	memset(&avc, 0, sizeof(avc));
+	memset(&hevc, 0, sizeof(hevc));
+	if (m->h265)
+		r = h265_annexbtomp4(&hevc, frame->annexb.data(), frame->annexb.size(), s_buffer, sizeof(s_buffer), &vcl, &update);
+	else
+		r = h264_annexbtomp4(&avc, frame->annexb.data(), frame->annexb.size(), s_buffer, sizeof(s_buffer), &vcl, &update);
+	assert(r > 0);
+	bench_append(frame->mp4, s_buffer, r);
+
+	if (frame->keyframe && 0 == m->config_bytes)
+	{
+		r = m->h265 ? mpeg4_hevc_decoder_configuration_record_save(&hevc, m->config, sizeof(m->config)) : mpeg4_avc_decoder_configuration_record_save(&avc, m->config, sizeof(m->config));
+		assert(r > 0);
+		m->config_bytes = r;
+	}
+}
+
+static void bench_audio(struct bench_media_t* m, bench_frame_t* frame, uint32_t* seed)
+{
+	uint8_t adts[7];
+	struct mpeg4_aac_t aac;
+
+	bench_payload(frame->mp4, BENCH_AAC_BYTES, seed);
+
+	memset(&aac, 0, sizeof(aac));
+	aac.profile = MPEG4_AAC_LC;
+	aac.sampling_frequency_index = MPEG4_AAC_44100;
+	aac.channel_configuration = 2;
+	aac.channels = 2;
+	aac.sampling_frequency = 44100;
+	mpeg4_aac_adts_save(&aac, frame->mp4.size(), adts, sizeof(adts));
+	bench_append(frame->annexb, adts, sizeof(adts));
+	bench_append(frame->annexb, frame->mp4.data(), frame->mp4.size());
+
+	if (0 == m->asc_bytes)
+		m->asc_bytes = mpeg4_aac_audio_specific_config_save(&aac, m->asc, sizeof(m->asc));
+}
+
+static void bench_media_create(struct bench_media_t* m, int h265)
+{
+	int v, a;
+	uint32_t seed;
+	int64_t vdts, adts;
+
+	seed = h265 ? 0x265 : 0x264;
+	m->h265 = h265;
+	m->config_bytes = 0;
+	m->asc_bytes = 0;
+	m->bytes = 0;
+	m->width = 1280;
+	m->height = 720;
+
+	for (v = a = 0; v < BENCH_SECONDS * BENCH_FPS; )
+	{
+		vdts = v * 1000 / BENCH_FPS;
+		adts = a * 1024 * 1000 / 44100;
+
+		bench_frame_t frame;
+		frame.video = vdts <= adts ? 1 : 0;
+		frame.keyframe = frame.video ? (0 == v % BENCH_GOP) : 1;
+		frame.pts = frame.dts = frame.video ? vdts : adts;
+		if (frame.video)
+		{
+			bench_video(m, &frame, &seed);
+			v++;
+		}
+		else
+		{
+			bench_audio(m, &frame, &seed);
+			a++;
+		}
+
+		m->bytes += frame.annexb.size();
+		m->frames.push_back(frame);
+	}
+}
+
+const struct bench_media_t* bench_media(int h265)
+{
+	static struct bench_media_t s_media[2];
+	if (s_media[h265 ? 1 : 0].frames.empty())
+		bench_media_create(&s_media[h265 ? 1 : 0], h265 ? 1 : 0);
+	return &s_media[h265 ? 1 : 0];
+}
@@ -0,0 +1,264 @@
+// MP4/fMP4/MKV writer/reader benchmarks(memory buffer, no file I/O)
+
+#include "bench.h"
+#include "mov-buffer.h"
+#include "mov-format.h"
+#include "mov-writer.h"
+#include "mov-reader.h"
+#include "fmp4-writer.h"
+#include "mkv-buffer.h"
+#include "mkv-format.h"
+#include "mkv-writer.h"
+#include "mkv-reader.h"
+#include <string.h>
+#include <assert.h>
+
+#define BENCH_MOV_BUFFER (4 * 1024 * 1024)
+
+// preallocated memory file
+struct bench_mov_t
+{
+	uint8_t* data;
+	uint64_t capacity;
+	uint64_t bytes; // file size
+	uint64_t offset;
+	size_t frames;
+};
+
+static int bench_mov_read(void* param, void* data, uint64_t bytes)
+{
+	struct bench_mov_t* ctx = (struct bench_mov_t*)param;
+	if (ctx->offset + bytes > ctx->bytes)
+		return -1;
+	memcpy(data, ctx->data + ctx->offset, (size_t)bytes);
+	ctx->offset += bytes;
+	return 0;
+}
+
+static int bench_mov_write(void* param, const void* data, uint64_t bytes)
+{
+	struct bench_mov_t* ctx = (struct bench_mov_t*)param;
+	if (ctx->offset + bytes > ctx->capacity)
+		return -1;
+	memcpy(ctx->data + ctx->offset, data, (size_t)bytes);
+	ctx->offset += bytes;
+	if (ctx->offset > ctx->bytes)
+		ctx->bytes = ctx->offset;
+	return 0;
+}
+
+static int bench_mov_seek(void* param, int64_t offset)
+{
+	struct bench_mov_t* ctx = (struct bench_mov_t*)param;
+	if (offset >= 0 ? offset > (int64_t)ctx->capacity : -offset > (int64_t)ctx->bytes)
+		return -1; // allow seek beyond the end of file(same as fseek)
+	ctx->offset = offset >= 0 ? offset : ctx->bytes + offset;
+	return 0;
+}
+
+static int64_t bench_mov_tell(void* param)
+{
+	return (int64_t)((struct bench_mov_t*)param)->offset;
+}
+
+static const struct mov_buffer_t s_mov_buffer = { bench_mov_read, bench_mov_write, bench_mov_seek, bench_mov_tell };
+static const struct mkv_buffer_t s_mkv_buffer = { bench_mov_read, bench_mov_write, bench_mov_seek, bench_mov_tell };
+
+static void bench_mov_onread(void* param, uint32_t track, const void* buffer, size_t bytes, int64_t pts, int64_t dts, int flags)
+{
+	(void)track, (void)buffer, (void)bytes, (void)pts, (void)dts, (void)flags;
+	((struct bench_mov_t*)param)->frames++;
+}
+
+static void bench_mov_reset(struct bench_mov_t* ctx)
+{
+	ctx->bytes = 0;
+	ctx->offset = 0;
+	ctx->frames = 0;
+}
+
+static void bench_mp4_write(const struct bench_media_t* m, struct bench_mov_t* ctx)
+{
+	size_t i;
+	int video, audio;
+	mov_writer_t* mov;
+
+	bench_mov_reset(ctx);
+	mov = mov_writer_create(&s_mov_buffer, ctx, MOV_FLAG_FASTSTART);
+	video = mov_writer_add_video(mov, MOV_OBJECT_H264, m->width, m->height, m->config, m->config_bytes);
+	audio = mov_writer_add_audio(mov, MOV_OBJECT_AAC, 2, 16, 44100, m->asc, m->asc_bytes);
+	for (i = 0; i < m->frames.size(); i++)
+	{
+		const bench_frame_t& f = m->frames[i];
+		mov_writer_write(mov, f.video ? video : audio, f.mp4.data(), f.mp4.size(), f.pts, f.dts, f.keyframe ? MOV_AV_FLAG_KEYFREAME : 0);
+	}
+	mov_writer_destroy(mov);
+}
+
+static void bench_fmp4_write(const struct bench_media_t* m, struct bench_mov_t* ctx)
+{
+	size_t i;
+	int video, audio;
+	fmp4_writer_t* fmp4;
+
+	bench_mov_reset(ctx);
+	fmp4 = fmp4_writer_create(&s_mov_buffer, ctx, MOV_FLAG_SEGMENT);
+	video = fmp4_writer_add_video(fmp4, MOV_OBJECT_H264, m->width, m->height, m->config, m->config_bytes);
+	audio = fmp4_writer_add_audio(fmp4, MOV_OBJECT_AAC, 2, 16, 44100, m->asc, m->asc_bytes);
+	fmp4_writer_init_segment(fmp4);
+	for (i = 0; i < m->frames.size(); i++)
+	{
+		const bench_frame_t& f = m->frames[i];
+		fmp4_writer_write(fmp4, f.video ? video : audio, f.mp4.data(), f.mp4.size(), f.pts, f.dts, f.keyframe ? MOV_AV_FLAG_KEYFREAME : 0);
+	}
+	fmp4_writer_destroy(fmp4);
+}
+
+static void bench_mkv_write(const struct bench_media_t* m, struct bench_mov_t* ctx)
+{
+	size_t i;
+	int video, audio;
+	mkv_writer_t* mkv;
+
+	bench_mov_reset(ctx);
+	mkv = mkv_writer_create(&s_mkv_buffer, ctx, 0);
+	video = mkv_writer_add_video(mkv, MKV_CODEC_VIDEO_H264, m->width, m->height, m->config, m->config_bytes);
+	audio = mkv_writer_add_audio(mkv, MKV_CODEC_AUDIO_AAC, 2, 16, 44100, m->asc, m->asc_bytes);
+	for (i = 0; i < m->frames.size(); i++)
+	{
+		const bench_frame_t& f = m->frames[i];
+		mkv_writer_write(mkv, f.video ? video : audio, f.mp4.data(), f.mp4.size(), f.pts, f.dts, f.keyframe ? MKV_FLAGS_KEYFRAME : 0);
+	}
+	mkv_writer_destroy(mkv);
+}
+
+static uint64_t bench_mov_bytes(const struct bench_media_t* m)
+{
+	size_t i;
+	uint64_t bytes;
+	for (bytes = i = 0; i < m->frames.size(); i++)
+		bytes += m->frames[i].mp4.size();
+	return bytes;
+}
+
+void bench_mp4_write_h264(struct bench_state_t* state)
+{
+	struct bench_mov_t ctx;
+	std::vector<uint8_t> file(BENCH_MOV_BUFFER);
+	const struct bench_media_t* m = bench_media(0);
+
+	ctx.data = file.data();
+	ctx.capacity = file.size();
+	while (bench_next(state))
+	{
+		bench_mp4_write(m, &ctx);
+		state->bytes += bench_mov_bytes(m);
+	}
+}
+
+void bench_fmp4_write_h264(struct bench_state_t* state)
+{
+	struct bench_mov_t ctx;
+	std::vector<uint8_t> file(BENCH_MOV_BUFFER);
+	const struct bench_media_t* m = bench_media(0);
+
+	ctx.data = file.data();
+	ctx.capacity = file.size();
+	while (bench_next(state))
+	{
+		bench_fmp4_write(m, &ctx);
+		state->bytes += bench_mov_bytes(m);
+	}
+}
+
+void bench_mp4_read_h264(struct bench_state_t* state)
+{
+	mov_reader_t* mov;
+	struct bench_mov_t ctx;
+	std::vector<uint8_t> file(BENCH_MOV_BUFFER);
+	static uint8_t s_frame[256 * 1024];
+	const struct bench_media_t* m = bench_media(0);
+
+	ctx.data = file.data();
+	ctx.capacity = file.size();
+	bench_mp4_write(m, &ctx);
+
+	while (bench_next(state))
+	{
+		ctx.offset = 0;
+		ctx.frames = 0;
+		mov = mov_reader_create(&s_mov_buffer, &ctx);
+		while (mov_reader_read(mov, s_frame, sizeof(s_frame), bench_mov_onread, &ctx) > 0)
+			;
+		mov_reader_destroy(mov);
+		assert(ctx.frames == m->frames.size());
+		state->bytes += ctx.bytes;
+	}
+}
+
+// init segment + media segments(moof/mdat), mov_reader walk the fragments
+void bench_fmp4_read_h264(struct bench_state_t* state)
+{
+	mov_reader_t* mov;
+	struct bench_mov_t ctx;
+	std::vector<uint8_t> file(BENCH_MOV_BUFFER);
+	static uint8_t s_frame[256 * 1024];
+	const struct bench_media_t* m = bench_media(0);
+
+	ctx.data = file.data();
+	ctx.capacity = file.size();
+	bench_fmp4_write(m, &ctx);
+
+	while (bench_next(state))
+	{
+		ctx.offset = 0;
+		ctx.frames = 0;
+		mov = mov_reader_create(&s_mov_buffer, &ctx);
+		while (mov_reader_read(mov, s_frame, sizeof(s_frame), bench_mov_onread, &ctx) > 0)
+			;
+		mov_reader_destroy(mov);
+		assert(ctx.frames == m->frames.size());
+		state->bytes += ctx.bytes;
+	}
+}
+
+void bench_mkv_write_h264(struct bench_state_t* state)
+{
+	struct bench_mov_t ctx;
+	std::vector<uint8_t> file(BENCH_MOV_BUFFER);
+	const struct bench_media_t* m = bench_media(0);
+
+	ctx.data = file.data();
+	ctx.capacity = file.size();
+	while (bench_next(state))
+	{
+		bench_mkv_write(m, &ctx);
+		state->bytes += bench_mov_bytes(m);
+	}
+}
+
+void bench_mkv_read_h264(struct bench_state_t* state)
+{
+	mkv_reader_t* mkv;
+	struct bench_mov_t ctx;
+	std::vector<uint8_t> file(BENCH_MOV_BUFFER);
+	static uint8_t s_frame[256 * 1024];
+	const struct bench_media_t* m = bench_media(0);
+
+	ctx.data = file.data();
+	ctx.capacity = file.size();
+	bench_mkv_write(m, &ctx);
+
+	while (bench_next(state))
+	{
+		ctx.offset = 0;
+		ctx.frames = 0;
+		mkv = mkv_reader_create(&s_mkv_buffer, &ctx);
+		// stop at the last frame: mkv_reader print the trailing Cues element as unknown id
+		while (ctx.frames < m->frames.size() && mkv_reader_read(mkv, s_frame, sizeof(s_frame), bench_mov_onread, &ctx) > 0)
+			;
+		mkv_reader_destroy(mkv);
+		assert(ctx.frames == m->frames.size());
+		state->bytes += ctx.bytes;
+	}
+}
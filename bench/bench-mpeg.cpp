@@ -0,0 +1,213 @@
+// MPEG-2 TS/PS muxer/demuxer benchmarks
+
+#include "bench.h"
+#include "mpeg-ts.h"
+#include "mpeg-ps.h"
+#include <string.h>
+#include <assert.h>
+
+struct bench_mpeg_t
+{
+	uint8_t packet[64 * 1024];
+	std::vector<uint8_t>* output; // NULL-drop
+	size_t frames;
+};
+
+static void* bench_mpeg_alloc(void* param, size_t bytes)
+{
+	struct bench_mpeg_t* ctx = (struct bench_mpeg_t*)param;
+	assert(bytes <= sizeof(ctx->packet));
+	return ctx->packet;
+}
+
+static void bench_mpeg_free(void* param, void* packet)
+{
+	(void)param; (void)packet;
+}
+
+static int bench_ts_write(void* param, const void* packet, size_t bytes)
+{
+	struct bench_mpeg_t* ctx = (struct bench_mpeg_t*)param;
+	if (ctx->output)
+		ctx->output->insert(ctx->output->end(), (const uint8_t*)packet, (const uint8_t*)packet + bytes);
+	return 0;
+}
+
+static int bench_ps_write(void* param, int stream, void* packet, size_t bytes)
+{
+	(void)stream;
+	return bench_ts_write(param, packet, bytes);
+}
+
+static int bench_ts_onpacket(void* param, int program, int stream, int codecid, int flags, int64_t pts, int64_t dts, const void* data, size_t bytes)
+{
+	(void)program, (void)stream, (void)codecid, (void)flags, (void)pts, (void)dts, (void)data, (void)bytes;
+	((struct bench_mpeg_t*)param)->frames++;
+	return 0;
+}
+
+static int bench_ps_onpacket(void* param, int stream, int codecid, int flags, int64_t pts, int64_t dts, const void* data, size_t bytes)
+{
+	return bench_ts_onpacket(param, 0, stream, codecid, flags, pts, dts, data, bytes);
+}
+
+static void bench_ts_mux(const struct bench_media_t* m, struct bench_mpeg_t* ctx)
+{
+	void* ts;
+	size_t i;
+	int video, audio;
+	struct mpeg_ts_func_t func = { bench_mpeg_alloc, bench_mpeg_free, bench_ts_write };
+
+	ts = mpeg_ts_create(&func, ctx);
+	video = mpeg_ts_add_stream(ts, m->h265 ? PSI_STREAM_H265 : PSI_STREAM_H264, NULL, 0);
+	audio = mpeg_ts_add_stream(ts, PSI_STREAM_AAC, NULL, 0);
+	for (i = 0; i < m->frames.size(); i++)
+	{
+		const bench_frame_t& f = m->frames[i];
+		mpeg_ts_write(ts, f.video ? video : audio, f.video && f.keyframe ? MPEG_FLAG_IDR_FRAME : 0, f.pts * 90, f.dts * 90, f.annexb.data(), f.annexb.size());
+	}
+	mpeg_ts_destroy(ts);
+}
+
+static void bench_ps_mux(const struct bench_media_t* m, struct bench_mpeg_t* ctx)
+{
+	size_t i;
+	int video, audio;
+	struct ps_muxer_t* ps;
+	struct ps_muxer_func_t func = { bench_mpeg_alloc, bench_mpeg_free, bench_ps_write };
+
+	ps = ps_muxer_create(&func, ctx);
+	video = ps_muxer_add_stream(ps, m->h265 ? PSI_STREAM_H265 : PSI_STREAM_H264, NULL, 0);
+	audio = ps_muxer_add_stream(ps, PSI_STREAM_AAC, NULL, 0);
+	for (i = 0; i < m->frames.size(); i++)
+	{
+		const bench_frame_t& f = m->frames[i];
+		ps_muxer_input(ps, f.video ? video : audio, f.video && f.keyframe ? MPEG_FLAG_IDR_FRAME : 0, f.pts * 90, f.dts * 90, f.annexb.data(), f.annexb.size());
+	}
+	ps_muxer_destroy(ps);
+}
+
+void bench_media_ts(int h265, std::vector<uint8_t>& ts)
+{
+	static struct bench_mpeg_t s_ctx;
+	s_ctx.output = &ts;
+	bench_ts_mux(bench_media(h265), &s_ctx);
+	s_ctx.output = NULL;
+}
+
+void bench_media_ps(int h265, std::vector<uint8_t>& ps)
+{
+	static struct bench_mpeg_t s_ctx;
+	s_ctx.output = &ps;
+	bench_ps_mux(bench_media(h265), &s_ctx);
+	s_ctx.output = NULL;
+}
+
+static void bench_ts_mux(struct bench_state_t* state, int h265)
+{
+	static struct bench_mpeg_t s_ctx;
+	const struct bench_media_t* m = bench_media(h265);
+	s_ctx.output = NULL;
+	while (bench_next(state))
+	{
+		bench_ts_mux(m, &s_ctx);
+		state->bytes += m->bytes;
+	}
+}
+
+static void bench_ps_mux(struct bench_state_t* state, int h265)
+{
+	static struct bench_mpeg_t s_ctx;
+	const struct bench_media_t* m = bench_media(h265);
+	s_ctx.output = NULL;
+	while (bench_next(state))
+	{
+		bench_ps_mux(m, &s_ctx);
+		state->bytes += m->bytes;
+	}
+}
+
+static void bench_ts_demux(struct bench_state_t* state, int h265)
+{
+	size_t i;
+	struct ts_demuxer_t* ts;
+	struct bench_mpeg_t ctx;
+	std::vector<uint8_t> data;
+
+	bench_media_ts(h265, data);
+	while (bench_next(state))
+	{
+		ctx.frames = 0;
+		ts = ts_demuxer_create(bench_ts_onpacket, &ctx);
+		for (i = 0; i + 188 <= data.size(); i += 188)
+			ts_demuxer_input(ts, data.data() + i, 188);
+		ts_demuxer_flush(ts);
+		ts_demuxer_destroy(ts);
+		assert(ctx.frames == bench_media(h265)->frames.size());
+		state->bytes += data.size();
+	}
+}
+
+static void bench_ps_demux(struct bench_state_t* state, int h265)
+{
+	int r;
+	size_t i;
+	struct ps_demuxer_t* ps;
+	struct bench_mpeg_t ctx;
+	std::vector<uint8_t> data;
+
+	bench_media_ps(h265, data);
+	while (bench_next(state))
+	{
+		ctx.frames = 0;
+		ps = ps_demuxer_create(bench_ps_onpacket, &ctx);
+		for (i = 0; i < data.size(); i += r)
+		{
+			r = ps_demuxer_input(ps, data.data() + i, data.size() - i);
+			if (r <= 0)
+				break;
+		}
+		ps_demuxer_destroy(ps);
+		state->bytes += data.size();
+	}
+}
+
+void bench_ts_mux_h264(struct bench_state_t* state)
+{
+	bench_ts_mux(state, 0);
+}
+
+void bench_ts_mux_h265(struct bench_state_t* state)
+{
+	bench_ts_mux(state, 1);
+}
+
+void bench_ts_demux_h264(struct bench_state_t* state)
+{
+	bench_ts_demux(state, 0);
+}
+
+void bench_ts_demux_h265(struct bench_state_t* state)
+{
+	bench_ts_demux(state, 1);
+}
+
+void bench_ps_mux_h264(struct bench_state_t* state)
+{
+	bench_ps_mux(state, 0);
+}
+
+void bench_ps_mux_h265(struct bench_state_t* state)
+{
+	bench_ps_mux(state, 1);
+}
+
+void bench_ps_demux_h264(struct bench_state_t* state)
+{
+	bench_ps_demux(state, 0);
+}
+
+void bench_ps_demux_h265(struct bench_state_t* state)
+{
+	bench_ps_demux(state, 1);
+}
@@ -0,0 +1,261 @@
+// RTP payload packer/unpacker and jitter queue benchmarks
+
+#include "bench.h"
+#include "rtp-payload.h"
+#include "rtp-profile.h"
+#include "rtp-queue.h"
+#include <string.h>
+#include <assert.h>
+
+#define BENCH_RTP_TS_BYTES (188 * 7)
+
+struct bench_rtp_unit_t
+{
+	const uint8_t* data;
+	int bytes;
+	uint32_t timestamp;
+};
+
+struct bench_rtp_t
+{
+	uint8_t packet[2048];
+	std::vector<std::vector<uint8_t> >* packets; // NULL-drop
+	size_t count;
+	uint64_t bytes;
+};
+
+static void* bench_rtp_alloc(void* param, int bytes)
+{
+	struct bench_rtp_t* ctx = (struct bench_rtp_t*)param;
+	assert(bytes <= (int)sizeof(ctx->packet));
+	return ctx->packet;
+}
+
+static void bench_rtp_free(void* param, void* packet)
+{
+	(void)param; (void)packet;
+}
+
+static int bench_rtp_packet(void* param, const void* packet, int bytes, uint32_t timestamp, int flags)
+{
+	struct bench_rtp_t* ctx = (struct bench_rtp_t*)param;
+	(void)timestamp, (void)flags;
+	if (ctx->packets)
+		ctx->packets->push_back(std::vector<uint8_t>((const uint8_t*)packet, (const uint8_t*)packet + bytes));
+	ctx->count++;
+	ctx->bytes += bytes;
+	return 0;
+}
+
+// access units of the synthetic clip
+static void bench_rtp_units(const char* encoding, std::vector<struct bench_rtp_unit_t>& units, std::vector<uint8_t>& mpeg)
+{
+	size_t i;
+	int video, h265;
+	struct bench_rtp_unit_t unit;
+	const struct bench_media_t* m;
+
+	h265 = 0 == strcmp("H265", encoding) ? 1 : 0;
+	video = 0 == strcmp("H264", encoding) || h265;
+	if (0 == strcmp("MP2T", encoding) || 0 == strcmp("MP2P", encoding))
+	{
+		if (0 == strcmp("MP2T", encoding))
+			bench_media_ts(0, mpeg);
+		else
+			bench_media_ps(0, mpeg);
+
+		// 2s clip, 40ms per 7 TS packets
+		for (i = 0; i < mpeg.size(); i += BENCH_RTP_TS_BYTES)
+		{
+			unit.data = mpeg.data() + i;
+			unit.bytes = (int)(mpeg.size() - i < BENCH_RTP_TS_BYTES ? mpeg.size() - i : BENCH_RTP_TS_BYTES);
+			unit.timestamp = (uint32_t)(i / BENCH_RTP_TS_BYTES * 2000 * 90 / (mpeg.size() / BENCH_RTP_TS_BYTES + 1));
+			units.push_back(unit);
+		}
+		return;
+	}
+
+	m = bench_media(h265);
+	for (i = 0; i < m->frames.size(); i++)
+	{
+		const bench_frame_t& f = m->frames[i];
+		if (f.video != video)
+			continue;
+
+		// H.264/H.265 AnnexB, AAC raw frame
+		unit.data = video ? f.annexb.data() : f.mp4.data();
+		unit.bytes = (int)(video ? f.annexb.size() : f.mp4.size());
+		unit.timestamp = (uint32_t)(video ? f.pts * 90 : f.pts * 441 / 10);
+		units.push_back(unit);
+	}
+}
+
+static int bench_rtp_payload(const char* encoding)
+{
+	return 0 == strcmp("MP2T", encoding) ? RTP_PAYLOAD_MP2T : (0 == strcmp("MP4A-LATM", encoding) || 0 == strcmp("mpeg4-generic", encoding) ? 97 : 96);
+}
+
+static void bench_rtp_pack(const char* encoding, const std::vector<struct bench_rtp_unit_t>& units, struct bench_rtp_t* ctx)
+{
+	size_t i;
+	void* encoder;
+	struct rtp_payload_t handler = { bench_rtp_alloc, bench_rtp_free, bench_rtp_packet };
+
+	encoder = rtp_payload_encode_create(bench_rtp_payload(encoding), encoding, 0, 0x12345678, &handler, ctx);
+	for (i = 0; i < units.size(); i++)
+		rtp_payload_encode_input(encoder, units[i].data, units[i].bytes, units[i].timestamp);
+	rtp_payload_encode_destroy(encoder);
+}
+
+static void bench_rtp_pack(struct bench_state_t* state, const char* encoding)
+{
+	size_t i;
+	uint64_t bytes;
+	struct bench_rtp_t ctx;
+	std::vector<uint8_t> mpeg;
+	std::vector<struct bench_rtp_unit_t> units;
+
+	bench_rtp_units(encoding, units, mpeg);
+	for (bytes = i = 0; i < units.size(); i++)
+		bytes += units[i].bytes;
+
+	ctx.packets = NULL;
+	while (bench_next(state))
+	{
+		bench_rtp_pack(encoding, units, &ctx);
+		state->bytes += bytes;
+	}
+}
+
+static void bench_rtp_unpack(struct bench_state_t* state, const char* encoding)
+{
+	size_t i;
+	uint64_t bytes;
+	void* decoder;
+	struct bench_rtp_t ctx;
+	std::vector<uint8_t> mpeg;
+	std::vector<struct bench_rtp_unit_t> units;
+	std::vector<std::vector<uint8_t> > packets;
+	struct rtp_payload_t handler = { bench_rtp_alloc, bench_rtp_free, bench_rtp_packet };
+
+	bench_rtp_units(encoding, units, mpeg);
+	ctx.packets = &packets;
+	bench_rtp_pack(encoding, units, &ctx);
+	for (bytes = i = 0; i < packets.size(); i++)
+		bytes += packets[i].size();
+
+	ctx.packets = NULL;
+	while (bench_next(state))
+	{
+		ctx.count = 0;
+		decoder = rtp_payload_decode_create(bench_rtp_payload(encoding), encoding, &handler, &ctx);
+		for (i = 0; i < packets.size(); i++)
+			rtp_payload_decode_input(decoder, packets[i].data(), (int)packets[i].size());
+		rtp_payload_decode_destroy(decoder);
+		assert(ctx.count > 0);
+		state->bytes += bytes;
+	}
+}
+
+void bench_rtp_pack_h264(struct bench_state_t* state)
+{
+	bench_rtp_pack(state, "H264");
+}
+
+void bench_rtp_unpack_h264(struct bench_state_t* state)
+{
+	bench_rtp_unpack(state, "H264");
+}
+
+void bench_rtp_pack_h265(struct bench_state_t* state)
+{
+	bench_rtp_pack(state, "H265");
+}
+
+void bench_rtp_unpack_h265(struct bench_state_t* state)
+{
+	bench_rtp_unpack(state, "H265");
+}
+
+void bench_rtp_pack_mpeg4_generic(struct bench_state_t* state)
+{
+	bench_rtp_pack(state, "mpeg4-generic");
+}
+
+void bench_rtp_unpack_mpeg4_generic(struct bench_state_t* state)
+{
+	bench_rtp_unpack(state, "mpeg4-generic");
+}
+
+void bench_rtp_pack_mp4a_latm(struct bench_state_t* state)
+{
+	bench_rtp_pack(state, "MP4A-LATM");
+}
+
+void bench_rtp_unpack_mp4a_latm(struct bench_state_t* state)
+{
+	bench_rtp_unpack(state, "MP4A-LATM");
+}
+
+void bench_rtp_pack_mp2t(struct bench_state_t* state)
+{
+	bench_rtp_pack(state, "MP2T");
+}
+
+void bench_rtp_unpack_mp2t(struct bench_state_t* state)
+{
+	bench_rtp_unpack(state, "MP2T");
+}
+
+void bench_rtp_pack_ps(struct bench_state_t* state)
+{
+	bench_rtp_pack(state, "MP2P");
+}
+
+void bench_rtp_unpack_ps(struct bench_state_t* state)
+{
+	bench_rtp_unpack(state, "MP2P");
+}
+
+static void bench_rtp_queue_free(void* param, struct rtp_packet_t* pkt)
+{
+	(void)param; (void)pkt;
+}
+
+// one op: 1000 packets, every 10th packet swapped with its successor
+void bench_rtp_queue(struct bench_state_t* state)
+{
+	int i, n;
+	rtp_queue_t* q;
+	static struct rtp_packet_t s_packets[1000];
+	struct rtp_packet_t* order[sizeof(s_packets) / sizeof(s_packets[0])];
+
+	n = (int)(sizeof(s_packets) / sizeof(s_packets[0]));
+	for (i = 0; i < n; i++)
+	{
+		memset(&s_packets[i], 0, sizeof(s_packets[i]));
+		s_packets[i].rtp.v = 2;
+		s_packets[i].rtp.seq = (uint16_t)(65000 + i); // wrap around
+		s_packets[i].rtp.timestamp = (uint32_t)(i * 3000);
+		s_packets[i].payloadlen = 1400;
+		order[i] = &s_packets[i];
+	}
+	for (i = 5; i + 1 < n; i += 10)
+	{
+		order[i] = &s_packets[i + 1];
+		order[i + 1] = &s_packets[i];
+	}
+
+	while (bench_next(state))
+	{
+		q = rtp_queue_create(100, 90000, bench_rtp_queue_free, NULL);
+		for (i = 0; i < n; i++)
+		{
+			rtp_queue_write(q, order[i]);
+			while (rtp_queue_read(q))
+				;
+		}
+		rtp_queue_destroy(q);
+		state->bytes += n * 1400;
+	}
+}
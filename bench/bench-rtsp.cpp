@@ -0,0 +1,125 @@
+// SDP/RTSP header parser benchmarks
+
+#include "bench.h"
+#include "sdp.h"
+#include "sdp-a-fmtp.h"
+#include "rtsp-header-transport.h"
+extern "C" {
+#include "sdp-a-rtpmap.h"
+#include "rtsp-header-range.h"
+#include "rtsp-header-rtp-info.h"
+#include "rtsp-header-session.h"
+}
+#include <string.h>
+#include <assert.h>
+
+// DESCRIBE response of a H.264 + AAC live stream
+static const char* s_sdp =
+	"v=0\r\n"
+	"o=- 1609841932 1609841932 IN IP4 192.168.1.100\r\n"
+	"s=media-server\r\n"
+	"i=live stream\r\n"
+	"c=IN IP4 0.0.0.0\r\n"
+	"t=0 0\r\n"
+	"a=tool:media-server\r\n"
+	"a=range:npt=0-\r\n"
+	"a=control:*\r\n"
+	"m=video 0 RTP/AVP 96\r\n"
+	"b=AS:4000\r\n"
+	"a=rtpmap:96 H264/90000\r\n"
+	"a=fmtp:96 packetization-mode=1;profile-level-id=42E01E;sprop-parameter-sets=Z0LgHqtA8CjQgAAAAIAAABlwIAB4AAAPABaxsDxQqoCA,KM48gA==\r\n"
+	"a=framerate:25\r\n"
+	"a=control:track1\r\n"
+	"m=audio 0 RTP/AVP 97\r\n"
+	"b=AS:128\r\n"
+	"a=rtpmap:97 MPEG4-GENERIC/44100/2\r\n"
+	"a=fmtp:97 streamtype=5;profile-level-id=1;mode=AAC-hbr;sizelength=13;indexlength=3;indexdeltalength=3;config=1210\r\n"
+	"a=control:track2\r\n";
+
+static const char* s_fmtp = "96 packetization-mode=1;profile-level-id=42E01E;sprop-parameter-sets=Z0LgHqtA8CjQgAAAAIAAABlwIAB4AAAPABaxsDxQqoCA,KM48gA==";
+static const char* s_rtpmap = "97 MPEG4-GENERIC/44100/2";
+static const char* s_transport = "RTP/AVP/UDP;unicast;client_port=20000-20001;server_port=30000-30001;ssrc=12345678;mode=\"PLAY\"";
+static const char* s_range = "npt=12:05:35.3-12:06:35.3";
+static const char* s_rtp_info = "url=rtsp://192.168.1.100/live/track1;seq=45102;rtptime=12345678";
+static const char* s_session = "47112344;timeout=60";
+
+void bench_sdp_parse(struct bench_state_t* state)
+{
+	sdp_t* sdp;
+	int n = (int)strlen(s_sdp);
+	while (bench_next(state))
+	{
+		sdp = sdp_parse(s_sdp, n);
+		assert(sdp && 2 == sdp_media_count(sdp));
+		sdp_destroy(sdp);
+		state->bytes += n;
+	}
+}
+
+void bench_sdp_a_fmtp_h264(struct bench_state_t* state)
+{
+	int format;
+	struct sdp_a_fmtp_h264_t h264;
+	size_t n = strlen(s_fmtp);
+	while (bench_next(state))
+	{
+		sdp_a_fmtp_h264(s_fmtp, &format, &h264);
+		state->bytes += n;
+	}
+}
+
+void bench_sdp_a_rtpmap(struct bench_state_t* state)
+{
+	int payload, rate;
+	char encoding[16], parameters[64];
+	size_t n = strlen(s_rtpmap);
+	while (bench_next(state))
+	{
+		sdp_a_rtpmap(s_rtpmap, &payload, encoding, &rate, parameters);
+		state->bytes += n;
+	}
+}
+
+void bench_rtsp_header_transport(struct bench_state_t* state)
+{
+	struct rtsp_header_transport_t transport;
+	size_t n = strlen(s_transport);
+	while (bench_next(state))
+	{
+		rtsp_header_transport(s_transport, &transport);
+		state->bytes += n;
+	}
+}
+
+void bench_rtsp_header_range(struct bench_state_t* state)
+{
+	struct rtsp_header_range_t range;
+	size_t n = strlen(s_range);
+	while (bench_next(state))
+	{
+		rtsp_header_range(s_range, &range);
+		state->bytes += n;
+	}
+}
+
+void bench_rtsp_header_rtp_info(struct bench_state_t* state)
+{
+	struct rtsp_header_rtp_info_t rtpinfo;
+	size_t n = strlen(s_rtp_info);
+	while (bench_next(state))
+	{
+		rtsp_header_rtp_info(s_rtp_info, &rtpinfo);
+		state->bytes += n;
+	}
+}
+
+void bench_rtsp_header_session(struct bench_state_t* state)
+{
+	struct rtsp_header_session_t session;
+	size_t n = strlen(s_session);
+	while (bench_next(state))
+	{
+		rtsp_header_session(s_session, &session);
+		state->bytes += n;
+	}
+}
@@ -0,0 +1,250 @@
+// media-server micro benchmarks
+// Output: one JSON object per line(JSON Lines), e.g.
+// {"name":"ts_mux_h264","iterations":1234,"ns_per_op":810373,"mb_per_s":323.41,"allocs_per_op":0.00}
+// op: one 2s synthetic clip for container/RTP benchmarks, one message for SDP/RTSP header parsers
+// usage: bench [-t milliseconds] [-f name-filter] [-l]
+
+#include "bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+#define BENCH_DURATION 1000 // ms
+
+static uint64_t s_allocs;
+
+#if defined(BENCH_WRAP_MALLOC)
+// GNU ld -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc: count allocations of the static libraries and bench
+extern "C" void* __real_malloc(size_t bytes);
+extern "C" void* __real_calloc(size_t count, size_t bytes);
+extern "C" void* __real_realloc(void* ptr, size_t bytes);
+
+extern "C" void* __wrap_malloc(size_t bytes)
+{
+	++s_allocs;
+	return __real_malloc(bytes);
+}
+
+extern "C" void* __wrap_calloc(size_t count, size_t bytes)
+{
+	++s_allocs;
+	return __real_calloc(count, bytes);
+}
+
+extern "C" void* __wrap_realloc(void* ptr, size_t bytes)
+{
+	++s_allocs;
+	return __real_realloc(ptr, bytes);
+}
+
+int64_t bench_allocs(void)
+{
+	return (int64_t)s_allocs;
+}
+#else
+int64_t bench_allocs(void)
+{
+	(void)s_allocs;
+	return -1;
+}
+#endif
+
+static uint64_t bench_clock(void)
+{
+	return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool bench_next(struct bench_state_t* state)
+{
+	uint64_t per, n;
+	if (0 == state->check)
+	{
+		// first operation
+		state->check = 1;
+		state->iterations = 0;
+		state->bytes = 0;
+		state->allocs = (uint64_t)bench_allocs();
+		state->clock = bench_clock();
+	}
+	else if (state->iterations >= state->check)
+	{
+		state->elapsed = bench_clock() - state->clock;
+		if (state->elapsed >= state->duration)
+		{
+			state->allocs = (uint64_t)bench_allocs() - state->allocs;
+			return false;
+		}
+
+		// check clock about every 10ms(or remain time)
+		per = state->elapsed / state->iterations + 1;
+		n = state->duration - state->elapsed;
+		n = (n < 10000000 ? n : 10000000) / per;
+		state->check = state->iterations + (n > 0 ? n : 1);
+	}
+
+	state->iterations++;
+	return true;
+}
+
+// libmpeg
+void bench_ts_mux_h264(struct bench_state_t* state);
+void bench_ts_mux_h265(struct bench_state_t* state);
+void bench_ts_demux_h264(struct bench_state_t* state);
+void bench_ts_demux_h265(struct bench_state_t* state);
+void bench_ps_mux_h264(struct bench_state_t* state);
+void bench_ps_mux_h265(struct bench_state_t* state);
+void bench_ps_demux_h264(struct bench_state_t* state);
+void bench_ps_demux_h265(struct bench_state_t* state);
+
+// libflv/librtmp
+void bench_flv_mux_h264(struct bench_state_t* state);
+void bench_flv_mux_h265(struct bench_state_t* state);
+void bench_flv_demux_h264(struct bench_state_t* state);
+void bench_flv_demux_h265(struct bench_state_t* state);
+void bench_rtmp_chunk_write(struct bench_state_t* state);
+void bench_rtmp_chunk_read(struct bench_state_t* state);
+
+// librtp
+void bench_rtp_pack_h264(struct bench_state_t* state);
+void bench_rtp_unpack_h264(struct bench_state_t* state);
+void bench_rtp_pack_h265(struct bench_state_t* state);
+void bench_rtp_unpack_h265(struct bench_state_t* state);
+void bench_rtp_pack_mpeg4_generic(struct bench_state_t* state);
+void bench_rtp_unpack_mpeg4_generic(struct bench_state_t* state);
+void bench_rtp_pack_mp4a_latm(struct bench_state_t* state);
+void bench_rtp_unpack_mp4a_latm(struct bench_state_t* state);
+void bench_rtp_pack_mp2t(struct bench_state_t* state);
+void bench_rtp_unpack_mp2t(struct bench_state_t* state);
+void bench_rtp_pack_ps(struct bench_state_t* state);
+void bench_rtp_unpack_ps(struct bench_state_t* state);
+void bench_rtp_queue(struct bench_state_t* state);
+
+// libmov/libmkv
+void bench_mp4_write_h264(struct bench_state_t* state);
+void bench_mp4_read_h264(struct bench_state_t* state);
+void bench_fmp4_write_h264(struct bench_state_t* state);
+void bench_fmp4_read_h264(struct bench_state_t* state);
+void bench_mkv_write_h264(struct bench_state_t* state);
+void bench_mkv_read_h264(struct bench_state_t* state);
+
+// librtsp
+void bench_sdp_parse(struct bench_state_t* state);
+void bench_sdp_a_fmtp_h264(struct bench_state_t* state);
+void bench_sdp_a_rtpmap(struct bench_state_t* state);
+void bench_rtsp_header_transport(struct bench_state_t* state);
+void bench_rtsp_header_range(struct bench_state_t* state);
+void bench_rtsp_header_rtp_info(struct bench_state_t* state);
+void bench_rtsp_header_session(struct bench_state_t* state);
+
+static const struct
+{
+	const char* name;
+	bench_func func;
+} s_benches[] = {
+	{ "ts_mux_h264", bench_ts_mux_h264 },
+	{ "ts_mux_h265", bench_ts_mux_h265 },
+	{ "ts_demux_h264", bench_ts_demux_h264 },
+	{ "ts_demux_h265", bench_ts_demux_h265 },
+	{ "ps_mux_h264", bench_ps_mux_h264 },
+	{ "ps_mux_h265", bench_ps_mux_h265 },
+	{ "ps_demux_h264", bench_ps_demux_h264 },
+	{ "ps_demux_h265", bench_ps_demux_h265 },
+
+	{ "flv_mux_h264", bench_flv_mux_h264 },
+	{ "flv_mux_h265", bench_flv_mux_h265 },
+	{ "flv_demux_h264", bench_flv_demux_h264 },
+	{ "flv_demux_h265", bench_flv_demux_h265 },
+	{ "rtmp_chunk_write", bench_rtmp_chunk_write },
+	{ "rtmp_chunk_read", bench_rtmp_chunk_read },
+
+	{ "rtp_pack_h264", bench_rtp_pack_h264 },
+	{ "rtp_unpack_h264", bench_rtp_unpack_h264 },
+	{ "rtp_pack_h265", bench_rtp_pack_h265 },
+	{ "rtp_unpack_h265", bench_rtp_unpack_h265 },
+	{ "rtp_pack_mpeg4_generic", bench_rtp_pack_mpeg4_generic },
+	{ "rtp_unpack_mpeg4_generic", bench_rtp_unpack_mpeg4_generic },
+	{ "rtp_pack_mp4a_latm", bench_rtp_pack_mp4a_latm },
+	{ "rtp_unpack_mp4a_latm", bench_rtp_unpack_mp4a_latm },
+	{ "rtp_pack_mp2t", bench_rtp_pack_mp2t },
+	{ "rtp_unpack_mp2t", bench_rtp_unpack_mp2t },
+	{ "rtp_pack_ps", bench_rtp_pack_ps },
+	{ "rtp_unpack_ps", bench_rtp_unpack_ps },
+	{ "rtp_queue", bench_rtp_queue },
+
+	{ "mp4_write_h264", bench_mp4_write_h264 },
+	{ "mp4_read_h264", bench_mp4_read_h264 },
+	{ "fmp4_write_h264", bench_fmp4_write_h264 },
+	{ "fmp4_read_h264", bench_fmp4_read_h264 },
+	{ "mkv_write_h264", bench_mkv_write_h264 },
+	{ "mkv_read_h264", bench_mkv_read_h264 },
+
+	{ "sdp_parse", bench_sdp_parse },
+	{ "sdp_a_fmtp_h264", bench_sdp_a_fmtp_h264 },
+	{ "sdp_a_rtpmap", bench_sdp_a_rtpmap },
+	{ "rtsp_header_transport", bench_rtsp_header_transport },
+	{ "rtsp_header_range", bench_rtsp_header_range },
+	{ "rtsp_header_rtp_info", bench_rtsp_header_rtp_info },
+	{ "rtsp_header_session", bench_rtsp_header_session },
+};
+
+static void bench_run(const char* name, bench_func func, uint64_t duration)
+{
+	double ns;
+	struct bench_state_t state;
+
+	memset(&state, 0, sizeof(state));
+	state.duration = duration;
+	func(&state);
+	if (0 == state.iterations)
+	{
+		printf("{\"name\":\"%s\",\"error\":\"no iteration\"}\n", name);
+		return;
+	}
+
+	ns = (double)state.elapsed / state.iterations;
+	printf("{\"name\":\"%s\",\"iterations\":%llu,\"ns_per_op\":%.0f,\"mb_per_s\":%.2f", name, (unsigned long long)state.iterations, ns, state.elapsed > 0 ? state.bytes * 1000.0 / state.elapsed : 0.0);
+	if (bench_allocs() >= 0)
+		printf(",\"allocs_per_op\":%.2f}\n", (double)state.allocs / state.iterations);
+	else
+		printf(",\"allocs_per_op\":null}\n");
+	fflush(stdout);
+}
+
+int main(int argc, char* argv[])
+{
+	int i;
+	const char* filter = NULL;
+	uint64_t duration = BENCH_DURATION;
+
+	for (i = 1; i < argc; i++)
+	{
+		if (0 == strcmp("-t", argv[i]) && i + 1 < argc)
+		{
+			duration = strtoul(argv[++i], NULL, 10);
+		}
+		else if (0 == strcmp("-f", argv[i]) && i + 1 < argc)
+		{
+			filter = argv[++i];
+		}
+		else if (0 == strcmp("-l", argv[i]))
+		{
+			for (i = 0; i < (int)(sizeof(s_benches) / sizeof(s_benches[0])); i++)
+				printf("%s\n", s_benches[i].name);
+			return 0;
+		}
+		else
+		{
+			printf("usage: %s [-t milliseconds] [-f name-filter] [-l]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	for (i = 0; i < (int)(sizeof(s_benches) / sizeof(s_benches[0])); i++)
+	{
+		if (filter && !strstr(s_benches[i].name, filter))
+			continue;
+		bench_run(s_benches[i].name, s_benches[i].func, duration * 1000000);
+	}
+	return 0;
+}
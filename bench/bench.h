@@ -0,0 +1,82 @@
+#ifndef _bench_h_
+#define _bench_h_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+/// Benchmark state, usage:
+/// static void bench_xxx(struct bench_state_t* state)
+/// {
+///     setup(not measured)
+///     while (bench_next(state))
+///     {
+///         one operation
+///         state->bytes += processed bytes;
+///     }
+///     cleanup(not measured)
+/// }
+struct bench_state_t
+{
+	uint64_t bytes; // processed bytes of all operations(MB/s)
+
+	// private
+	uint64_t iterations;
+	uint64_t check; // next clock check iteration
+	uint64_t duration; // minimum measure time(ns)
+	uint64_t clock; // start clock(ns)
+	uint64_t elapsed; // ns
+	uint64_t allocs; // allocations at start
+};
+
+typedef void (*bench_func)(struct bench_state_t* state);
+
+/// @return true-run one more operation, false-stop measure
+bool bench_next(struct bench_state_t* state);
+
+/// malloc/calloc/realloc calls, -1 if allocation counter is unavailable(link without -Wl,--wrap=malloc)
+int64_t bench_allocs(void);
+
+/// Synthetic media frame
+struct bench_frame_t
+{
+	int video; // 1-video, 0-audio
+	int keyframe;
+	int64_t pts; // ms
+	int64_t dts; // ms
+	std::vector<uint8_t> annexb; // H.264/H.265 AnnexB(SPS/PPS before IDR), AAC ADTS
+	std::vector<uint8_t> mp4; // H.264/H.265 4-bytes NALU length + NALU, AAC raw frame
+};
+
+/// Synthetic H.264/H.265 + AAC clip: 25fps, 1s GOP, IDR ~20KB, P ~4KB, AAC-LC 44.1kHz stereo ~300B
+struct bench_media_t
+{
+	int h265;
+	std::vector<bench_frame_t> frames; // interleaved by dts
+	uint8_t config[512]; // AVCDecoderConfigurationRecord/HEVCDecoderConfigurationRecord
+	size_t config_bytes;
+	uint8_t asc[8]; // AAC AudioSpecificConfig
+	size_t asc_bytes;
+	uint64_t bytes; // ES(AnnexB/ADTS) bytes of all frames
+	int width;
+	int height;
+};
+
+/// @param[in] h265 0-H.264, 1-H.265
+/// @return 2s clip(created on first call)
+const struct bench_media_t* bench_media(int h265);
+
+/// FLV tag(flv_muxer output)
+struct bench_tag_t
+{
+	int type; // FLV_TYPE_AUDIO/FLV_TYPE_VIDEO/FLV_TYPE_SCRIPT
+	uint32_t timestamp;
+	std::vector<uint8_t> data;
+};
+
+/// Mux the synthetic clip(setup for demuxer/RTP/RTMP benchmarks)
+void bench_media_ts(int h265, std::vector<uint8_t>& ts);
+void bench_media_ps(int h265, std::vector<uint8_t>& ps);
+void bench_media_flv(int h265, std::vector<struct bench_tag_t>& tags);
+
+#endif /* !_bench_h_ */
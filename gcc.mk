@@ -59,6 +59,11 @@ ifeq ($(FILENAME),1)
 	CFLAGS += -Wno-builtin-macro-redefined -D'__FILE_NAME__="$(notdir $<)"'
 endif
 
+# hot-path metrics(media-metrics.h)
+ifeq ($(METRICS),1)
+	DEFINES += MEDIA_METRICS
+endif
+
 ifeq ($(VERSION),1)
 	VERSIONFILE = version.o
 endif
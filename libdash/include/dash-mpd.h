@@ -15,6 +15,19 @@ typedef int (*dash_mpd_segment)(void* param, int adapation, const void* data, si
 dash_mpd_t* dash_mpd_create(int flags, dash_mpd_segment handler, void* param);
 void dash_mpd_destroy(dash_mpd_t* mpd);
 
+/// Low-latency chunked CMAF: chunk(moof + mdat) of the segment name, segment = chunk 0 + chunk 1 + ...
+/// called before dash_mpd_segment of the segment
+/// @param[in] data chunk content, NULL(bytes = 0) for the end signal: the last chunk has been delivered with last = 0
+/// @param[in] pts/dts chunk first pts/dts(ms), the end signal carry the pts/dts of the delivered last chunk
+/// @param[in] name segment name
+/// @param[in] last 1-last chunk of the segment(end of chunked transfer), 0-more chunks
+typedef int (*dash_mpd_chunk)(void* param, int adapation, const void* data, size_t bytes, int64_t pts, int64_t dts, const char* name, int last);
+
+/// Enable chunked mode: availabilityTimeOffset and availabilityTimeComplete="false" in SegmentTemplate
+/// @param[in] frames frames per chunk, 0-disable
+/// @return 0-ok, other-error
+int dash_mpd_set_chunk(dash_mpd_t* mpd, int frames, dash_mpd_chunk handler, void* param);
+
 /// @param[in] prefix dash adapation set name prefix
 /// @return >=0-adapation id, <0-error
 int dash_mpd_add_video_adaptation_set(dash_mpd_t* mpd, const char* prefix, uint8_t object, int width, int height, const void* extra_data, size_t extra_data_size);
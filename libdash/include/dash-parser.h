@@ -425,6 +425,12 @@ int dash_mpd_parse(struct dash_mpd_t** mpd, const char* data, size_t bytes);
 
 int dash_mpd_free(struct dash_mpd_t** mpd);
 
+/// Reload live MPD: SegmentTimeline resume from the last known S@t/@r, the known S elements 
+/// between the first and the last known S are reused(don't parse)
+/// @param[in,out] mpd NULL-parse all, other-previous dash_mpd_parse/dash_mpd_refresh mpd(free by dash_mpd_free)
+/// @return >=0-new SegmentTimeline segment count(all segments if the known S changed), <0-error(mpd is unchanged)
+int dash_mpd_refresh(struct dash_mpd_t** mpd, const char* data, size_t bytes);
+
 /// @return -1-live, >=0-duration(ms), other-error
 int64_t dash_get_duration(const struct dash_mpd_t* mpd);
 
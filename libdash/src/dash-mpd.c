@@ -52,6 +52,14 @@ struct dash_adaptation_set_t
 	
 	int seq;
 	uint8_t object;
+
+	// chunked CMAF
+	size_t chunk_offset; // chunk start position in segment
+	int chunk_frames; // frames in current chunk
+	int64_t chunk_pts; // chunk first pts
+	int64_t chunk_dts; // chunk first dts
+	int64_t chunk_duration; // max chunk duration
+
 	char name[8]; // H264/H265/H266/AAC
 	char codecs[64]; // avc1.x.x.x
 
@@ -87,6 +95,10 @@ struct dash_mpd_t
 	dash_mpd_segment handler;
 	void* param;
 
+	int chunk_frames; // frames per chunk, 0-disable
+	dash_mpd_chunk onchunk;
+	void* chunk_param;
+
 	union
 	{
 		struct mpeg4_avc_t avc;
@@ -159,6 +171,35 @@ static struct mov_buffer_t s_io = {
 	mov_buffer_tell,
 };
 
+static void dash_adaptation_set_name(struct dash_adaptation_set_t* track, int64_t timestamp, char* name, size_t bytes)
+{
+	if(MOV_OBJECT_AAC == track->object)
+		snprintf(name, bytes - 1, "%s-%" PRId64 ".m4a", track->prefix, timestamp);
+	else
+		snprintf(name, bytes - 1, "%s-%" PRId64 ".m4v", track->prefix, timestamp);
+}
+
+/// flush current chunk(fmp4_writer_save_fragment) and notify
+static int dash_adaptation_set_chunk(struct dash_mpd_t* mpd, struct dash_adaptation_set_t* track, int last)
+{
+	int r;
+	size_t offset;
+	char name[N_NAME + 32];
+
+	r = fmp4_writer_save_fragment(track->fmp4);
+	if (0 != r)
+		return r;
+
+	assert(track->chunk_frames > 0);
+	track->chunk_duration = MAX(track->chunk_duration, track->dts_last - track->chunk_dts);
+
+	offset = track->chunk_offset;
+	track->chunk_offset = track->bytes;
+	track->chunk_frames = 0;
+	dash_adaptation_set_name(track, track->dts, name, sizeof(name));
+	return mpd->onchunk(mpd->chunk_param, track->setid, track->ptr + offset, track->bytes - offset, track->chunk_pts, track->chunk_dts, name, last);
+}
+
 static int dash_adaptation_set_segment(struct dash_mpd_t* mpd, struct dash_adaptation_set_t* track)
 {
 	int r;
@@ -166,7 +207,19 @@ static int dash_adaptation_set_segment(struct dash_mpd_t* mpd, struct dash_adapt
 	struct list_head *link;
 	struct dash_segment_t* seg;
 
-	r = fmp4_writer_save_segment(track->fmp4);
+	// last chunk, or end signal if the last chunk has been delivered(keep its timestamp)
+	if (mpd->onchunk && track->chunk_frames > 0)
+		r = dash_adaptation_set_chunk(mpd, track, 1);
+	else if (mpd->onchunk)
+	{
+		dash_adaptation_set_name(track, track->dts, name, sizeof(name));
+		r = mpd->onchunk(mpd->chunk_param, track->setid, NULL, 0, track->chunk_pts, track->chunk_dts, name, 1);
+	}
+	else
+		r = 0;
+
+	if (0 == r)
+		r = fmp4_writer_save_segment(track->fmp4);
 	if (0 != r)
 		return r;
 
@@ -176,10 +229,7 @@ static int dash_adaptation_set_segment(struct dash_mpd_t* mpd, struct dash_adapt
 	seg->timestamp = track->dts;
 	seg->duration = track->dts_last - track->dts;
 
-	if(MOV_OBJECT_AAC == track->object)
-		snprintf(name, sizeof(name) - 1, "%s-%" PRId64 ".m4a", track->prefix, seg->timestamp);
-	else
-		snprintf(name, sizeof(name) - 1, "%s-%" PRId64 ".m4v", track->prefix, seg->timestamp);
+	dash_adaptation_set_name(track, seg->timestamp, name, sizeof(name));
 	r = mpd->handler(mpd->param, track->setid, track->ptr, track->bytes, track->pts, track->dts, seg->duration, name);
 	if (0 != r)
 	{
@@ -227,6 +277,8 @@ static int dash_mpd_flush(struct dash_mpd_t* mpd)
 		// reset track buffer
 		track->offset = 0;
 		track->bytes = 0;
+		track->chunk_offset = 0;
+		track->chunk_frames = 0;
 	}
 
 	return r;
@@ -246,6 +298,14 @@ struct dash_mpd_t* dash_mpd_create(int flags, dash_mpd_segment segment, void* pa
 	return mpd;
 }
 
+int dash_mpd_set_chunk(struct dash_mpd_t* mpd, int frames, dash_mpd_chunk handler, void* param)
+{
+	mpd->chunk_frames = handler ? frames : 0;
+	mpd->onchunk = mpd->chunk_frames > 0 ? handler : NULL;
+	mpd->chunk_param = param;
+	return 0;
+}
+
 void dash_mpd_destroy(struct dash_mpd_t* mpd)
 {
 	int i;
@@ -432,7 +492,21 @@ int dash_mpd_input(struct dash_mpd_t* mpd, int adapation, const void* data, size
 	}
 	track->dts_last = dts;
 	track->raw_bytes += bytes;
-	return fmp4_writer_write(track->fmp4, track->track, data, bytes, pts, dts, flags);
+
+	if (!mpd->onchunk)
+		return fmp4_writer_write(track->fmp4, track->track, data, bytes, pts, dts, flags);
+
+	if (0 == track->chunk_frames)
+	{
+		track->chunk_pts = pts;
+		track->chunk_dts = dts;
+	}
+
+	// chunk is delivered as soon as it's produced, fragment per chunk only
+	r = fmp4_writer_write(track->fmp4, track->track, data, bytes, pts, dts, flags | MOV_AV_FLAG_SEGMENT_DISABLE);
+	if (0 == r && ++track->chunk_frames >= mpd->chunk_frames)
+		r = dash_adaptation_set_chunk(mpd, track, 0);
+	return r;
 }
 
 // ISO/IEC 23009-1:2014(E) 5.4 Media Presentation Description updates (p67)
@@ -473,14 +547,14 @@ size_t dash_mpd_playlist(struct dash_mpd_t* mpd, char* playlist, size_t bytes)
 	static const char* s_h264 =
 		"    <AdaptationSet contentType=\"video\" segmentAlignment=\"true\" bitstreamSwitching=\"true\">\n"
 		"      <Representation id=\"%s\" mimeType=\"video/mp4\" codecs=\"%s\" width=\"%d\" height=\"%d\" frameRate=\"%d\" startWithSAP=\"1\" bandwidth=\"%d\">\n"
-		"        <SegmentTemplate timescale=\"1000\" media=\"%s-$Time$.m4v\" initialization=\"%s-init.m4v\">\n"
+		"        <SegmentTemplate timescale=\"1000\" media=\"%s-$Time$.m4v\" initialization=\"%s-init.m4v\"%s>\n"
 		"          <SegmentTimeline>\n";
 
 	static const char* s_aac =
 		"    <AdaptationSet contentType=\"audio\" segmentAlignment=\"true\" bitstreamSwitching=\"true\">\n"
 		"      <Representation id=\"%s\" mimeType=\"audio/mp4\" codecs=\"%s\" audioSamplingRate=\"%d\" startWithSAP=\"1\" bandwidth=\"%d\">\n"
 		"		 <AudioChannelConfiguration schemeIdUri=\"urn:mpeg:dash:23003:3:audio_channel_configuration:2011\" value=\"%d\"/>\n"
-		"        <SegmentTemplate timescale=\"1000\" media=\"%s-$Time$.m4a\" initialization=\"%s-init.m4a\">\n"
+		"        <SegmentTemplate timescale=\"1000\" media=\"%s-$Time$.m4a\" initialization=\"%s-init.m4a\"%s>\n"
 		"          <SegmentTimeline>\n";
 
 	static const char* s_footer =
@@ -493,6 +567,7 @@ size_t dash_mpd_playlist(struct dash_mpd_t* mpd, char* playlist, size_t bytes)
 	size_t n;
 	time_t now;
 	char publishTime[32];
+	char availability[96];
 	char availabilityStartTime[32];
 	unsigned int minimumUpdatePeriod;
 	unsigned int timeShiftBufferDepth;
@@ -521,9 +596,15 @@ size_t dash_mpd_playlist(struct dash_mpd_t* mpd, char* playlist, size_t bytes)
 	for (i = 0; i < mpd->count; i++)
 	{
 		track = &mpd->tracks[i];
+
+		// ISO/IEC 23009-1 5.3.9.5.3 chunked segment is available availabilityTimeOffset earlier than complete
+		availability[0] = '\0';
+		if (mpd->onchunk && mpd->max_segment_duration > track->chunk_duration)
+			snprintf(availability, sizeof(availability), " availabilityTimeOffset=\"%.3f\" availabilityTimeComplete=\"false\"", (mpd->max_segment_duration - track->chunk_duration) / 1000.0);
+
 		if (MOV_OBJECT_H264 == track->object || MOV_OBJECT_HEVC == track->object || MOV_OBJECT_VVC == track->object)
 		{
-			n += snprintf(playlist + n, n < bytes ? bytes - n : 0, s_h264, track->name, track->codecs, track->u.video.width, track->u.video.height, track->u.video.frame_rate, track->bitrate, track->prefix, track->prefix);
+			n += snprintf(playlist + n, n < bytes ? bytes - n : 0, s_h264, track->name, track->codecs, track->u.video.width, track->u.video.height, track->u.video.frame_rate, track->bitrate, track->prefix, track->prefix, availability);
 			list_for_each(link, &track->root)
 			{
 				seg = list_entry(link, struct dash_segment_t, link);
@@ -533,7 +614,7 @@ size_t dash_mpd_playlist(struct dash_mpd_t* mpd, char* playlist, size_t bytes)
 		}
 		else if (MOV_OBJECT_AAC == track->object)
 		{
-			n += snprintf(playlist + n, n < bytes ? bytes - n : 0, s_aac, track->name, track->codecs, track->u.audio.sample_rate, track->bitrate, track->u.audio.channel, track->prefix, track->prefix);
+			n += snprintf(playlist + n, n < bytes ? bytes - n : 0, s_aac, track->name, track->codecs, track->u.audio.sample_rate, track->bitrate, track->u.audio.channel, track->prefix, track->prefix, availability);
 			list_for_each(link, &track->root)
 			{
 				seg = list_entry(link, struct dash_segment_t, link);
@@ -550,3 +631,101 @@ size_t dash_mpd_playlist(struct dash_mpd_t* mpd, char* playlist, size_t bytes)
 	n += snprintf(playlist + n, n < bytes ? bytes - n : 0, "  </Period>\n</MPD>\n");
 	return n >= bytes ? 0 : n;
 }
+
+#if defined(_DEBUG) || defined(DEBUG)
+struct dash_mpd_test_t
+{
+	uint8_t segment[64 * 1024];
+	size_t bytes;
+	int chunks;
+	int ends; // end signals
+	int segments;
+	int frames; // frames per chunk
+};
+
+static int dash_mpd_test_onsegment(void* param, int adapation, const void* data, size_t bytes, int64_t pts, int64_t dts, int64_t duration, const char* name)
+{
+	struct dash_mpd_test_t* ctx;
+	ctx = (struct dash_mpd_test_t*)param;
+	if (0 == duration)
+		return 0; // init segment
+
+	// segment = chunk 0 + chunk 1 + ...
+	assert(bytes == ctx->bytes && 0 == memcmp(ctx->segment, data, bytes));
+	ctx->bytes = 0;
+	ctx->segments++;
+	(void)adapation, (void)pts, (void)dts, (void)name;
+	return 0;
+}
+
+static int dash_mpd_test_onchunk(void* param, int adapation, const void* data, size_t bytes, int64_t pts, int64_t dts, const char* name, int last)
+{
+	char ts[32];
+	struct dash_mpd_test_t* ctx;
+	ctx = (struct dash_mpd_test_t*)param;
+	assert(ctx->bytes + bytes <= sizeof(ctx->segment));
+
+	// 1s per segment, chunks of the same segment have the same name
+	snprintf(ts, sizeof(ts), "-%" PRId64 ".m4v", dts / 1000 * 1000);
+	assert(strstr(name, ts));
+	assert(0 == dts % 1000 % (ctx->frames * 40));
+
+	if (NULL == data)
+	{
+		// end signal: the last chunk(800ms) has been delivered
+		assert(0 == bytes && last && 800 == dts % 1000 && ctx->bytes > 0);
+		ctx->ends++;
+		return 0;
+	}
+
+	assert(0 == ctx->bytes ? (bytes > 8 && 0 == memcmp((const uint8_t*)data + 4, "styp", 4)) : (bytes > 8 && 0 == memcmp((const uint8_t*)data + 4, "moof", 4)));
+	assert(!last || 1000 - dts % 1000 <= ctx->frames * 40);
+	memcpy(ctx->segment + ctx->bytes, data, bytes);
+	ctx->bytes += bytes;
+	ctx->chunks++;
+	(void)adapation, (void)pts;
+	return 0;
+}
+
+void dash_mpd_test(void)
+{
+	// AVCDecoderConfigurationRecord(1-SPS, 1-PPS)
+	static const uint8_t s_avcc[] = { 0x01, 0x42, 0xc0, 0x1e, 0xff, 0xe1, 0x00, 0x08, 0x67, 0x42, 0xc0, 0x1e, 0xd9, 0x01, 0x40, 0x16, 0x01, 0x00, 0x04, 0x68, 0xcb, 0x83, 0xcb };
+	static struct dash_mpd_test_t ctx;
+	static char playlist[8 * 1024];
+	int i, adapation;
+	uint8_t video[4 + 16];
+	dash_mpd_t* mpd;
+
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.frames = 5;
+	mpd = dash_mpd_create(DASH_DYNAMIC, dash_mpd_test_onsegment, &ctx);
+	assert(0 == dash_mpd_set_chunk(mpd, ctx.frames, dash_mpd_test_onchunk, &ctx));
+	adapation = dash_mpd_add_video_adaptation_set(mpd, "video", MOV_OBJECT_H264, 320, 240, s_avcc, sizeof(s_avcc));
+	assert(0 == adapation);
+
+	// 25fps, gop 1s, chunk 200ms
+	memset(video, 0, sizeof(video));
+	video[3] = 16;
+	for (i = 0; i < 100; i++)
+		assert(0 == dash_mpd_input(mpd, adapation, video, sizeof(video), i * 40, i * 40, (i % 25) ? 0 : MOV_AV_FLAG_KEYFREAME));
+	assert(0 == dash_mpd_input(mpd, adapation, NULL, 0, 0, 0, 0));
+	assert(4 == ctx.segments && 4 * 5 == ctx.chunks && 4 == ctx.ends); // 5 chunks + end signal per segment
+
+	assert(dash_mpd_playlist(mpd, playlist, sizeof(playlist)) > 0);
+	assert(strstr(playlist, "initialization=\"video-init.m4v\" availabilityTimeOffset=\"0.800\" availabilityTimeComplete=\"false\">"));
+	dash_mpd_destroy(mpd);
+
+	// chunk 280ms: 7 + 7 + 7 + 4(last) frames per segment, no end signal
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.frames = 7;
+	mpd = dash_mpd_create(DASH_DYNAMIC, dash_mpd_test_onsegment, &ctx);
+	assert(0 == dash_mpd_set_chunk(mpd, ctx.frames, dash_mpd_test_onchunk, &ctx));
+	adapation = dash_mpd_add_video_adaptation_set(mpd, "video", MOV_OBJECT_H264, 320, 240, s_avcc, sizeof(s_avcc));
+	for (i = 0; i < 100; i++)
+		assert(0 == dash_mpd_input(mpd, adapation, video, sizeof(video), i * 40, i * 40, (i % 25) ? 0 : MOV_AV_FLAG_KEYFREAME));
+	assert(0 == dash_mpd_input(mpd, adapation, NULL, 0, 0, 0, 0));
+	assert(4 == ctx.segments && 4 * 4 == ctx.chunks && 0 == ctx.ends);
+	dash_mpd_destroy(mpd);
+}
+#endif
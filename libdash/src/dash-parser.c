@@ -8,6 +8,8 @@
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
+#include <limits.h>
+#include <time.h>
 
 #ifndef offsetof
 #define offsetof(s, m)   (size_t)&(((s*)0)->m)
@@ -80,6 +82,17 @@ struct dash_parser_t
 		size_t off;
 	} stack[16];
 	int level;
+
+	// dash_mpd_refresh: resume the SegmentTimeline after the last known S
+	const struct dash_mpd_t* prev; // previous mpd, NULL-parse all
+	const struct dash_segment_timeline_t* known; // previous SegmentTimeline of the current SegmentTimeline
+	int resume; // 0-parse all S, 1-first S, 2-last known S
+	int resync; // 1-known S don't match, parse all
+	size_t skip; // known S elements, reuse without parse
+	uint64_t last_t; // start time of the last known S
+	uint64_t last_d;
+	int last_r;
+	uint64_t segments; // new segments
 };
 
 enum
@@ -535,6 +548,54 @@ static int dash_tag_segment_template(struct dash_parser_t* parser, void* ptr, co
 	return dash_tag_segment(parser, ptr, DASH_SEGMENT_TEMPLATE, attr, len);
 }
 
+/// previous mpd SegmentTimeline of the same Period(@id)/AdaptationSet(@id)/Representation(@id)
+static const struct dash_segment_timeline_t* dash_parser_known_timeline(struct dash_parser_t* parser, const struct dash_segment_t* segment)
+{
+	size_t i, j, k;
+	const struct dash_period_t* period, *prev;
+	const struct dash_adaptation_set_t* set, *set0;
+	const struct dash_representation_t* representation;
+
+	if (!parser->prev || parser->mpd->period_count < 1)
+		return NULL;
+
+	period = &parser->mpd->periods[parser->mpd->period_count - 1];
+	for (i = 0; i < parser->prev->period_count; i++)
+	{
+		prev = &parser->prev->periods[i];
+		if (period->id && prev->id ? 0 == strcmp(period->id, prev->id) : i + 1 == parser->mpd->period_count)
+			break;
+	}
+	if (i >= parser->prev->period_count)
+		return NULL;
+	if (segment == &period->segment)
+		return &prev->segment.segment_timeline;
+
+	if (period->adaptation_set_count < 1)
+		return NULL;
+	set = &period->adaptation_sets[period->adaptation_set_count - 1];
+	for (j = 0; j < prev->adaptation_set_count; j++)
+	{
+		set0 = &prev->adaptation_sets[j];
+		if (set->id && set0->id ? set->id == set0->id : j + 1 == period->adaptation_set_count)
+			break;
+	}
+	if (j >= prev->adaptation_set_count)
+		return NULL;
+	if (segment == &set->segment)
+		return &set0->segment.segment_timeline;
+
+	if (set->representation_count < 1 || segment != &set->representations[set->representation_count - 1].segment)
+		return NULL;
+	representation = &set->representations[set->representation_count - 1];
+	for (k = 0; k < set0->representation_count; k++)
+	{
+		if (representation->id && set0->representations[k].id ? 0 == strcmp(representation->id, set0->representations[k].id) : k + 1 == set->representation_count)
+			return &set0->representations[k].segment.segment_timeline;
+	}
+	return NULL;
+}
+
 static int dash_tag_segment_timeline(struct dash_parser_t* parser, void* ptr, const char* attr, size_t len)
 {
 	struct dash_segment_t* segment;
@@ -542,10 +603,105 @@ static int dash_tag_segment_timeline(struct dash_parser_t* parser, void* ptr, co
 	segment = (struct dash_segment_t*)ptr;
 	timeline = &segment->segment_timeline;
 	parser->tag = timeline; // save
+	parser->known = dash_parser_known_timeline(parser, segment);
+	parser->resume = parser->known && parser->known->count > 0 ? 1 : 0;
 	(void)attr, (void)len;
 	return 0;
 }
 
+/// locate the first S in the known timeline, reuse the known S between the first and the last known S
+static int dash_parser_resume_first(struct dash_parser_t* parser, struct dash_segment_timeline_t* timeline)
+{
+	int r;
+	size_t i, n, capacity;
+	uint64_t t, start;
+	const struct dash_segment_timeline_t* known;
+
+	known = parser->known;
+	for (t = start = 0, i = 0; i < known->count; i++)
+	{
+		if (known->S[i].r < 0 || known->S[i].d < 1)
+			break; // @r = -1: repeat until next S@t, can't locate, parse all
+
+		start = known->S[i].t ? known->S[i].t : t;
+		t = start + known->S[i].d * (known->S[i].r + 1);
+		if (timeline->S[0].t >= start && timeline->S[0].t < t)
+			break;
+	}
+
+	if (i >= known->count || known->S[i].r < 0 || known->S[i].d < 1)
+	{
+		// new timeline, parse all
+		parser->segments += timeline->S[0].r >= 0 ? timeline->S[0].r + 1 : 1;
+		return 0;
+	}
+
+	if (timeline->S[0].d != known->S[i].d || 0 != (timeline->S[0].t - start) % known->S[i].d)
+	{
+		parser->resync = 1;
+		return -1;
+	}
+
+	// segments of the first S after expired segments removed
+	r = known->S[i].r - (int)((timeline->S[0].t - start) / known->S[i].d);
+	if (i + 1 == known->count)
+	{
+		// the first S is the last known S
+		parser->segments += timeline->S[0].r > r ? timeline->S[0].r - r : 0;
+		return 0;
+	}
+	else if (timeline->S[0].r != r)
+	{
+		parser->resync = 1;
+		return -1;
+	}
+
+	// reuse known S (i, count - 1), don't parse
+	n = known->count - 2 - i;
+	capacity = SEGMENT_URL_CAPACITY(timeline->count);
+	if (0 != dash_parser_realloc((void**)&timeline->S, &capacity, timeline->count + n, SEGMENT_URL_INCR, sizeof(timeline->S[0])))
+		return -ENOMEM;
+	memcpy(timeline->S + timeline->count, known->S + i + 1, n * sizeof(timeline->S[0]));
+	timeline->count += n;
+
+	for (i++; i + 1 < known->count; i++)
+		t = (known->S[i].t ? known->S[i].t : t) + known->S[i].d * (known->S[i].r + 1);
+	parser->last_t = known->S[i].t ? known->S[i].t : t;
+	parser->last_d = known->S[i].d;
+	parser->last_r = known->S[i].r;
+	parser->skip = n;
+	parser->resume = 2;
+	return 0;
+}
+
+static int dash_parser_resume(struct dash_parser_t* parser, struct dash_segment_timeline_t* timeline)
+{
+	uint64_t t, d;
+	int r;
+
+	if (1 == parser->resume)
+	{
+		assert(1 == timeline->count);
+		parser->resume = 0;
+		return dash_parser_resume_first(parser, timeline);
+	}
+
+	// the last known S, @r may be increased
+	assert(2 == parser->resume && 0 == parser->skip);
+	parser->resume = 0;
+	t = timeline->S[timeline->count - 1].t;
+	d = timeline->S[timeline->count - 1].d;
+	r = timeline->S[timeline->count - 1].r;
+	if (d != parser->last_d || (t && t != parser->last_t) || r < parser->last_r)
+	{
+		parser->resync = 1;
+		return -1;
+	}
+
+	parser->segments += r - parser->last_r;
+	return 0;
+}
+
 static int dash_tag_s(struct dash_parser_t* parser, void* ptr, const char* attr, size_t len)
 {
 	int r;
@@ -571,6 +727,10 @@ static int dash_tag_s(struct dash_parser_t* parser, void* ptr, const char* attr,
 
 	parser->tag = &timeline->S[timeline->count]; // save
 	timeline->count++;
+	if (parser->resume)
+		return dash_parser_resume(parser, timeline);
+
+	parser->segments += timeline->S[timeline->count - 1].r >= 0 ? timeline->S[timeline->count - 1].r + 1 : 1;
 	return 0;
 }
 
@@ -1253,6 +1413,14 @@ static int dash_parser_input(struct dash_parser_t* parser, const char* data, siz
 				return -1; // tag don't match
 			}			
 			parser->level -= 1;
+
+			if (0 == strcasecmp("SegmentTimeline", tag.name))
+			{
+				if (2 == parser->resume)
+					parser->resync = 1; // the last known S is removed
+				parser->resume = 0;
+				parser->known = NULL;
+			}
 		}
 		else
 		{
@@ -1268,7 +1436,16 @@ static int dash_parser_input(struct dash_parser_t* parser, const char* data, siz
 				parser->content = "";
 			}
 
-			r = dash_parser_ontag(parser, tag.name, tag.attr, tag.nattr);
+			if (parser->skip > 0 && 0 == strcasecmp("S", tag.name) && parser->level > 0 && 0 == strcasecmp("SegmentTimeline", parser->stack[parser->level - 1].tag))
+			{
+				// known S, reused by dash_parser_resume_first
+				parser->skip--;
+				parser->tag = NULL;
+			}
+			else
+			{
+				r = dash_parser_ontag(parser, tag.name, tag.attr, tag.nattr);
+			}
 
 			assert(parser->level < sizeof(parser->stack) / sizeof(parser->stack[0]));
 			if (0 == (DASH_TAG_FLAG_LINBREAK & tag.flags) && parser->level < sizeof(parser->stack) / sizeof(parser->stack[0]))
@@ -1284,10 +1461,12 @@ static int dash_parser_input(struct dash_parser_t* parser, const char* data, siz
 
 	if (!ptr)
 		return -1;
-	return r;
+	return parser->resync ? -EAGAIN : r;
 }
 
-int dash_mpd_parse(struct dash_mpd_t** mpd, const char* data, size_t bytes)
+/// @param[in] prev previous mpd, NULL-parse all
+/// @param[out] segments new SegmentTimeline segments
+static int dash_mpd_load(struct dash_mpd_t** mpd, const struct dash_mpd_t* prev, const char* data, size_t bytes, uint64_t* segments)
 {
 	int r;
 	char* ptr;
@@ -1297,6 +1476,7 @@ int dash_mpd_parse(struct dash_mpd_t** mpd, const char* data, size_t bytes)
 		return -1;
 
 	memset(&parser, 0, sizeof(parser));
+	parser.prev = prev;
 	parser.mpd = (struct dash_mpd_t*)calloc(1, sizeof(struct dash_mpd_t) + bytes + 1);
 	if (!parser.mpd)
 		return -ENOMEM;
@@ -1312,9 +1492,34 @@ int dash_mpd_parse(struct dash_mpd_t** mpd, const char* data, size_t bytes)
 	}
 
 	*mpd = parser.mpd;
+	*segments = parser.segments;
 	return 0;
 }
 
+int dash_mpd_parse(struct dash_mpd_t** mpd, const char* data, size_t bytes)
+{
+	uint64_t segments;
+	return dash_mpd_load(mpd, NULL, data, bytes, &segments);
+}
+
+int dash_mpd_refresh(struct dash_mpd_t** mpd, const char* data, size_t bytes)
+{
+	int r;
+	uint64_t segments;
+	struct dash_mpd_t* p;
+
+	r = dash_mpd_load(&p, *mpd, data, bytes, &segments);
+	if (-EAGAIN == r)
+		r = dash_mpd_load(&p, NULL, data, bytes, &segments); // known S changed
+	if (0 != r)
+		return r;
+
+	if (*mpd)
+		dash_mpd_free(mpd);
+	*mpd = p;
+	return segments > INT_MAX ? INT_MAX : (int)segments;
+}
+
 static void dash_segment_free(struct dash_segment_t* segment)
 {
 	if (segment->segment_timeline.S)
@@ -1408,7 +1613,7 @@ static void dash_adaptation_set_free(struct dash_adaptation_set_t* set)
 
 	dash_segment_free(&set->segment);
 
-	for (k = 0; k < set->content_component_count; k++)
+	for (k = 0; k < set->representation_count; k++)
 	{
 		dash_representation_free(&set->representations[k]);
 	}
@@ -1534,4 +1739,120 @@ void dash_parser_test(const char* xml)
 	assert(0 == dash_mpd_parse(&mpd, data, n));
 	dash_mpd_free(&mpd);
 }
+
+static uint64_t dash_mpd_refresh_test_duration(int track, int i)
+{
+	return 0 == track ? ((i / 4) % 2 ? 2000 : 2002) : (2 == i % 3 ? 2048 : 1984);
+}
+
+/// live window segments [sequence, sequence + count)
+static size_t dash_mpd_refresh_test_mpd(char* mpd, int sequence, int count)
+{
+	int i, j, track;
+	size_t n;
+	uint64_t t;
+
+	n = sprintf(mpd, "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n<MPD xmlns=\"urn:mpeg:dash:schema:mpd:2011\" type=\"dynamic\" minimumUpdatePeriod=\"PT2S\" minBufferTime=\"PT2S\">\n<Period id=\"p0\" start=\"PT0S\">\n");
+	for (track = 0; track < 2; track++)
+	{
+		n += sprintf(mpd + n, 0 == track ? "<AdaptationSet id=\"1\" contentType=\"video\" mimeType=\"video/mp4\">\n<SegmentTemplate timescale=\"1000\" media=\"v-$Time$.m4s\" initialization=\"v-init.mp4\">\n<SegmentTimeline>\n"
+			: "<AdaptationSet id=\"2\" contentType=\"audio\" mimeType=\"audio/mp4\">\n<Representation id=\"a1\" bandwidth=\"128000\" codecs=\"mp4a.40.2\">\n<SegmentTemplate timescale=\"1000\" media=\"a-$Time$.m4s\" initialization=\"a-init.mp4\">\n<SegmentTimeline>\n");
+		for (t = 0, i = 0; i < sequence; i++)
+			t += dash_mpd_refresh_test_duration(track, i);
+		for (i = sequence; i < sequence + count; i = j)
+		{
+			for (j = i + 1; j < sequence + count && dash_mpd_refresh_test_duration(track, j) == dash_mpd_refresh_test_duration(track, i); j++)
+				;
+			// video: only the first S has @t, audio: all S have @t
+			if (i == sequence || 1 == track)
+				n += sprintf(mpd + n, "<S t=\"%llu\" d=\"%llu\"", (unsigned long long)t, (unsigned long long)dash_mpd_refresh_test_duration(track, i));
+			else
+				n += sprintf(mpd + n, "<S d=\"%llu\"", (unsigned long long)dash_mpd_refresh_test_duration(track, i));
+			n += j - i > 1 ? sprintf(mpd + n, " r=\"%d\"/>\n", j - i - 1) : sprintf(mpd + n, "/>\n");
+			t += dash_mpd_refresh_test_duration(track, i) * (j - i);
+		}
+		n += sprintf(mpd + n, 0 == track ? "</SegmentTimeline>\n</SegmentTemplate>\n<Representation id=\"v1\" bandwidth=\"2000000\" width=\"1280\" height=\"720\" codecs=\"avc1.64001f\"/>\n</AdaptationSet>\n"
+			: "</SegmentTimeline>\n</SegmentTemplate>\n</Representation>\n</AdaptationSet>\n");
+	}
+	n += sprintf(mpd + n, "</Period>\n</MPD>\n");
+	return n;
+}
+
+static void dash_mpd_refresh_test_check(const struct dash_mpd_t* mpd, const char* data, size_t bytes)
+{
+	const struct dash_segment_timeline_t* timelines[2], *timelines2[2];
+	struct dash_mpd_t* full;
+	int i;
+
+	assert(0 == dash_mpd_parse(&full, data, bytes));
+	assert(1 == mpd->period_count && 2 == mpd->periods[0].adaptation_set_count);
+	timelines[0] = &mpd->periods[0].adaptation_sets[0].segment.segment_timeline;
+	timelines[1] = &mpd->periods[0].adaptation_sets[1].representations[0].segment.segment_timeline;
+	timelines2[0] = &full->periods[0].adaptation_sets[0].segment.segment_timeline;
+	timelines2[1] = &full->periods[0].adaptation_sets[1].representations[0].segment.segment_timeline;
+	for (i = 0; i < 2; i++)
+	{
+		assert(timelines[i]->count == timelines2[i]->count && timelines[i]->count > 0);
+		assert(0 == memcmp(timelines[i]->S, timelines2[i]->S, timelines[i]->count * sizeof(timelines[i]->S[0])));
+	}
+	dash_mpd_free(&full);
+}
+
+void dash_mpd_refresh_test(void)
+{
+	const int W = 5000; // live window segments
+	const int N = 200; // reload count
+	int i, r;
+	size_t bytes;
+	char* data;
+	clock_t t0, t1, t2;
+	struct dash_mpd_t* mpd;
+
+	data = (char*)malloc(2 * W * 64 + 2048);
+	bytes = dash_mpd_refresh_test_mpd(data, 0, W);
+	t0 = clock();
+	for (i = 0; i < 20; i++)
+	{
+		assert(0 == dash_mpd_parse(&mpd, data, bytes));
+		dash_mpd_free(&mpd);
+	}
+	t1 = clock();
+	printf("dash_mpd_parse: %d segments, %.3f ms/parse\n", W, (t1 - t0) * 1000.0 / CLOCKS_PER_SEC / 20);
+
+	mpd = NULL;
+	assert(2 * W == dash_mpd_refresh(&mpd, data, bytes));
+	t2 = 0;
+	for (i = 1; i <= N; i++)
+	{
+		// one new video and audio segment per reload
+		bytes = dash_mpd_refresh_test_mpd(data, i, W);
+		t0 = clock();
+		r = dash_mpd_refresh(&mpd, data, bytes);
+		t2 += clock() - t0;
+		assert(2 == r);
+		if (i < 10)
+			dash_mpd_refresh_test_check(mpd, data, bytes);
+	}
+	printf("dash_mpd_refresh: %d segments, %.3f ms/refresh\n", W, t2 * 1000.0 / CLOCKS_PER_SEC / N);
+	dash_mpd_refresh_test_check(mpd, data, bytes);
+
+	// no reload change
+	assert(0 == dash_mpd_refresh(&mpd, data, bytes));
+	// 3 new segments, expired 2 segments
+	bytes = dash_mpd_refresh_test_mpd(data, N + 2, W + 1);
+	assert(6 == dash_mpd_refresh(&mpd, data, bytes));
+	dash_mpd_refresh_test_check(mpd, data, bytes);
+
+	// server restart: timeline rewind, parse all
+	bytes = dash_mpd_refresh_test_mpd(data, 0, 10);
+	assert(20 == dash_mpd_refresh(&mpd, data, bytes));
+	dash_mpd_refresh_test_check(mpd, data, bytes);
+	// last known S changed, parse all
+	strstr(data, "<S d=\"2002\" r=\"1\"/>")[9] = '3';
+	assert(20 == dash_mpd_refresh(&mpd, data, bytes));
+	dash_mpd_refresh_test_check(mpd, data, bytes);
+	dash_mpd_free(&mpd);
+
+	free(data);
+}
 #endif
@@ -13,7 +13,7 @@ typedef struct flv_demuxer_t flv_demuxer_t;
 /// Audio/Video Elementary Stream
 /// @param[in] param user-defined parameter
 /// @param[in] codec audio/video format (see more flv-proto.h)
-/// @param[in] data audio/video element data, AAC: ADTS + AAC-Frame, H.264: startcode + NALU, MP3-Raw data
+/// @param[in] data audio/video element data, AAC: ADTS + AAC-Frame, H.264: startcode + NALU(FLV_DEMUXER_FORMAT_MP4: NALU length + NALU), MP3-Raw data
 /// @param[in] bytes data length in byte
 /// @param[in] pts audio/video presentation timestamp
 /// @param[in] dts audio/video decoding timestamp
@@ -21,7 +21,17 @@ typedef struct flv_demuxer_t flv_demuxer_t;
 /// @return 0-ok, other-error
 typedef int (*flv_demuxer_handler)(void* param, int codec, const void* data, size_t bytes, uint32_t pts, uint32_t dts, int flags);
 
+/// H.264/H.265/H.266 output format
+enum
+{
+	FLV_DEMUXER_FORMAT_ANNEXB = 0,		// default, startcode + NALU, insert SPS/PPS before IDR if need
+	FLV_DEMUXER_FORMAT_MP4,				// NALU length + NALU(same as FLV/MP4 sample), point to input data, no copy
+};
+
 flv_demuxer_t* flv_demuxer_create(flv_demuxer_handler handler, void* param);
+
+/// @param[in] format H.264/H.265/H.266 output format, FLV_DEMUXER_FORMAT_XXX
+flv_demuxer_t* flv_demuxer_create2(flv_demuxer_handler handler, void* param, int format);
 void flv_demuxer_destroy(flv_demuxer_t* demuxer);
 
 /// Input FLV Audio/Video Stream
@@ -32,6 +42,18 @@ void flv_demuxer_destroy(flv_demuxer_t* demuxer);
 /// @return 0-ok, other-error
 int flv_demuxer_input(flv_demuxer_t* demuxer, int type, const void* data, size_t bytes, uint32_t timestamp);
 
+/// Same as flv_demuxer_input, but the H.264/H.265 Annex-B output(FLV_DEMUXER_FORMAT_ANNEXB) is made in place:
+/// 4-bytes NALU length is rewritten to startcode in the input data and the handler data point to it, no copy.
+/// Frames need insert SPS/PPS(or VPS) before IRAP, or with 1/2-bytes NALU length, are copied as flv_demuxer_input.
+/// @param[in,out] data flv audio/video Stream, the video data will be changed
+int flv_demuxer_input_inplace(flv_demuxer_t* demuxer, int type, void* data, size_t bytes, uint32_t timestamp);
+
+/// Hot-path metrics snapshot(build with -DMEDIA_METRICS), see more @media-metrics.h
+/// frames_in/bytes_in-FLV tags, frames_out/bytes_out-audio/video frames(handler), buffer_hwm-AnnexB buffer capacity
+/// @return 0-ok, -ENOSYS-metrics disabled
+struct media_metrics_t;
+int flv_demuxer_get_metrics(flv_demuxer_t* demuxer, struct media_metrics_t* metrics);
+
 #if defined(__cplusplus)
 }
 #endif
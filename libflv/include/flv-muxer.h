@@ -48,6 +48,22 @@ int flv_muxer_avc(flv_muxer_t* muxer, const void* data, size_t bytes, uint32_t p
 /// @param[in] data h.265 annexb bitstream: H.265 start code + H.265 NALU, 0x00000001...
 int flv_muxer_hevc(flv_muxer_t* muxer, const void* data, size_t bytes, uint32_t pts, uint32_t dts);
 
+enum
+{
+	FLV_MUXER_FLAG_KEYFRAME = 0x01, // IDR/IRAP frame
+	FLV_MUXER_FLAG_CONFIG = 0x02, // re-send sequence header before this frame
+};
+
+/// Set precomputed decoder configuration record, sequence header is sent before the next frame(flv_muxer_video_nalu)
+/// @param[in] codec FLV_VIDEO_H264/FLV_VIDEO_H265/FLV_VIDEO_H266
+/// @param[in] record AVCDecoderConfigurationRecord/HEVCDecoderConfigurationRecord/VVCDecoderConfigurationRecord
+int flv_muxer_video_config(flv_muxer_t* muxer, int codec, const void* record, size_t bytes);
+
+/// Fast path for encoder output: no start code scan and no SPS/PPS/VPS detect
+/// @param[in] data one or more NALUs(four-bytes length + NALU), e.g. encoder AVCC output
+/// @param[in] flags FLV_MUXER_FLAG_XXX
+int flv_muxer_video_nalu(flv_muxer_t* muxer, const void* data, size_t bytes, uint32_t pts, uint32_t dts, int flags);
+
 /// @param[in] data av1 low overhead bitstream format
 int flv_muxer_av1(flv_muxer_t* muxer, const void* data, size_t bytes, uint32_t pts, uint32_t dts);
 
@@ -73,6 +89,12 @@ struct flv_metadata_t
 
 int flv_muxer_metadata(flv_muxer_t* muxer, const struct flv_metadata_t* metadata);
 
+/// Hot-path metrics snapshot(build with -DMEDIA_METRICS), see more @media-metrics.h
+/// frames_in/bytes_in-audio/video frames, frames_out/bytes_out-FLV tags(handler), buffer_hwm-tag buffer capacity
+/// @return 0-ok, -ENOSYS-metrics disabled
+struct media_metrics_t;
+int flv_muxer_get_metrics(flv_muxer_t* muxer, struct media_metrics_t* metrics);
+
 #if defined(__cplusplus)
 }
 #endif
@@ -54,6 +54,10 @@ int mpeg4_avc_to_nalu(const struct mpeg4_avc_t* avc, uint8_t* data, size_t bytes
 
 int mpeg4_avc_codecs(const struct mpeg4_avc_t* avc, char* codecs, size_t bytes);
 
+/// Picture size of the first SPS(frame cropping applied)
+/// @return 0-ok, <0-error(no SPS or invalid SPS)
+int mpeg4_avc_get_resolution(const struct mpeg4_avc_t* avc, int* width, int* height);
+
 /// @param[out] vcl 0-non VCL, 1-IDR, 2-P/B
 /// @return <=0-error, >0-output bytes
 int h264_annexbtomp4(struct mpeg4_avc_t* avc, const void* data, size_t bytes, void* out, size_t size, int* vcl, int* update);
@@ -54,6 +54,10 @@ int mpeg4_hevc_to_nalu(const struct mpeg4_hevc_t* hevc, uint8_t* data, size_t by
 
 int mpeg4_hevc_codecs(const struct mpeg4_hevc_t* hevc, char* codecs, size_t bytes);
 
+/// Picture size of the first SPS(conformance window applied)
+/// @return 0-ok, <0-error(no SPS or invalid SPS)
+int mpeg4_hevc_get_resolution(const struct mpeg4_hevc_t* hevc, int* width, int* height);
+
 int h265_annexbtomp4(struct mpeg4_hevc_t* hevc, const void* data, size_t bytes, void* out, size_t size, int *vcl, int* update);
 
 int h265_mp4toannexb(const struct mpeg4_hevc_t* hevc, const void* data, size_t bytes, void* out, size_t size);
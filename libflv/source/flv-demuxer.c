@@ -10,6 +10,7 @@
 #include "aom-av1.h"
 #include "avswg-avs3.h"
 #include "amf0.h"
+#include "media-metrics.h"
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
@@ -35,12 +36,37 @@ struct flv_demuxer_t
 
 	flv_demuxer_handler handler;
 	void* param;
+	int format; // FLV_DEMUXER_FORMAT_XXX
 
 	uint8_t* ptr;
 	int capacity;
+
+#if defined(MEDIA_METRICS)
+	struct media_metrics_t metrics;
+	flv_demuxer_handler onpacket; // user callback
+	void* cbparam;
+#endif
 };
 
+#if defined(MEDIA_METRICS)
+static int flv_demuxer_handler_metrics(void* param, int codec, const void* data, size_t bytes, uint32_t pts, uint32_t dts, int flags)
+{
+	int r;
+	struct flv_demuxer_t* flv;
+	flv = (struct flv_demuxer_t*)param;
+	MEDIA_METRICS_ADD(&flv->metrics, frames_out, 1);
+	MEDIA_METRICS_ADD(&flv->metrics, bytes_out, bytes);
+	MEDIA_METRICS_CALL(&flv->metrics, r, flv->onpacket(flv->cbparam, codec, data, bytes, pts, dts, flags));
+	return r;
+}
+#endif
+
 struct flv_demuxer_t* flv_demuxer_create(flv_demuxer_handler handler, void* param)
+{
+	return flv_demuxer_create2(handler, param, FLV_DEMUXER_FORMAT_ANNEXB);
+}
+
+struct flv_demuxer_t* flv_demuxer_create2(flv_demuxer_handler handler, void* param, int format)
 {
 	struct flv_demuxer_t* flv;
 	flv = (struct flv_demuxer_t*)malloc(sizeof(struct flv_demuxer_t));
@@ -50,6 +76,13 @@ struct flv_demuxer_t* flv_demuxer_create(flv_demuxer_handler handler, void* para
 	memset(flv, 0, sizeof(struct flv_demuxer_t));
 	flv->handler = handler;
 	flv->param = param;
+	flv->format = format;
+#if defined(MEDIA_METRICS)
+	flv->onpacket = handler;
+	flv->cbparam = param;
+	flv->handler = flv_demuxer_handler_metrics;
+	flv->param = flv;
+#endif
 	return flv;
 }
 
@@ -73,6 +106,53 @@ static int flv_demuxer_check_and_alloc(struct flv_demuxer_t* flv, int bytes)
 			return -1;
 		flv->ptr = (uint8_t*)p;
 		flv->capacity = bytes;
+		MEDIA_METRICS_ADD(&flv->metrics, allocs, 1);
+		MEDIA_METRICS_MAX(&flv->metrics, buffer_hwm, bytes);
+	}
+	return 0;
+}
+
+/// rewrite 4-bytes NALU length to startcode(00 00 00 01)
+/// @return 0-ok, <0-can't in place(need insert parameter sets or invalid NALU length), data don't be changed
+static int flv_demuxer_annexb_inplace(int codec, uint8_t* data, int bytes)
+{
+	int n, type, ps, irap;
+	uint8_t *p, *end;
+
+	// 1. check only, don't modify data
+	ps = 0;
+	end = data + bytes;
+	for (p = data; p + 4 < end; p += n + 4)
+	{
+		n = (int)(((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3]);
+		if (n <= 1 || n > end - p - 4)
+			return -1; // invalid length or 0x00000001 startcode(h264_mp4toannexb fix)
+
+		if (FLV_VIDEO_H264 == codec)
+		{
+			type = p[4] & 0x1f;
+			ps |= (7 == type || 8 == type) ? 1 : 0; // SPS/PPS
+			irap = 5 == type ? 1 : 0; // IDR
+		}
+		else
+		{
+			type = (p[4] >> 1) & 0x3f;
+			ps |= (32 <= type && type <= 34) ? 1 : 0; // VPS/SPS/PPS
+			irap = (16 <= type && type <= 23) ? 1 : 0; // BLA_W_LP ~ RSV_IRAP
+		}
+
+		if (irap && !ps)
+			return -1; // need insert parameter sets
+	}
+
+	if (p != end)
+		return -1;
+
+	// 2. NALU length -> startcode
+	for (p = data; p < end; p += n + 4)
+	{
+		n = (int)(((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3]);
+		p[0] = 0; p[1] = 0; p[2] = 0; p[3] = 1;
 	}
 	return 0;
 }
@@ -152,7 +232,8 @@ static int flv_demuxer_audio(struct flv_demuxer_t* flv, const uint8_t* data, int
 	return 0;
 }
 
-static int flv_demuxer_video(struct flv_demuxer_t* flv, const uint8_t* data, int bytes, uint32_t timestamp)
+/// @param[in] inplace writable input data(flv_demuxer_input_inplace), NULL-read only
+static int flv_demuxer_video(struct flv_demuxer_t* flv, const uint8_t* data, uint8_t* inplace, int bytes, uint32_t timestamp)
 {
 	int n;
 	struct flv_video_tag_header_t video;
@@ -176,6 +257,10 @@ static int flv_demuxer_video(struct flv_demuxer_t* flv, const uint8_t* data, int
 			//if (flv->v.avc.nalu > 0 && bytes > n) // 5 ==  bytes flv eof
 			{
 				// H.264
+				if (FLV_DEMUXER_FORMAT_MP4 == flv->format
+					|| (inplace && 4 == flv->v.avc.nalu && 0 == flv_demuxer_annexb_inplace(FLV_VIDEO_H264, inplace + n, bytes - n)))
+					return flv->handler(flv->param, FLV_VIDEO_H264, data + n, bytes - n, timestamp + video.cts, timestamp, (FLV_VIDEO_KEY_FRAME == video.keyframe) ? 1 : 0);
+
 				if (0 != flv_demuxer_check_and_alloc(flv, bytes + 4 * 1024))
 					return -ENOMEM;
 
@@ -217,6 +302,10 @@ static int flv_demuxer_video(struct flv_demuxer_t* flv, const uint8_t* data, int
 			//if (flv->v.hevc.numOfArrays > 0 && bytes > n) // 5 ==  bytes flv eof
 			{
 				// H.265
+				if (FLV_DEMUXER_FORMAT_MP4 == flv->format
+					|| (inplace && 3 == flv->v.hevc.lengthSizeMinusOne && 0 == flv_demuxer_annexb_inplace(FLV_VIDEO_H265, inplace + n, bytes - n)))
+					return flv->handler(flv->param, FLV_VIDEO_H265, data + n, bytes - n, timestamp + video.cts, timestamp, (FLV_VIDEO_KEY_FRAME == video.keyframe) ? 1 : 0);
+
 				if (0 != flv_demuxer_check_and_alloc(flv, bytes + 4 * 1024))
 					return -ENOMEM;
 
@@ -256,6 +345,9 @@ static int flv_demuxer_video(struct flv_demuxer_t* flv, const uint8_t* data, int
 			//if (flv->v.vvc.numOfArrays > 0 && bytes > n) // 5 ==  bytes flv eof
 			{
 				// H.266
+				if (FLV_DEMUXER_FORMAT_MP4 == flv->format)
+					return flv->handler(flv->param, FLV_VIDEO_H266, data + n, bytes - n, timestamp + video.cts, timestamp, (FLV_VIDEO_KEY_FRAME == video.keyframe) ? 1 : 0);
+
 				if (0 != flv_demuxer_check_and_alloc(flv, bytes + 4 * 1024))
 					return -ENOMEM;
 
@@ -333,29 +425,123 @@ static int flv_demuxer_video(struct flv_demuxer_t* flv, const uint8_t* data, int
 }
 
 int flv_demuxer_script(struct flv_demuxer_t* flv, const uint8_t* data, size_t bytes);
-int flv_demuxer_input(struct flv_demuxer_t* flv, int type, const void* data, size_t bytes, uint32_t timestamp)
+static int flv_demuxer_input2(struct flv_demuxer_t* flv, int type, const void* data, uint8_t* inplace, size_t bytes, uint32_t timestamp)
 {
-	int n;
+	int n, r;
 	if (bytes < 1)
 		return 0;
 
+	MEDIA_METRICS_ADD(&flv->metrics, frames_in, 1);
+	MEDIA_METRICS_ADD(&flv->metrics, bytes_in, bytes);
+
 	switch (type)
 	{
 	case FLV_TYPE_AUDIO:
-		return flv_demuxer_audio(flv, data, (int)bytes, timestamp);
+		r = flv_demuxer_audio(flv, data, (int)bytes, timestamp);
+		break;
 
 	case FLV_TYPE_VIDEO:
-		return flv_demuxer_video(flv, data, (int)bytes, timestamp);
+		r = flv_demuxer_video(flv, data, inplace, (int)bytes, timestamp);
+		break;
 
 	case FLV_TYPE_SCRIPT:
 		n = flv_demuxer_script(flv, data, bytes);
 		if (n < 12)
 			return 0; // ignore
 		n -= 12; // 2-LEN + 10-onMetaData
-		return flv->handler(flv->param, FLV_SCRIPT_METADATA, (const uint8_t*)data + n, bytes - n, timestamp, timestamp, 0);
+		r = flv->handler(flv->param, FLV_SCRIPT_METADATA, (const uint8_t*)data + n, bytes - n, timestamp, timestamp, 0);
+		break;
 		
 	default:
 		assert(0);
-		return -1;
+		r = -1;
+	}
+
+	if (0 != r)
+		MEDIA_METRICS_ADD(&flv->metrics, errors, 1);
+	return r;
+}
+
+int flv_demuxer_input(struct flv_demuxer_t* flv, int type, const void* data, size_t bytes, uint32_t timestamp)
+{
+	return flv_demuxer_input2(flv, type, data, NULL, bytes, timestamp);
+}
+
+int flv_demuxer_input_inplace(struct flv_demuxer_t* flv, int type, void* data, size_t bytes, uint32_t timestamp)
+{
+	// in place for the Annex-B output only
+	return flv_demuxer_input2(flv, type, data, FLV_DEMUXER_FORMAT_ANNEXB == flv->format ? (uint8_t*)data : NULL, bytes, timestamp);
+}
+
+int flv_demuxer_get_metrics(struct flv_demuxer_t* flv, struct media_metrics_t* metrics)
+{
+#if defined(MEDIA_METRICS)
+	media_metrics_snapshot(metrics, &flv->metrics);
+	return 0;
+#else
+	(void)flv;
+	memset(metrics, 0, sizeof(*metrics));
+	return -ENOSYS;
+#endif
+}
+
+#if defined(DEBUG) || defined(_DEBUG)
+struct flv_demuxer_test_t
+{
+	const void* data;
+	size_t bytes;
+};
+
+static int flv_demuxer_test_onpacket(void* param, int codec, const void* data, size_t bytes, uint32_t pts, uint32_t dts, int flags)
+{
+	struct flv_demuxer_test_t* t;
+	t = (struct flv_demuxer_test_t*)param;
+	if (FLV_VIDEO_H264 == codec)
+	{
+		t->data = data;
+		t->bytes = bytes;
 	}
+	(void)pts, (void)dts, (void)flags;
+	return 0;
+}
+
+void flv_demuxer_test(void)
+{
+	const uint8_t avcc[] = {
+		0x17, 0x00, 0x00, 0x00, 0x00,
+		0x01, 0x42, 0xe0, 0x1e, 0xff, 0xe1, 0x00, 0x21, 0x67, 0x42, 0xe0, 0x1e, 0xab, 0x40, 0xf0, 0x28,
+		0xd0, 0x80, 0x00, 0x00, 0x00, 0x80, 0x00, 0x00, 0x19, 0x70, 0x20, 0x00, 0x78, 0x00, 0x00, 0x0f,
+		0x00, 0x16, 0xb1, 0xb0, 0x3c, 0x50, 0xaa, 0x80, 0x80, 0x01, 0x00, 0x04, 0x28, 0xce, 0x3c, 0x80,
+	};
+	const uint8_t idr[] = { 0x17, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x04, 0x65, 0x88, 0x84, 0x01 };
+	const uint8_t slice[] = { 0x27, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x41, 0x9a, 0x00, 0x00, 0x00, 0x02, 0x41, 0x9b };
+	const uint8_t annexb[] = { 0x00, 0x00, 0x00, 0x01, 0x41, 0x9a, 0x00, 0x00, 0x00, 0x01, 0x41, 0x9b };
+
+	uint8_t frame[sizeof(slice)];
+	struct flv_demuxer_t* flv;
+	struct flv_demuxer_test_t t;
+
+	// passthrough
+	flv = flv_demuxer_create2(flv_demuxer_test_onpacket, &t, FLV_DEMUXER_FORMAT_MP4);
+	assert(0 == flv_demuxer_input(flv, FLV_TYPE_VIDEO, avcc, sizeof(avcc), 0));
+	assert(0 == flv_demuxer_input(flv, FLV_TYPE_VIDEO, slice, sizeof(slice), 40));
+	assert(t.data == slice + 5 && t.bytes == sizeof(slice) - 5);
+	flv_demuxer_destroy(flv);
+
+	// in place
+	flv = flv_demuxer_create(flv_demuxer_test_onpacket, &t);
+	assert(0 == flv_demuxer_input(flv, FLV_TYPE_VIDEO, avcc, sizeof(avcc), 0));
+	memcpy(frame, slice, sizeof(slice));
+	assert(0 == flv_demuxer_input_inplace(flv, FLV_TYPE_VIDEO, frame, sizeof(frame), 40));
+	assert(t.data == frame + 5 && t.bytes == sizeof(annexb) && 0 == memcmp(t.data, annexb, sizeof(annexb)));
+
+	// read only input: copy, the input data isn't changed
+	assert(0 == flv_demuxer_input(flv, FLV_TYPE_VIDEO, slice, sizeof(slice), 40));
+	assert(t.data != slice + 5 && t.bytes == sizeof(annexb) && 0 == memcmp(t.data, annexb, sizeof(annexb)));
+
+	// IDR without SPS/PPS: copy and insert SPS/PPS
+	assert(0 == flv_demuxer_input(flv, FLV_TYPE_VIDEO, idr, sizeof(idr), 80));
+	assert(t.data != idr + 5 && t.bytes == 4 + 0x21 + 4 + 4 + 4 + 4);
+	flv_demuxer_destroy(flv);
 }
+#endif
@@ -16,9 +16,12 @@
 #include "avswg-avs3.h"
 #include "mp3-header.h"
 #include "opus-head.h"
+#include "media-metrics.h"
 
 #define FLV_MUXER "ireader/media-server"
 
+#define FLV_MUXER_INPUT(flv, bytes) do { MEDIA_METRICS_ADD(&(flv)->metrics, frames_in, 1); MEDIA_METRICS_ADD(&(flv)->metrics, bytes_in, bytes); } while (0)
+
 struct flv_muxer_t
 {
 	flv_muxer_handler handler;
@@ -46,11 +49,37 @@ struct flv_muxer_t
 	int vcl; // 0-non vcl, 1-idr, 2-p/b
 	int update; // avc/hevc sequence header update
 
+	// precomputed decoder configuration record(flv_muxer_video_config)
+	int config_codec;
+	uint8_t* config;
+	size_t config_bytes;
+
 	uint8_t* ptr;
 	size_t bytes;
 	size_t capacity;
+
+#if defined(MEDIA_METRICS)
+	struct media_metrics_t metrics;
+	flv_muxer_handler onflv; // user callback
+	void* cbparam;
+#endif
 };
 
+#if defined(MEDIA_METRICS)
+static int flv_muxer_handler_metrics(void* param, int type, const void* data, size_t bytes, uint32_t timestamp)
+{
+	int r;
+	struct flv_muxer_t* flv;
+	flv = (struct flv_muxer_t*)param;
+	MEDIA_METRICS_ADD(&flv->metrics, frames_out, 1);
+	MEDIA_METRICS_ADD(&flv->metrics, bytes_out, bytes);
+	MEDIA_METRICS_CALL(&flv->metrics, r, flv->onflv(flv->cbparam, type, data, bytes, timestamp));
+	if (0 != r)
+		MEDIA_METRICS_ADD(&flv->metrics, errors, 1);
+	return r;
+}
+#endif
+
 struct flv_muxer_t* flv_muxer_create(flv_muxer_handler handler, void* param)
 {
 	struct flv_muxer_t* flv;
@@ -61,6 +90,12 @@ struct flv_muxer_t* flv_muxer_create(flv_muxer_handler handler, void* param)
 	flv_muxer_reset(flv);
 	flv->handler = handler;
 	flv->param = param;
+#if defined(MEDIA_METRICS)
+	flv->onflv = handler;
+	flv->cbparam = param;
+	flv->handler = flv_muxer_handler_metrics;
+	flv->param = flv;
+#endif
 #ifdef FLV_ENHANCE_RTMP
 	flv->enhanced_rtmp = 1;
 #endif
@@ -76,6 +111,12 @@ void flv_muxer_destroy(struct flv_muxer_t* flv)
 		flv->ptr = NULL;
 	}
 
+	if (flv->config)
+	{
+		free(flv->config);
+		flv->config = NULL;
+	}
+
 	free(flv);
 }
 
@@ -101,6 +142,8 @@ static int flv_muxer_alloc(struct flv_muxer_t* flv, size_t bytes)
 
 	flv->ptr = (uint8_t*)p;
 	flv->capacity = bytes;
+	MEDIA_METRICS_ADD(&flv->metrics, allocs, 1);
+	MEDIA_METRICS_MAX(&flv->metrics, buffer_hwm, bytes);
 	return 0;
 }
 
@@ -109,6 +152,7 @@ int flv_muxer_g711a(struct flv_muxer_t* flv, const void* data, size_t bytes, uin
 	struct flv_audio_tag_header_t audio;
 	(void)pts;
 
+	FLV_MUXER_INPUT(flv, bytes);
 	if (flv->capacity < bytes + 1)
 	{
 		if (0 != flv_muxer_alloc(flv, bytes + 4))
@@ -130,6 +174,7 @@ int flv_muxer_g711u(struct flv_muxer_t* flv, const void* data, size_t bytes, uin
 	struct flv_audio_tag_header_t audio;
 	(void)pts;
 
+	FLV_MUXER_INPUT(flv, bytes);
 	if (flv->capacity < bytes + 1)
 	{
 		if (0 != flv_muxer_alloc(flv, bytes + 4))
@@ -152,6 +197,7 @@ int flv_muxer_mp3(struct flv_muxer_t* flv, const void* data, size_t bytes, uint3
 	struct flv_audio_tag_header_t audio;
 	(void)pts;
 
+	FLV_MUXER_INPUT(flv, bytes);
 	if (0 == mp3_header_load(&mp3, data, (int)bytes))
 	{
 		return -EINVAL;
@@ -189,6 +235,7 @@ int flv_muxer_aac(struct flv_muxer_t* flv, const void* data, size_t bytes, uint3
 	struct flv_audio_tag_header_t audio;
 	(void)pts;
 
+	FLV_MUXER_INPUT(flv, bytes);
 	if (flv->capacity < bytes + 5 /*AudioTagHeader*/ + 8 /*AudioSpecificConfig*/)
 	{
 		if (0 != flv_muxer_alloc(flv, bytes + 5 + 8))
@@ -231,6 +278,7 @@ int flv_muxer_opus(flv_muxer_t* flv, const void* data, size_t bytes, uint32_t pt
 	struct flv_audio_tag_header_t audio;
 	(void)pts;
 
+	FLV_MUXER_INPUT(flv, bytes);
 	if (flv->capacity < bytes + 2/*AudioTagHeader*/ + 29/*OpusHead*/)
 	{
 		if (0 != flv_muxer_alloc(flv, bytes + 4))
@@ -272,6 +320,7 @@ int flv_muxer_ac3(struct flv_muxer_t* flv, const void* data, size_t bytes, uint3
 	struct flv_audio_tag_header_t audio;
 	(void)pts;
 
+	FLV_MUXER_INPUT(flv, bytes);
 	if (flv->capacity < bytes + 5 /*enhanced*/)
 	{
 		if (0 != flv_muxer_alloc(flv, bytes + 5))
@@ -291,6 +340,7 @@ int flv_muxer_eac3(struct flv_muxer_t* flv, const void* data, size_t bytes, uint
 	struct flv_audio_tag_header_t audio;
 	(void)pts;
 
+	FLV_MUXER_INPUT(flv, bytes);
 	if (flv->capacity < bytes + 5 /*enhanced*/)
 	{
 		if (0 != flv_muxer_alloc(flv, bytes + 5))
@@ -343,6 +393,7 @@ static int flv_muxer_h264(struct flv_muxer_t* flv, uint32_t pts, uint32_t dts)
 
 int flv_muxer_avc(struct flv_muxer_t* flv, const void* data, size_t bytes, uint32_t pts, uint32_t dts)
 {
+	FLV_MUXER_INPUT(flv, bytes);
 	if (flv->capacity < bytes + 5 + sizeof(flv->v.avc) /*AVCDecoderConfigurationRecord*/)
 	{
 		if (0 != flv_muxer_alloc(flv, bytes + 5 + sizeof(flv->v.avc)))
@@ -396,6 +447,7 @@ static int flv_muxer_h265(struct flv_muxer_t* flv, uint32_t pts, uint32_t dts)
 
 int flv_muxer_hevc(struct flv_muxer_t* flv, const void* data, size_t bytes, uint32_t pts, uint32_t dts)
 {
+	FLV_MUXER_INPUT(flv, bytes);
 	if ((size_t)flv->capacity < bytes + 8 /*enhanced*/ + sizeof(flv->v.hevc) /*HEVCDecoderConfigurationRecord*/)
 	{
 		if (0 != flv_muxer_alloc(flv, bytes + 8 + sizeof(flv->v.hevc)))
@@ -449,6 +501,7 @@ static int flv_muxer_h266(struct flv_muxer_t* flv, uint32_t pts, uint32_t dts)
 
 int flv_muxer_vvc(struct flv_muxer_t* flv, const void* data, size_t bytes, uint32_t pts, uint32_t dts)
 {
+	FLV_MUXER_INPUT(flv, bytes);
 	if ((size_t)flv->capacity < bytes + 8 /*enhanced*/ + sizeof(flv->v.vvc) /*HEVCDecoderConfigurationRecord*/)
 	{
 		if (0 != flv_muxer_alloc(flv, bytes + 8 + sizeof(flv->v.vvc)))
@@ -463,12 +516,77 @@ int flv_muxer_vvc(struct flv_muxer_t* flv, const void* data, size_t bytes, uint3
 	return flv_muxer_h266(flv, pts, dts);
 }
 
+int flv_muxer_video_config(flv_muxer_t* flv, int codec, const void* record, size_t bytes)
+{
+	void* p;
+	if (FLV_VIDEO_H264 != codec && FLV_VIDEO_H265 != codec && FLV_VIDEO_H266 != codec)
+		return -EINVAL;
+
+	if (bytes > flv->config_bytes || !flv->config)
+	{
+		p = realloc(flv->config, bytes);
+		if (!p)
+			return -ENOMEM;
+		flv->config = (uint8_t*)p;
+	}
+
+	memcpy(flv->config, record, bytes);
+	flv->config_bytes = bytes;
+	flv->config_codec = codec;
+	flv->video_sequence_header = 0; // send on next frame
+	return 0;
+}
+
+int flv_muxer_video_nalu(flv_muxer_t* flv, const void* data, size_t bytes, uint32_t pts, uint32_t dts, int flags)
+{
+	int r, n;
+	struct flv_video_tag_header_t video;
+
+	FLV_MUXER_INPUT(flv, bytes);
+	if (!flv->config || flv->config_bytes < 1)
+		return -EINVAL; // flv_muxer_video_config first
+
+	if (flv->capacity < bytes + 8 /*enhanced*/ || flv->capacity < flv->config_bytes + 8)
+	{
+		if (0 != flv_muxer_alloc(flv, (bytes > flv->config_bytes ? bytes : flv->config_bytes) + 8))
+			return -ENOMEM;
+	}
+
+	video.codecid = (uint8_t)flv->config_codec;
+	video.enhanced_rtmp = flv->enhanced_rtmp;
+	if (0 == flv->video_sequence_header || (FLV_MUXER_FLAG_CONFIG & flags))
+	{
+		video.cts = 0;
+		video.keyframe = 1; // keyframe
+		video.avpacket = FLV_SEQUENCE_HEADER;
+		n = flv_video_tag_header_write(&video, flv->ptr, flv->capacity);
+		if (n < 0)
+			return -1;
+
+		memcpy(flv->ptr + n, flv->config, flv->config_bytes);
+		flv->video_sequence_header = 1;
+		r = flv->handler(flv->param, FLV_TYPE_VIDEO, flv->ptr, n + flv->config_bytes, dts);
+		if (0 != r) return r;
+	}
+
+	// NALUs are copied as-is, no start code scan and no parameter set detect
+	video.cts = pts - dts;
+	video.keyframe = (FLV_MUXER_FLAG_KEYFRAME & flags) ? FLV_VIDEO_KEY_FRAME : FLV_VIDEO_INTER_FRAME;
+	video.avpacket = FLV_AVPACKET;
+	n = flv_video_tag_header_write(&video, flv->ptr, flv->capacity);
+	if (n < 0)
+		return -1;
+	memcpy(flv->ptr + n, data, bytes);
+	return flv->handler(flv->param, FLV_TYPE_VIDEO, flv->ptr, n + bytes, dts);
+}
+
 int flv_muxer_av1(flv_muxer_t* flv, const void* data, size_t bytes, uint32_t pts, uint32_t dts)
 {
 	int r;
 	int m, n;
 	struct flv_video_tag_header_t video;
 
+	FLV_MUXER_INPUT(flv, bytes);
 	if ((size_t)flv->capacity < bytes + 8 /*enhanced*/ + sizeof(flv->v.av1) /*HEVCDecoderConfigurationRecord*/)
 	{
 		if (0 != flv_muxer_alloc(flv, bytes + 8 + sizeof(flv->v.av1)))
@@ -520,6 +638,7 @@ int flv_muxer_avs3(flv_muxer_t* flv, const void* data, size_t bytes, uint32_t pt
 	int m, n;
 	struct flv_video_tag_header_t video;
 
+	FLV_MUXER_INPUT(flv, bytes);
 	if ((size_t)flv->capacity < bytes + 8 + sizeof(flv->v.avs3) /*AVS3DecoderConfigurationRecord*/)
 	{
 		if (0 != flv_muxer_alloc(flv, bytes + 8 + sizeof(flv->v.avs3)))
@@ -620,3 +739,147 @@ int flv_muxer_metadata(flv_muxer_t* flv, const struct flv_metadata_t* metadata)
 
 	return flv->handler(flv->param, FLV_TYPE_SCRIPT, flv->ptr, ptr - flv->ptr, 0);
 }
+
+int flv_muxer_get_metrics(flv_muxer_t* flv, struct media_metrics_t* metrics)
+{
+#if defined(MEDIA_METRICS)
+	media_metrics_snapshot(metrics, &flv->metrics);
+	return 0;
+#else
+	(void)flv;
+	memset(metrics, 0, sizeof(*metrics));
+	return -ENOSYS;
+#endif
+}
+
+#if defined(_DEBUG) || defined(DEBUG)
+#include <time.h>
+struct flv_muxer_test_t
+{
+	uint8_t config[64];
+	size_t config_bytes;
+	uint32_t hash;
+	int tags;
+};
+
+static int flv_muxer_test_onflv(void* param, int type, const void* data, size_t bytes, uint32_t timestamp)
+{
+	size_t i;
+	struct flv_muxer_test_t* t;
+	t = (struct flv_muxer_test_t*)param;
+	assert(FLV_TYPE_VIDEO == type);
+	if (0 == t->config_bytes && FLV_SEQUENCE_HEADER == ((const uint8_t*)data)[1])
+	{
+		assert(bytes - 5 <= sizeof(t->config));
+		memcpy(t->config, (const uint8_t*)data + 5, bytes - 5);
+		t->config_bytes = bytes - 5;
+	}
+
+	// FNV-1a
+	for (i = 0; i < bytes; i++)
+		t->hash = (t->hash ^ ((const uint8_t*)data)[i]) * 16777619;
+	t->hash = (t->hash ^ timestamp) * 16777619;
+	t->tags++;
+	return 0;
+}
+
+static int flv_muxer_test_onnull(void* param, int type, const void* data, size_t bytes, uint32_t timestamp)
+{
+	(void)param, (void)type, (void)data, (void)bytes, (void)timestamp;
+	return 0;
+}
+
+static size_t flv_muxer_test_nalu(uint8_t* ptr, const uint8_t* nalu, size_t bytes, int annexb)
+{
+	if (annexb)
+	{
+		ptr[0] = 0; ptr[1] = 0; ptr[2] = 0; ptr[3] = 1;
+	}
+	else
+	{
+		ptr[0] = (uint8_t)(bytes >> 24); ptr[1] = (uint8_t)(bytes >> 16); ptr[2] = (uint8_t)(bytes >> 8); ptr[3] = (uint8_t)bytes;
+	}
+	memcpy(ptr + 4, nalu, bytes);
+	return bytes + 4;
+}
+
+/// 4K60 H.264: IDR 400KB, P 80KB, GOP 2s
+static size_t flv_muxer_test_frame(uint8_t* ptr, uint8_t* slice, int i, int annexb)
+{
+	static const uint8_t sps[] = { 0x67, 0x64, 0x00, 0x33, 0xac, 0xb4, 0x00, 0xf0, 0x00, 0x87, 0xd0, 0x80 };
+	static const uint8_t pps[] = { 0x68, 0xee, 0x3c, 0xb0 };
+	size_t n;
+
+	n = 0;
+	if (0 == i % 120)
+	{
+		n += flv_muxer_test_nalu(ptr + n, sps, sizeof(sps), annexb);
+		n += flv_muxer_test_nalu(ptr + n, pps, sizeof(pps), annexb);
+	}
+
+	slice[0] = (0 == i % 120) ? 0x65 : 0x41; // IDR/non-IDR slice
+	n += flv_muxer_test_nalu(ptr + n, slice, (0 == i % 120) ? 400 * 1024 : 80 * 1024, annexb);
+	return n;
+}
+
+void flv_muxer_test(void)
+{
+	int i, j;
+	size_t n;
+	clock_t t0, t1, t2;
+	uint8_t* slice, *frame;
+	flv_muxer_t* muxer;
+	struct flv_muxer_test_t annexb, nalu;
+
+	slice = (uint8_t*)malloc(400 * 1024);
+	frame = (uint8_t*)malloc(401 * 1024);
+	for (i = 0; i < 400 * 1024; i++)
+		slice[i] = (uint8_t)(rand() % 255 + 1); // no emulation prevention/start code
+
+	// same output: sequence header + frames
+	memset(&annexb, 0, sizeof(annexb));
+	muxer = flv_muxer_create(flv_muxer_test_onflv, &annexb);
+	for (i = 0; i < 240; i++)
+	{
+		n = flv_muxer_test_frame(frame, slice, i, 1);
+		assert(0 == flv_muxer_avc(muxer, frame, n, i * 1000 / 60 + 20, i * 1000 / 60));
+	}
+	flv_muxer_destroy(muxer);
+
+	memset(&nalu, 0, sizeof(nalu));
+	muxer = flv_muxer_create(flv_muxer_test_onflv, &nalu);
+	assert(0 != flv_muxer_video_nalu(muxer, frame, n, 0, 0, 0)); // no config
+	assert(0 == flv_muxer_video_config(muxer, FLV_VIDEO_H264, annexb.config, annexb.config_bytes));
+	for (i = 0; i < 240; i++)
+	{
+		n = flv_muxer_test_frame(frame, slice, i, 0);
+		assert(0 == flv_muxer_video_nalu(muxer, frame, n, i * 1000 / 60 + 20, i * 1000 / 60, (0 == i % 120) ? FLV_MUXER_FLAG_KEYFRAME : 0));
+	}
+	flv_muxer_destroy(muxer);
+	assert(annexb.tags == nalu.tags && annexb.hash == nalu.hash);
+
+	// benchmark, exclude frame generation
+	t1 = t2 = 0;
+	for (j = 0; j < 2; j++)
+	{
+		muxer = flv_muxer_create(flv_muxer_test_onnull, NULL);
+		if (1 == j)
+			flv_muxer_video_config(muxer, FLV_VIDEO_H264, annexb.config, annexb.config_bytes);
+		for (i = 0; i < 600; i++)
+		{
+			n = flv_muxer_test_frame(frame, slice, i, 0 == j ? 1 : 0);
+			t0 = clock();
+			if (0 == j)
+				flv_muxer_avc(muxer, frame, n, i * 1000 / 60, i * 1000 / 60);
+			else
+				flv_muxer_video_nalu(muxer, frame, n, i * 1000 / 60, i * 1000 / 60, (0 == i % 120) ? FLV_MUXER_FLAG_KEYFRAME : 0);
+			*(0 == j ? &t1 : &t2) += clock() - t0;
+		}
+		flv_muxer_destroy(muxer);
+	}
+	printf("flv_muxer 4K60 600 frames: annexb %.2f ms, nalu %.2f ms\n", t1 * 1000.0 / CLOCKS_PER_SEC, t2 * 1000.0 / CLOCKS_PER_SEC);
+
+	free(slice);
+	free(frame);
+}
+#endif
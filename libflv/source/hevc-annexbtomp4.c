@@ -29,9 +29,9 @@ struct h265_annexbtomp4_handle_t
 	size_t capacity;
 };
 
-uint8_t mpeg4_h264_read_ue(const uint8_t* data, size_t bytes, size_t* offset);
+uint32_t mpeg4_h264_read_ue(const uint8_t* data, size_t bytes, size_t* offset);
 
-static size_t hevc_rbsp_decode(const uint8_t* nalu, size_t bytes, uint8_t* sodb, size_t len)
+size_t hevc_rbsp_decode(const uint8_t* nalu, size_t bytes, uint8_t* sodb, size_t len)
 {
 	size_t i, j;
 	const size_t max_sps_luma_bit_depth_offset = 256;
@@ -161,9 +161,10 @@ int mpeg4_h264_annexb_nalu(const void* h264, size_t bytes, void (*handler)(void*
 	return 0;
 }
 
-uint8_t mpeg4_h264_read_ue(const uint8_t* data, size_t bytes, size_t* offset)
+uint32_t mpeg4_h264_read_ue(const uint8_t* data, size_t bytes, size_t* offset)
 {
-	int bit, i;
+	int i;
+	uint32_t bit;
 	int leadingZeroBits = -1;
 
 	for (bit = 0; !bit && *offset / 8 < bytes; ++leadingZeroBits)
@@ -180,7 +181,7 @@ uint8_t mpeg4_h264_read_ue(const uint8_t* data, size_t bytes, size_t* offset)
 		++*offset;
 	}
 
-	return (uint8_t)((1 << leadingZeroBits) - 1 + bit);
+	return (uint32_t)((1ULL << leadingZeroBits) - 1 + bit);
 }
 
 static void mpeg4_avc_remove(struct mpeg4_avc_t* avc, uint8_t* ptr, size_t bytes, const uint8_t* end)
@@ -1,4 +1,5 @@
 #include "mpeg4-avc.h"
+#include "mpeg4-bits.h"
 #include <stdio.h>
 #include <string.h>
 #include <assert.h>
@@ -232,6 +233,111 @@ int mpeg4_avc_codecs(const struct mpeg4_avc_t* avc, char* codecs, size_t bytes)
     return snprintf(codecs, bytes, "avc1.%02x%02x%02x", avc->profile, avc->compatibility, avc->level);
 }
 
+
+uint32_t mpeg4_h264_read_ue(const uint8_t* data, size_t bytes, size_t* offset);
+size_t hevc_rbsp_decode(const uint8_t* nalu, size_t bytes, uint8_t* sodb, size_t len);
+
+static int32_t mpeg4_h264_read_se(const uint8_t* data, size_t bytes, size_t* offset)
+{
+	uint32_t v;
+	v = mpeg4_h264_read_ue(data, bytes, offset);
+	return (v & 0x01) ? (int32_t)((v + 1) / 2) : -(int32_t)(v / 2);
+}
+
+static void mpeg4_avc_scaling_list_skip(struct mpeg4_bits_t* bits, int size)
+{
+	int i, last, next;
+	for (last = next = 8, i = 0; i < size && bits->bits < bits->size * 8; i++)
+	{
+		if (0 != next)
+			next = (last + mpeg4_h264_read_se(bits->data, bits->size, &bits->bits) + 256) % 256;
+		last = 0 == next ? last : next;
+	}
+}
+
+int mpeg4_avc_get_resolution(const struct mpeg4_avc_t* avc, int* width, int* height)
+{
+	// ITU-T H.264 7.3.2.1.1 Sequence parameter set data syntax
+	int i;
+	uint8_t profile_idc;
+	uint8_t sodb[256];
+	uint32_t chroma_format_idc, pic_order_cnt_type, frame_mbs_only_flag;
+	uint32_t pic_width_in_mbs_minus1, pic_height_in_map_units_minus1;
+	uint32_t crop[4]; // frame_crop_left/right/top/bottom_offset
+	uint32_t n, sub_width, sub_height;
+	struct mpeg4_bits_t bits;
+
+	if (avc->nb_sps < 1 || avc->sps[0].bytes < 4)
+		return -1;
+
+	mpeg4_bits_init(&bits, sodb, hevc_rbsp_decode(avc->sps[0].data, avc->sps[0].bytes, sodb, sizeof(sodb)));
+	mpeg4_bits_skip(&bits, 8); // nal_unit_header
+	profile_idc = mpeg4_bits_read_uint8(&bits, 8);
+	mpeg4_bits_skip(&bits, 16); // constraint_set_flags + level_idc
+	mpeg4_h264_read_ue(bits.data, bits.size, &bits.bits); // seq_parameter_set_id
+
+	chroma_format_idc = 1;
+	if (100 == profile_idc || 110 == profile_idc || 122 == profile_idc || 244 == profile_idc || 44 == profile_idc || 83 == profile_idc
+		|| 86 == profile_idc || 118 == profile_idc || 128 == profile_idc || 138 == profile_idc || 139 == profile_idc || 134 == profile_idc || 135 == profile_idc)
+	{
+		chroma_format_idc = mpeg4_h264_read_ue(bits.data, bits.size, &bits.bits);
+		if (3 == chroma_format_idc)
+			mpeg4_bits_skip(&bits, 1); // separate_colour_plane_flag
+		mpeg4_h264_read_ue(bits.data, bits.size, &bits.bits); // bit_depth_luma_minus8
+		mpeg4_h264_read_ue(bits.data, bits.size, &bits.bits); // bit_depth_chroma_minus8
+		mpeg4_bits_skip(&bits, 1); // qpprime_y_zero_transform_bypass_flag
+		if (mpeg4_bits_read(&bits)) // seq_scaling_matrix_present_flag
+		{
+			for (i = 0; i < (3 != chroma_format_idc ? 8 : 12); i++)
+			{
+				if (mpeg4_bits_read(&bits)) // seq_scaling_list_present_flag
+					mpeg4_avc_scaling_list_skip(&bits, i < 6 ? 16 : 64);
+			}
+		}
+	}
+
+	mpeg4_h264_read_ue(bits.data, bits.size, &bits.bits); // log2_max_frame_num_minus4
+	pic_order_cnt_type = mpeg4_h264_read_ue(bits.data, bits.size, &bits.bits);
+	if (0 == pic_order_cnt_type)
+	{
+		mpeg4_h264_read_ue(bits.data, bits.size, &bits.bits); // log2_max_pic_order_cnt_lsb_minus4
+	}
+	else if (1 == pic_order_cnt_type)
+	{
+		mpeg4_bits_skip(&bits, 1); // delta_pic_order_always_zero_flag
+		mpeg4_h264_read_se(bits.data, bits.size, &bits.bits); // offset_for_non_ref_pic
+		mpeg4_h264_read_se(bits.data, bits.size, &bits.bits); // offset_for_top_to_bottom_field
+		n = mpeg4_h264_read_ue(bits.data, bits.size, &bits.bits); // num_ref_frames_in_pic_order_cnt_cycle
+		for (; n > 0 && bits.bits < bits.size * 8; n--)
+			mpeg4_h264_read_se(bits.data, bits.size, &bits.bits); // offset_for_ref_frame
+	}
+
+	mpeg4_h264_read_ue(bits.data, bits.size, &bits.bits); // max_num_ref_frames
+	mpeg4_bits_skip(&bits, 1); // gaps_in_frame_num_value_allowed_flag
+	pic_width_in_mbs_minus1 = mpeg4_h264_read_ue(bits.data, bits.size, &bits.bits);
+	pic_height_in_map_units_minus1 = mpeg4_h264_read_ue(bits.data, bits.size, &bits.bits);
+	frame_mbs_only_flag = mpeg4_bits_read(&bits);
+	if (!frame_mbs_only_flag)
+		mpeg4_bits_skip(&bits, 1); // mb_adaptive_frame_field_flag
+	mpeg4_bits_skip(&bits, 1); // direct_8x8_inference_flag
+
+	memset(crop, 0, sizeof(crop));
+	if (mpeg4_bits_read(&bits)) // frame_cropping_flag
+	{
+		for (i = 0; i < 4; i++)
+			crop[i] = mpeg4_h264_read_ue(bits.data, bits.size, &bits.bits);
+	}
+	if (mpeg4_bits_error(&bits) || bits.bits > bits.size * 8 || pic_width_in_mbs_minus1 > 0xFFFF || pic_height_in_map_units_minus1 > 0xFFFF)
+		return -1;
+
+	// 7.4.2.1.1 CropUnitX/CropUnitY(ChromaArrayType 0: 1 and 2 - frame_mbs_only_flag)
+	sub_width = (1 == chroma_format_idc || 2 == chroma_format_idc) ? 2 : 1;
+	sub_height = (1 == chroma_format_idc ? 2 : 1) * (2 - frame_mbs_only_flag);
+	*width = (int)((pic_width_in_mbs_minus1 + 1) * 16) - (int)(sub_width * (crop[0] + crop[1]));
+	*height = (int)((2 - frame_mbs_only_flag) * (pic_height_in_map_units_minus1 + 1) * 16) - (int)(sub_height * (crop[2] + crop[3]));
+	return *width > 0 && *height > 0 ? 0 : -1;
+}
+
 int mpeg4_avc_decoder_configuration_record_load(const uint8_t* data, size_t bytes, struct mpeg4_avc_t* avc)
 {
 	int r;
@@ -260,6 +366,7 @@ void mpeg4_avc_test(void)
 	};
 	unsigned char data[sizeof(src)];
 
+	int w, h;
 	struct mpeg4_avc_t avc;
 	assert(sizeof(src) == mpeg4_avc_decoder_configuration_record_load(src, sizeof(src), &avc));
 	assert(0x42 == avc.profile && 0xe0 == avc.compatibility && 0x1e == avc.level);
@@ -272,6 +379,8 @@ void mpeg4_avc_test(void)
 	assert(sizeof(nalu) == mpeg4_avc_to_nalu(&avc, data, sizeof(data)));
 	assert(0 == memcmp(nalu, data, sizeof(nalu)));
 
+	assert(0 == mpeg4_avc_get_resolution(&avc, &w, &h) && 480 == w && 640 == h);
+
 	mpeg4_annexbtomp4_test();
 }
 #endif
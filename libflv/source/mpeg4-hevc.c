@@ -1,4 +1,5 @@
 #include "mpeg4-hevc.h"
+#include "mpeg4-bits.h"
 #include <stdio.h>
 #include <string.h>
 #include <assert.h>
@@ -275,6 +276,76 @@ int mpeg4_hevc_codecs(const struct mpeg4_hevc_t* hevc, char* codecs, size_t byte
     return snprintf(codecs, bytes, "hvc1.%s%u.%x.%c%u", space[hevc->general_profile_space%4], (unsigned int)hevc->general_profile_idc, (unsigned int)x, tier[hevc->general_tier_flag%2], (unsigned int)hevc->general_level_idc);
 }
 
+
+uint32_t mpeg4_h264_read_ue(const uint8_t* data, size_t bytes, size_t* offset);
+size_t hevc_rbsp_decode(const uint8_t* nalu, size_t bytes, uint8_t* sodb, size_t len);
+
+int mpeg4_hevc_get_resolution(const struct mpeg4_hevc_t* hevc, int* width, int* height)
+{
+	// ITU-T H.265 7.3.2.2.1 General sequence parameter set RBSP syntax
+	int i;
+	uint8_t sodb[256];
+	uint8_t sub_layer_profile_present_flag[8];
+	uint8_t sub_layer_level_present_flag[8];
+	uint32_t sps_max_sub_layers_minus1, chroma_format_idc;
+	uint32_t pic_width_in_luma_samples, pic_height_in_luma_samples;
+	uint32_t conf[4]; // conf_win_left/right/top/bottom_offset
+	uint32_t sub_width, sub_height;
+	struct mpeg4_bits_t bits;
+
+	for (i = 0; i < hevc->numOfArrays && H265_SPS != hevc->nalu[i].type; i++)
+	{
+	}
+	if (i >= hevc->numOfArrays || hevc->nalu[i].bytes < 4)
+		return -1;
+
+	mpeg4_bits_init(&bits, sodb, hevc_rbsp_decode(hevc->nalu[i].data, hevc->nalu[i].bytes, sodb, sizeof(sodb)));
+	mpeg4_bits_skip(&bits, 16); // nal_unit_header
+	mpeg4_bits_skip(&bits, 4); // sps_video_parameter_set_id
+	sps_max_sub_layers_minus1 = mpeg4_bits_read_uint32(&bits, 3);
+	mpeg4_bits_skip(&bits, 1); // sps_temporal_id_nesting_flag
+
+	// profile_tier_level(1, sps_max_sub_layers_minus1)
+	mpeg4_bits_skip(&bits, 96); // general profile/tier/level
+	for (i = 0; i < (int)sps_max_sub_layers_minus1; i++)
+	{
+		sub_layer_profile_present_flag[i] = (uint8_t)mpeg4_bits_read(&bits);
+		sub_layer_level_present_flag[i] = (uint8_t)mpeg4_bits_read(&bits);
+	}
+	if (sps_max_sub_layers_minus1 > 0)
+		mpeg4_bits_skip(&bits, 2 * (8 - sps_max_sub_layers_minus1)); // reserved_zero_2bits
+	for (i = 0; i < (int)sps_max_sub_layers_minus1; i++)
+	{
+		if (sub_layer_profile_present_flag[i])
+			mpeg4_bits_skip(&bits, 88);
+		if (sub_layer_level_present_flag[i])
+			mpeg4_bits_skip(&bits, 8);
+	}
+
+	mpeg4_h264_read_ue(bits.data, bits.size, &bits.bits); // sps_seq_parameter_set_id
+	chroma_format_idc = mpeg4_h264_read_ue(bits.data, bits.size, &bits.bits);
+	if (3 == chroma_format_idc)
+		mpeg4_bits_skip(&bits, 1); // separate_colour_plane_flag
+	pic_width_in_luma_samples = mpeg4_h264_read_ue(bits.data, bits.size, &bits.bits);
+	pic_height_in_luma_samples = mpeg4_h264_read_ue(bits.data, bits.size, &bits.bits);
+
+	memset(conf, 0, sizeof(conf));
+	if (mpeg4_bits_read(&bits)) // conformance_window_flag
+	{
+		for (i = 0; i < 4; i++)
+			conf[i] = mpeg4_h264_read_ue(bits.data, bits.size, &bits.bits);
+	}
+	if (mpeg4_bits_error(&bits) || bits.bits > bits.size * 8 || pic_width_in_luma_samples > 0xFFFF || pic_height_in_luma_samples > 0xFFFF)
+		return -1;
+
+	// Table 6-1 SubWidthC/SubHeightC
+	sub_width = (1 == chroma_format_idc || 2 == chroma_format_idc) ? 2 : 1;
+	sub_height = 1 == chroma_format_idc ? 2 : 1;
+	*width = (int)pic_width_in_luma_samples - (int)(sub_width * (conf[0] + conf[1]));
+	*height = (int)pic_height_in_luma_samples - (int)(sub_height * (conf[2] + conf[3]));
+	return *width > 0 && *height > 0 ? 0 : -1;
+}
+
 int mpeg4_hevc_decoder_configuration_record_load(const uint8_t* data, size_t bytes, struct mpeg4_hevc_t* hevc)
 {
 	int r;
@@ -310,6 +381,7 @@ void mpeg4_hevc_test(void)
 	};
 	unsigned char data[sizeof(src)];
 
+	int w, h;
 	struct mpeg4_hevc_t hevc;
 	assert(sizeof(src) == mpeg4_hevc_decoder_configuration_record_load(src, sizeof(src), &hevc));
 	assert(0 == hevc.general_profile_space && 0 == hevc.general_tier_flag);
@@ -324,6 +396,8 @@ void mpeg4_hevc_test(void)
 	assert(sizeof(nalu) == mpeg4_hevc_to_nalu(&hevc, data, sizeof(data)));
 	assert(0 == memcmp(nalu, data, sizeof(nalu)));
 
+	assert(0 == mpeg4_hevc_get_resolution(&hevc, &w, &h) && 3840 == w && 2160 == h);
+
 	hevc_annexbtomp4_test();
 }
 #endif
@@ -34,7 +34,7 @@ struct h266_annexbtomp4_handle_t
 	size_t capacity;
 };
 
-uint8_t mpeg4_h264_read_ue(const uint8_t* data, size_t bytes, size_t* offset);
+uint32_t mpeg4_h264_read_ue(const uint8_t* data, size_t bytes, size_t* offset);
 
 static size_t vvc_rbsp_decode(const uint8_t* nalu, size_t bytes, uint8_t* sodb, size_t len)
 {
@@ -0,0 +1,30 @@
+#ifndef _hls_crypto_h_
+#define _hls_crypto_h_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// EXT-X-KEY METHOD
+enum
+{
+	HLS_CRYPTO_NONE = 0,
+	HLS_CRYPTO_AES_128, // full segment AES-128-CBC with PKCS7 padding
+	HLS_CRYPTO_SAMPLE_AES, // H.264 slice NAL/AAC ADTS payload(MPEG-2 Stream Encryption Format for HTTP Live Streaming)
+};
+
+/// Segment key(rotation), the application MUST publish the key and update EXT-X-KEY(hls_m3u8_set_key) before the segment is added
+/// IV is the media sequence number(big-endian, EXT-X-KEY without IV attribute)
+/// @param[in] param user-defined parameter(hls_media_set_encrypt/hls_fmp4_set_encrypt)
+/// @param[in] seq media sequence number of the first segment encrypted with the key(base 0)
+/// @param[out] key AES-128 key
+/// @return 0-ok, other-error
+typedef int (*hls_crypto_onkey)(void* param, int64_t seq, uint8_t key[16]);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* !_hls_crypto_h_ */
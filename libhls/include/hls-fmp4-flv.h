@@ -0,0 +1,37 @@
+#ifndef _hls_fmp4_flv_h_
+#define _hls_fmp4_flv_h_
+
+#include "hls-fmp4.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// RTMP/FLV to fMP4 repackager
+/// FLV AVCDecoderConfigurationRecord/HEVCDecoderConfigurationRecord/AV1CodecConfigurationRecord/
+/// AudioSpecificConfig/OpusHead are used as track extra data, and the length-prefixed
+/// NALU/OBU/raw audio payload is passed to fmp4 writer as-is(no Annex-B round trip)
+typedef struct hls_fmp4_flv_t hls_fmp4_flv_t;
+
+/// @param[in] hls fmp4 segmenter(hls_fmp4_create), must be valid until hls_fmp4_flv_destroy
+/// @param[in] width/height video resolution(tkhd/playlist, e.g. from onMetaData), 0-parse from AVC/HEVC sequence header
+hls_fmp4_flv_t* hls_fmp4_flv_create(hls_fmp4_t* hls, int width, int height);
+
+void hls_fmp4_flv_destroy(hls_fmp4_flv_t* flv);
+
+/// Input RTMP audio/video message(FLV tag body)
+/// Tracks are added on sequence header(AAC/Opus/MP3/G.711 on first frame), and are
+/// fixed once the first media frame is written, so sequence headers must come first(as RTMP publish).
+/// Frames before its sequence header and repeated sequence headers are ignored.
+/// @param[in] type 8-audio, 9-video, 18-script (see more flv-proto.h)
+/// @param[in] data AudioTagHeader/VideoTagHeader + A/V Data
+/// @param[in] bytes data length in byte
+/// @param[in] timestamp FLV tag timestamp(DTS) in millisecond
+/// @return 0-ok, other-error
+int hls_fmp4_flv_input(hls_fmp4_flv_t* flv, int type, const void* data, size_t bytes, uint32_t timestamp);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* !_hls_fmp4_flv_h_ */
@@ -3,6 +3,7 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include "hls-crypto.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -19,11 +20,34 @@ typedef struct hls_fmp4_t hls_fmp4_t;
 /// @return 0-ok, other-error
 typedef int (*hls_fmp4_handler)(void* param, const void* data, size_t bytes, int64_t pts, int64_t dts, int64_t duration);
 
+/// LL-HLS partial segment(EXT-X-PART), called before the segment handler of the last part
+/// @param[in] param user-defined parameter(hls_fmp4_set_part)
+/// @param[in] data partial segment content, segment = part 0 + part 1 + ...
+/// @param[in] bytes partial segment length in byte
+/// @param[in] pts/dts part first pts/dts(ms)
+/// @param[in] duration part duration(ms)
+/// @param[in] independent 1-start with video key frame or audio only(INDEPENDENT=YES)
+/// @return 0-ok, other-error
+typedef int (*hls_fmp4_part_handler)(void* param, const void* data, size_t bytes, int64_t pts, int64_t dts, int64_t duration, int independent);
+
 /// @param[in] duration ts segment duration(millisecond), 0-create segment per video key frame
 hls_fmp4_t* hls_fmp4_create(int64_t duration, hls_fmp4_handler handler, void* param);
 
 void hls_fmp4_destroy(hls_fmp4_t* hls);
 
+/// Enable LL-HLS partial segment
+/// @param[in] duration part target duration(millisecond), 0-disable
+/// @return 0-ok, other-error
+int hls_fmp4_set_part(hls_fmp4_t* hls, int64_t duration, hls_fmp4_part_handler handler, void* param);
+
+/// Segment encryption(EXT-X-KEY), MUST be set before the first input, the init segment(EXT-X-MAP) is clear
+/// HLS_CRYPTO_AES_128 only: the whole segment, output length is padded to 16 bytes(PKCS7), don't support LL-HLS partial segment
+/// @param[in] method HLS_CRYPTO_NONE/HLS_CRYPTO_AES_128
+/// @param[in] rotation new key every rotation segments, 0-one key
+/// @param[in] onkey key callback, media sequence number start from 0(one per segment handler)
+/// @return 0-ok, other-error
+int hls_fmp4_set_encrypt(hls_fmp4_t* hls, int method, int rotation, hls_crypto_onkey onkey, void* param);
+
 /// @param[in] object MPEG-4 systems ObjectTypeIndication such as: MOV_OBJECT_H264, see more @mov-format.h
 /// @param[in] extra_data AudioSpecificConfig/AVCDecoderConfigurationRecord/HEVCDecoderConfigurationRecord
 /// @return >=0-track, <0-error
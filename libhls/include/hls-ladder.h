@@ -0,0 +1,78 @@
+#ifndef _hls_ladder_h_
+#define _hls_ladder_h_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// ABR ladder packager: N pre-encoded renditions(fMP4) with shared segment boundaries
+/// A segment is cut only at a timestamp where every video rendition has a key frame(aligned IDR),
+/// so all renditions have the same segment sequence number, start time and duration.
+typedef struct hls_ladder_t hls_ladder_t;
+
+/// @param[in] param user-defined parameter(hls_ladder_create)
+/// @param[in] rendition rendition index(hls_ladder_add_rendition)
+/// @param[in] data init segment(duration = 0) or media segment content
+/// @param[in] bytes data length in byte
+/// @param[in] pts/dts segment first pts/dts(ms)
+/// @param[in] duration segment duration(ms), same for all renditions
+/// @param[in] name segment name, e.g. 720p-init.mp4, 720p-1.m4s
+/// @return 0-ok, other-error
+typedef int (*hls_ladder_handler)(void* param, int rendition, const void* data, size_t bytes, int64_t pts, int64_t dts, int64_t duration, const char* name);
+
+struct hls_ladder_frame_t
+{
+	int rendition; // hls_ladder_add_rendition return value
+	int track; // hls_ladder_add_video/hls_ladder_add_audio return value
+	const void* data; // h264/h265 mp4 format stream
+	size_t bytes;
+	int64_t pts; // present timestamp in millisecond
+	int64_t dts; // decode timestamp in millisecond
+	int flags; // MOV_AV_FLAG_XXX, such as: MOV_AV_FLAG_KEYFREAME
+};
+
+/// @param[in] duration segment duration(millisecond)
+/// @param[in] live 0-vod, >=HLS_LIVE_NUM-live playlist segment count
+hls_ladder_t* hls_ladder_create(int64_t duration, int live, hls_ladder_handler handler, void* param);
+void hls_ladder_destroy(hls_ladder_t* ladder);
+
+/// @param[in] name rendition name(segment name prefix and media playlist name: name.m3u8)
+/// @param[in] bandwidth EXT-X-STREAM-INF BANDWIDTH(bit/s), 0-measured peak segment bit rate
+/// @return >=0-rendition, <0-error
+int hls_ladder_add_rendition(hls_ladder_t* ladder, const char* name, int bandwidth);
+
+/// Add tracks before the first hls_ladder_input
+/// @param[in] object MPEG-4 systems ObjectTypeIndication such as: MOV_OBJECT_H264, see more @mov-format.h
+/// @param[in] extra_data AudioSpecificConfig/AVCDecoderConfigurationRecord/HEVCDecoderConfigurationRecord
+/// @return >=0-track, <0-error
+int hls_ladder_add_video(hls_ladder_t* ladder, int rendition, uint8_t object, int width, int height, const void* extra_data, size_t extra_data_size);
+int hls_ladder_add_audio(hls_ladder_t* ladder, int rendition, uint8_t object, int channel_count, int bits_per_sample, int sample_rate, const void* extra_data, size_t extra_data_size);
+
+/// Write the video frames of all renditions with the same timestamp, followed by the audio frames up to the next video timestamp
+/// A segment is cut before the frames, the segment boundary is the video frame timestamp(the first frame for audio only)
+/// @param[in] frames frames in decode order, NULL-flush the last segment
+/// @return 0-ok, other-error
+int hls_ladder_input(hls_ladder_t* ladder, const struct hls_ladder_frame_t* frames, int count);
+
+/// Get rendition media playlist
+/// @param[in] eof 1-EXT-X-ENDLIST, 0-ignore
+/// @return 0-ok, other-error
+int hls_ladder_playlist(hls_ladder_t* ladder, int rendition, int eof, char* playlist, size_t bytes);
+
+/// Get master playlist(EXT-X-STREAM-INF per rendition)
+/// @return 0-ok, other-error
+int hls_ladder_master(hls_ladder_t* ladder, char* playlist, size_t bytes);
+
+/// Get DASH MPD: one AdaptationSet, one Representation per rendition with the same
+/// bandwidth/codecs/resolution as hls_ladder_master, SegmentTemplate of the rendition segments:
+/// $RepresentationID$-init.mp4 and $RepresentationID$-$Number$.m4s(rendition name as Representation@id)
+/// @return 0-ok, other-error
+int hls_ladder_mpd(hls_ladder_t* ladder, char* mpd, size_t bytes);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* !_hls_ladder_h_ */
@@ -3,6 +3,7 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include "hls-crypto.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -18,6 +19,14 @@ void hls_m3u8_destroy(hls_m3u8_t* m3u8);
 /// EXT-X-MAP
 int hls_m3u8_set_x_map(hls_m3u8_t* m3u8, const char* name);
 
+/// EXT-X-KEY of the following segments(hls_m3u8_add/hls_m3u8_add_part), e.g. key rotation(hls_crypto_onkey)
+/// IV attribute requires version 2 and above, SAMPLE-AES requires version 5 and above
+///@param[in] method HLS_CRYPTO_AES_128/HLS_CRYPTO_SAMPLE_AES, HLS_CRYPTO_NONE-METHOD=NONE
+///@param[in] uri key uri, NULL for HLS_CRYPTO_NONE
+///@param[in] iv 16-bytes initialization vector, NULL-media sequence number as IV(recommended)
+///@return 0-ok, other-error
+int hls_m3u8_set_key(hls_m3u8_t* m3u8, int method, const char* uri, const uint8_t iv[16]);
+
 ///@param[in] pts present timestamp (millisecond)
 ///@param[in] duration segment duration (millisecond)
 ///@param[in] discontinuity 1-EXT-X-DISCONTINUITY flag, 0-ignore
@@ -33,11 +42,55 @@ int hls_m3u8_add_with_offset(hls_m3u8_t* m3u8, const char* name, int64_t pts, in
 ///@return media segment count
 size_t hls_m3u8_count(hls_m3u8_t* m3u8);
 
+/// LL-HLS: EXT-X-PART-INF and EXT-X-SERVER-CONTROL(CAN-BLOCK-RELOAD=YES,PART-HOLD-BACK)
+///@param[in] duration part target duration(millisecond), 0-disable
+///@return 0-ok, other-error
+int hls_m3u8_set_part(hls_m3u8_t* m3u8, int64_t duration);
+
+/// EXT-X-PART: partial segment of the next media segment(hls_m3u8_add),
+/// removed from playlist when the segment is three target durations from the end
+///@param[in] duration part duration (millisecond)
+///@param[in] independent 1-INDEPENDENT=YES, 0-ignore
+///@return 0-ok, other-error
+int hls_m3u8_add_part(hls_m3u8_t* m3u8, const char* name, int64_t duration, int independent);
+
+/// EXT-X-PRELOAD-HINT:TYPE=PART
+///@param[in] name next part uri, NULL-remove hint
+///@return 0-ok, other-error
+int hls_m3u8_set_preload_hint(hls_m3u8_t* m3u8, const char* name);
+
+///@param[in] param hls_m3u8_block param
+typedef void (*hls_m3u8_onready)(void* param, hls_m3u8_t* m3u8);
+
+/// Blocking playlist reload(_HLS_msn/_HLS_part), wait until the playlist contains the segment/part
+/// onready is called in hls_m3u8_add/hls_m3u8_add_part, the HTTP layer reply hls_m3u8_playlist then
+///@param[in] msn _HLS_msn media sequence number
+///@param[in] part _HLS_part part index of the media segment, -1 if none
+///@return 1-ready(no callback), 0-wait onready, <0-error(-ERANGE: msn too far, 400 Bad Request)
+int hls_m3u8_block(hls_m3u8_t* m3u8, int64_t msn, int part, hls_m3u8_onready onready, void* param);
+
+/// Cancel waiting request(e.g. timeout, connection closed)
+///@param[in] param hls_m3u8_block param
+///@return 0-ok, other-not found
+int hls_m3u8_unblock(hls_m3u8_t* m3u8, void* param);
+
 ///Get m3u8 playlist file
 ///@param[in] eof 1-EXT-X-ENDLIST, 0-ignore
 ///@return 0-ok, other-error
 int hls_m3u8_playlist(hls_m3u8_t* m3u8, int eof, char* playlist, size_t bytes);
 
+/// Playlist Delta Updates: EXT-X-SERVER-CONTROL CAN-SKIP-UNTIL
+///@param[in] duration skip boundary(millisecond), SHOULD be at least six times the target duration, 0-disable
+///@return 0-ok, other-error
+int hls_m3u8_set_skip(hls_m3u8_t* m3u8, int64_t duration);
+
+/// Get cached m3u8 playlist(segments are rendered once on hls_m3u8_add, no formatting on reply)
+///@param[in] eof 1-EXT-X-ENDLIST, 0-ignore
+///@param[in] skip 1-delta update with EXT-X-SKIP(_HLS_skip=YES), 0-full playlist
+///@param[out] bytes playlist length(exclude '\0')
+///@return NULL-error, other-playlist text, valid until next hls_m3u8_xxx call
+const char* hls_m3u8_get_playlist(hls_m3u8_t* m3u8, int eof, int skip, size_t* bytes);
+
 #ifdef __cplusplus
 }
 #endif
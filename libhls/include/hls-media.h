@@ -3,6 +3,7 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include "hls-crypto.h"
 
 #define HLS_FLAGS_KEYFRAME 0x8000
 
@@ -21,11 +22,35 @@ typedef struct hls_media_t hls_media_t;
 /// @return 0-ok, other-error
 typedef int (*hls_media_handler)(void* param, const void* data, size_t bytes, int64_t pts, int64_t dts, int64_t duration);
 
+/// LL-HLS partial segment(EXT-X-PART), called before the segment handler of the last part
+/// @param[in] param user-defined parameter(hls_media_set_part)
+/// @param[in] data partial segment content, ts file = part 0 + part 1 + ...
+/// @param[in] bytes partial segment length in byte
+/// @param[in] pts/dts part first pts/dts(ms)
+/// @param[in] duration part duration(ms)
+/// @param[in] independent 1-start with video key frame or audio only(INDEPENDENT=YES)
+/// @return 0-ok, other-error
+typedef int (*hls_media_part_handler)(void* param, const void* data, size_t bytes, int64_t pts, int64_t dts, int64_t duration, int independent);
+
 /// param[in] duration ts segment duration(millisecond), 0-create segment per video key frame
 hls_media_t* hls_media_create(int64_t duration, hls_media_handler handler, void* param);
 
 void hls_media_destroy(hls_media_t* hls);
 
+/// Enable LL-HLS partial segment
+/// @param[in] duration part target duration(millisecond), 0-disable
+/// @return 0-ok, other-error
+int hls_media_set_part(hls_media_t* hls, int64_t duration, hls_media_part_handler handler, void* param);
+
+/// Segment encryption(EXT-X-KEY), MUST be set before the first input
+/// 1. HLS_CRYPTO_AES_128: the whole ts file, output length is padded to 16 bytes(PKCS7), don't support LL-HLS partial segment
+/// 2. HLS_CRYPTO_SAMPLE_AES: H.264/AAC payload, PMT stream_type 0xDB/0xCF(other streams are clear)
+/// @param[in] method HLS_CRYPTO_XXX
+/// @param[in] rotation new key every rotation segments, 0-one key
+/// @param[in] onkey key callback, media sequence number start from 0(one per segment handler)
+/// @return 0-ok, other-error
+int hls_media_set_encrypt(hls_media_t* hls, int method, int rotation, hls_crypto_onkey onkey, void* param);
+
 /// Add TS PMT stream
 /// @param[in] avtype audio/video type (mpeg-ps.h STREAM_VIDEO_XXX/STREAM_AUDIO_XXX)
 /// @param[in] extra [optional] media extra info data
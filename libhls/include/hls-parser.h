@@ -192,6 +192,12 @@ int hls_playlist_parse(struct hls_playlist_t** playlist, const char* m3u8, size_
 
 int hls_playlist_free(struct hls_playlist_t** playlist);
 
+/// Reload live media playlist: only segments after the last known segment are parsed,
+/// the known segments are reused(no parse/copy), text of expired segments is freed
+/// @param[in,out] playlist NULL-parse all, other-previous hls_playlist_parse/hls_playlist_refresh playlist(free by hls_playlist_free)
+/// @return >=0-new segment count, <0-error(playlist is unchanged)
+int hls_playlist_refresh(struct hls_playlist_t** playlist, const char* m3u8, size_t len);
+
 /// @return total duration in MS
 int64_t hls_playlist_duration(const struct hls_playlist_t* playlist);
 
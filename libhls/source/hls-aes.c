@@ -0,0 +1,362 @@
+// HTTP Live Streaming(RFC8216) 5.2. Media Segment Encryption: AES-128/SAMPLE-AES
+// MPEG-2 Stream Encryption Format for HTTP Live Streaming(Apple): 2. Elementary Stream Encryption
+
+#include "hls-aes.h"
+#include "hls-h264.h"
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+
+#if !defined(_OPENSSL_)
+#include "mov-aes.h" // portable AES-128, make OPENSSL=1 for OpenSSL EVP
+#endif
+
+int hls_aes_init(struct hls_aes_t* aes, int method, int rotation, hls_crypto_onkey onkey, void* param)
+{
+	hls_aes_free(aes);
+	if (HLS_CRYPTO_NONE != method && (!onkey || rotation < 0))
+		return -EINVAL;
+
+#if defined(_OPENSSL_)
+	if (HLS_CRYPTO_NONE != method)
+	{
+		aes->evp = EVP_CIPHER_CTX_new();
+		if (!aes->evp)
+			return -ENOMEM;
+	}
+#endif
+
+	aes->method = method;
+	aes->rotation = rotation;
+	aes->onkey = onkey;
+	aes->param = param;
+	return 0;
+}
+
+void hls_aes_free(struct hls_aes_t* aes)
+{
+#if defined(_OPENSSL_)
+	if (aes->evp)
+		EVP_CIPHER_CTX_free(aes->evp);
+#endif
+	if (aes->buf)
+		free(aes->buf);
+	memset(aes, 0, sizeof(*aes));
+}
+
+int hls_aes_segment(struct hls_aes_t* aes, int64_t seq)
+{
+	int i, r;
+	uint8_t key[16];
+
+	if (HLS_CRYPTO_NONE == aes->method)
+		return 0;
+
+	// key rotation
+	if (!aes->ready || (aes->rotation > 0 && 0 == seq % aes->rotation))
+	{
+		r = aes->onkey(aes->param, seq, key);
+		if (0 != r)
+			return r;
+
+#if defined(_OPENSSL_)
+		if (1 != EVP_EncryptInit_ex(aes->evp, EVP_aes_128_cbc(), NULL, key, NULL))
+			return -EINVAL;
+		EVP_CIPHER_CTX_set_padding(aes->evp, 0);
+#else
+		mov_aes128_expand_key(aes->rk, key);
+#endif
+		memset(key, 0, sizeof(key));
+		aes->ready = 1;
+	}
+
+	// 5.2. the Media Sequence Number is to be used as the IV(big-endian binary representation into a 16-octet buffer)
+	memset(aes->iv, 0, sizeof(aes->iv));
+	for (i = 0; i < 8; i++)
+		aes->iv[15 - i] = (uint8_t)(((uint64_t)seq) >> (i * 8));
+	return 0;
+}
+
+void hls_aes_cbc_begin(struct hls_aes_t* aes, const uint8_t iv[16])
+{
+#if defined(_OPENSSL_)
+	EVP_EncryptInit_ex(aes->evp, NULL, NULL, NULL, iv);
+#else
+	memcpy(aes->chain, iv, 16);
+#endif
+}
+
+int hls_aes_cbc_update(struct hls_aes_t* aes, uint8_t* data, size_t bytes)
+{
+#if defined(_OPENSSL_)
+	int n;
+	assert(0 == bytes % 16 && bytes < 0x7FFFFFFF);
+	return 1 == EVP_EncryptUpdate(aes->evp, data, &n, data, (int)bytes) && (size_t)n == bytes ? 0 : -EINVAL;
+#else
+	size_t i, j;
+	assert(0 == bytes % 16);
+	for (i = 0; i + 16 <= bytes; i += 16)
+	{
+		for (j = 0; j < 16; j++)
+			aes->chain[j] ^= data[i + j];
+		mov_aes128_encrypt_block(aes->rk, aes->chain);
+		memcpy(data + i, aes->chain, 16);
+	}
+	return 0;
+#endif
+}
+
+size_t hls_aes_pkcs7(uint8_t* data, size_t bytes)
+{
+	size_t n;
+	n = 16 - bytes % 16; // 1 ~ 16
+	memset(data + bytes, (int)n, n);
+	return bytes + n;
+}
+
+/// @return NAL unit length without emulation prevention bytes
+static size_t hls_aes_unescape(const uint8_t* nalu, size_t bytes, uint8_t* out)
+{
+	size_t i, n, zeros;
+	for (zeros = n = i = 0; i < bytes; i++)
+	{
+		if (zeros >= 2 && 0x03 == nalu[i])
+		{
+			zeros = 0;
+			continue; // emulation_prevention_three_byte
+		}
+		zeros = 0x00 == nalu[i] ? zeros + 1 : 0;
+		out[n++] = nalu[i];
+	}
+	return n;
+}
+
+/// @return NAL unit length with emulation prevention bytes
+static size_t hls_aes_escape(const uint8_t* rbsp, size_t bytes, uint8_t* out)
+{
+	size_t i, n, zeros;
+	for (zeros = n = i = 0; i < bytes; i++)
+	{
+		if (zeros >= 2 && rbsp[i] <= 0x03)
+		{
+			out[n++] = 0x03;
+			zeros = 0;
+		}
+		zeros = 0x00 == rbsp[i] ? zeros + 1 : 0;
+		out[n++] = rbsp[i];
+	}
+	// cabac_zero_word/next start code: the last byte MUST NOT be 0x00
+	if (n > 0 && 0x00 == out[n - 1])
+		out[n++] = 0x03;
+	return n;
+}
+
+/// 2.1.1 Encrypted_nal_unit: 32 bytes clear leader, then one encrypted 16-byte block
+/// followed by up to nine clear 16-byte blocks, the last block(<=16 bytes) is clear
+static int hls_aes_sample_nalu(struct hls_aes_t* aes, uint8_t* nalu, size_t bytes)
+{
+	int r;
+	size_t n;
+
+	hls_aes_cbc_begin(aes, aes->iv); // IV reset per NAL unit
+	for (r = 0, nalu += 32, bytes -= 32; bytes > 0 && 0 == r; )
+	{
+		if (bytes > 16)
+		{
+			r = hls_aes_cbc_update(aes, nalu, 16);
+			nalu += 16;
+			bytes -= 16;
+		}
+
+		n = bytes < 144 ? bytes : 144;
+		nalu += n;
+		bytes -= n;
+	}
+	return r;
+}
+
+int hls_aes_sample_h264(struct hls_aes_t* aes, const uint8_t* data, size_t bytes, uint8_t* out, size_t capacity)
+{
+	int r;
+	void* p;
+	size_t n, m, len;
+	const uint8_t* end;
+	const uint8_t* nalu;
+	const uint8_t* next;
+
+	if (capacity < bytes * 3 / 2 + 4)
+		return -E2BIG;
+
+	end = data + bytes;
+	nalu = h264_startcode(data, bytes);
+	if (!nalu)
+		return -EINVAL; // don't have start code
+
+	// leading zero bytes and start code
+	n = nalu - data;
+	memcpy(out, data, n);
+
+	for (; nalu; nalu = next)
+	{
+		next = h264_startcode(nalu, end - nalu);
+		len = (next ? next - 3 : end) - nalu;
+		while (next && len > 0 && 0x00 == nalu[len - 1])
+			len--; // 4-bytes start code or trailing zero bytes
+
+		m = 0;
+		if (len > 48 && (1 == (nalu[0] & 0x1f) || 5 == (nalu[0] & 0x1f)))
+		{
+			if (len > aes->capacity)
+			{
+				p = realloc(aes->buf, len);
+				if (!p)
+					return -ENOMEM;
+				aes->buf = (uint8_t*)p;
+				aes->capacity = len;
+			}
+			m = hls_aes_unescape(nalu, len, aes->buf);
+		}
+
+		if (m > 48)
+		{
+			r = hls_aes_sample_nalu(aes, aes->buf, m);
+			if (0 != r)
+				return r;
+			n += hls_aes_escape(aes->buf, m, out + n);
+		}
+		else
+		{
+			memcpy(out + n, nalu, len);
+			n += len;
+		}
+
+		// trailing zero bytes and next start code
+		m = (next ? next : end) - (nalu + len);
+		memcpy(out + n, nalu + len, m);
+		n += m;
+		assert(n <= capacity);
+	}
+	return (int)n;
+}
+
+/// 2.2.1 Encrypted_AAC_Frame: ADTS header and 16 bytes clear leader, then encrypted 16-byte blocks,
+/// the last partial block(<16 bytes) is clear
+int hls_aes_sample_adts(struct hls_aes_t* aes, uint8_t* data, size_t bytes)
+{
+	int r;
+	size_t n, len, header;
+
+	for (r = 0; bytes >= 7 && 0 == r; data += len, bytes -= len)
+	{
+		if (0xFF != data[0] || 0xF0 != (data[1] & 0xF6))
+			return -EINVAL; // invalid syncword/layer
+
+		len = ((size_t)(data[3] & 0x03) << 11) | ((size_t)data[4] << 3) | ((size_t)(data[5] >> 5) & 0x07);
+		header = (data[1] & 0x01) ? 7 : 9; // protection_absent
+		if (len < header || len > bytes)
+			return -EINVAL;
+
+		if (len > header + 16)
+		{
+			n = (len - header - 16) / 16 * 16;
+			hls_aes_cbc_begin(aes, aes->iv); // IV reset per frame
+			r = n > 0 ? hls_aes_cbc_update(aes, data + header + 16, n) : 0;
+		}
+	}
+	return r;
+}
+
+#if defined(_DEBUG) || defined(DEBUG)
+static int hls_aes_test_onkey(void* param, int64_t seq, uint8_t key[16])
+{
+	memcpy(key, param, 16);
+	(void)seq;
+	return 0;
+}
+
+static void hls_aes_test_cbc(void)
+{
+	// FIPS-197 C.1 AES-128 and SP800-38A F.2.1 CBC-AES128.Encrypt
+	static const uint8_t k1[16] = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f };
+	static const uint8_t p1[16] = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff };
+	static const uint8_t c1[16] = { 0x69, 0xc4, 0xe0, 0xd8, 0x6a, 0x7b, 0x04, 0x30, 0xd8, 0xcd, 0xb7, 0x80, 0x70, 0xb4, 0xc5, 0x5a };
+	static const uint8_t k2[16] = { 0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c };
+	static const uint8_t p2[32] = { 0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96, 0xe9, 0x3d, 0x7e, 0x11, 0x73, 0x93, 0x17, 0x2a,
+									0xae, 0x2d, 0x8a, 0x57, 0x1e, 0x03, 0xac, 0x9c, 0x9e, 0xb7, 0x6f, 0xac, 0x45, 0xaf, 0x8e, 0x51 };
+	static const uint8_t c2[32] = { 0x76, 0x49, 0xab, 0xac, 0x81, 0x19, 0xb2, 0x46, 0xce, 0xe9, 0x8e, 0x9b, 0x12, 0xe9, 0x19, 0x7d,
+									0x50, 0x86, 0xcb, 0x9b, 0x50, 0x72, 0x19, 0xee, 0x95, 0xdb, 0x11, 0x3a, 0x91, 0x76, 0x78, 0xb2 };
+	uint8_t iv[16], data[48];
+	struct hls_aes_t aes;
+
+	memset(&aes, 0, sizeof(aes));
+	assert(0 == hls_aes_init(&aes, HLS_CRYPTO_AES_128, 0, hls_aes_test_onkey, (void*)k1));
+	assert(0 == hls_aes_segment(&aes, 0x0102));
+	assert(0x01 == aes.iv[14] && 0x02 == aes.iv[15] && 0 == aes.iv[0]);
+	memset(iv, 0, sizeof(iv));
+	memcpy(data, p1, 16);
+	hls_aes_cbc_begin(&aes, iv);
+	assert(0 == hls_aes_cbc_update(&aes, data, 16) && 0 == memcmp(data, c1, 16));
+
+	assert(0 == hls_aes_init(&aes, HLS_CRYPTO_AES_128, 0, hls_aes_test_onkey, (void*)k2));
+	assert(0 == hls_aes_segment(&aes, 0));
+	memcpy(iv, k1, 16); // IV 000102...0f
+	memcpy(data, p2, 32);
+	hls_aes_cbc_begin(&aes, iv);
+	assert(0 == hls_aes_cbc_update(&aes, data, 16) && 0 == hls_aes_cbc_update(&aes, data + 16, 16)); // chained
+	assert(0 == memcmp(data, c2, 32));
+
+	assert(48 == hls_aes_pkcs7(data, 32) && 16 == data[47] && 16 == data[32]);
+	assert(32 == hls_aes_pkcs7(data, 31) && 1 == data[31]);
+	hls_aes_free(&aes);
+}
+
+static void hls_aes_test_sample(void)
+{
+	static const uint8_t key[16] = { 0x11 };
+	static uint8_t data[512], out[1024], rbsp[512];
+	size_t i, n, zeros;
+	struct hls_aes_t aes;
+	int r;
+
+	memset(&aes, 0, sizeof(aes));
+	assert(0 == hls_aes_init(&aes, HLS_CRYPTO_SAMPLE_AES, 1, hls_aes_test_onkey, (void*)key));
+	assert(0 == hls_aes_segment(&aes, 7));
+
+	// SPS(clear) + IDR slice 300 bytes(with emulation prevention) + short slice(clear)
+	n = 0;
+	memcpy(data + n, "\x00\x00\x00\x01\x67\x42\x00\x1f\xe9", 9); n += 9;
+	memcpy(data + n, "\x00\x00\x00\x01\x65", 5); n += 5;
+	for (i = 0; i < 299; i++)
+		data[n++] = (i % 7) ? (uint8_t)(i * 13) : 0x00;
+	data[n - 1] = 0x80; // rbsp_stop_one_bit
+	memcpy(data + n, "\x00\x00\x01\x41\x9a\x02\x03\x80", 8); n += 8;
+	r = hls_aes_sample_h264(&aes, data, n, out, sizeof(out));
+	assert(r > 0 && 0 == memcmp(out, data, 13 + 32)); // SPS + start code + 32 bytes clear leader
+	assert(0 != memcmp(out + 13 + 32, data + 13 + 32, 16)); // first encrypted block
+	assert(0 == memcmp(out + r - 8, "\x00\x00\x01\x41\x9a\x02\x03\x80", 8)); // short slice
+	for (zeros = 0, i = 13; i < (size_t)r - 8; i++)
+	{
+		assert(zeros < 2 || out[i] > 0x03 || 0x03 == out[i]); // emulation prevention
+		zeros = 0x00 == out[i] ? zeros + 1 : 0;
+	}
+	assert(300 == hls_aes_unescape(out + 13, r - 8 - 13, rbsp));
+	assert(0 == memcmp(rbsp + 48, data + 13 + 48, 144)); // 9 clear blocks
+	assert(0 == memcmp(rbsp + 208, data + 13 + 208, 92)); // clear tail after the last encrypted block
+
+	// ADTS: 7 bytes header + 100 bytes payload, 16 bytes leader + 5 blocks + 4 bytes
+	memset(data, 0x5A, sizeof(data));
+	memcpy(data, "\xFF\xF1\x50\x80\x0D\x60\x00", 7); // frame_length 107
+	memcpy(out, data, 107);
+	assert(0 == hls_aes_sample_adts(&aes, out, 107));
+	assert(0 == memcmp(out, data, 7 + 16) && 0 != memcmp(out + 23, data + 23, 80) && 0 == memcmp(out + 103, data + 103, 4));
+	assert(0 != hls_aes_sample_adts(&aes, out, 100)); // truncated frame
+	hls_aes_free(&aes);
+}
+
+void hls_aes_test(void)
+{
+	hls_aes_test_cbc();
+	hls_aes_test_sample();
+}
+#endif
@@ -0,0 +1,58 @@
+#ifndef _hls_aes_h_
+#define _hls_aes_h_
+
+#include "hls-crypto.h"
+#include <stdint.h>
+#include <stddef.h>
+
+#if defined(_OPENSSL_)
+#include "openssl/evp.h"
+#endif
+
+struct hls_aes_t
+{
+	int method; // HLS_CRYPTO_XXX
+	int rotation; // segments per key, 0-one key
+	hls_crypto_onkey onkey;
+	void* param;
+
+	int ready; // key loaded
+	uint8_t iv[16]; // segment IV: media sequence number
+
+#if defined(_OPENSSL_)
+	EVP_CIPHER_CTX* evp; // AES-NI/ARMv8-CE accelerated if available
+#else
+	uint8_t rk[176]; // AES-128 round keys
+	uint8_t chain[16]; // CBC chain block
+#endif
+
+	uint8_t* buf; // SAMPLE-AES NAL unit without emulation prevention bytes
+	size_t capacity;
+};
+
+int hls_aes_init(struct hls_aes_t* aes, int method, int rotation, hls_crypto_onkey onkey, void* param);
+void hls_aes_free(struct hls_aes_t* aes);
+
+/// New segment: load key(first segment/rotation) and set segment IV to the media sequence number
+/// @return 0-ok, other-onkey error
+int hls_aes_segment(struct hls_aes_t* aes, int64_t seq);
+
+/// AES-128-CBC: begin a new chain with iv, then encrypt in place(bytes MUST be multiple of 16)
+void hls_aes_cbc_begin(struct hls_aes_t* aes, const uint8_t iv[16]);
+int hls_aes_cbc_update(struct hls_aes_t* aes, uint8_t* data, size_t bytes);
+
+/// PKCS7 padding, data MUST have 16 bytes extra space
+/// @return padded length(multiple of 16)
+size_t hls_aes_pkcs7(uint8_t* data, size_t bytes);
+
+/// SAMPLE-AES H.264 annexb access unit: encrypt slice NAL units(type 1/5) longer than 48 bytes,
+/// then re-insert emulation prevention bytes
+/// @param[in] capacity out buffer size, at least bytes * 3 / 2 + 4
+/// @return >=0-output length, <0-error
+int hls_aes_sample_h264(struct hls_aes_t* aes, const uint8_t* data, size_t bytes, uint8_t* out, size_t capacity);
+
+/// SAMPLE-AES AAC ADTS frames in place(frame length unchanged)
+/// @return 0-ok, other-error
+int hls_aes_sample_adts(struct hls_aes_t* aes, uint8_t* data, size_t bytes);
+
+#endif /* !_hls_aes_h_ */
@@ -0,0 +1,67 @@
+#include "hls-buffer.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+static int mov_buffer_read(void* param, void* data, uint64_t bytes)
+{
+	struct hls_buffer_t* buf;
+	buf = (struct hls_buffer_t*)param;
+	if (buf->offset + bytes > buf->bytes)
+		return -E2BIG;
+	memcpy(data, buf->ptr + buf->offset, (size_t)bytes);
+	return 0;
+}
+
+static int mov_buffer_write(void* param, const void* data, uint64_t bytes)
+{
+	void* ptr;
+	size_t capacity;
+	struct hls_buffer_t* buf;
+	buf = (struct hls_buffer_t*)param;
+	if (buf->offset + bytes > buf->maxsize)
+		return -E2BIG;
+
+	if (buf->offset + (size_t)bytes > buf->capacity)
+	{
+		capacity = buf->offset + (size_t)bytes + N_SEGMENT;
+		capacity = capacity > buf->maxsize ? buf->maxsize : capacity;
+		ptr = realloc(buf->ptr, capacity);
+		if (NULL == ptr)
+			return -ENOMEM;
+		buf->ptr = ptr;
+		buf->capacity = capacity;
+	}
+
+	memcpy(buf->ptr + buf->offset, data, (size_t)bytes);
+	buf->offset += (size_t)bytes;
+	if (buf->offset > buf->bytes)
+		buf->bytes = buf->offset;
+	return 0;
+}
+
+static int mov_buffer_seek(void* param, int64_t offset)
+{
+	struct hls_buffer_t* buf;
+	buf = (struct hls_buffer_t*)param;
+	if ((offset >= 0 ? offset : -offset) >= buf->maxsize)
+		return -E2BIG;
+	buf->offset = (size_t)(offset >= 0 ? offset : buf->maxsize + offset);
+	return 0;
+}
+
+static int64_t mov_buffer_tell(void* param)
+{
+	return (int64_t)((struct hls_buffer_t*)param)->offset;
+}
+
+const struct mov_buffer_t* hls_buffer_io(void)
+{
+	static const struct mov_buffer_t s_io = {
+		mov_buffer_read,
+		mov_buffer_write,
+		mov_buffer_seek,
+		mov_buffer_tell,
+	};
+	return &s_io;
+}
@@ -0,0 +1,24 @@
+#ifndef _hls_buffer_h_
+#define _hls_buffer_h_
+
+#include "mov-buffer.h"
+#include <stdint.h>
+#include <stddef.h>
+
+#define N_SEGMENT (1 * 1024 * 1024)
+#define N_FILESIZE (100 * 1024 * 1024) // 100M
+
+/// fmp4 writer memory output(hls-fmp4/hls-ladder segment)
+struct hls_buffer_t
+{
+	uint8_t* ptr;
+	size_t bytes;
+	size_t capacity;
+	size_t offset;
+	size_t maxsize; // max bytes per mp4 file
+};
+
+/// @return mov buffer io, param: struct hls_buffer_t*
+const struct mov_buffer_t* hls_buffer_io(void);
+
+#endif /* !_hls_buffer_h_ */
@@ -0,0 +1,270 @@
+#include "hls-fmp4-flv.h"
+#include "mov-format.h"
+#include "flv-proto.h"
+#include "flv-parser.h"
+#include "mpeg4-aac.h"
+#include "mpeg4-avc.h"
+#include "mpeg4-hevc.h"
+#include "mpeg4-vvc.h"
+#include "aom-av1.h"
+#include "mp3-header.h"
+#include "opus-head.h"
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+
+struct hls_fmp4_flv_t
+{
+	hls_fmp4_t* hls;
+	int width;
+	int height;
+	int bits_per_sample; // FLV audio tag SoundSize
+
+	int video_track; // -1: no video sequence header
+	int audio_track; // -1: no audio sequence header
+	int started; // first media frame written, can't add track
+};
+
+hls_fmp4_flv_t* hls_fmp4_flv_create(hls_fmp4_t* hls, int width, int height)
+{
+	struct hls_fmp4_flv_t* flv;
+	flv = (struct hls_fmp4_flv_t*)calloc(1, sizeof(*flv));
+	if (NULL == flv)
+		return NULL;
+
+	flv->hls = hls;
+	flv->width = width;
+	flv->height = height;
+	flv->bits_per_sample = 16;
+	flv->video_track = -1;
+	flv->audio_track = -1;
+	return flv;
+}
+
+void hls_fmp4_flv_destroy(hls_fmp4_flv_t* flv)
+{
+	free(flv);
+}
+
+static void hls_fmp4_flv_resolution(struct hls_fmp4_flv_t* flv, uint8_t object, const uint8_t* data, size_t bytes)
+{
+	int r, width, height;
+	union
+	{
+		struct mpeg4_avc_t avc;
+		struct mpeg4_hevc_t hevc;
+		struct mpeg4_vvc_t vvc;
+		struct aom_av1_t av1[2]; // av1C, sequence header
+	} v;
+
+	memset(&v, 0, sizeof(v));
+	switch (object)
+	{
+	case MOV_OBJECT_H264:
+		r = mpeg4_avc_decoder_configuration_record_load(data, bytes, &v.avc) > 0 ? mpeg4_avc_get_resolution(&v.avc, &width, &height) : -1;
+		break;
+	case MOV_OBJECT_HEVC:
+		r = mpeg4_hevc_decoder_configuration_record_load(data, bytes, &v.hevc) > 0 ? mpeg4_hevc_get_resolution(&v.hevc, &width, &height) : -1;
+		break;
+	case MOV_OBJECT_H266:
+		r = mpeg4_vvc_decoder_configuration_record_load(data, bytes, &v.vvc) > 0 && v.vvc.max_picture_width > 0 ? 0 : -1;
+		width = v.vvc.max_picture_width;
+		height = v.vvc.max_picture_height;
+		break;
+	case MOV_OBJECT_AV1:
+		r = aom_av1_codec_configuration_record_load(data, bytes, &v.av1[0]) > 0 ? aom_av1_codec_configuration_record_init(&v.av1[1], v.av1[0].data, v.av1[0].bytes) : -1;
+		width = (int)v.av1[1].width; // max_frame_width_minus_1 + 1
+		height = (int)v.av1[1].height;
+		break;
+	default:
+		r = -1;
+	}
+
+	if (0 == r && width > 0 && height > 0)
+	{
+		flv->width = width;
+		flv->height = height;
+	}
+}
+
+static int hls_fmp4_flv_add_video(struct hls_fmp4_flv_t* flv, uint8_t object, const void* data, size_t bytes)
+{
+	if (flv->video_track >= 0 || flv->started)
+		return 0; // ignore repeated sequence header
+
+	// tkhd/playlist resolution from SPS if not set by the caller
+	if (flv->width <= 0 || flv->height <= 0)
+		hls_fmp4_flv_resolution(flv, object, (const uint8_t*)data, bytes);
+
+	// decoder configuration record is the same as mp4 avcC/hvcC/av1C/vvcC box payload
+	flv->video_track = hls_fmp4_add_video(flv->hls, object, flv->width, flv->height, data, bytes);
+	return flv->video_track < 0 ? flv->video_track : 0;
+}
+
+static int hls_fmp4_flv_add_audio(struct hls_fmp4_flv_t* flv, uint8_t object, int channels, int rate, const void* data, size_t bytes)
+{
+	if (flv->audio_track >= 0 || flv->started)
+		return 0; // ignore repeated sequence header
+
+	flv->audio_track = hls_fmp4_add_audio(flv->hls, object, channels, flv->bits_per_sample, rate, data, bytes);
+	return flv->audio_track < 0 ? flv->audio_track : 0;
+}
+
+static int hls_fmp4_flv_write(struct hls_fmp4_flv_t* flv, int track, const void* data, size_t bytes, uint32_t pts, uint32_t dts, int flags)
+{
+	if (track < 0)
+		return 0; // drop frame before sequence header
+
+	flv->started = 1;
+	return hls_fmp4_input(flv->hls, track, data, bytes, pts, dts, flags ? MOV_AV_FLAG_KEYFREAME : 0);
+}
+
+static int hls_fmp4_flv_handler(void* param, int codec, const void* data, size_t bytes, uint32_t pts, uint32_t dts, int flags)
+{
+	int r;
+	struct mp3_header_t mp3;
+	struct opus_head_t opus;
+	struct mpeg4_aac_t aac;
+	struct hls_fmp4_flv_t* flv;
+	flv = (struct hls_fmp4_flv_t*)param;
+
+	switch (codec)
+	{
+	case FLV_VIDEO_AVCC:
+		return hls_fmp4_flv_add_video(flv, MOV_OBJECT_H264, data, bytes);
+	case FLV_VIDEO_HVCC:
+		return hls_fmp4_flv_add_video(flv, MOV_OBJECT_HEVC, data, bytes);
+	case FLV_VIDEO_VVCC:
+		return hls_fmp4_flv_add_video(flv, MOV_OBJECT_H266, data, bytes);
+	case FLV_VIDEO_AV1C:
+		return hls_fmp4_flv_add_video(flv, MOV_OBJECT_AV1, data, bytes);
+
+	case FLV_AUDIO_ASC:
+		if (mpeg4_aac_audio_specific_config_load((const uint8_t*)data, bytes, &aac) < 0)
+			return -EINVAL;
+		return hls_fmp4_flv_add_audio(flv, MOV_OBJECT_AAC, aac.channel_configuration, mpeg4_aac_audio_frequency_to((enum mpeg4_aac_frequency)aac.sampling_frequency_index), data, bytes);
+
+	case FLV_AUDIO_OPUS_HEAD:
+		if (opus_head_load((const uint8_t*)data, bytes, &opus) < 0)
+			return -EINVAL;
+		return hls_fmp4_flv_add_audio(flv, MOV_OBJECT_OPUS, opus.channels, opus.input_sample_rate, data, bytes);
+
+	case FLV_VIDEO_H264:
+	case FLV_VIDEO_H265:
+	case FLV_VIDEO_H266:
+	case FLV_VIDEO_AV1:
+		return hls_fmp4_flv_write(flv, flv->video_track, data, bytes, pts, dts, flags);
+
+	case FLV_AUDIO_AAC:
+	case FLV_AUDIO_OPUS:
+		return hls_fmp4_flv_write(flv, flv->audio_track, data, bytes, pts, dts, 0);
+
+	case FLV_AUDIO_MP3:
+		// no sequence header, add track on first frame
+		if (flv->audio_track < 0 && 0 == mp3_header_load(&mp3, data, (int)bytes))
+			return 0;
+		if (flv->audio_track < 0 && 0 != (r = hls_fmp4_flv_add_audio(flv, MOV_OBJECT_MP3, mp3_get_channel(&mp3), mp3_get_frequency(&mp3), NULL, 0)))
+			return r;
+		return hls_fmp4_flv_write(flv, flv->audio_track, data, bytes, pts, dts, 0);
+
+	case FLV_AUDIO_G711A:
+	case FLV_AUDIO_G711U:
+		if (flv->audio_track < 0 && 0 != (r = hls_fmp4_flv_add_audio(flv, FLV_AUDIO_G711A == codec ? MOV_OBJECT_G711a : MOV_OBJECT_G711u, 1, 8000, NULL, 0)))
+			return r;
+		return hls_fmp4_flv_write(flv, flv->audio_track, data, bytes, pts, dts, 0);
+
+	default:
+		return 0; // ignore script data and unsupported codec
+	}
+}
+
+int hls_fmp4_flv_input(hls_fmp4_flv_t* flv, int type, const void* data, size_t bytes, uint32_t timestamp)
+{
+	// SoundSize: 0-8bit, 1-16bit(enhanced rtmp FourCC audio don't have it)
+	if (FLV_TYPE_AUDIO == type && bytes > 0 && FLV_AUDIO_FOURCC != (*(const uint8_t*)data & 0xF0))
+		flv->bits_per_sample = (*(const uint8_t*)data & 0x02) ? 16 : 8;
+
+	return flv_parser_tag(type, data, bytes, timestamp, hls_fmp4_flv_handler, flv);
+}
+
+#if defined(_DEBUG) || defined(DEBUG)
+static int hls_fmp4_flv_test_onsegment(void* param, const void* data, size_t bytes, int64_t pts, int64_t dts, int64_t duration)
+{
+	assert(bytes > 8 && 0 == memcmp((const uint8_t*)data + 4, "styp", 4));
+	assert(duration > 0 && duration <= 1100);
+	++*(int*)param;
+	(void)pts, (void)dts;
+	return 0;
+}
+
+void hls_fmp4_flv_test(void)
+{
+	// VideoTagHeader(key frame, AVC sequence header) + AVCDecoderConfigurationRecord(1-SPS 320x240, 1-PPS)
+	static const uint8_t s_avcc[] = { 0x17, 0x00, 0x00, 0x00, 0x00, 0x01, 0x42, 0xc0, 0x1e, 0xff, 0xe1, 0x00, 0x08, 0x67, 0x42, 0xc0, 0x1e, 0xda, 0x05, 0x07, 0xe4, 0x01, 0x00, 0x04, 0x68, 0xcb, 0x83, 0xcb };
+	// AudioTagHeader(AAC, 44.1kHz, 16bit, stereo, sequence header) + AudioSpecificConfig(AAC-LC, 44.1kHz, stereo)
+	static const uint8_t s_asc[] = { 0xaf, 0x00, 0x12, 0x10 };
+	// ExVideoTagHeader(key frame, SequenceStart, av01) + AV1CodecConfigurationRecord
+	static const uint8_t s_av1c[] = { 0x90, 0x61, 0x76, 0x30, 0x31, 0x81, 0x04, 0x0c, 0x00, 0x0a, 0x0b, 0x00, 0x00, 0x00, 0x24, 0xcf, 0x7f, 0x0d, 0xbf, 0xff, 0x30, 0x08 };
+	int i, segments;
+	int n;
+	uint8_t video[5 + 4 + 16];
+	uint8_t audio[2 + 16];
+	uint8_t init[4096];
+	hls_fmp4_t* hls;
+	hls_fmp4_flv_t* flv;
+
+	segments = 0;
+	hls = hls_fmp4_create(1000, hls_fmp4_flv_test_onsegment, &segments);
+	flv = hls_fmp4_flv_create(hls, 0, 0); // resolution from SPS
+
+	// frame before sequence header is dropped
+	memset(audio, 0, sizeof(audio));
+	audio[0] = 0xaf; audio[1] = 0x01;
+	assert(0 == hls_fmp4_flv_input(flv, FLV_TYPE_AUDIO, audio, sizeof(audio), 0));
+	assert(0 == hls_fmp4_flv_input(flv, FLV_TYPE_VIDEO, s_avcc, sizeof(s_avcc), 0));
+	assert(0 == hls_fmp4_flv_input(flv, FLV_TYPE_AUDIO, s_asc, sizeof(s_asc), 0));
+	assert(0 == flv->video_track && 1 == flv->audio_track);
+	assert(320 == flv->width && 240 == flv->height && 16 == flv->bits_per_sample);
+
+	// 25fps, gop 1s, length-prefixed NALU as-is
+	memset(video, 0, sizeof(video));
+	video[8] = 16;
+	for (i = 0; i < 100; i++)
+	{
+		video[0] = (i % 25) ? 0x27 : 0x17;
+		video[1] = 0x01; // AVC NALU
+		video[9] = (i % 25) ? 0x41 : 0x65;
+		assert(0 == hls_fmp4_flv_input(flv, FLV_TYPE_VIDEO, video, sizeof(video), i * 40));
+		assert(0 == hls_fmp4_flv_input(flv, FLV_TYPE_AUDIO, audio, sizeof(audio), i * 40));
+
+		// repeated sequence header is ignored
+		if (50 == i)
+			assert(0 == hls_fmp4_flv_input(flv, FLV_TYPE_VIDEO, s_avcc, sizeof(s_avcc), i * 40));
+	}
+	assert(3 == segments);
+
+	n = hls_fmp4_init_segment(hls, init, sizeof(init));
+	assert(n > 0 && 0 == memcmp(init + 4, "ftyp", 4));
+	for (i = 0; i + 4 + sizeof(s_avcc) - 5 < (size_t)n && 0 != memcmp(init + i, "avcC", 4); i++)
+	{
+	}
+	assert(0 == memcmp(init + i + 4, s_avcc + 5, sizeof(s_avcc) - 5));
+
+	hls_fmp4_flv_destroy(flv);
+	hls_fmp4_destroy(hls);
+
+	// enhanced rtmp AV1 sequence start, resolution from the av1C sequence header OBU
+	hls = hls_fmp4_create(1000, hls_fmp4_flv_test_onsegment, &segments);
+	flv = hls_fmp4_flv_create(hls, 0, 0);
+	assert(0 == hls_fmp4_flv_input(flv, FLV_TYPE_VIDEO, s_av1c, sizeof(s_av1c), 0));
+	assert(0 == flv->video_track && 0 < flv->width && 0 < flv->height);
+
+	// G.711 A-law, 8kHz, 8bit, mono
+	audio[0] = 0x70;
+	assert(0 == hls_fmp4_flv_input(flv, FLV_TYPE_AUDIO, audio, sizeof(audio), 0));
+	assert(1 == flv->audio_track && 8 == flv->bits_per_sample);
+	hls_fmp4_flv_destroy(flv);
+	hls_fmp4_destroy(hls);
+}
+#endif
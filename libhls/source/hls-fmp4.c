@@ -1,5 +1,7 @@
 #include "hls-fmp4.h"
 #include "hls-param.h"
+#include "hls-aes.h"
+#include "hls-buffer.h"
 #include "mov-format.h"
 #include "fmp4-writer.h"
 #include <stdlib.h>
@@ -7,19 +9,14 @@
 #include <assert.h>
 #include <errno.h>
 
-#define N_SEGMENT (1 * 1024 * 1024)
-#define N_FILESIZE (100 * 1024 * 1024) // 100M
+#define N_TRACK 8 // part cut frame duration
 
 #define VMAX(a, b) ((a) > (b) ? (a) : (b))
 
 struct hls_fmp4_t
 {
 	fmp4_writer_t* mp4;
-	uint8_t* ptr;
-	size_t bytes;
-	size_t capacity;
-	size_t offset;
-	size_t maxsize; // max bytes per mp4 file
+	struct hls_buffer_t buf;
 
 	int64_t duration;	// user setting segment duration
 	int64_t dts_last;	// last packet dts
@@ -31,79 +28,37 @@ struct hls_fmp4_t
 
 	hls_fmp4_handler handler;
 	void* param;
-};
-
-static int mov_buffer_read(void* param, void* data, uint64_t bytes)
-{
-	struct hls_fmp4_t* fmp4;
-	fmp4 = (struct hls_fmp4_t*)param;
-	if (fmp4->offset + bytes > fmp4->bytes)
-		return -E2BIG;
-	memcpy(data, fmp4->ptr + fmp4->offset, (size_t)bytes);
-	return 0;
-}
 
-static int mov_buffer_write(void* param, const void* data, uint64_t bytes)
-{
-	void* ptr;
-	size_t capacity;
-	struct hls_fmp4_t* fmp4;
-	fmp4 = (struct hls_fmp4_t*)param;
-	if (fmp4->offset + bytes > fmp4->maxsize)
-		return -E2BIG;
-
-	if (fmp4->offset + (size_t)bytes > fmp4->capacity)
-	{
-		capacity = fmp4->offset + (size_t)bytes + N_SEGMENT;
-		capacity = capacity > fmp4->maxsize ? fmp4->maxsize : capacity;
-		ptr = realloc(fmp4->ptr, capacity);
-		if (NULL == ptr)
-			return -ENOMEM;
-		fmp4->ptr = ptr;
-		fmp4->capacity = capacity;
-	}
-
-	memcpy(fmp4->ptr + fmp4->offset, data, (size_t)bytes);
-	fmp4->offset += (size_t)bytes;
-	if(fmp4->offset > fmp4->bytes)
-		fmp4->bytes = fmp4->offset;
-	return 0;
-}
-
-static int mov_buffer_seek(void* param, int64_t offset)
-{
-	struct hls_fmp4_t* fmp4;
-	fmp4 = (struct hls_fmp4_t*)param;
-    if ((offset >= 0 ? offset : -offset) >= fmp4->maxsize)
-		return -E2BIG;
-    fmp4->offset = (size_t)(offset >= 0 ? offset : fmp4->maxsize+offset);
-	return 0;
-}
-
-static int64_t mov_buffer_tell(void* param)
-{
-	return (int64_t)((struct hls_fmp4_t*)param)->offset;
-}
-
-static struct mov_buffer_t s_io = {
-	mov_buffer_read,
-	mov_buffer_write,
-	mov_buffer_seek,
-	mov_buffer_tell,
+	// LL-HLS partial segment
+	int64_t part_duration; // user setting part duration, 0-disable
+	int64_t part_dts;	// part first dts
+	int64_t part_pts;	// part first pts
+	size_t part_offset;	// part start position in segment
+	int part_independent;
+	int64_t frame_dts[N_TRACK];	// last dts per track
+	int64_t frame_duration[N_TRACK]; // last frame interval per track(estimate current frame duration)
+	hls_fmp4_part_handler onpart;
+	void* part_param;
+
+	// EXT-X-KEY
+	struct hls_aes_t aes;
+	int64_t seq;		// media sequence number of the segment
 };
 
 struct hls_fmp4_t* hls_fmp4_create(int64_t duration, hls_fmp4_handler handler, void* param)
 {
-	int flags;
+	int i, flags;
 	struct hls_fmp4_t* hls;
 	hls = (struct hls_fmp4_t*)calloc(1, sizeof(*hls));
 	if (NULL == hls)
 		return NULL;
 
 	hls->video_track = -1;
-	hls->maxsize = N_FILESIZE;
+	hls->buf.maxsize = N_FILESIZE;
 	hls->dts = hls->pts = PTS_NO_VALUE;
 	hls->dts_last = PTS_NO_VALUE;
+	for (i = 0; i < N_TRACK; i++)
+		hls->frame_dts[i] = PTS_NO_VALUE;
 	hls->duration = duration;
 	hls->handler = handler;
 	hls->param = param;
@@ -111,7 +66,7 @@ struct hls_fmp4_t* hls_fmp4_create(int64_t duration, hls_fmp4_handler handler, v
 	flags = 0;
 	//flags |= MOV_FLAG_FASTSTART;
 	flags |= MOV_FLAG_SEGMENT;
-	hls->mp4 = fmp4_writer_create(&s_io, hls, flags);
+	hls->mp4 = fmp4_writer_create(hls_buffer_io(), &hls->buf, flags);
 	if (NULL == hls->mp4)
 	{
 		free(hls);
@@ -129,15 +84,71 @@ void hls_fmp4_destroy(struct hls_fmp4_t* hls)
 		hls->mp4 = NULL;
 	}
 
-	if (hls->ptr)
+	if (hls->buf.ptr)
 	{
-		free(hls->ptr);
-		hls->ptr = NULL;
+		free(hls->buf.ptr);
+		hls->buf.ptr = NULL;
 	}
 
+	hls_aes_free(&hls->aes);
 	free(hls);
 }
 
+int hls_fmp4_set_part(hls_fmp4_t* hls, int64_t duration, hls_fmp4_part_handler handler, void* param)
+{
+	if (HLS_CRYPTO_AES_128 == hls->aes.method && handler && duration > 0)
+		return -EINVAL; // partial segment can't be decrypted without the previous cipher block
+
+	hls->part_duration = handler ? duration : 0;
+	hls->onpart = handler;
+	hls->part_param = param;
+	return 0;
+}
+
+int hls_fmp4_set_encrypt(hls_fmp4_t* hls, int method, int rotation, hls_crypto_onkey onkey, void* param)
+{
+	if (HLS_CRYPTO_NONE != method && HLS_CRYPTO_AES_128 != method)
+		return -ENOTSUP; // SAMPLE-AES: fMP4 common encryption('cbcs')
+	if (HLS_CRYPTO_AES_128 == method && hls->part_duration > 0)
+		return -EINVAL;
+	if (PTS_NO_VALUE != hls->dts_last)
+		return -EBUSY; // before the first input
+	return hls_aes_init(&hls->aes, method, rotation, onkey, param);
+}
+
+/// AES-128: the fragment writer seeks back to update box sizes, encrypt the whole segment in place once saved
+static int hls_fmp4_encrypt(struct hls_fmp4_t* hls)
+{
+	void* ptr;
+	if (hls->buf.bytes + 16 > hls->buf.capacity)
+	{
+		ptr = realloc(hls->buf.ptr, hls->buf.bytes + 16);
+		if (NULL == ptr)
+			return -ENOMEM;
+		hls->buf.ptr = ptr;
+		hls->buf.capacity = hls->buf.bytes + 16;
+	}
+
+	hls->buf.bytes = hls_aes_pkcs7(hls->buf.ptr, hls->buf.bytes);
+	hls_aes_cbc_begin(&hls->aes, hls->aes.iv);
+	return hls_aes_cbc_update(&hls->aes, hls->buf.ptr, hls->buf.bytes);
+}
+
+/// flush current part(fmp4_writer_save_fragment) and notify
+static int hls_fmp4_part(struct hls_fmp4_t* hls, int64_t dts)
+{
+	int r;
+	size_t offset;
+
+	r = fmp4_writer_save_fragment(hls->mp4);
+	if (0 != r || hls->buf.bytes <= hls->part_offset)
+		return r;
+
+	offset = hls->part_offset;
+	hls->part_offset = hls->buf.bytes;
+	return hls->onpart(hls->part_param, hls->buf.ptr + offset, hls->buf.bytes - offset, hls->part_pts, hls->part_dts, dts - hls->part_dts, hls->part_independent);
+}
+
 int hls_fmp4_add_audio(hls_fmp4_t* hls, uint8_t object, int channel_count, int bits_per_sample, int sample_rate, const void* extra_data, size_t extra_data_size)
 {
 	return fmp4_writer_add_audio(hls->mp4, object, channel_count, bits_per_sample, sample_rate, extra_data, extra_data_size);
@@ -154,9 +165,19 @@ int hls_fmp4_input(struct hls_fmp4_t* hls, int track, const void* data, size_t b
 	int r, segment;
 	int force_new_segment;
 	int64_t duration;
+	int64_t frame;
 
 	assert(dts < hls->dts_last + hls->duration || PTS_NO_VALUE == hls->dts_last);
 
+	// frame duration: dts interval of the same track, not the A/V interleave gap
+	frame = 0;
+	if (track >= 0 && track < N_TRACK)
+	{
+		if (PTS_NO_VALUE != hls->frame_dts[track] && dts > hls->frame_dts[track])
+			hls->frame_duration[track] = dts - hls->frame_dts[track];
+		frame = hls->frame_duration[track];
+	}
+
 	// PTS/DTS rewind
 	force_new_segment = 0;
 	if (dts + hls->duration < hls->dts_last || NULL == data || 0 == bytes)
@@ -181,20 +202,41 @@ int hls_fmp4_input(struct hls_fmp4_t* hls, int track, const void* data, size_t b
 		if (PTS_NO_VALUE != hls->dts_last)
 		{
 			// save and create new segment
-			r = fmp4_writer_save_segment(hls->mp4);
+			duration = ((force_new_segment || dts > hls->dts_last + 100) ? hls->dts_last : dts) - hls->dts;
+			r = hls->part_duration > 0 ? hls_fmp4_part(hls, hls->dts + duration) : 0; // last part
 			if (0 == r)
-			{
-				duration = ((force_new_segment || dts > hls->dts_last + 100) ? hls->dts_last : dts) - hls->dts;
-				r = hls->handler(hls->param, hls->ptr, hls->bytes, hls->pts, hls->dts, duration);
-			}
+				r = fmp4_writer_save_segment(hls->mp4);
+			if (0 == r && HLS_CRYPTO_AES_128 == hls->aes.method)
+				r = hls_fmp4_encrypt(hls);
+			if (0 == r)
+				r = hls->handler(hls->param, hls->buf.ptr, hls->buf.bytes, hls->pts, hls->dts, duration);
 			if (0 != r) return r;
+			hls->seq++;
 		}
 
+		// new segment(key rotation)
+		r = hls_aes_segment(&hls->aes, hls->seq);
+		if (0 != r) return r;
+
 		hls->pts = pts;
 		hls->dts = dts;
 		hls->audio_only_flag = 1;
-		hls->offset = 0;
-		hls->bytes = 0;
+		hls->buf.offset = 0;
+		hls->buf.bytes = 0;
+		hls->part_offset = 0;
+		hls->part_pts = pts;
+		hls->part_dts = dts;
+		hls->part_independent = (MOV_AV_FLAG_KEYFREAME & flags) || hls->video_track < 0;
+	}
+	else if (hls->part_duration > 0 && dts + frame - hls->part_dts > hls->part_duration)
+	{
+		// part duration MUST be less than or equal to the part target(current frame end estimated by the track frame interval)
+		r = hls_fmp4_part(hls, dts);
+		if (0 != r) return r;
+
+		hls->part_pts = pts;
+		hls->part_dts = dts;
+		hls->part_independent = (MOV_AV_FLAG_KEYFREAME & flags) || hls->video_track < 0;
 	}
 
 	if (NULL == data || 0 == bytes)
@@ -204,39 +246,31 @@ int hls_fmp4_input(struct hls_fmp4_t* hls, int track, const void* data, size_t b
 		hls->audio_only_flag = 0; // clear audio only flag
 
 	hls->dts_last = dts;
+	if (track >= 0 && track < N_TRACK)
+		hls->frame_dts[track] = dts;
+	if (hls->part_duration > 0)
+		flags |= MOV_AV_FLAG_SEGMENT_DISABLE; // fragment per part only
 	return fmp4_writer_write(hls->mp4, track, data, bytes, pts, dts, flags);
 }
 
 int hls_fmp4_init_segment(hls_fmp4_t* hls, void* data, size_t bytes)
 {
 	int r;
-	uint8_t* ptr;
-	size_t len;
-	size_t capacity;
-	size_t offset;
-	size_t maxsize;
+	struct hls_buffer_t buf;
 	
 	// save
-	ptr = hls->ptr;
-	len = hls->bytes;
-	offset = hls->offset;
-	capacity = hls->capacity;
-	maxsize = hls->maxsize;
-
-	hls->ptr = (uint8_t*)data;
-	hls->bytes = 0;
-	hls->offset = 0;
-	hls->capacity = bytes;
-	hls->maxsize = bytes;
+	memcpy(&buf, &hls->buf, sizeof(buf));
+
+	hls->buf.ptr = (uint8_t*)data;
+	hls->buf.bytes = 0;
+	hls->buf.offset = 0;
+	hls->buf.capacity = bytes;
+	hls->buf.maxsize = bytes;
 
 	r = fmp4_writer_init_segment(hls->mp4);
-	r = 0 ==  r ? (int)hls->bytes : -1;
+	r = 0 ==  r ? (int)hls->buf.bytes : -1;
 
 	// restore
-	hls->ptr = ptr;
-	hls->bytes = len;
-	hls->offset = offset;
-	hls->capacity = capacity;
-	hls->maxsize = maxsize;
+	memcpy(&hls->buf, &buf, sizeof(buf));
 	return r;
 }
@@ -0,0 +1,616 @@
+#include "hls-ladder.h"
+#include "hls-m3u8.h"
+#include "hls-param.h"
+#include "hls-buffer.h"
+#include "mov-format.h"
+#include "fmp4-writer.h"
+#include "mpeg4-avc.h"
+#include "mpeg4-hevc.h"
+#include "mpeg4-vvc.h"
+#include "mpeg4-aac.h"
+#include "aom-av1.h"
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+#include <time.h>
+
+#define N_RENDITION 16
+#define N_NAME 64
+
+#define VMAX(a, b) ((a) > (b) ? (a) : (b))
+
+// user setting or measured peak segment bit rate, same for EXT-X-STREAM-INF and MPD
+#define HLS_LADDER_BANDWIDTH(rendition) ((rendition)->bandwidth > 0 ? (rendition)->bandwidth : (rendition)->peak)
+
+struct hls_rendition_t
+{
+	fmp4_writer_t* mp4;
+	hls_m3u8_t* m3u8;
+	struct hls_buffer_t buf;
+
+	char name[N_NAME];
+	char codecs[128]; // CODECS="avc1.64001f,mp4a.40.2"
+	int bandwidth; // user setting BANDWIDTH, 0-measured
+	int peak; // measured peak segment bit rate
+	int width;
+	int height;
+
+	int video_track;
+	int keyframe; // video key frame of current timestamp
+};
+
+// MPD SegmentTimeline, same for all renditions
+struct hls_ladder_segment_t
+{
+	int64_t pts;
+	int64_t duration;
+};
+
+struct hls_ladder_t
+{
+	int live;
+	int init; // init segment saved, tracks are fixed
+	int64_t duration;	// user setting segment duration
+	int64_t seq;		// segment sequence number, same for all renditions
+	int64_t dts_last;	// last timestamp dts
+	int64_t dts;		// segment first dts
+	int64_t pts;		// segment first pts
+
+	hls_ladder_handler handler;
+	void* param;
+
+	time_t time; // MPD availabilityStartTime
+	struct hls_ladder_segment_t* segments; // live: last live segments, vod: all segments
+	int nsegment;
+	int capacity;
+
+	union
+	{
+		struct mpeg4_avc_t avc;
+		struct mpeg4_hevc_t hevc;
+		struct mpeg4_vvc_t vvc;
+		struct aom_av1_t av1;
+		struct mpeg4_aac_t aac;
+	} v;
+
+	int count;
+	struct hls_rendition_t renditions[N_RENDITION];
+};
+
+struct hls_ladder_t* hls_ladder_create(int64_t duration, int live, hls_ladder_handler handler, void* param)
+{
+	struct hls_ladder_t* ladder;
+	ladder = (struct hls_ladder_t*)calloc(1, sizeof(*ladder));
+	if (NULL == ladder)
+		return NULL;
+
+	ladder->live = live;
+	ladder->duration = duration;
+	ladder->handler = handler;
+	ladder->param = param;
+	ladder->dts = ladder->pts = PTS_NO_VALUE;
+	ladder->dts_last = PTS_NO_VALUE;
+	ladder->time = time(NULL);
+	return ladder;
+}
+
+void hls_ladder_destroy(struct hls_ladder_t* ladder)
+{
+	int i;
+	struct hls_rendition_t* rendition;
+
+	for (i = 0; i < ladder->count; i++)
+	{
+		rendition = &ladder->renditions[i];
+		if (rendition->mp4)
+			fmp4_writer_destroy(rendition->mp4);
+		if (rendition->m3u8)
+			hls_m3u8_destroy(rendition->m3u8);
+		if (rendition->buf.ptr)
+			free(rendition->buf.ptr);
+	}
+
+	if (ladder->segments)
+		free(ladder->segments);
+	free(ladder);
+}
+
+int hls_ladder_add_rendition(struct hls_ladder_t* ladder, const char* name, int bandwidth)
+{
+	struct hls_rendition_t* rendition;
+	if (ladder->count >= N_RENDITION || ladder->init || strlen(name) >= N_NAME)
+		return -EINVAL;
+
+	rendition = &ladder->renditions[ladder->count];
+	memset(rendition, 0, sizeof(*rendition));
+	snprintf(rendition->name, sizeof(rendition->name), "%s", name);
+	rendition->bandwidth = bandwidth;
+	rendition->video_track = -1;
+	rendition->buf.maxsize = N_FILESIZE;
+	rendition->mp4 = fmp4_writer_create(hls_buffer_io(), &rendition->buf, MOV_FLAG_SEGMENT);
+	rendition->m3u8 = hls_m3u8_create(ladder->live, 7);
+	if (!rendition->mp4 || !rendition->m3u8)
+	{
+		if (rendition->mp4)
+			fmp4_writer_destroy(rendition->mp4);
+		if (rendition->m3u8)
+			hls_m3u8_destroy(rendition->m3u8);
+		return -ENOMEM;
+	}
+
+	return ladder->count++;
+}
+
+/// append RFC6381 codecs parameter
+static void hls_ladder_codecs(struct hls_ladder_t* ladder, struct hls_rendition_t* rendition, uint8_t object, const void* extra_data, size_t extra_data_size)
+{
+	int r;
+	size_t n;
+	char* codecs;
+
+	n = strlen(rendition->codecs);
+	if (n + 2 >= sizeof(rendition->codecs))
+		return;
+	codecs = rendition->codecs + n + (n > 0 ? 1 : 0);
+	n = sizeof(rendition->codecs) - (codecs - rendition->codecs);
+
+	r = -1;
+	switch (object)
+	{
+	case MOV_OBJECT_H264:
+		if (mpeg4_avc_decoder_configuration_record_load((const uint8_t*)extra_data, extra_data_size, &ladder->v.avc) > 0)
+			r = mpeg4_avc_codecs(&ladder->v.avc, codecs, n);
+		break;
+
+	case MOV_OBJECT_H265:
+		if (mpeg4_hevc_decoder_configuration_record_load((const uint8_t*)extra_data, extra_data_size, &ladder->v.hevc) > 0)
+			r = mpeg4_hevc_codecs(&ladder->v.hevc, codecs, n);
+		break;
+
+	case MOV_OBJECT_H266:
+		if (mpeg4_vvc_decoder_configuration_record_load((const uint8_t*)extra_data, extra_data_size, &ladder->v.vvc) > 0)
+			r = mpeg4_vvc_codecs(&ladder->v.vvc, codecs, n);
+		break;
+
+	case MOV_OBJECT_AV1:
+		if (aom_av1_codec_configuration_record_load((const uint8_t*)extra_data, extra_data_size, &ladder->v.av1) > 0)
+			r = aom_av1_codecs(&ladder->v.av1, codecs, n);
+		break;
+
+	case MOV_OBJECT_AAC:
+		if (mpeg4_aac_audio_specific_config_load((const uint8_t*)extra_data, extra_data_size, &ladder->v.aac) > 0)
+			r = mpeg4_aac_codecs(&ladder->v.aac, codecs, n);
+		break;
+
+	case MOV_OBJECT_OPUS:
+		r = snprintf(codecs, n, "opus");
+		break;
+
+	case MOV_OBJECT_MP3:
+		r = snprintf(codecs, n, "mp4a.40.34");
+		break;
+	}
+
+	if (r <= 0 || (size_t)r >= n)
+		codecs[0] = '\0'; // unknown codec, keep previous codecs
+	else if (codecs > rendition->codecs)
+		codecs[-1] = ','; // join with previous codec
+}
+
+int hls_ladder_add_video(struct hls_ladder_t* ladder, int rendition, uint8_t object, int width, int height, const void* extra_data, size_t extra_data_size)
+{
+	struct hls_rendition_t* r;
+	if (rendition < 0 || rendition >= ladder->count || ladder->init)
+		return -EINVAL;
+
+	r = &ladder->renditions[rendition];
+	if (r->video_track >= 0)
+		return -EEXIST; // one video track per rendition
+
+	r->width = width;
+	r->height = height;
+	r->video_track = fmp4_writer_add_video(r->mp4, object, width, height, extra_data, extra_data_size);
+	if (r->video_track >= 0)
+		hls_ladder_codecs(ladder, r, object, extra_data, extra_data_size);
+	return r->video_track;
+}
+
+int hls_ladder_add_audio(struct hls_ladder_t* ladder, int rendition, uint8_t object, int channel_count, int bits_per_sample, int sample_rate, const void* extra_data, size_t extra_data_size)
+{
+	int track;
+	struct hls_rendition_t* r;
+	if (rendition < 0 || rendition >= ladder->count || ladder->init)
+		return -EINVAL;
+
+	r = &ladder->renditions[rendition];
+	track = fmp4_writer_add_audio(r->mp4, object, channel_count, bits_per_sample, sample_rate, extra_data, extra_data_size);
+	if (track >= 0)
+		hls_ladder_codecs(ladder, r, object, extra_data, extra_data_size);
+	return track;
+}
+
+/// save init segment of all renditions
+static int hls_ladder_init_segment(struct hls_ladder_t* ladder)
+{
+	int i, r;
+	char name[N_NAME + 16];
+	struct hls_rendition_t* rendition;
+
+	for (i = 0; i < ladder->count; i++)
+	{
+		rendition = &ladder->renditions[i];
+		rendition->buf.offset = 0;
+		rendition->buf.bytes = 0;
+		r = fmp4_writer_init_segment(rendition->mp4);
+		if (0 != r)
+			return r;
+
+		snprintf(name, sizeof(name), "%s-init.mp4", rendition->name);
+		r = ladder->handler(ladder->param, i, rendition->buf.ptr, rendition->buf.bytes, 0, 0, 0, name);
+		if (0 == r)
+			r = hls_m3u8_set_x_map(rendition->m3u8, name);
+		if (0 != r)
+			return r;
+
+		rendition->buf.offset = 0;
+		rendition->buf.bytes = 0;
+	}
+
+	ladder->init = 1;
+	return 0;
+}
+
+/// MPD SegmentTimeline
+static int hls_ladder_timeline(struct hls_ladder_t* ladder, int64_t duration)
+{
+	void* ptr;
+	if (ladder->live > 0 && ladder->nsegment >= ladder->live)
+	{
+		memmove(ladder->segments, ladder->segments + 1, (ladder->nsegment - 1) * sizeof(ladder->segments[0]));
+		ladder->nsegment--;
+	}
+	else if (ladder->nsegment >= ladder->capacity)
+	{
+		ptr = realloc(ladder->segments, (ladder->capacity + 64) * sizeof(ladder->segments[0]));
+		if (NULL == ptr)
+			return -ENOMEM;
+		ladder->segments = (struct hls_ladder_segment_t*)ptr;
+		ladder->capacity += 64;
+	}
+
+	ladder->segments[ladder->nsegment].pts = ladder->pts;
+	ladder->segments[ladder->nsegment].duration = duration;
+	ladder->nsegment++;
+	return 0;
+}
+
+/// save current segment of all renditions with the same sequence/timestamp/duration
+static int hls_ladder_segment(struct hls_ladder_t* ladder, int64_t duration)
+{
+	int i, r;
+	char name[N_NAME + 32];
+	struct hls_rendition_t* rendition;
+
+	r = hls_ladder_timeline(ladder, duration);
+	if (0 != r)
+		return r;
+
+	for (i = 0; i < ladder->count; i++)
+	{
+		rendition = &ladder->renditions[i];
+		r = fmp4_writer_save_segment(rendition->mp4);
+		if (0 != r)
+			return r;
+
+		snprintf(name, sizeof(name), "%s-%" PRId64 ".m4s", rendition->name, ladder->seq);
+		r = ladder->handler(ladder->param, i, rendition->buf.ptr, rendition->buf.bytes, ladder->pts, ladder->dts, duration, name);
+		if (0 == r)
+			r = hls_m3u8_add(rendition->m3u8, name, ladder->pts, duration, 0);
+		if (0 != r)
+			return r;
+
+		if (duration > 0)
+			rendition->peak = VMAX(rendition->peak, (int)(rendition->buf.bytes * 8000 / duration));
+		rendition->buf.offset = 0;
+		rendition->buf.bytes = 0;
+	}
+
+	ladder->seq++;
+	return 0;
+}
+
+int hls_ladder_input(struct hls_ladder_t* ladder, const struct hls_ladder_frame_t* frames, int count)
+{
+	int i, r, aligned;
+	int64_t pts, dts;
+	struct hls_rendition_t* rendition;
+
+	if (NULL == frames || count < 1)
+	{
+		// flush the last segment
+		if (PTS_NO_VALUE == ladder->dts_last)
+			return 0;
+		r = hls_ladder_segment(ladder, ladder->dts_last - ladder->dts);
+		ladder->dts = ladder->pts = ladder->dts_last = PTS_NO_VALUE;
+		return r;
+	}
+
+	if (!ladder->init)
+	{
+		r = hls_ladder_init_segment(ladder);
+		if (0 != r)
+			return r;
+	}
+
+	// segment boundary: every video rendition has a key frame at this timestamp
+	pts = frames[0].pts;
+	dts = frames[0].dts;
+	for (i = 0; i < ladder->count; i++)
+		ladder->renditions[i].keyframe = 0;
+	for (i = count - 1; i >= 0; i--)
+	{
+		if (frames[i].rendition < 0 || frames[i].rendition >= ladder->count)
+			return -EINVAL;
+		rendition = &ladder->renditions[frames[i].rendition];
+		if (frames[i].track != rendition->video_track)
+			continue;
+
+		pts = frames[i].pts;
+		dts = frames[i].dts;
+		if (MOV_AV_FLAG_KEYFREAME & frames[i].flags)
+			rendition->keyframe = 1;
+	}
+	for (aligned = 1, i = 0; i < ladder->count && aligned; i++)
+	{
+		if (ladder->renditions[i].video_track >= 0 && !ladder->renditions[i].keyframe)
+			aligned = 0;
+	}
+
+	if (PTS_NO_VALUE == ladder->dts_last)
+	{
+		// wait for aligned IDR, all renditions start with key frame
+		if (!aligned)
+			return 0;
+	}
+	else if ((aligned && dts - ladder->dts >= ladder->duration) || dts + ladder->duration < ladder->dts_last /*PTS/DTS rewind*/)
+	{
+		r = hls_ladder_segment(ladder, (dts > ladder->dts_last + 100 || dts < ladder->dts_last ? ladder->dts_last : dts) - ladder->dts);
+		if (0 != r)
+			return r;
+		ladder->dts_last = PTS_NO_VALUE;
+	}
+
+	if (PTS_NO_VALUE == ladder->dts_last)
+	{
+		ladder->pts = pts;
+		ladder->dts = dts;
+	}
+	ladder->dts_last = dts;
+
+	for (i = 0; i < count; i++)
+	{
+		if (NULL == frames[i].data || 0 == frames[i].bytes)
+			continue;
+
+		rendition = &ladder->renditions[frames[i].rendition];
+		r = fmp4_writer_write(rendition->mp4, frames[i].track, frames[i].data, frames[i].bytes, frames[i].pts, frames[i].dts, frames[i].flags);
+		if (0 != r)
+			return r;
+	}
+	return 0;
+}
+
+int hls_ladder_playlist(struct hls_ladder_t* ladder, int rendition, int eof, char* playlist, size_t bytes)
+{
+	if (rendition < 0 || rendition >= ladder->count)
+		return -EINVAL;
+	return hls_m3u8_playlist(ladder->renditions[rendition].m3u8, eof, playlist, bytes);
+}
+
+int hls_ladder_master(struct hls_ladder_t* ladder, char* playlist, size_t bytes)
+{
+	int i;
+	size_t n;
+	struct hls_rendition_t* rendition;
+
+	// 4.3.3.5. EXT-X-INDEPENDENT-SEGMENTS: every segment starts with key frame
+	n = snprintf(playlist, bytes, "#EXTM3U\n#EXT-X-VERSION:7\n#EXT-X-INDEPENDENT-SEGMENTS\n");
+	for (i = 0; i < ladder->count && n < bytes; i++)
+	{
+		rendition = &ladder->renditions[i];
+		n += snprintf(playlist + n, bytes - n, "#EXT-X-STREAM-INF:BANDWIDTH=%d", HLS_LADDER_BANDWIDTH(rendition));
+		if (rendition->codecs[0] && n < bytes)
+			n += snprintf(playlist + n, bytes - n, ",CODECS=\"%s\"", rendition->codecs);
+		if (rendition->video_track >= 0 && n < bytes)
+			n += snprintf(playlist + n, bytes - n, ",RESOLUTION=%dx%d", rendition->width, rendition->height);
+		if (n < bytes)
+			n += snprintf(playlist + n, bytes - n, "\n%s.m3u8\n", rendition->name);
+	}
+
+	return n < bytes ? 0 : -ENOMEM;
+}
+
+int hls_ladder_mpd(struct hls_ladder_t* ladder, char* mpd, size_t bytes)
+{
+	int i, j;
+	size_t n;
+	time_t now;
+	int64_t t, duration, total;
+	char publishTime[32];
+	char availabilityStartTime[32];
+	struct hls_rendition_t* rendition;
+
+	for (total = duration = 0, i = 0; i < ladder->nsegment; i++)
+	{
+		total += ladder->segments[i].duration;
+		duration = VMAX(duration, ladder->segments[i].duration);
+	}
+	duration = VMAX(duration, ladder->duration);
+
+	// ISO/IEC 23009-1 G.1/G.2 ISO Base media file format On Demand/Live profile
+	n = snprintf(mpd, bytes, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<MPD xmlns=\"urn:mpeg:dash:schema:mpd:2011\"");
+	if (ladder->live > 0 && n < bytes)
+	{
+		now = time(NULL);
+		strftime(availabilityStartTime, sizeof(availabilityStartTime), "%Y-%m-%dT%H:%M:%SZ", gmtime(&ladder->time));
+		strftime(publishTime, sizeof(publishTime), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+		n += snprintf(mpd + n, bytes - n, " type=\"dynamic\" minimumUpdatePeriod=\"PT%.3fS\" timeShiftBufferDepth=\"PT%.3fS\" availabilityStartTime=\"%s\" publishTime=\"%s\" minBufferTime=\"PT%.3fS\" profiles=\"urn:mpeg:dash:profile:isoff-live:2011\">\n",
+			duration / 1000.0, total / 1000.0, availabilityStartTime, publishTime, duration / 1000.0);
+	}
+	else if (n < bytes)
+	{
+		n += snprintf(mpd + n, bytes - n, " type=\"static\" mediaPresentationDuration=\"PT%.3fS\" minBufferTime=\"PT%.3fS\" profiles=\"urn:mpeg:dash:profile:isoff-live:2011\">\n",
+			total / 1000.0, duration / 1000.0);
+	}
+
+	// one AdaptationSet: renditions have aligned segments(same sequence number and timeline)
+	if (n < bytes)
+		n += snprintf(mpd + n, bytes - n, "  <Period id=\"0\" start=\"PT0S\">\n    <AdaptationSet segmentAlignment=\"true\" startWithSAP=\"1\">\n"
+			"      <SegmentTemplate timescale=\"1000\" media=\"$RepresentationID$-$Number$.m4s\" initialization=\"$RepresentationID$-init.mp4\" startNumber=\"%" PRId64 "\">\n        <SegmentTimeline>\n",
+			ladder->seq - ladder->nsegment);
+	for (i = 0; i < ladder->nsegment && n < bytes; i = j)
+	{
+		t = ladder->segments[i].pts + ladder->segments[i].duration;
+		for (j = i + 1; j < ladder->nsegment && ladder->segments[j].duration == ladder->segments[i].duration && ladder->segments[j].pts == t; j++)
+			t += ladder->segments[j].duration;
+
+		n += snprintf(mpd + n, bytes - n, "          <S t=\"%" PRId64 "\" d=\"%" PRId64 "\"", ladder->segments[i].pts, ladder->segments[i].duration);
+		if (n < bytes)
+			n += j - i > 1 ? snprintf(mpd + n, bytes - n, " r=\"%d\"/>\n", j - i - 1) : snprintf(mpd + n, bytes - n, "/>\n");
+	}
+	if (n < bytes)
+		n += snprintf(mpd + n, bytes - n, "        </SegmentTimeline>\n      </SegmentTemplate>\n");
+
+	for (i = 0; i < ladder->count && n < bytes; i++)
+	{
+		rendition = &ladder->renditions[i];
+		n += snprintf(mpd + n, bytes - n, "      <Representation id=\"%s\" mimeType=\"%s\" bandwidth=\"%d\"", rendition->name, rendition->video_track >= 0 ? "video/mp4" : "audio/mp4", HLS_LADDER_BANDWIDTH(rendition));
+		if (rendition->codecs[0] && n < bytes)
+			n += snprintf(mpd + n, bytes - n, " codecs=\"%s\"", rendition->codecs);
+		if (rendition->video_track >= 0 && n < bytes)
+			n += snprintf(mpd + n, bytes - n, " width=\"%d\" height=\"%d\"", rendition->width, rendition->height);
+		if (n < bytes)
+			n += snprintf(mpd + n, bytes - n, "/>\n");
+	}
+
+	if (n < bytes)
+		n += snprintf(mpd + n, bytes - n, "    </AdaptationSet>\n  </Period>\n</MPD>\n");
+	return n < bytes ? 0 : -ENOMEM;
+}
+
+#if defined(_DEBUG) || defined(DEBUG)
+struct hls_ladder_test_t
+{
+	int64_t timestamp[3];
+	int64_t duration[3];
+	int segments[3];
+};
+
+static int hls_ladder_test_onsegment(void* param, int rendition, const void* data, size_t bytes, int64_t pts, int64_t dts, int64_t duration, const char* name)
+{
+	struct hls_ladder_test_t* ctx;
+	ctx = (struct hls_ladder_test_t*)param;
+	if (0 == duration)
+	{
+		assert(bytes > 8 && 0 == memcmp((const uint8_t*)data + 4, "ftyp", 4) && strstr(name, "-init.mp4"));
+		return 0;
+	}
+
+	assert(bytes > 8 && 0 == memcmp((const uint8_t*)data + 4, "styp", 4));
+	ctx->timestamp[rendition] = dts;
+	ctx->duration[rendition] = duration;
+	ctx->segments[rendition]++;
+
+	// same boundary with rendition 0
+	assert(rendition < 1 || (ctx->timestamp[rendition] == ctx->timestamp[0] && ctx->duration[rendition] == ctx->duration[0] && ctx->segments[rendition] == ctx->segments[0]));
+	(void)pts;
+	return 0;
+}
+
+void hls_ladder_test(void)
+{
+	// AVCDecoderConfigurationRecord(1-SPS, 1-PPS)
+	static const uint8_t s_avcc[] = { 0x01, 0x42, 0xc0, 0x1e, 0xff, 0xe1, 0x00, 0x08, 0x67, 0x42, 0xc0, 0x1e, 0xd9, 0x01, 0x40, 0x16, 0x01, 0x00, 0x04, 0x68, 0xcb, 0x83, 0xcb };
+	// AudioSpecificConfig(AAC-LC, 44.1kHz, stereo)
+	static const uint8_t s_asc[] = { 0x12, 0x10 };
+	static char playlist[4 * 1024];
+	char line[256];
+	int i, j, n, aac, audio;
+	int renditions[3];
+	uint8_t video[4 + 16];
+	struct hls_ladder_frame_t frames[5];
+	struct hls_ladder_test_t ctx;
+	hls_ladder_t* ladder;
+
+	memset(&ctx, 0, sizeof(ctx));
+	ladder = hls_ladder_create(2000, 0, hls_ladder_test_onsegment, &ctx);
+	renditions[0] = hls_ladder_add_rendition(ladder, "1080p", 5000000);
+	renditions[1] = hls_ladder_add_rendition(ladder, "720p", 0);
+	renditions[2] = hls_ladder_add_rendition(ladder, "360p", 0);
+	assert(0 == hls_ladder_add_video(ladder, renditions[0], MOV_OBJECT_H264, 1920, 1080, s_avcc, sizeof(s_avcc)));
+	assert(0 == hls_ladder_add_video(ladder, renditions[1], MOV_OBJECT_H264, 1280, 720, s_avcc, sizeof(s_avcc)));
+	assert(0 == hls_ladder_add_video(ladder, renditions[2], MOV_OBJECT_H264, 640, 360, s_avcc, sizeof(s_avcc)));
+	audio = hls_ladder_add_audio(ladder, renditions[2], MOV_OBJECT_AAC, 2, 16, 44100, s_asc, sizeof(s_asc));
+	assert(1 == audio);
+
+	memset(video, 0, sizeof(video));
+	video[3] = 16;
+	for (aac = i = 0; i < 300; i++)
+	{
+		// 25fps, aligned IDR per second, 360p has an extra key frame per 0.8s(scene cut)
+		for (j = 0; j < 3; j++)
+		{
+			frames[j].rendition = renditions[j];
+			frames[j].track = 0;
+			frames[j].data = video;
+			frames[j].bytes = sizeof(video);
+			frames[j].pts = i * 40;
+			frames[j].dts = i * 40;
+			frames[j].flags = (0 == (i + 10) % 25 || (2 == j && 0 == i % 20)) ? MOV_AV_FLAG_KEYFREAME : 0;
+		}
+
+		// AAC 1024 samples per frame(23.2ms), frames until the next video frame
+		for (n = 3; (int64_t)aac * 1024 * 1000 / 44100 < (i + 1) * 40; n++, aac++)
+		{
+			assert(n < (int)(sizeof(frames) / sizeof(frames[0])));
+			frames[n].rendition = renditions[2];
+			frames[n].track = audio;
+			frames[n].data = video;
+			frames[n].bytes = 8;
+			frames[n].pts = (int64_t)aac * 1024 * 1000 / 44100;
+			frames[n].dts = frames[n].pts;
+			frames[n].flags = 0;
+		}
+
+		// first frames before aligned IDR are dropped
+		assert(0 == hls_ladder_input(ladder, frames, n));
+	}
+	assert(0 == hls_ladder_input(ladder, NULL, 0));
+	assert(6 == ctx.segments[0] && 6 == ctx.segments[1] && 6 == ctx.segments[2]);
+	assert(10600 == ctx.timestamp[2] && 1360 == ctx.duration[2]);
+
+	assert(0 == hls_ladder_playlist(ladder, renditions[1], 1, playlist, sizeof(playlist)));
+	assert(strstr(playlist, "#EXT-X-MAP:URI=\"720p-init.mp4\"") && strstr(playlist, "#EXTINF:2.000,\n720p-0.m4s\n#EXTINF:2.000,\n720p-1.m4s\n") && strstr(playlist, "#EXT-X-ENDLIST\n"));
+
+	assert(0 == hls_ladder_master(ladder, playlist, sizeof(playlist)));
+	assert(strstr(playlist, "#EXT-X-STREAM-INF:BANDWIDTH=5000000,CODECS=\"avc1.42c01e\",RESOLUTION=1920x1080\n1080p.m3u8\n"));
+	assert(strstr(playlist, ",CODECS=\"avc1.42c01e,mp4a.40.2\",RESOLUTION=640x360\n360p.m3u8\n"));
+	snprintf(line, sizeof(line), "#EXT-X-STREAM-INF:BANDWIDTH=%d,CODECS=\"avc1.42c01e\",RESOLUTION=1280x720\n720p.m3u8\n", ladder->renditions[1].peak);
+	assert(ladder->renditions[1].peak > 0 && strstr(playlist, line));
+
+	// MPD: same renditions as master playlist
+	assert(0 == hls_ladder_mpd(ladder, playlist, sizeof(playlist)));
+	assert(strstr(playlist, "type=\"static\" mediaPresentationDuration=\"PT11.360S\""));
+	assert(strstr(playlist, "media=\"$RepresentationID$-$Number$.m4s\" initialization=\"$RepresentationID$-init.mp4\" startNumber=\"0\""));
+	assert(strstr(playlist, "<S t=\"600\" d=\"2000\" r=\"4\"/>\n          <S t=\"10600\" d=\"1360\"/>\n"));
+	assert(strstr(playlist, "<Representation id=\"1080p\" mimeType=\"video/mp4\" bandwidth=\"5000000\" codecs=\"avc1.42c01e\" width=\"1920\" height=\"1080\"/>"));
+	snprintf(line, sizeof(line), "<Representation id=\"720p\" mimeType=\"video/mp4\" bandwidth=\"%d\" codecs=\"avc1.42c01e\" width=\"1280\" height=\"720\"/>", ladder->renditions[1].peak);
+	assert(strstr(playlist, line));
+	snprintf(line, sizeof(line), "<Representation id=\"360p\" mimeType=\"video/mp4\" bandwidth=\"%d\" codecs=\"avc1.42c01e,mp4a.40.2\" width=\"640\" height=\"360\"/>", ladder->renditions[2].peak);
+	assert(strstr(playlist, line));
+	hls_ladder_destroy(ladder);
+}
+#endif
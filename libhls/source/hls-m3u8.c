@@ -10,6 +10,39 @@
 
 #define VMAX(a, b) ((a) > (b) ? (a) : (b))
 
+struct hls_part_t
+{
+	int64_t duration;	// part duration (millisecond)
+	int independent;	// INDEPENDENT=YES
+	char* name;
+};
+
+// rendered EXT-X-KEY tag, shared by segments
+struct hls_key_t
+{
+	int ref;
+	int none; // METHOD=NONE
+	size_t bytes;
+	char text[1];
+};
+
+struct hls_waiter_t
+{
+	int64_t msn;
+	int part;
+	hls_m3u8_onready onready;
+	void* param;
+};
+
+struct hls_playlist_t
+{
+	char* ptr;
+	size_t bytes; // playlist length, exclude '\0'
+	size_t capacity;
+	int eof;
+	int valid;
+};
+
 struct hls_m3u8_t
 {
 	int live;
@@ -21,6 +54,22 @@ struct hls_m3u8_t
 	struct list_head root;
 
 	char* ext_x_map;
+	struct hls_key_t* key; // EXT-X-KEY of the next segment
+
+	// LL-HLS
+	int64_t part_target; // EXT-X-PART-INF PART-TARGET (millisecond), 0-disable
+	struct hls_part_t* parts; // parts of the next media segment
+	int nparts;
+	int part_capacity;
+	char* preload_hint;
+
+	struct hls_waiter_t* waiters; // blocking playlist reload
+	int nwaiters;
+	int waiter_capacity;
+
+	int64_t skip; // EXT-X-SERVER-CONTROL CAN-SKIP-UNTIL (millisecond), 0-disable
+	size_t text_bytes; // rendered text length of all segments
+	struct hls_playlist_t playlists[2]; // 0-full playlist, 1-delta update(EXT-X-SKIP)
 };
 
 struct hls_segment_t
@@ -32,11 +81,34 @@ struct hls_segment_t
 	int64_t offset;		// EXT-X-BYTERANGE offset: a byte offset from the beginning of the resource
 	int64_t bytes;		// EXT-X-BYTERANGE length
 	int discontinuity;	// EXT-X-DISCONTINUITY flag
+	struct hls_key_t* key; // EXT-X-KEY in effect, NULL-no key
+	int key_tag;		// 1-key changed, render EXT-X-KEY before the segment
+
+	struct hls_part_t* parts; // EXT-X-PART
+	int nparts;
+
+	char* text; // rendered tags and uri of the segment
+	size_t text_bytes;
+	size_t text_capacity;
 
 	char* name;
 	size_t capacity;
 };
 
+static void hls_key_release(struct hls_key_t* key)
+{
+	if (key && 0 == --key->ref)
+		free(key);
+}
+
+static void hls_part_free(struct hls_part_t* parts, int n)
+{
+	int i;
+	for (i = 0; i < n; i++)
+		free(parts[i].name);
+	free(parts);
+}
+
 struct hls_m3u8_t* hls_m3u8_create(int live, int version)
 {
 	struct hls_m3u8_t* m3u8;
@@ -61,9 +133,26 @@ void hls_m3u8_destroy(struct hls_m3u8_t* m3u8)
 	list_for_each_safe(l, n, &m3u8->root)
 	{
 		seg = list_entry(l, struct hls_segment_t, link);
+		if (seg->parts)
+			hls_part_free(seg->parts, seg->nparts);
+		if (seg->text)
+			free(seg->text);
+		hls_key_release(seg->key);
 		free(seg);
 	}
 
+	hls_key_release(m3u8->key);
+	if (m3u8->playlists[0].ptr)
+		free(m3u8->playlists[0].ptr);
+	if (m3u8->playlists[1].ptr)
+		free(m3u8->playlists[1].ptr);
+
+	if (m3u8->parts)
+		hls_part_free(m3u8->parts, m3u8->nparts);
+	if (m3u8->waiters)
+		free(m3u8->waiters);
+	if (m3u8->preload_hint)
+		free(m3u8->preload_hint);
 	if (m3u8->ext_x_map)
 		free(m3u8->ext_x_map);
 	free(m3u8);
@@ -81,10 +170,134 @@ static struct hls_segment_t* hls_segment_alloc(size_t bytes)
 		seg->bytes = 0;
 		seg->pts = 0;
 		seg->discontinuity = 0;
+		seg->key = NULL;
+		seg->key_tag = 0;
+		seg->parts = NULL;
+		seg->nparts = 0;
+		seg->text = NULL;
+		seg->text_bytes = 0;
+		seg->text_capacity = 0;
 	}
 	return seg;
 }
 
+static size_t hls_m3u8_playlist_parts(const struct hls_part_t* parts, int count, char* playlist, size_t n, size_t bytes)
+{
+	int i;
+	for (i = 0; i < count && n < bytes; i++)
+		n += snprintf(playlist + n, bytes - n, "#EXT-X-PART:DURATION=%.3f,URI=\"%s\"%s\n", parts[i].duration / 1000.0, parts[i].name, parts[i].independent ? ",INDEPENDENT=YES" : "");
+	return n;
+}
+
+/// @return max rendered length of parts
+static size_t hls_m3u8_parts_bytes(const struct hls_part_t* parts, int count)
+{
+	int i;
+	size_t n;
+	for (n = 0, i = 0; i < count; i++)
+		n += strlen(parts[i].name) + 96; // #EXT-X-PART:DURATION=%.3f,URI="%s",INDEPENDENT=YES
+	return n;
+}
+
+/// render segment text once(add/parts expired), hls_m3u8_playlist copy it only
+static int hls_segment_render(struct hls_m3u8_t* m3u8, struct hls_segment_t* seg)
+{
+	void* p;
+	size_t n, bytes;
+
+	bytes = strlen(seg->name) + 160 + hls_m3u8_parts_bytes(seg->parts, seg->nparts) + (seg->key_tag ? seg->key->bytes : 0);
+	if (bytes > seg->text_capacity)
+	{
+		p = realloc(seg->text, bytes);
+		if (!p)
+			return -ENOMEM;
+		seg->text = (char*)p;
+		seg->text_capacity = bytes;
+	}
+
+	n = 0;
+	if (seg->discontinuity)
+		n += snprintf(seg->text + n, bytes - n, "#EXT-X-DISCONTINUITY\n");
+	if (seg->key_tag)
+	{
+		memcpy(seg->text + n, seg->key->text, seg->key->bytes);
+		n += seg->key->bytes;
+	}
+	if (seg->parts)
+		n = hls_m3u8_playlist_parts(seg->parts, seg->nparts, seg->text, n, bytes);
+	if (seg->bytes > 0)
+		n += snprintf(seg->text + n, n < bytes ? bytes - n : 0, "#EXTINF:%.3f,\n#EXT-X-BYTERANGE:%" PRId64 "@%" PRId64 "\n%s\n", seg->duration / 1000.0, seg->bytes, seg->offset, seg->name);
+	else
+		n += snprintf(seg->text + n, n < bytes ? bytes - n : 0, "#EXTINF:%.3f,\n%s\n", seg->duration / 1000.0, seg->name);
+	assert(n < bytes);
+
+	m3u8->text_bytes = m3u8->text_bytes - seg->text_bytes + n;
+	seg->text_bytes = n;
+	return 0;
+}
+
+static void hls_m3u8_changed(struct hls_m3u8_t* m3u8)
+{
+	m3u8->playlists[0].valid = 0;
+	m3u8->playlists[1].valid = 0;
+}
+
+/// @return 1-playlist contains the segment/part, 0-not yet, <0-error
+static int hls_m3u8_ready(struct hls_m3u8_t* m3u8, int64_t msn, int part)
+{
+	int64_t next;
+	next = m3u8->seq + (int64_t)m3u8->count; // media sequence number of the next(in-progress) segment
+	if (msn > next + 1)
+		return -ERANGE; // 6.2.5.2. greater than the last segment plus two
+	if (msn < next)
+		return 1;
+	return (msn == next && part >= 0 && m3u8->part_target > 0 && part < m3u8->nparts) ? 1 : 0;
+}
+
+static void hls_m3u8_notify(struct hls_m3u8_t* m3u8)
+{
+	int i;
+	struct hls_waiter_t w;
+
+	for (i = 0; i < m3u8->nwaiters; )
+	{
+		if (1 != hls_m3u8_ready(m3u8, m3u8->waiters[i].msn, m3u8->waiters[i].part))
+		{
+			i++;
+			continue;
+		}
+
+		// remove before callback, onready may call hls_m3u8_block/hls_m3u8_unblock
+		memcpy(&w, &m3u8->waiters[i], sizeof(w));
+		m3u8->waiters[i] = m3u8->waiters[--m3u8->nwaiters];
+		w.onready(w.param, m3u8);
+	}
+}
+
+/// Partial Segments SHOULD be removed from the Playlist once they are greater than three Target Durations from the end
+static void hls_m3u8_expire_parts(struct hls_m3u8_t* m3u8)
+{
+	int64_t duration;
+	struct list_head* link;
+	struct hls_segment_t* seg;
+
+	duration = 0;
+	for (link = m3u8->root.prev; link != &m3u8->root; link = link->prev)
+	{
+		seg = list_entry(link, struct hls_segment_t, link);
+		if (duration > 3 * m3u8->duration)
+		{
+			if (!seg->parts)
+				break; // expired
+			hls_part_free(seg->parts, seg->nparts);
+			seg->parts = NULL;
+			seg->nparts = 0;
+			hls_segment_render(m3u8, seg); // shrink only, never fail
+		}
+		duration += seg->duration;
+	}
+}
+
 int hls_m3u8_add(struct hls_m3u8_t* m3u8, const char* name, int64_t pts, int64_t duration, int discontinuity)
 {
 	return hls_m3u8_add_with_offset(m3u8, name, pts, duration, discontinuity, 0, 0);
@@ -93,7 +306,7 @@ int hls_m3u8_add(struct hls_m3u8_t* m3u8, const char* name, int64_t pts, int64_t
 int hls_m3u8_add_with_offset(hls_m3u8_t* m3u8, const char* name, int64_t pts, int64_t duration, int discontinuity, int64_t offset, int64_t bytes)
 {
 	size_t r;
-	struct hls_segment_t* seg;
+	struct hls_segment_t* seg, *prev;
 	seg = NULL;
 	r = strlen(name);
 
@@ -106,10 +319,22 @@ int hls_m3u8_add_with_offset(hls_m3u8_t* m3u8, const char* name, int64_t pts, in
 		// reuse the first segment
 		seg = list_entry(m3u8->root.next, struct hls_segment_t, link);
 		list_remove(&seg->link);
+		m3u8->text_bytes -= seg->text_bytes;
+		seg->text_bytes = 0;
+		hls_key_release(seg->key);
+		seg->key = NULL;
+		if (seg->parts)
+		{
+			hls_part_free(seg->parts, seg->nparts);
+			seg->parts = NULL;
+			seg->nparts = 0;
+		}
 
 		// check name length
 		if (r + 1 > seg->capacity)
 		{
+			if (seg->text)
+				free(seg->text);
 			free(seg);
 			seg = NULL;
 			--m3u8->count;
@@ -137,15 +362,178 @@ int hls_m3u8_add_with_offset(hls_m3u8_t* m3u8, const char* name, int64_t pts, in
 	seg->discontinuity = discontinuity; // EXT-X-DISCONTINUITY
 	memcpy(seg->name, name, r + 1); // copy last '\0'
 
+	// EXT-X-KEY applies to every segment until the next EXT-X-KEY
+	prev = list_empty(&m3u8->root) ? NULL : list_entry(m3u8->root.prev, struct hls_segment_t, link);
+	seg->key = m3u8->key;
+	seg->key_tag = m3u8->key && (prev ? prev->key != m3u8->key : !m3u8->key->none);
+	if (seg->key)
+		seg->key->ref++;
+
+	// parts of the segment
+	seg->parts = m3u8->parts;
+	seg->nparts = m3u8->nparts;
+	m3u8->parts = NULL;
+	m3u8->nparts = 0;
+	m3u8->part_capacity = 0;
+
+	hls_m3u8_changed(m3u8);
+	if (0 != hls_segment_render(m3u8, seg))
+	{
+		if (seg->parts)
+			hls_part_free(seg->parts, seg->nparts);
+		if (seg->text)
+			free(seg->text);
+		hls_key_release(seg->key);
+		free(seg);
+		--m3u8->count;
+		return -ENOMEM;
+	}
+
 	list_insert_after(&seg->link, m3u8->root.prev);
+
+	if (m3u8->part_target > 0)
+		hls_m3u8_expire_parts(m3u8);
+	hls_m3u8_notify(m3u8);
+	return 0;
+}
+
+int hls_m3u8_set_key(hls_m3u8_t* m3u8, int method, const char* uri, const uint8_t iv[16])
+{
+	int i;
+	size_t n;
+	struct hls_key_t* key;
+
+	if (HLS_CRYPTO_NONE != method && (!uri || (HLS_CRYPTO_AES_128 != method && HLS_CRYPTO_SAMPLE_AES != method)))
+		return -EINVAL;
+
+	n = 96 + (uri ? strlen(uri) : 0);
+	key = (struct hls_key_t*)malloc(sizeof(*key) + n);
+	if (!key)
+		return -ENOMEM;
+
+	key->ref = 1;
+	key->none = HLS_CRYPTO_NONE == method ? 1 : 0;
+	if (key->none)
+	{
+		key->bytes = snprintf(key->text, n, "#EXT-X-KEY:METHOD=NONE\n");
+	}
+	else
+	{
+		key->bytes = snprintf(key->text, n, "#EXT-X-KEY:METHOD=%s,URI=\"%s\"", HLS_CRYPTO_AES_128 == method ? "AES-128" : "SAMPLE-AES", uri);
+		if (iv)
+		{
+			key->bytes += snprintf(key->text + key->bytes, n - key->bytes, ",IV=0x");
+			for (i = 0; i < 16; i++)
+				key->bytes += snprintf(key->text + key->bytes, n - key->bytes, "%02X", (unsigned int)iv[i]);
+		}
+		key->bytes += snprintf(key->text + key->bytes, n - key->bytes, "\n");
+	}
+	assert(key->bytes < n);
+
+	hls_key_release(m3u8->key);
+	m3u8->key = key;
+	hls_m3u8_changed(m3u8);
+	return 0;
+}
+
+int hls_m3u8_set_part(hls_m3u8_t* m3u8, int64_t duration)
+{
+	m3u8->part_target = duration;
+	hls_m3u8_changed(m3u8);
+	return 0;
+}
+
+int hls_m3u8_set_skip(hls_m3u8_t* m3u8, int64_t duration)
+{
+	m3u8->skip = duration;
+	hls_m3u8_changed(m3u8);
+	return 0;
+}
+
+int hls_m3u8_add_part(hls_m3u8_t* m3u8, const char* name, int64_t duration, int independent)
+{
+	void* p;
+	struct hls_part_t* part;
+
+	if (m3u8->nparts >= m3u8->part_capacity)
+	{
+		p = realloc(m3u8->parts, sizeof(struct hls_part_t) * (m3u8->part_capacity + 8));
+		if (!p)
+			return -ENOMEM;
+		m3u8->parts = (struct hls_part_t*)p;
+		m3u8->part_capacity += 8;
+	}
+
+	part = &m3u8->parts[m3u8->nparts];
+	part->name = strdup(name);
+	if (!part->name)
+		return -ENOMEM;
+	part->duration = duration;
+	part->independent = independent;
+	m3u8->nparts++;
+
+	// PART-TARGET: the duration of each Partial Segment MUST be less than or equal to the Part Target Duration
+	m3u8->part_target = VMAX(m3u8->part_target, duration);
+	hls_m3u8_changed(m3u8);
+	hls_m3u8_notify(m3u8);
+	return 0;
+}
+
+int hls_m3u8_set_preload_hint(hls_m3u8_t* m3u8, const char* name)
+{
+	if (m3u8->preload_hint)
+		free(m3u8->preload_hint);
+	m3u8->preload_hint = name ? strdup(name) : NULL;
+	hls_m3u8_changed(m3u8);
+	return m3u8->preload_hint || !name ? 0 : -ENOMEM;
+}
+
+int hls_m3u8_block(hls_m3u8_t* m3u8, int64_t msn, int part, hls_m3u8_onready onready, void* param)
+{
+	int r;
+	void* p;
+
+	r = hls_m3u8_ready(m3u8, msn, part);
+	if (0 != r)
+		return r;
+
+	if (m3u8->nwaiters >= m3u8->waiter_capacity)
+	{
+		p = realloc(m3u8->waiters, sizeof(struct hls_waiter_t) * (m3u8->waiter_capacity + 16));
+		if (!p)
+			return -ENOMEM;
+		m3u8->waiters = (struct hls_waiter_t*)p;
+		m3u8->waiter_capacity += 16;
+	}
+
+	m3u8->waiters[m3u8->nwaiters].msn = msn;
+	m3u8->waiters[m3u8->nwaiters].part = part;
+	m3u8->waiters[m3u8->nwaiters].onready = onready;
+	m3u8->waiters[m3u8->nwaiters].param = param;
+	m3u8->nwaiters++;
 	return 0;
 }
 
+int hls_m3u8_unblock(hls_m3u8_t* m3u8, void* param)
+{
+	int i;
+	for (i = 0; i < m3u8->nwaiters; i++)
+	{
+		if (m3u8->waiters[i].param == param)
+		{
+			m3u8->waiters[i] = m3u8->waiters[--m3u8->nwaiters];
+			return 0;
+		}
+	}
+	return -ENOENT;
+}
+
 int hls_m3u8_set_x_map(hls_m3u8_t* m3u8, const char* name)
 {
 	if (m3u8->ext_x_map)
 		free(m3u8->ext_x_map);
 	m3u8->ext_x_map = name ? strdup(name) : NULL;
+	hls_m3u8_changed(m3u8);
 	return m3u8->ext_x_map ? 0 : -ENOMEM;
 }
 
@@ -154,54 +542,279 @@ size_t hls_m3u8_count(struct hls_m3u8_t* m3u8)
 	return m3u8->count;
 }
 
-int hls_m3u8_playlist(struct hls_m3u8_t* m3u8, int eof, char* playlist, size_t bytes)
+static int hls_m3u8_render(struct hls_m3u8_t* m3u8, struct hls_playlist_t* playlist, int eof, int skip)
 {
 	int r;
-	size_t n;
+	void* p;
+	size_t n, bytes, skipped_bytes;
+	int64_t duration;
 	struct list_head* link;
 	struct hls_segment_t* seg;
+	struct hls_key_t* key, *last;
+
+	// 6.2.5.1. the server MUST NOT skip any segment whose start is within CAN-SKIP-UNTIL of the end of the playlist
+	r = 0;
+	skipped_bytes = 0;
+	if (skip)
+	{
+		duration = 0;
+		list_for_each(link, &m3u8->root)
+		{
+			duration += list_entry(link, struct hls_segment_t, link)->duration;
+		}
+
+		list_for_each(link, &m3u8->root)
+		{
+			seg = list_entry(link, struct hls_segment_t, link);
+			if (duration <= m3u8->skip)
+				break;
+			duration -= seg->duration;
+			skipped_bytes += seg->text_bytes;
+			r++;
+		}
+	}
 
-	r = snprintf(playlist, bytes,
+	// EXT-X-KEY of the first segment(the key tag was in a removed or skipped segment)
+	key = NULL;
+	n = 0;
+	list_for_each(link, &m3u8->root)
+	{
+		seg = list_entry(link, struct hls_segment_t, link);
+		if (n++ == (size_t)r)
+		{
+			key = (seg->key && !seg->key_tag && !seg->key->none) ? seg->key : NULL;
+			break;
+		}
+	}
+
+	// EXT-X-KEY of the in-progress parts(key rotation before the segment added)
+	last = list_empty(&m3u8->root) ? NULL : list_entry(m3u8->root.prev, struct hls_segment_t, link)->key;
+	last = (m3u8->key && m3u8->key != last && (last || !m3u8->key->none) && m3u8->part_target > 0 && !eof && m3u8->nparts > 0) ? m3u8->key : NULL;
+
+	// precompute playlist length upper bound: header + segments text + in-progress parts
+	bytes = 512 + (m3u8->ext_x_map ? strlen(m3u8->ext_x_map) : 0) + m3u8->text_bytes - skipped_bytes;
+	bytes += (key ? key->bytes : 0) + (last ? last->bytes : 0);
+	if (m3u8->part_target > 0 && !eof)
+		bytes += hls_m3u8_parts_bytes(m3u8->parts, m3u8->nparts) + (m3u8->preload_hint ? strlen(m3u8->preload_hint) + 64 : 0);
+	if (bytes > playlist->capacity)
+	{
+		p = realloc(playlist->ptr, bytes);
+		if (!p)
+			return -ENOMEM;
+		playlist->ptr = (char*)p;
+		playlist->capacity = bytes;
+	}
+
+	n = snprintf(playlist->ptr, bytes,
 		"#EXTM3U\n" // MUST
 		"#EXT-X-VERSION:%d\n" // Optional
 		"#EXT-X-TARGETDURATION:%" PRId64 "\n" // MUST, decimal-integer, in seconds
 		"#EXT-X-MEDIA-SEQUENCE:%" PRId64 "\n"
 		"%s"  // #EXT-X-PLAYLIST-TYPE:VOD
 		"%s", // #EXT-X-ALLOW-CACHE:YES
-		m3u8->version,
+		skip ? VMAX(m3u8->version, 9) : m3u8->version, // EXT-X-SKIP: version 9
 		(m3u8->duration + 999) / 1000,
 		m3u8->seq,
 		m3u8->live ? "" : "#EXT-X-PLAYLIST-TYPE:VOD\n",
 		m3u8->live ? "" : "#EXT-X-ALLOW-CACHE:YES\n");
-	if (r <= 0 || (size_t)r >= bytes)
-		return -ENOMEM;
+
+	// LL-HLS: PART-HOLD-BACK MUST be at least three times the Part Target Duration
+	if (m3u8->part_target > 0 || m3u8->skip > 0)
+	{
+		n += snprintf(playlist->ptr + n, bytes - n, "#EXT-X-SERVER-CONTROL:%s", m3u8->part_target > 0 ? "CAN-BLOCK-RELOAD=YES," : "");
+		if (m3u8->skip > 0)
+			n += snprintf(playlist->ptr + n, bytes - n, "CAN-SKIP-UNTIL=%.3f,", m3u8->skip / 1000.0);
+		if (m3u8->part_target > 0)
+			n += snprintf(playlist->ptr + n, bytes - n, "PART-HOLD-BACK=%.3f,", m3u8->part_target * 3 / 1000.0);
+		playlist->ptr[n - 1] = '\n'; // replace last ','
+		if (m3u8->part_target > 0)
+			n += snprintf(playlist->ptr + n, bytes - n, "#EXT-X-PART-INF:PART-TARGET=%.3f\n", m3u8->part_target / 1000.0);
+	}
 
 	// #EXT-X-MAP:URI="main.mp4",BYTERANGE="1206@0"
 	if (m3u8->ext_x_map)
-		r += snprintf(playlist + r, r < bytes ? bytes - r : 0, "#EXT-X-MAP:URI=\"%s\",\n", m3u8->ext_x_map);
+		n += snprintf(playlist->ptr + n, bytes - n, "#EXT-X-MAP:URI=\"%s\",\n", m3u8->ext_x_map);
 
-	n = r;
-	list_for_each(link, &m3u8->root)
+	if (r > 0)
+		n += snprintf(playlist->ptr + n, bytes - n, "#EXT-X-SKIP:SKIPPED-SEGMENTS=%d\n", r);
+
+	if (key)
 	{
-		if (bytes <= n)
-			break;
+		memcpy(playlist->ptr + n, key->text, key->bytes);
+		n += key->bytes;
+	}
 
+	list_for_each(link, &m3u8->root)
+	{
 		seg = list_entry(link, struct hls_segment_t, link);
+		if (r > 0)
+		{
+			--r;
+			continue;
+		}
+		memcpy(playlist->ptr + n, seg->text, seg->text_bytes);
+		n += seg->text_bytes;
+	}
 
-		if (seg->discontinuity)
-			n += snprintf(playlist + n, n < bytes ? bytes - n : 0, "#EXT-X-DISCONTINUITY\n");
-		if (bytes > n)
+	// parts of the in-progress segment
+	if (m3u8->part_target > 0 && !eof)
+	{
+		if (last)
 		{
-			if(seg->bytes > 0)
-				n += snprintf(playlist + n, n < bytes ? bytes - n : 0, "#EXTINF:%.3f,\n#EXT-X-BYTERANGE:%" PRId64 "@%" PRId64 "\n%s\n", seg->duration / 1000.0, seg->bytes, seg->offset, seg->name);
-			else
-				n += snprintf(playlist + n, n < bytes ? bytes - n : 0, "#EXTINF:%.3f,\n%s\n", seg->duration / 1000.0, seg->name);
+			memcpy(playlist->ptr + n, last->text, last->bytes);
+			n += last->bytes;
 		}
-			
+		n = hls_m3u8_playlist_parts(m3u8->parts, m3u8->nparts, playlist->ptr, n, bytes);
+		if (m3u8->preload_hint)
+			n += snprintf(playlist->ptr + n, bytes - n, "#EXT-X-PRELOAD-HINT:TYPE=PART,URI=\"%s\"\n", m3u8->preload_hint);
+	}
+
+	if (eof)
+		n += snprintf(playlist->ptr + n, bytes - n, "#EXT-X-ENDLIST\n");
+
+	assert(n < bytes);
+	playlist->ptr[n] = '\0'; // segment text copied without '\0'
+	playlist->bytes = n;
+	playlist->eof = eof;
+	playlist->valid = 1;
+	return 0;
+}
+
+const char* hls_m3u8_get_playlist(hls_m3u8_t* m3u8, int eof, int skip, size_t* bytes)
+{
+	struct hls_playlist_t* playlist;
+	skip = (skip && m3u8->skip > 0) ? 1 : 0;
+	playlist = &m3u8->playlists[skip];
+	if (!playlist->valid || playlist->eof != eof)
+	{
+		if (0 != hls_m3u8_render(m3u8, playlist, eof, skip))
+			return NULL;
 	}
 
-	if (eof && bytes > n + 15)
-		n += snprintf(playlist + n, n < bytes ? bytes - n : 0, "#EXT-X-ENDLIST\n");
+	if (bytes)
+		*bytes = playlist->bytes;
+	return playlist->ptr;
+}
+
+int hls_m3u8_playlist(struct hls_m3u8_t* m3u8, int eof, char* playlist, size_t bytes)
+{
+	size_t n;
+	const char* ptr;
+	ptr = hls_m3u8_get_playlist(m3u8, eof, 0, &n);
+	if (!ptr || n + 1 > bytes)
+		return -ENOMEM;
+	memcpy(playlist, ptr, n + 1); // copy last '\0'
+	return 0;
+}
 
-	return (bytes > n && n > 0) ? 0 : -ENOMEM;
+#if defined(_DEBUG) || defined(DEBUG)
+static void hls_m3u8_test_onready(void* param, hls_m3u8_t* m3u8)
+{
+	++*(int*)param;
+	(void)m3u8;
+}
+
+void hls_m3u8_test(void)
+{
+	int i, j, ready;
+	size_t n;
+	char name[64];
+	const char* ptr;
+	static char playlist[8 * 1024];
+	hls_m3u8_t* m3u8;
+
+	ready = 0;
+	m3u8 = hls_m3u8_create(5, 7);
+	assert(0 == hls_m3u8_set_part(m3u8, 1000));
+	assert(0 == hls_m3u8_set_x_map(m3u8, "init.mp4"));
+
+	// _HLS_msn=0&_HLS_part=1
+	assert(0 == hls_m3u8_block(m3u8, 0, 1, hls_m3u8_test_onready, &ready));
+	assert(0 == hls_m3u8_block(m3u8, 0, -1, hls_m3u8_test_onready, &ready));
+	assert(-ERANGE == hls_m3u8_block(m3u8, 2, -1, hls_m3u8_test_onready, &ready));
+	for (i = 0; i < 6; i++)
+	{
+		for (j = 0; j < 4; j++)
+		{
+			snprintf(name, sizeof(name), "%d.%d.m4s", i, j);
+			assert(0 == hls_m3u8_add_part(m3u8, name, 1000, 0 == j ? 1 : 0));
+			assert(1 == ready || i > 0 || j < 1);
+		}
+		snprintf(name, sizeof(name), "%d.m4s", i);
+		assert(0 == hls_m3u8_add(m3u8, name, i * 4000, 4000, 0));
+		assert(2 == ready || i > 0);
+
+		snprintf(name, sizeof(name), "%d.0.m4s", i + 1);
+		assert(0 == hls_m3u8_set_preload_hint(m3u8, name));
+	}
+
+	assert(0 == hls_m3u8_block(m3u8, 6, 0, hls_m3u8_test_onready, &ready));
+	assert(0 == hls_m3u8_unblock(m3u8, &ready));
+	assert(0 != hls_m3u8_unblock(m3u8, &ready));
+	assert(1 == hls_m3u8_block(m3u8, 5, 3, hls_m3u8_test_onready, &ready));
+	assert(0 == hls_m3u8_add_part(m3u8, "6.0.m4s", 1000, 1));
+	assert(0 == hls_m3u8_set_preload_hint(m3u8, "6.1.m4s"));
+
+	assert(0 == hls_m3u8_playlist(m3u8, 0, playlist, sizeof(playlist)));
+	assert(strstr(playlist, "#EXT-X-SERVER-CONTROL:CAN-BLOCK-RELOAD=YES,PART-HOLD-BACK=3.000\n"));
+	assert(strstr(playlist, "#EXT-X-PART-INF:PART-TARGET=1.000\n"));
+	assert(strstr(playlist, "#EXT-X-MEDIA-SEQUENCE:1\n"));
+	assert(!strstr(playlist, "\"1.0.m4s\"") && strstr(playlist, "\"2.0.m4s\"")); // more than three target durations from the end
+	assert(strstr(playlist, "#EXT-X-PART:DURATION=1.000,URI=\"4.0.m4s\",INDEPENDENT=YES\n#EXT-X-PART:DURATION=1.000,URI=\"4.1.m4s\"\n"));
+	assert(strstr(playlist, "#EXTINF:4.000,\n5.m4s\n#EXT-X-PART:DURATION=1.000,URI=\"6.0.m4s\",INDEPENDENT=YES\n#EXT-X-PRELOAD-HINT:TYPE=PART,URI=\"6.1.m4s\"\n"));
+	hls_m3u8_destroy(m3u8);
+
+	// delta update
+	m3u8 = hls_m3u8_create(20, 3);
+	assert(0 == hls_m3u8_set_skip(m3u8, 12000));
+	for (i = 0; i < 20; i++)
+	{
+		snprintf(name, sizeof(name), "%d.ts", i);
+		assert(0 == hls_m3u8_add(m3u8, name, i * 2000, 2000, 5 == i ? 1 : 0));
+	}
+	ptr = hls_m3u8_get_playlist(m3u8, 0, 0, &n);
+	assert(ptr && n == strlen(ptr) && ptr == hls_m3u8_get_playlist(m3u8, 0, 0, NULL)); // cached
+	assert(strstr(ptr, "#EXT-X-VERSION:3\n") && strstr(ptr, "#EXT-X-SERVER-CONTROL:CAN-SKIP-UNTIL=12.000\n"));
+	assert(strstr(ptr, "#EXT-X-DISCONTINUITY\n#EXTINF:2.000,\n5.ts\n"));
+	assert(0 == hls_m3u8_playlist(m3u8, 0, playlist, sizeof(playlist)) && 0 == strcmp(playlist, ptr));
+	assert(-ENOMEM == hls_m3u8_playlist(m3u8, 0, playlist, n));
+	ptr = hls_m3u8_get_playlist(m3u8, 0, 1, &n);
+	assert(ptr && n == strlen(ptr));
+	assert(strstr(ptr, "#EXT-X-VERSION:9\n") && strstr(ptr, "#EXT-X-SKIP:SKIPPED-SEGMENTS=14\n#EXTINF:2.000,\n14.ts\n"));
+	ptr = hls_m3u8_get_playlist(m3u8, 1, 0, &n);
+	assert(ptr && n == strlen(ptr) && strstr(ptr, "19.ts\n#EXT-X-ENDLIST\n"));
+
+	for (i = 20; i < 40; i++)
+	{
+		snprintf(name, sizeof(name), "%d.ts", i);
+		assert(0 == hls_m3u8_add(m3u8, name, i * 2000, 2000, 0));
+	}
+	ptr = hls_m3u8_get_playlist(m3u8, 0, 0, &n);
+	assert(ptr && n == strlen(ptr) && !strstr(ptr, "\n19.ts\n") && strstr(ptr, "#EXT-X-MEDIA-SEQUENCE:20\n") && strstr(ptr, "#EXT-X-SERVER-CONTROL:CAN-SKIP-UNTIL=12.000\n#EXTINF:2.000,\n20.ts\n"));
+	hls_m3u8_destroy(m3u8);
+
+	// EXT-X-KEY: key rotation per 2 segments
+	m3u8 = hls_m3u8_create(3, 5);
+	assert(-EINVAL == hls_m3u8_set_key(m3u8, HLS_CRYPTO_AES_128, NULL, NULL));
+	for (i = 0; i < 6; i++)
+	{
+		if (0 == i % 2)
+		{
+			snprintf(name, sizeof(name), "%d.key", i / 2);
+			assert(0 == hls_m3u8_set_key(m3u8, HLS_CRYPTO_AES_128, name, NULL));
+		}
+		snprintf(name, sizeof(name), "%d.ts", i);
+		assert(0 == hls_m3u8_add(m3u8, name, i * 2000, 2000, 0));
+	}
+	ptr = hls_m3u8_get_playlist(m3u8, 0, 0, &n);
+	assert(ptr && n == strlen(ptr) && strstr(ptr, "#EXT-X-MEDIA-SEQUENCE:3\n#EXT-X-KEY:METHOD=AES-128,URI=\"1.key\"\n#EXTINF:2.000,\n3.ts\n#EXT-X-KEY:METHOD=AES-128,URI=\"2.key\"\n#EXTINF:2.000,\n4.ts\n#EXTINF:2.000,\n5.ts\n"));
+	assert(0 == hls_m3u8_set_key(m3u8, HLS_CRYPTO_NONE, NULL, NULL));
+	assert(0 == hls_m3u8_add(m3u8, "6.ts", 12000, 2000, 0));
+	assert(0 == hls_m3u8_set_key(m3u8, HLS_CRYPTO_SAMPLE_AES, "skd://3", (const uint8_t*)"\x00\x01\x02\x03\x04\x05\x06\x07\x08\x09\x0a\x0b\x0c\x0d\x0e\x0f"));
+	assert(0 == hls_m3u8_set_part(m3u8, 1000) && 0 == hls_m3u8_add_part(m3u8, "7.0.ts", 1000, 1));
+	ptr = hls_m3u8_get_playlist(m3u8, 0, 0, &n);
+	assert(ptr && n == strlen(ptr) && strstr(ptr, "#EXT-X-KEY:METHOD=AES-128,URI=\"2.key\"\n#EXTINF:2.000,\n4.ts\n#EXTINF:2.000,\n5.ts\n#EXT-X-KEY:METHOD=NONE\n#EXTINF:2.000,\n6.ts\n"));
+	assert(strstr(ptr, "#EXT-X-KEY:METHOD=SAMPLE-AES,URI=\"skd://3\",IV=0x000102030405060708090A0B0C0D0E0F\n#EXT-X-PART:DURATION=1.000,URI=\"7.0.ts\",INDEPENDENT=YES\n"));
+	hls_m3u8_destroy(m3u8);
 }
+#endif
@@ -1,11 +1,14 @@
 #include "hls-media.h"
 #include "hls-param.h"
+#include "hls-aes.h"
 #include "mpeg-ts.h"
 #include "mpeg-ps.h"
 #include "mpeg-util.h"
+#include "mpeg4-aac.h"
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
+#include <errno.h>
 
 #define N_TS_PACKET 188
 #define N_TS_FILESIZE (100 * 1024 * 1024) // 100M
@@ -31,39 +34,53 @@ struct hls_media_t
 
 	hls_media_handler handler;
 	void* param;
+
+	// LL-HLS partial segment
+	int64_t part_duration; // user setting part duration, 0-disable
+	int64_t part_dts;	// part first dts
+	int64_t part_pts;	// part first pts
+	size_t part_offset;	// part start position in ts file
+	int part_independent;
+	int64_t frame_dts[2];	// last dts per track(0-audio, 1-video)
+	int64_t frame_duration[2]; // last frame interval per track(estimate current frame duration)
+	hls_media_part_handler onpart;
+	void* part_param;
+
+	// EXT-X-KEY
+	struct hls_aes_t aes;
+	int64_t seq;		// media sequence number of the segment
+	size_t encrypted;	// AES-128: encrypted bytes of the segment
+	int sample_aes;		// SAMPLE-AES: 0x01-audio signaled, 0x02-video signaled
+	uint8_t* sample;	// SAMPLE-AES: encrypted access unit
+	size_t sample_capacity;
 };
 
-static void* hls_ts_alloc(void* param, size_t bytes)
+/// reserve TS packets of one access unit, mpeg-ts muxer build packets in place(mpeg_ts_set_buffer)
+static int hls_ts_reserve(struct hls_media_t* hls, size_t bytes)
 {
-	struct hls_media_t* hls;
-	hls = (struct hls_media_t*)param;
-	assert(188 == bytes);
+	void* p;
+	size_t n;
+
+	// payload(184-bytes per packet) + first/last packet + SDT/PAT/PMT
+	n = (bytes / 184 + 8) * N_TS_PACKET;
 	assert(hls->capacity >= hls->bytes);
-	if (hls->capacity - hls->bytes < bytes)
+	if (hls->capacity - hls->bytes < n)
 	{
-		void* p = realloc(hls->ptr, hls->capacity + bytes + N_TS_PACKET * 10 * 1024);
+		p = realloc(hls->ptr, hls->capacity + n + N_TS_PACKET * 10 * 1024);
 		if (NULL == p)
-			return NULL;
+			return -ENOMEM;
 		hls->ptr = p;
-		hls->capacity += bytes + N_TS_PACKET * 10 * 1024;
+		hls->capacity += n + N_TS_PACKET * 10 * 1024;
 	}
-	return hls->ptr + hls->bytes;
-}
-
-static void hls_ts_free(void* param, void* packet)
-{
-	struct hls_media_t* hls;
-	hls = (struct hls_media_t*)param;
-	assert(packet == hls->ptr + hls->bytes - 188);
-	assert(hls->ptr <= (uint8_t*)packet && hls->ptr + hls->capacity > (uint8_t*)packet);
+	return mpeg_ts_set_buffer(hls->ts, hls->ptr + hls->bytes, hls->capacity - hls->bytes, 0);
 }
 
 static int hls_ts_write(void* param, const void* packet, size_t bytes)
 {
 	struct hls_media_t* hls;
 	hls = (struct hls_media_t*)param;
-	assert(188 == bytes);
-	assert(hls->ptr <= (uint8_t*)packet && hls->ptr + hls->capacity > (uint8_t*)packet);
+	assert(0 == bytes % N_TS_PACKET && packet == hls->ptr + hls->bytes);
+	assert(hls->bytes + bytes <= hls->capacity);
 	hls->bytes += bytes; // update packet length
 	return 0;
 }
@@ -71,9 +88,9 @@ static int hls_ts_write(void* param, const void* packet, size_t bytes)
 static void* hls_ts_create(struct hls_media_t* hls)
 {
 	struct mpeg_ts_func_t handler;
-	handler.alloc = hls_ts_alloc;
+	handler.alloc = NULL; // batched output only
 	handler.write = hls_ts_write;
-	handler.free = hls_ts_free;
+	handler.free = NULL;
 	return mpeg_ts_create(&handler, hls);
 }
 
@@ -100,6 +117,7 @@ struct hls_media_t* hls_media_create(int64_t duration, hls_media_handler handler
 	hls->maxsize = N_TS_FILESIZE;
 	hls->dts = hls->pts = PTS_NO_VALUE;
 	hls->dts_last = PTS_NO_VALUE;
+	hls->frame_dts[0] = hls->frame_dts[1] = PTS_NO_VALUE;
 	hls->duration = duration;
 	hls->handler = handler;
 	hls->param = param;
@@ -117,9 +135,135 @@ void hls_media_destroy(struct hls_media_t* hls)
 		free(hls->ptr);
 	}
 
+	if (hls->sample)
+		free(hls->sample);
+	hls_aes_free(&hls->aes);
 	free(hls);
 }
 
+int hls_media_set_part(hls_media_t* hls, int64_t duration, hls_media_part_handler handler, void* param)
+{
+	if (HLS_CRYPTO_AES_128 == hls->aes.method && handler && duration > 0)
+		return -EINVAL; // partial segment can't be decrypted without the previous cipher block
+
+	hls->part_duration = handler ? duration : 0;
+	hls->onpart = handler;
+	hls->part_param = param;
+	return 0;
+}
+
+/// notify ts packets since last part
+static int hls_media_part(struct hls_media_t* hls, int64_t dts)
+{
+	size_t offset;
+	if (hls->bytes <= hls->part_offset)
+		return 0;
+
+	offset = hls->part_offset;
+	hls->part_offset = hls->bytes;
+	return hls->onpart(hls->part_param, hls->ptr + offset, hls->bytes - offset, hls->part_pts, hls->part_dts, dts - hls->part_dts, hls->part_independent);
+}
+
+int hls_media_set_encrypt(hls_media_t* hls, int method, int rotation, hls_crypto_onkey onkey, void* param)
+{
+	if (HLS_CRYPTO_AES_128 == method && hls->part_duration > 0)
+		return -EINVAL;
+	if (HLS_CRYPTO_NONE != method && HLS_CRYPTO_AES_128 != method && HLS_CRYPTO_SAMPLE_AES != method)
+		return -EINVAL;
+	if (hls->bytes > 0)
+		return -EBUSY; // before the first input
+	return hls_aes_init(&hls->aes, method, rotation, onkey, param);
+}
+
+/// AES-128: encrypt full blocks as the TS packets are produced(no extra pass over the segment)
+static int hls_media_encrypt(struct hls_media_t* hls, int eof)
+{
+	int r;
+	void* p;
+	size_t n;
+
+	assert(hls->encrypted <= hls->bytes && 0 == hls->encrypted % 16);
+	if (eof)
+	{
+		// PKCS7 padding, 16 bytes at most
+		if (hls->capacity < hls->bytes + 16)
+		{
+			p = realloc(hls->ptr, hls->bytes + 16);
+			if (NULL == p)
+				return -ENOMEM;
+			hls->ptr = p;
+			hls->capacity = hls->bytes + 16;
+		}
+		hls->bytes = hls_aes_pkcs7(hls->ptr, hls->bytes);
+	}
+
+	n = (hls->bytes - hls->encrypted) / 16 * 16;
+	if (0 == n)
+		return 0;
+
+	if (0 == hls->encrypted)
+		hls_aes_cbc_begin(&hls->aes, hls->aes.iv);
+	r = hls_aes_cbc_update(&hls->aes, hls->ptr + hls->encrypted, n);
+	hls->encrypted += n;
+	return r;
+}
+
+/// SAMPLE-AES: H.264 slice NAL units and AAC ADTS frames, other codecs are clear
+static int hls_media_sample_aes(struct hls_media_t* hls, int avtype, const void** data, size_t* bytes)
+{
+	int r;
+	void* p;
+	size_t n;
+	uint8_t asc[8];
+	struct mpeg4_aac_t aac;
+
+	if (PSI_STREAM_H264 != avtype && PSI_STREAM_AAC != avtype)
+		return 0;
+
+	n = *bytes * 3 / 2 + 4; // emulation prevention bytes
+	if (n > hls->sample_capacity)
+	{
+		p = realloc(hls->sample, n);
+		if (NULL == p)
+			return -ENOMEM;
+		hls->sample = (uint8_t*)p;
+		hls->sample_capacity = n;
+	}
+
+	if (PSI_STREAM_AAC == avtype)
+	{
+		// PMT audio setup information: AudioSpecificConfig
+		if (0 == (hls->sample_aes & 0x01))
+		{
+			memset(&aac, 0, sizeof(aac));
+			r = mpeg4_aac_adts_load((const uint8_t*)*data, *bytes, &aac);
+			r = r > 0 ? mpeg4_aac_audio_specific_config_save(&aac, asc, sizeof(asc)) : -EINVAL;
+			r = r > 0 ? mpeg_ts_set_sample_aes(hls->ts, hls->audio, asc, r) : -EINVAL;
+			if (0 != r) return r;
+			hls->sample_aes |= 0x01;
+		}
+
+		memcpy(hls->sample, *data, *bytes);
+		r = hls_aes_sample_adts(&hls->aes, hls->sample, *bytes);
+	}
+	else
+	{
+		if (0 == (hls->sample_aes & 0x02))
+		{
+			r = mpeg_ts_set_sample_aes(hls->ts, hls->video, NULL, 0);
+			if (0 != r) return r;
+			hls->sample_aes |= 0x02;
+		}
+
+		r = hls_aes_sample_h264(&hls->aes, (const uint8_t*)*data, *bytes, hls->sample, hls->sample_capacity);
+		*bytes = r > 0 ? (size_t)r : *bytes;
+		r = r > 0 ? 0 : r;
+	}
+
+	*data = hls->sample;
+	return r;
+}
+
 int hls_media_add_stream(hls_media_t* hls, int avtype, const void* extra, size_t bytes)
 {
 	if (mpeg_stream_type_audio(avtype))
@@ -139,6 +283,7 @@ int hls_media_add_stream(hls_media_t* hls, int avtype, const void* extra, size_t
 int hls_media_input(struct hls_media_t* hls, int avtype, const void* data, size_t bytes, int64_t pts, int64_t dts, int flags)
 {
 	int r;
+	int track;
 	int stream;
 	int segment;
 	int force_new_segment;
@@ -147,6 +292,11 @@ int hls_media_input(struct hls_media_t* hls, int avtype, const void* data, size_
 	assert(dts < hls->dts_last + hls->duration || PTS_NO_VALUE == hls->dts_last);
 	stream = hls_media_add_stream(hls, avtype, NULL, 0);
 
+	// frame duration: dts interval of the same track, not the A/V interleave gap
+	track = mpeg_stream_type_video(avtype) ? 1 : 0;
+	if (PTS_NO_VALUE != hls->frame_dts[track] && dts > hls->frame_dts[track])
+		hls->frame_duration[track] = dts - hls->frame_dts[track];
+
 	// PTS/DTS rewind
 	force_new_segment = 0;
 	if (dts + hls->duration < hls->dts_last || NULL == data || 0 == bytes)
@@ -176,23 +326,119 @@ int hls_media_input(struct hls_media_t* hls, int avtype, const void* data, size_
 		if (hls->bytes > 0)
 		{
 			duration = ((force_new_segment || dts > hls->dts_last + 100) ? hls->dts_last : dts) - hls->dts;
-			r = hls->handler(hls->param, hls->ptr, hls->bytes, hls->pts, hls->dts, duration);
+			r = hls->part_duration > 0 ? hls_media_part(hls, hls->dts + duration) : 0; // last part
+			if (0 == r && HLS_CRYPTO_AES_128 == hls->aes.method)
+				r = hls_media_encrypt(hls, 1);
+			if (0 == r)
+				r = hls->handler(hls->param, hls->ptr, hls->bytes, hls->pts, hls->dts, duration);
 			if (0 != r) return r;
+			hls->seq++;
 
 			// reset mpeg ts generator
 			mpeg_ts_reset(hls->ts);
 		}
 
-		// new segment
+		// new segment(key rotation)
+		r = hls_aes_segment(&hls->aes, hls->seq);
+		if (0 != r) return r;
+
+		hls->encrypted = 0;
 		hls->pts = pts;
 		hls->dts = dts;
 		hls->bytes = 0;
 		hls->audio_only_flag = 1;
+		hls->part_offset = 0;
+		hls->part_pts = pts;
+		hls->part_dts = dts;
+		hls->part_independent = (HLS_FLAGS_KEYFRAME & flags) || hls->video < 0;
+	}
+	else if (hls->part_duration > 0 && dts + hls->frame_duration[track] - hls->part_dts > hls->part_duration)
+	{
+		// part duration MUST be less than or equal to the part target(current frame end estimated by the track frame interval)
+		r = hls_media_part(hls, dts);
+		if (0 != r) return r;
+
+		hls->part_pts = pts;
+		hls->part_dts = dts;
+		hls->part_independent = (HLS_FLAGS_KEYFRAME & flags) || hls->video < 0;
 	}
 
     if (hls->audio_only_flag && mpeg_stream_type_video(avtype))
 		hls->audio_only_flag = 0; // clear audio only flag
 
 	hls->dts_last = dts;
-	return mpeg_ts_write(hls->ts, stream, HLS_FLAGS_KEYFRAME & flags ? 1 : 0, pts * 90, dts * 90, data, bytes);
+	hls->frame_dts[track] = dts;
+	if (HLS_CRYPTO_SAMPLE_AES == hls->aes.method && data && bytes > 0)
+	{
+		r = hls_media_sample_aes(hls, avtype, &data, &bytes);
+		if (0 != r) return r;
+	}
+
+	r = hls_ts_reserve(hls, bytes);
+	if (0 != r) return r;
+	r = mpeg_ts_write(hls->ts, stream, HLS_FLAGS_KEYFRAME & flags ? 1 : 0, pts * 90, dts * 90, data, bytes);
+	if (0 == r && HLS_CRYPTO_AES_128 == hls->aes.method)
+		r = hls_media_encrypt(hls, 0);
+	return r;
+}
+
+#if defined(_DEBUG) || defined(DEBUG)
+struct hls_media_part_test_t
+{
+	int64_t end; // max frame end(dts + frame duration) of the current part
+	int parts;
+};
+
+static int hls_media_part_test_onsegment(void* param, const void* data, size_t bytes, int64_t pts, int64_t dts, int64_t duration)
+{
+	(void)param, (void)data, (void)bytes, (void)pts, (void)dts, (void)duration;
+	return 0;
+}
+
+static int hls_media_part_test_onpart(void* param, const void* data, size_t bytes, int64_t pts, int64_t dts, int64_t duration, int independent)
+{
+	struct hls_media_part_test_t* ctx;
+	ctx = (struct hls_media_part_test_t*)param;
+	assert(bytes > 0 && duration > 0 && duration <= 200);
+	assert(ctx->end - dts <= 200); // the last frame of the part ends within the part target
+	ctx->end = 0;
+	ctx->parts++;
+	(void)data, (void)pts, (void)independent;
+	return 0;
+}
+
+// 25fps H.264 + 44.1kHz AAC(23.2ms), part target 200ms:
+// the A/V interleave gap(0~17ms) underestimates the video frame duration
+static void hls_media_part_test_cut(void)
+{
+	int i, j, avtype;
+	int64_t dts, audio, video;
+	uint8_t frame[64];
+	hls_media_t* hls;
+	struct hls_media_part_test_t ctx;
+
+	memset(&ctx, 0, sizeof(ctx));
+	memset(frame, 0, sizeof(frame));
+	hls = hls_media_create(10000, hls_media_part_test_onsegment, NULL);
+	assert(0 == hls_media_set_part(hls, 200, hls_media_part_test_onpart, &ctx));
+	for (i = j = 0; i < 75; )
+	{
+		audio = (int64_t)j * 1024 * 1000 / 44100;
+		video = (int64_t)i * 40;
+		avtype = video <= audio ? PSI_STREAM_H264 : PSI_STREAM_AAC;
+		dts = PSI_STREAM_H264 == avtype ? video : audio;
+		assert(0 == hls_media_input(hls, avtype, frame, sizeof(frame), dts, dts, 0 == i ? HLS_FLAGS_KEYFRAME : 0));
+		if (PSI_STREAM_H264 == avtype)
+			ctx.end = VMAX(ctx.end, dts + 40), i++;
+		else
+			ctx.end = VMAX(ctx.end, (int64_t)(j + 1) * 1024 * 1000 / 44100), j++;
+	}
+	assert(ctx.parts >= 14 && ctx.parts <= 16); // 3s / 200ms
+	hls_media_destroy(hls);
+}
+
+void hls_media_part_test(void)
+{
+	hls_media_part_test_cut();
 }
+#endif
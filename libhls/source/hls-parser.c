@@ -27,6 +27,22 @@ struct hls_parser_t
 	struct hls_playlist_t* playlist;
 };
 
+// text arena of a parse/refresh, freed when all it's segments are removed from the playlist
+struct hls_playlist_arena_t
+{
+	struct hls_playlist_arena_t* next;
+	uint64_t sequence; // media sequence of the last segment in the arena
+};
+
+// hls_playlist_parse/hls_playlist_refresh media playlist
+struct hls_playlist_context_t
+{
+	struct hls_playlist_t playlist; // MUST be the first member
+	struct hls_segment_t* base; // segments array, playlist.segments = base + expired segments
+	size_t capacity;
+	struct hls_playlist_arena_t* arenas; // oldest first
+};
+
 enum 
 { 
 	ATTR_VALUE_TYPE_UINT32, 
@@ -703,28 +719,236 @@ int hls_master_parse(struct hls_master_t** master, const char* m3u8, size_t len)
 	return 0;
 }
 
-int hls_playlist_parse(struct hls_playlist_t** playlist, const char* m3u8, size_t len)
+/// @return uri(segment) line count
+static size_t hls_parser_count_uri(const char* m3u8, size_t len)
+{
+	size_t n, count;
+	const char* ptr, *next;
+
+	count = 0;
+	for (ptr = m3u8; ptr && ptr < m3u8 + len; ptr = next)
+	{
+		n = hls_strsplit(ptr, m3u8 + len, "\r\n", "", &next);
+		ptr = hls_strtrim(ptr, &n, " \t", " \t"); // trim SP/HTAB
+		if (n > 0 && '#' != *ptr)
+			count++;
+	}
+	return count;
+}
+
+/// Find the last known segment in the reloaded playlist, parse EXT-X-MEDIA-SEQUENCE/EXT-X-DISCONTINUITY-SEQUENCE only
+/// @return offset of the first new segment, 0-don't have known segment(parse all)
+static size_t hls_playlist_skip(struct hls_parser_t* parser, const struct hls_playlist_t* playlist, const char* m3u8, size_t len)
+{
+	int segment;
+	size_t n;
+	uint64_t sequence, last;
+	const char* ptr, *next, *uri;
+
+	segment = 0;
+	sequence = 0;
+	last = playlist->media_sequence + playlist->count - 1;
+	for (ptr = m3u8; ptr < m3u8 + len; ptr = next)
+	{
+		// known segments: line scan only(memchr), don't tokenize
+		next = (const char*)memchr(ptr, '\n', m3u8 + len - ptr);
+		next = next ? next + 1 : m3u8 + len;
+		n = next - ptr;
+		ptr = hls_strtrim(ptr, &n, " \t", " \t\r\n"); // trim SP/HTAB/CRLF
+		if (n < 1)
+			continue; // blank line
+
+		if ('#' == *ptr)
+		{
+			// Media Playlist tags MUST appear before the first Media Segment
+			if (segment)
+				continue;
+			else if (n > 21 && 0 == strncasecmp("#EXT-X-MEDIA-SEQUENCE:", ptr, 22))
+				hls_ext_x_media_sequence(parser, ptr + 22, n - 22);
+			else if (n > 29 && 0 == strncasecmp("#EXT-X-DISCONTINUITY-SEQUENCE:", ptr, 30))
+				hls_ext_x_discontinuity_sequence(parser, ptr + 30, n - 30);
+			continue;
+		}
+
+		if (!segment)
+		{
+			segment = 1;
+			sequence = parser->playlist->media_sequence;
+			if (sequence < playlist->media_sequence || sequence > last)
+				return 0; // server restarted or segments missed
+		}
+
+		if (sequence++ < last)
+			continue;
+
+		// the last known segment MUST have the same uri
+		uri = playlist->segments[playlist->count - 1].uri;
+		return (uri && strlen(uri) == n && 0 == memcmp(uri, ptr, n)) ? (size_t)(next - m3u8) : 0;
+	}
+
+	return 0;
+}
+
+static size_t hls_playlist_key_copy(char** key, char* ptr)
+{
+	size_t n;
+	if (!*key)
+		return 0;
+
+	n = strlen(*key) + 1;
+	if (ptr)
+	{
+		memcpy(ptr, *key, n);
+		*key = ptr;
+	}
+	return n;
+}
+
+/// EXT-X-KEY of the last known segment, copy to the new arena(the arena of the key tag may be freed)
+static size_t hls_playlist_key(struct hls_segment_t* segment, char* ptr)
+{
+	size_t n;
+	n = hls_playlist_key_copy(&segment->key.method, ptr);
+	n += hls_playlist_key_copy(&segment->key.uri, ptr ? ptr + n : NULL);
+	n += hls_playlist_key_copy(&segment->key.keyformat, ptr ? ptr + n : NULL);
+	n += hls_playlist_key_copy(&segment->key.keyformatversions, ptr ? ptr + n : NULL);
+	return n;
+}
+
+int hls_playlist_refresh(struct hls_playlist_t** playlist, const char* m3u8, size_t len)
 {
 	int r;
-	char* ptr;
+	char* text;
+	size_t n, offset, start, head, keys;
+	uint64_t sequence, discontinuity;
 	struct hls_parser_t parser;
+	struct hls_playlist_t tmp;
+	struct hls_segment_t key;
+	struct hls_segment_t* segments;
+	struct hls_playlist_arena_t* arena, *next, **pp;
+	struct hls_playlist_context_t* ctx;
+
+	ctx = (struct hls_playlist_context_t*)*playlist;
+	if (!ctx)
+	{
+		ctx = (struct hls_playlist_context_t*)calloc(1, sizeof(*ctx));
+		if (!ctx)
+			return -ENOMEM;
+	}
 
+	memset(&tmp, 0, sizeof(tmp));
 	memset(&parser, 0, sizeof(parser));
-	parser.playlist = (struct hls_playlist_t*)calloc(1, sizeof(struct hls_playlist_t) + len + 1);
-	if (!parser.playlist)
-		return -ENOMEM;
+	parser.playlist = &tmp;
+	offset = ctx->playlist.count > 0 ? hls_playlist_skip(&parser, &ctx->playlist, m3u8, len) : 0;
 
-	ptr = (char*)(parser.playlist + 1);
-	memcpy(ptr, m3u8, len);
+	start = ctx->playlist.count; // expired segments
+	memset(&key, 0, sizeof(key));
+	if (offset > 0)
+	{
+		// reuse known segments and playlist tags
+		start = (size_t)(tmp.media_sequence - ctx->playlist.media_sequence);
+		sequence = tmp.media_sequence;
+		discontinuity = tmp.discontinuity_sequence;
+		memcpy(&tmp, &ctx->playlist, sizeof(tmp));
+		tmp.media_sequence = sequence;
+		tmp.discontinuity_sequence = discontinuity;
+		tmp.segments += start;
+		tmp.count -= start;
+		memcpy(&key.key, &tmp.segments[tmp.count - 1].key, sizeof(key.key));
+	}
 
-	r = hls_parser_input(&parser, ptr, len);
+	// single arena per refresh: new segments text + EXT-X-KEY
+	keys = hls_playlist_key(&key, NULL);
+	arena = (struct hls_playlist_arena_t*)malloc(sizeof(*arena) + len - offset + 1 + keys);
+	if (!arena)
+	{
+		if (!*playlist)
+			free(ctx);
+		return -ENOMEM;
+	}
+	arena->next = NULL;
+	text = (char*)(arena + 1);
+	memcpy(text, m3u8 + offset, len - offset);
+	text[len - offset] = 0;
+	hls_playlist_key(&key, text + len - offset + 1);
+
+	// segments array: [base, head) expired, [head, head + count) known, then new segments
+	n = hls_parser_count_uri(text, len - offset) + 1;
+	segments = ctx->base;
+	head = ctx->playlist.segments ? (size_t)(ctx->playlist.segments - ctx->base) + start : 0;
+	if (head + tmp.count + n > ctx->capacity)
+	{
+		segments = (struct hls_segment_t*)malloc((tmp.count + n + (tmp.count + n) / 2) * sizeof(struct hls_segment_t));
+		if (!segments)
+		{
+			free(arena);
+			if (!*playlist)
+				free(ctx);
+			return -ENOMEM;
+		}
+		if (tmp.count > 0)
+			memcpy(segments, tmp.segments, tmp.count * sizeof(struct hls_segment_t));
+		head = 0;
+	}
+	tmp.segments = segments + head;
+	memset(tmp.segments + tmp.count, 0, n * sizeof(struct hls_segment_t));
+
+	parser.segment_capacity = tmp.count + n; // don't realloc
+	parser.key_segment = offset > 0 ? &key : NULL;
+	r = hls_parser_input(&parser, text, len - offset);
+	assert(tmp.segments == segments + head); // don't realloc
 	if (0 != r)
 	{
-		hls_playlist_free(&parser.playlist);
+		if (segments != ctx->base)
+			free(segments);
+		free(arena);
+		if (!*playlist)
+			free(ctx);
 		return r;
 	}
 
-	*playlist = parser.playlist;
+	// free arenas of the expired segments
+	arena->sequence = tmp.media_sequence + tmp.count - 1;
+	for (pp = &ctx->arenas; *pp; )
+	{
+		if (0 == offset || (*pp)->sequence < tmp.media_sequence)
+		{
+			next = (*pp)->next;
+			free(*pp);
+			*pp = next;
+		}
+		else
+		{
+			pp = &(*pp)->next;
+		}
+	}
+	*pp = arena;
+
+	if (segments != ctx->base)
+	{
+		if (ctx->base)
+			free(ctx->base);
+		ctx->base = segments;
+		ctx->capacity = tmp.count + n + (tmp.count + n) / 2;
+	}
+
+	n = offset > 0 ? ctx->playlist.count - start : 0; // known segments
+	memcpy(&ctx->playlist, &tmp, sizeof(tmp));
+	*playlist = &ctx->playlist;
+	return (int)(tmp.count - n);
+}
+
+int hls_playlist_parse(struct hls_playlist_t** playlist, const char* m3u8, size_t len)
+{
+	int r;
+	struct hls_playlist_t* p;
+
+	p = NULL;
+	r = hls_playlist_refresh(&p, m3u8, len);
+	if (r < 0)
+		return r;
+
+	*playlist = p;
 	return 0;
 }
 
@@ -759,13 +983,20 @@ int hls_master_free(struct hls_master_t** master)
 
 int hls_playlist_free(struct hls_playlist_t** playlist)
 {
-	struct hls_playlist_t* p;
+	struct hls_playlist_arena_t* arena;
+	struct hls_playlist_context_t* ctx;
 	if (playlist && *playlist)
 	{
-		p = *playlist;
-		if (p->segments)
-			free(p->segments);
-		free(p);
+		ctx = (struct hls_playlist_context_t*)*playlist;
+		while (ctx->arenas)
+		{
+			arena = ctx->arenas;
+			ctx->arenas = arena->next;
+			free(arena);
+		}
+		if (ctx->base)
+			free(ctx->base);
+		free(ctx);
 		*playlist = NULL;
 		return 0;
 	}
@@ -791,6 +1022,7 @@ int hls_parser_probe(const char* m3u8, size_t len)
 }
 
 #if defined(_DEBUG) || defined(DEBUG)
+#include <time.h>
 void hls_parser_test(const char* m3u8)
 {
 	static char data[2 * 1024 * 1024];
@@ -816,4 +1048,88 @@ void hls_parser_test(const char* m3u8)
 		assert(0);
 	}
 }
+
+static size_t hls_playlist_refresh_test_m3u8(char* m3u8, const char* body, const size_t* lines, int sequence, int count)
+{
+	size_t n;
+	n = snprintf(m3u8, 128, "#EXTM3U\n#EXT-X-VERSION:3\n#EXT-X-TARGETDURATION:2\n#EXT-X-MEDIA-SEQUENCE:%d\n#EXT-X-KEY:METHOD=AES-128,URI=\"key.bin\"\n", sequence);
+	memcpy(m3u8 + n, body + lines[sequence], lines[sequence + count] - lines[sequence]);
+	return n + lines[sequence + count] - lines[sequence];
+}
+
+void hls_playlist_refresh_test(void)
+{
+	const int W = 10000; // live window segments
+	const int N = 1000; // reload count
+	int i, j, r;
+	size_t n, bytes, *lines;
+	char* body, *m3u8;
+	clock_t t0, t1, t2;
+	struct hls_playlist_t* playlist, *full;
+	struct hls_playlist_arena_t* arena;
+	struct hls_playlist_context_t* ctx;
+
+	// segment lines of sequence [0, W + N]
+	body = (char*)malloc((W + N + 1) * 64);
+	m3u8 = (char*)malloc((W + N + 1) * 64 + 128);
+	lines = (size_t*)malloc((W + N + 2) * sizeof(size_t));
+	for (n = 0, i = 0; i <= W + N; i++)
+	{
+		lines[i] = n;
+		n += snprintf(body + n, 64, "#EXTINF:2.000,\nhttp://cdn.example.com/live/seg-%d.ts\n", i);
+	}
+	lines[i] = n;
+
+	bytes = hls_playlist_refresh_test_m3u8(m3u8, body, lines, 0, W);
+	t0 = clock();
+	for (i = 0; i < 20; i++)
+	{
+		assert(0 == hls_playlist_parse(&playlist, m3u8, bytes));
+		assert(W == playlist->count && 0 == strcmp(playlist->segments[W - 1].key.uri, "key.bin"));
+		hls_playlist_free(&playlist);
+	}
+	t1 = clock();
+	printf("hls_playlist_parse: %d segments, %.3f ms/parse\n", W, (t1 - t0) * 1000.0 / CLOCKS_PER_SEC / 20);
+
+	playlist = NULL;
+	assert(W == hls_playlist_refresh(&playlist, m3u8, bytes));
+	t2 = 0;
+	for (i = 1; i <= N; i++)
+	{
+		// one new segment per reload
+		bytes = hls_playlist_refresh_test_m3u8(m3u8, body, lines, i, W);
+		t0 = clock();
+		r = hls_playlist_refresh(&playlist, m3u8, bytes);
+		t2 += clock() - t0;
+		assert(1 == r && W == playlist->count && (uint64_t)i == playlist->media_sequence);
+	}
+
+	ctx = (struct hls_playlist_context_t*)playlist;
+	for (n = sizeof(*ctx) + ctx->capacity * sizeof(struct hls_segment_t), j = 0, arena = ctx->arenas; arena; arena = arena->next, j++)
+		n += sizeof(*arena) + strlen((const char*)(arena + 1)) + 1;
+	printf("hls_playlist_refresh: %d segments, %.3f ms/refresh, memory: %d arenas, %u bytes\n", W, t2 * 1000.0 / CLOCKS_PER_SEC / N, j, (unsigned int)n);
+	assert(j <= W + 1);
+
+	// same as full parse
+	assert(0 == hls_playlist_parse(&full, m3u8, bytes));
+	assert(full->count == playlist->count && full->media_sequence == playlist->media_sequence);
+	for (i = 0; i < W; i++)
+	{
+		assert(0 == strcmp(full->segments[i].uri, playlist->segments[i].uri));
+		assert(full->segments[i].duration == playlist->segments[i].duration);
+		assert(0 == strcmp(full->segments[i].key.uri, playlist->segments[i].key.uri) && 0 == strcmp(full->segments[i].key.method, playlist->segments[i].key.method));
+	}
+	hls_playlist_free(&full);
+
+	// no reload change
+	assert(0 == hls_playlist_refresh(&playlist, m3u8, bytes));
+	// server restart: media sequence rewind
+	bytes = hls_playlist_refresh_test_m3u8(m3u8, body, lines, 0, 10);
+	assert(10 == hls_playlist_refresh(&playlist, m3u8, bytes) && 10 == playlist->count && 0 == playlist->media_sequence);
+	hls_playlist_free(&playlist);
+
+	free(lines);
+	free(m3u8);
+	free(body);
+}
 #endif
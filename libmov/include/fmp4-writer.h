@@ -22,6 +22,31 @@ int fmp4_writer_add_audio(fmp4_writer_t* fmp4, uint8_t object, int channel_count
 int fmp4_writer_add_video(fmp4_writer_t* fmp4, uint8_t object, int width, int height, const void* extra_data, size_t extra_data_size);
 int fmp4_writer_add_subtitle(fmp4_writer_t* fmp4, uint8_t object, const void* extra_data, size_t extra_data_size);
 
+/// ISO/IEC 23001-7 Common Encryption scheme
+enum
+{
+	FMP4_CENC_SCHEME_CENC = 0x63656E63, // 'cenc': AES-CTR
+	FMP4_CENC_SCHEME_CBCS = 0x63626373, // 'cbcs': AES-CBC 1:9 pattern(video), constant IV
+};
+
+/// Encrypt track samples as fragments are written, MUST be called before the first fragment(or fmp4_writer_init_segment)
+/// 1. video: H.264/H.265 NAL unit subsample encryption(NAL header in clear), AV1 is not supported(-ENOTSUP)
+/// 2. audio: full sample encryption
+/// @param[in] track return by fmp4_writer_add_audio/fmp4_writer_add_video
+/// @param[in] scheme FMP4_CENC_SCHEME_XXX
+/// @param[in] kid default key id
+/// @param[in] key AES-128 content key
+/// @param[in] iv cenc: first 8-bytes is the first sample IV(increase by sample), cbcs: 16-bytes constant IV
+/// @return 0-ok, -ENOTSUP-codec not supported, other-error
+int fmp4_writer_set_encrypt(fmp4_writer_t* fmp4, int track, uint32_t scheme, const uint8_t kid[16], const uint8_t key[16], const uint8_t iv[16]);
+
+/// Add a DRM system specific header(pssh) to moov
+/// @param[in] system_id DRM SystemID, e.g. W3C Common PSSH 1077efec-c0b2-4d02-ace3-3c1e52e2fb4b
+/// @param[in] kids key ids(kid_count * 16 bytes), 0 == kid_count for pssh version 0
+/// @param[in] data DRM system specific data
+/// @return 0-ok, other-error
+int fmp4_writer_add_pssh(fmp4_writer_t* fmp4, const uint8_t system_id[16], const uint8_t* kids, int kid_count, const void* data, size_t bytes);
+
 /// Write audio/video stream
 /// raw AAC data, don't include ADTS/AudioSpecificConfig
 /// H.264/H.265 MP4 format, replace start code(0x00000001) with NALU size
@@ -38,11 +63,22 @@ int fmp4_writer_write(fmp4_writer_t* fmp4, int track, const void* data, size_t b
 /// @return 0-ok, other-error
 int fmp4_writer_save_segment(fmp4_writer_t* fmp4);
 
+/// Save data as a fragment(moof + mdat) of current segment, e.g. CMAF chunk/LL-HLS partial segment
+/// The segment is styp + fragments(no sidx) if this function is called in it
+/// @return 0-ok, other-error
+int fmp4_writer_save_fragment(fmp4_writer_t* fmp4);
+
 /// Get init segment data(write FTYP, MOOV only)
 /// WARNING: it caller duty to switch file/buffer context with fmp4_writer_write
 /// @return 0-ok, other-error
 int fmp4_writer_init_segment(fmp4_writer_t* fmp4);
 
+/// Hot-path metrics snapshot(build with -DMEDIA_METRICS), see more @media-metrics.h
+/// frames_in/bytes_in-fmp4_writer_write, frames_out/bytes_out-fragments(moof + mdat) and mdat bytes, buffer_hwm-pending mdat bytes
+/// @return 0-ok, -ENOSYS-metrics disabled
+struct media_metrics_t;
+int fmp4_writer_get_metrics(fmp4_writer_t* fmp4, struct media_metrics_t* metrics);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,20 @@
+#ifndef _mov_aes_h_
+#define _mov_aes_h_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// AES-128 block cipher, portable fallback of OpenSSL EVP(see mov-cenc/hls-aes, NOOPENSSL=1)
+/// @param[out] rk round keys
+void mov_aes128_expand_key(uint8_t rk[176], const uint8_t key[16]);
+
+/// encrypt one block in place
+void mov_aes128_encrypt_block(const uint8_t rk[176], uint8_t block[16]);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* !_mov_aes_h_ */
@@ -34,6 +34,12 @@ int mov_writer_add_subtitle(mov_writer_t* mov, uint8_t object, const void* extra
 /// @return 0-ok, other-error
 int mov_writer_write(mov_writer_t* mov, int track, const void* data, size_t bytes, int64_t pts, int64_t dts, int flags);
 
+/// Hot-path metrics snapshot(build with -DMEDIA_METRICS), see more @media-metrics.h
+/// frames_in/bytes_in-mov_writer_write, frames_out/bytes_out-mdat samples(write callback), buffer_hwm-sample table bytes
+/// @return 0-ok, -ENOSYS-metrics disabled
+struct media_metrics_t;
+int mov_writer_get_metrics(mov_writer_t* mov, struct media_metrics_t* metrics);
+
 #ifdef __cplusplus
 }
 #endif
@@ -1,5 +1,7 @@
 #include "fmp4-writer.h"
 #include "mov-internal.h"
+#include "mov-cenc.h"
+#include "media-metrics.h"
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
@@ -15,6 +17,14 @@ struct fmp4_writer_t
 	uint32_t frag_interleave;
 	uint32_t fragment_id; // start from 1
 	uint32_t sn; // sample sn
+	int chunks; // fmp4_writer_save_fragment count in current segment
+
+	struct mov_pssh_t* pssh;
+	int pssh_count;
+
+#if defined(MEDIA_METRICS)
+	struct media_metrics_t metrics;
+#endif
 };
 
 static int fmp4_write_app(struct mov_t* mov)
@@ -51,7 +61,7 @@ static size_t fmp4_write_mvex(struct mov_t* mov)
 static size_t fmp4_write_traf(struct mov_t* mov, uint32_t moof)
 {
 	uint32_t i, start;
-	size_t size;
+	size_t size, n;
 	uint64_t offset;
     struct mov_track_t* track;
 
@@ -103,6 +113,19 @@ static size_t fmp4_write_traf(struct mov_t* mov, uint32_t moof)
 	}
     size += mov_write_trun(mov, start, i-start, moof);
 
+	// ISO/IEC 23001-7:2016(E) 7.1 sample auxiliary information in senc, saio point to the first sample info
+	if (track->cenc && track->cenc->bytes > 0)
+	{
+		n = mov_write_saiz(mov);
+		if (n > 0)
+		{
+			size += n;
+			start = (uint32_t)(mov_buffer_tell(&mov->io) - mov->moof_offset); // default-base-is-moof
+			size += mov_write_saio(mov, start + 20 /* saio */ + 16 /* senc header + sample_count */);
+		}
+		size += mov_write_senc(mov);
+	}
+
 	mov_write_size(mov, offset, size); /* update size */
 	return size;
 }
@@ -142,12 +165,14 @@ static size_t fmp4_write_moof(struct mov_t* mov, uint32_t fragment, uint32_t moo
 	return size;
 }
 
-static size_t fmp4_write_moov(struct mov_t* mov)
+static size_t fmp4_write_moov(struct fmp4_writer_t* writer)
 {
 	int i;
 	size_t size;
 	uint32_t count;
 	uint64_t offset;
+	struct mov_t* mov;
+	mov = &writer->mov;
 
 	size = 8 /* Box */;
 	offset = mov_buffer_tell(&mov->io);
@@ -156,6 +181,8 @@ static size_t fmp4_write_moov(struct mov_t* mov)
 
 	size += mov_write_mvhd(mov);
 //	size += fmp4_write_iods(mov);
+	for (i = 0; i < writer->pssh_count; i++)
+		size += mov_write_pssh(mov, writer->pssh + i);
 	for (i = 0; i < mov->track_count; i++)
 	{
 		mov->track = mov->tracks + i;
@@ -228,9 +255,10 @@ static int fmp4_add_fragment_entry(struct mov_track_t* track, uint64_t time, uin
 	return 0;
 }
 
-static int fmp4_write_fragment(struct fmp4_writer_t* writer)
+/// @param[in] chunk 1-fragment in current segment(styp on first fragment only, no sidx)
+static int fmp4_write_fragment(struct fmp4_writer_t* writer, int chunk)
 {
-	int i;
+	int i, r;
 	size_t n;
 	size_t refsize;
 	struct mov_t* mov;
@@ -239,8 +267,16 @@ static int fmp4_write_fragment(struct fmp4_writer_t* writer)
 	if (writer->mdat_size < 1)
 		return 0; // empty
 
+	chunk = chunk || writer->chunks > 0;
+
 	// write moov
-	if (mov->flags & MOV_FLAG_SEGMENT)
+	if ((mov->flags & MOV_FLAG_SEGMENT) && chunk)
+	{
+		// CMAF chunk/LL-HLS partial segment: segment = styp + (moof + mdat) * N
+		if (0 == writer->chunks)
+			mov_write_styp(mov);
+	}
+	else if (mov->flags & MOV_FLAG_SEGMENT)
 	{
 		// write stype
 		mov_write_styp(mov);
@@ -255,11 +291,29 @@ static int fmp4_write_fragment(struct fmp4_writer_t* writer)
 	{
 		mov_write_ftyp(mov);
 		fmp4_write_app(mov);
-		fmp4_write_moov(mov);
+		fmp4_write_moov(writer);
 		writer->has_moov = 1;
 	}
 
+	// encrypt samples in place and build sample auxiliary information before moof
+	for (i = 0; i < mov->track_count; i++)
+	{
+		mov->track = mov->tracks + i;
+		if (!mov->track->cenc)
+			continue;
+
+		mov_cenc_reset(mov->track->cenc);
+		for (n = 0; n < mov->track->sample_count; n++)
+		{
+			r = mov_cenc_sample(mov->track->cenc, (uint8_t*)mov->track->samples[n].data, mov->track->samples[n].bytes);
+			if (0 != r)
+				return r;
+		}
+	}
+
 	// moof
+	MEDIA_METRICS_ADD(&writer->metrics, frames_out, 1);
+	MEDIA_METRICS_ADD(&writer->metrics, bytes_out, writer->mdat_size);
 	mov->moof_offset = mov_buffer_tell(&mov->io);
 	refsize = fmp4_write_moof(mov, ++writer->fragment_id, 0); // start from 1
     // rewrite moof with trun data offset
@@ -275,7 +329,7 @@ static int fmp4_write_fragment(struct fmp4_writer_t* writer)
 			fmp4_add_fragment_entry(mov->track, mov->track->samples[0].dts, mov->moof_offset);
 
 		// hack: write sidx referenced_size
-		if (mov->flags & MOV_FLAG_SEGMENT)
+		if ((mov->flags & MOV_FLAG_SEGMENT) && !chunk)
 			mov_write_size(mov, mov->moof_offset - 52 * (uint64_t)(mov->track_count - i) + 40, (0 << 31) | (refsize & 0x7fffffff));
 
 		mov->track->offset = 0; // reset
@@ -318,8 +372,12 @@ static int fmp4_write_fragment(struct fmp4_writer_t* writer)
 		mov->tracks[i].offset = 0;
 	}
 	writer->mdat_size = 0;
+	writer->chunks += chunk ? 1 : 0;
 
-	return mov_buffer_error(&mov->io);
+	r = mov_buffer_error(&mov->io);
+	if (0 != r)
+		MEDIA_METRICS_ADD(&writer->metrics, errors, 1);
+	return r;
 }
 
 static int fmp4_writer_init(struct mov_t* mov)
@@ -398,6 +456,10 @@ void fmp4_writer_destroy(struct fmp4_writer_t* writer)
         mov_free_track(mov->tracks + i);
 	if (mov->tracks)
 		free(mov->tracks);
+	for (i = 0; i < writer->pssh_count; i++)
+		free(writer->pssh[i].kids);
+	if (writer->pssh)
+		free(writer->pssh);
 	free(writer);
 }
 
@@ -411,6 +473,8 @@ int fmp4_writer_write(struct fmp4_writer_t* writer, int idx, const void* data, s
 		return -ENOENT;
 
 	track = &writer->mov.tracks[idx];
+	MEDIA_METRICS_ADD(&writer->metrics, frames_in, 1);
+	MEDIA_METRICS_ADD(&writer->metrics, bytes_in, bytes);
 
     duration = dts > track->last_dts && INT64_MIN != track->last_dts ? dts - track->last_dts : 0;
 #if 1
@@ -422,7 +486,7 @@ int fmp4_writer_write(struct fmp4_writer_t* writer, int idx, const void* data, s
 	// 1. force segment or
 	// 2. video key frame
 	if (0 == (flags & MOV_AV_FLAG_SEGMENT_DISABLE) && (0 != (flags & MOV_AV_FLAG_SEGMENT_FORCE) || (MOV_VIDEO == track->handler_type && (flags & MOV_AV_FLAG_KEYFREAME)))  )
-		fmp4_write_fragment(writer); // fragment per video keyframe
+		fmp4_write_fragment(writer, 0); // fragment per video keyframe
 
 	if (track->sample_count + 1 >= track->sample_offset)
 	{
@@ -430,6 +494,7 @@ int fmp4_writer_write(struct fmp4_writer_t* writer, int idx, const void* data, s
 		if (NULL == ptr) return -ENOMEM;
 		track->samples = (struct mov_sample_t*)ptr;
 		track->sample_offset += 1024;
+		MEDIA_METRICS_ADD(&writer->metrics, allocs, 1);
 	}
 
 	pts = pts * track->mdhd.timescale / 1000;
@@ -447,10 +512,12 @@ int fmp4_writer_write(struct fmp4_writer_t* writer, int idx, const void* data, s
 	if (NULL == sample->data)
 		return -ENOMEM;
 	memcpy(sample->data, data, bytes);
+	MEDIA_METRICS_ADD(&writer->metrics, allocs, 1);
 
 	if (INT64_MIN == track->start_dts)
 		track->start_dts = sample->dts;
 	writer->mdat_size += bytes; // update media data size
+	MEDIA_METRICS_MAX(&writer->metrics, buffer_hwm, writer->mdat_size);
 	track->sample_count += 1;
     track->last_dts = sample->dts;
 	return mov_buffer_error(&writer->mov.io);
@@ -507,6 +574,64 @@ int fmp4_writer_add_subtitle(struct fmp4_writer_t* writer, uint8_t object, const
     return mov->track_count++;
 }
 
+int fmp4_writer_set_encrypt(struct fmp4_writer_t* writer, int idx, uint32_t scheme, const uint8_t kid[16], const uint8_t key[16], const uint8_t iv[16])
+{
+	int r;
+	struct mov_track_t* track;
+
+	if (idx < 0 || idx >= (int)writer->mov.track_count)
+		return -ENOENT;
+	if (writer->has_moov || writer->fragment_id > 0)
+		return -EINVAL; // sample entry(encv/enca) has been written
+
+	track = &writer->mov.tracks[idx];
+	if (!track->cenc)
+	{
+		track->cenc = (struct mov_cenc_t*)calloc(1, sizeof(struct mov_cenc_t));
+		if (!track->cenc)
+			return -ENOMEM;
+	}
+
+	mov_cenc_free(track->cenc);
+	r = mov_cenc_init(track->cenc, track, scheme, kid, key, iv);
+	if (0 != r)
+	{
+		mov_cenc_free(track->cenc);
+		free(track->cenc);
+		track->cenc = NULL;
+	}
+	return r;
+}
+
+int fmp4_writer_add_pssh(struct fmp4_writer_t* writer, const uint8_t system_id[16], const uint8_t* kids, int kid_count, const void* data, size_t bytes)
+{
+	void* p;
+	struct mov_pssh_t* pssh;
+
+	if (kid_count < 0 || bytes > UINT32_MAX - 64 || (kid_count > 0 && !kids))
+		return -EINVAL;
+
+	p = realloc(writer->pssh, sizeof(struct mov_pssh_t) * (writer->pssh_count + 1));
+	if (!p)
+		return -ENOMEM;
+	writer->pssh = (struct mov_pssh_t*)p;
+
+	pssh = &writer->pssh[writer->pssh_count];
+	pssh->kids = (uint8_t*)malloc(16 * kid_count + bytes + 1);
+	if (!pssh->kids)
+		return -ENOMEM;
+	pssh->data = pssh->kids + 16 * kid_count;
+	pssh->kid_count = kid_count;
+	pssh->bytes = (uint32_t)bytes;
+	memcpy(pssh->system_id, system_id, 16);
+	if (kid_count > 0)
+		memcpy(pssh->kids, kids, 16 * kid_count);
+	if (bytes > 0)
+		memcpy(pssh->data, data, bytes);
+	writer->pssh_count++;
+	return 0;
+}
+
 int fmp4_writer_add_udta(fmp4_writer_t* writer, const void* data, size_t size)
 {
 	writer->mov.udta = data;
@@ -516,12 +641,15 @@ int fmp4_writer_add_udta(fmp4_writer_t* writer, const void* data, size_t size)
 
 int fmp4_writer_save_segment(fmp4_writer_t* writer)
 {
+	int r;
 	//int i;
 	//struct mov_t* mov;
 	//mov = &writer->mov;
 
 	// flush fragment
-	return fmp4_write_fragment(writer);
+	r = fmp4_write_fragment(writer, 0);
+	writer->chunks = 0;
+	return r;
 
 	//// write mfra
 	//if (0 == (mov->flags & MOV_FLAG_SEGMENT))
@@ -534,12 +662,29 @@ int fmp4_writer_save_segment(fmp4_writer_t* writer)
 	//return mov_buffer_error(&mov->io);
 }
 
+int fmp4_writer_save_fragment(fmp4_writer_t* writer)
+{
+	return fmp4_write_fragment(writer, 1);
+}
+
 int fmp4_writer_init_segment(fmp4_writer_t* writer)
 {
 	struct mov_t* mov;
 	mov = &writer->mov;
 	mov_write_ftyp(mov);
-	fmp4_write_moov(mov);
+	fmp4_write_moov(writer);
 	writer->has_moov = 1;
 	return mov_buffer_error(&mov->io);
 }
+
+int fmp4_writer_get_metrics(struct fmp4_writer_t* writer, struct media_metrics_t* metrics)
+{
+#if defined(MEDIA_METRICS)
+	media_metrics_snapshot(metrics, &writer->metrics);
+	return 0;
+#else
+	(void)writer;
+	memset(metrics, 0, sizeof(*metrics));
+	return -ENOSYS;
+#endif
+}
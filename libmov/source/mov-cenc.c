@@ -0,0 +1,560 @@
+// ISO/IEC 23001-7:2016(E) Common encryption in ISO base media file format files
+// 1. cenc: AES-CTR, full sample(audio) or NAL subsample(video) encryption, 8-bytes per-sample IV
+// 2. cbcs: AES-CBC 1:9 pattern(video)/all blocks(audio) encryption, constant IV
+
+#include "mov-cenc.h"
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+
+#if !defined(_OPENSSL_)
+#include "mov-aes.h" // portable AES-128, make OPENSSL=1 for OpenSSL EVP
+#endif
+
+static int mov_cenc_nalu_length(const struct mov_sample_entry_t* entry)
+{
+	// ISO/IEC 14496-15:2017(E) 5.3.3.1.2 AVCDecoderConfigurationRecord lengthSizeMinusOne
+	if (MOV_OBJECT_H264 == entry->object_type_indication && entry->extra_data_size >= 5)
+		return (entry->extra_data[4] & 0x03) + 1;
+	// ISO/IEC 14496-15:2017(E) 8.3.3.1.2 HEVCDecoderConfigurationRecord lengthSizeMinusOne
+	else if (MOV_OBJECT_H265 == entry->object_type_indication && entry->extra_data_size >= 23)
+		return (entry->extra_data[21] & 0x03) + 1;
+	return 4;
+}
+
+int mov_cenc_init(struct mov_cenc_t* cenc, const struct mov_track_t* track, uint32_t scheme, const uint8_t kid[16], const uint8_t key[16], const uint8_t iv[16])
+{
+	const struct mov_sample_entry_t* entry;
+	if ((MOV_CENC != scheme && MOV_CBCS != scheme) || track->stsd.entry_count < 1)
+		return -EINVAL;
+
+	memset(cenc, 0, sizeof(*cenc));
+	entry = &track->stsd.entries[0];
+	if (MOV_VIDEO == track->handler_type)
+	{
+		// AV1(ISO/IEC 23001-7 AV1 binding) keep the frame header in clear, it needs a full
+		// frame_header_obu() parser to find the tile data, not supported
+		if (MOV_OBJECT_H264 == entry->object_type_indication || MOV_OBJECT_H265 == entry->object_type_indication)
+			cenc->nalu_length = mov_cenc_nalu_length(entry);
+		else
+			return -ENOTSUP;
+
+		// 10.4.2 the pattern 1:9 is recommended for video
+		cenc->subsample = 1;
+		cenc->crypt_byte_block = MOV_CBCS == scheme ? 1 : 0;
+		cenc->skip_byte_block = MOV_CBCS == scheme ? 9 : 0;
+	}
+	else if (MOV_AUDIO != track->handler_type)
+	{
+		return -ENOTSUP;
+	}
+
+	cenc->scheme = scheme;
+	cenc->object = entry->object_type_indication;
+	cenc->iv_size = MOV_CENC == scheme ? 8 : 0;
+	memcpy(cenc->kid, kid, 16);
+	memcpy(cenc->iv, iv, MOV_CENC == scheme ? 8 : 16);
+
+#if defined(_OPENSSL_)
+	cenc->evp = EVP_CIPHER_CTX_new();
+	if (!cenc->evp)
+		return -ENOMEM;
+	if (1 != EVP_EncryptInit_ex(cenc->evp, MOV_CENC == scheme ? EVP_aes_128_ctr() : EVP_aes_128_cbc(), NULL, key, NULL))
+	{
+		mov_cenc_free(cenc);
+		return -EINVAL;
+	}
+	EVP_CIPHER_CTX_set_padding(cenc->evp, 0);
+#else
+	mov_aes128_expand_key(cenc->rk, key);
+#endif
+	return 0;
+}
+
+void mov_cenc_free(struct mov_cenc_t* cenc)
+{
+#if defined(_OPENSSL_)
+	if (cenc->evp)
+		EVP_CIPHER_CTX_free(cenc->evp);
+#endif
+	if (cenc->aux)
+		free(cenc->aux);
+	if (cenc->sizes)
+		free(cenc->sizes);
+	memset(cenc, 0, sizeof(*cenc));
+}
+
+void mov_cenc_reset(struct mov_cenc_t* cenc)
+{
+	cenc->bytes = 0;
+	cenc->count = 0;
+}
+
+/// begin a new cenc sample(counter block) or cbcs subsample(chain)
+static void mov_cenc_begin(struct mov_cenc_t* cenc, const uint8_t iv[16])
+{
+#if defined(_OPENSSL_)
+	EVP_EncryptInit_ex(cenc->evp, NULL, NULL, NULL, iv);
+#else
+	memcpy(cenc->block, iv, 16);
+	cenc->num = 0;
+#endif
+}
+
+/// cenc: any length, key stream continue with the previous call
+/// cbcs: bytes MUST be multiple of 16, CBC chain continue with the previous call
+static int mov_cenc_update(struct mov_cenc_t* cenc, uint8_t* data, size_t bytes)
+{
+#if defined(_OPENSSL_)
+	int n;
+	assert(bytes < 0x7FFFFFFF);
+	return 1 == EVP_EncryptUpdate(cenc->evp, data, &n, data, (int)bytes) && (size_t)n == bytes ? 0 : -EINVAL;
+#else
+	int j;
+	size_t i;
+	if (MOV_CENC == cenc->scheme)
+	{
+		for (i = 0; i < bytes; i++)
+		{
+			if (0 == cenc->num)
+			{
+				memcpy(cenc->stream, cenc->block, 16);
+				mov_aes128_encrypt_block(cenc->rk, cenc->stream);
+				for (j = 15; j >= 0 && 0 == ++cenc->block[j]; j--)
+					;
+			}
+			data[i] ^= cenc->stream[cenc->num];
+			cenc->num = (cenc->num + 1) % 16;
+		}
+	}
+	else
+	{
+		assert(0 == bytes % 16);
+		for (i = 0; i + 16 <= bytes; i += 16)
+		{
+			for (j = 0; j < 16; j++)
+				cenc->block[j] ^= data[i + j];
+			mov_aes128_encrypt_block(cenc->rk, cenc->block);
+			memcpy(data + i, cenc->block, 16);
+		}
+	}
+	return 0;
+#endif
+}
+
+/// encrypt a protected range
+static int mov_cenc_protect(struct mov_cenc_t* cenc, uint8_t* data, size_t bytes)
+{
+	int r;
+	size_t i, n;
+
+	// cenc: the key stream continue across the subsamples of a sample
+	if (MOV_CENC == cenc->scheme)
+		return mov_cenc_update(cenc, data, bytes);
+
+	// cbcs: every subsample restart the chain with the constant IV, the partial block is left clear
+	mov_cenc_begin(cenc, cenc->iv);
+	bytes -= bytes % 16;
+	if (0 == cenc->crypt_byte_block)
+		return mov_cenc_update(cenc, data, bytes);
+
+	for (r = 0, i = 0; i < bytes && 0 == r; i += n + cenc->skip_byte_block * 16)
+	{
+		n = cenc->crypt_byte_block * 16;
+		n = n < bytes - i ? n : bytes - i;
+		r = mov_cenc_update(cenc, data + i, n);
+	}
+	return r;
+}
+
+static int mov_cenc_reserve(struct mov_cenc_t* cenc, size_t bytes)
+{
+	void* p;
+	if (cenc->bytes + bytes > cenc->capacity)
+	{
+		p = realloc(cenc->aux, cenc->bytes + bytes + 4096);
+		if (!p)
+			return -ENOMEM;
+		cenc->aux = (uint8_t*)p;
+		cenc->capacity = cenc->bytes + bytes + 4096;
+	}
+	return 0;
+}
+
+/// append subsample entries, clear data longer than 16-bits is split
+static int mov_cenc_subsample(struct mov_cenc_t* cenc, size_t clear, size_t protect, unsigned int* count)
+{
+	uint8_t* p;
+	size_t n, v;
+
+	assert(protect <= UINT32_MAX);
+	do
+	{
+		if (0 != mov_cenc_reserve(cenc, 6))
+			return -ENOMEM;
+
+		n = clear > 0xFFFF ? 0xFFFF : clear;
+		clear -= n;
+		v = 0 == clear ? protect : 0;
+
+		p = cenc->aux + cenc->bytes;
+		p[0] = (uint8_t)(n >> 8); /* BytesOfClearData */
+		p[1] = (uint8_t)n;
+		p[2] = (uint8_t)(v >> 24); /* BytesOfProtectedData */
+		p[3] = (uint8_t)(v >> 16);
+		p[4] = (uint8_t)(v >> 8);
+		p[5] = (uint8_t)v;
+		cenc->bytes += 6;
+		*count += 1;
+	} while (clear > 0);
+	return 0;
+}
+
+/// @param[out] head leading bytes MUST be clear, equal to the unit length if not protected
+/// @return NAL unit length
+static size_t mov_cenc_unit(const struct mov_cenc_t* cenc, const uint8_t* data, size_t bytes, size_t* head)
+{
+	int i, type, vcl;
+	size_t n, h;
+
+	assert(cenc->nalu_length > 0);
+	if (bytes <= (size_t)cenc->nalu_length)
+	{
+		*head = bytes; // invalid, keep clear
+		return bytes;
+	}
+
+	for (n = i = 0; i < cenc->nalu_length; i++)
+		n = (n << 8) | data[i];
+	n += cenc->nalu_length;
+	n = n < bytes ? n : bytes;
+
+	// 9.5.2 NAL length and NAL type MUST be clear
+	if (MOV_OBJECT_H264 == cenc->object)
+	{
+		type = data[cenc->nalu_length] & 0x1F;
+		vcl = type >= 1 && type <= 5;
+		h = cenc->nalu_length + 1;
+	}
+	else
+	{
+		type = (data[cenc->nalu_length] >> 1) & 0x3F;
+		vcl = type < 32;
+		h = cenc->nalu_length + 2;
+	}
+
+	// cbcs: keep slice header in clear(same 32 bytes leader as HLS SAMPLE-AES)
+	h += MOV_CBCS == cenc->scheme ? 32 : 0;
+	*head = vcl && h < n ? h : n;
+	return n;
+}
+
+int mov_cenc_sample(struct mov_cenc_t* cenc, uint8_t* data, size_t bytes)
+{
+	int i, r;
+	void* p;
+	size_t n, off, start, head, clear, protect;
+	unsigned int count;
+	uint8_t iv[16];
+
+	if (cenc->count >= cenc->max)
+	{
+		p = realloc(cenc->sizes, sizeof(cenc->sizes[0]) * (cenc->max + 256));
+		if (!p)
+			return -ENOMEM;
+		cenc->sizes = (uint16_t*)p;
+		cenc->max += 256;
+	}
+
+	if (0 != mov_cenc_reserve(cenc, 16 + 2))
+		return -ENOMEM;
+
+	// InitializationVector
+	start = cenc->bytes;
+	if (MOV_CENC == cenc->scheme)
+	{
+		memcpy(cenc->aux + cenc->bytes, cenc->iv, cenc->iv_size);
+		cenc->bytes += cenc->iv_size;
+
+		// 9.2 8-bytes IV: block counter in bytes 8 to 15
+		memcpy(iv, cenc->iv, 8);
+		memset(iv + 8, 0, 8);
+		mov_cenc_begin(cenc, iv);
+
+		// next sample IV
+		for (i = 7; i >= 0 && 0 == ++cenc->iv[i]; i--)
+			;
+	}
+
+	if (!cenc->subsample)
+	{
+		r = mov_cenc_protect(cenc, data, bytes);
+	}
+	else
+	{
+		// subsample_count placeholder
+		off = cenc->bytes;
+		cenc->bytes += 2;
+
+		r = 0;
+		count = 0;
+		for (clear = 0; bytes > 0 && 0 == r; data += n, bytes -= n)
+		{
+			n = mov_cenc_unit(cenc, data, bytes, &head);
+
+			// 16-bits subsample_count: protect the remaining units as one subsample(their NAL headers encrypted)
+			if (count + (clear + n) / 0xFFFF + 3 > 0xFFFF)
+				n = bytes;
+
+			protect = (n - head) & ~(size_t)0x0F; // block aligned, the remainder is clear
+			clear += n - protect;
+			if (protect > 0)
+			{
+				r = mov_cenc_subsample(cenc, clear, protect, &count);
+				r = 0 == r ? mov_cenc_protect(cenc, data + n - protect, protect) : r;
+				clear = 0;
+			}
+		}
+
+		if (0 == r && (clear > 0 || 0 == count))
+			r = mov_cenc_subsample(cenc, clear, 0, &count);
+
+		assert(count <= 0xFFFF);
+		cenc->aux[off] = (uint8_t)(count >> 8);
+		cenc->aux[off + 1] = (uint8_t)count;
+	}
+
+	// saiz sample_info_size is 8-bits, see mov_write_saiz
+	cenc->sizes[cenc->count++] = (uint16_t)(cenc->bytes - start);
+	return r;
+}
+
+// ISO/IEC 14496-12:2015(E) 8.12.1 Protection Scheme Information Box (p78)
+size_t mov_write_sinf(const struct mov_t* mov)
+{
+	size_t tenc;
+	const struct mov_cenc_t* cenc;
+	cenc = mov->track->cenc;
+
+	// ISO/IEC 23001-7:2016(E) 8.2 Track Encryption Box (p14)
+	tenc = 12 /* full box */ + 4 + 16 /* default_KID */ + (0 == cenc->iv_size ? 17 : 0);
+
+	mov_buffer_w32(&mov->io, 8 + 12 + 20 + 8 + (uint32_t)tenc); /* size */
+	mov_buffer_write(&mov->io, "sinf", 4);
+
+	// 8.12.2 Original Format Box
+	mov_buffer_w32(&mov->io, 12); /* size */
+	mov_buffer_write(&mov->io, "frma", 4);
+	mov_buffer_w32(&mov->io, mov->track->tag); /* data_format */
+
+	// 8.12.5 Scheme Type Box
+	mov_buffer_w32(&mov->io, 20); /* size */
+	mov_buffer_write(&mov->io, "schm", 4);
+	mov_buffer_w32(&mov->io, 0); /* version & flags */
+	mov_buffer_w32(&mov->io, cenc->scheme); /* scheme_type */
+	mov_buffer_w32(&mov->io, 0x00010000); /* scheme_version */
+
+	// 8.12.6 Scheme Information Box
+	mov_buffer_w32(&mov->io, 8 + (uint32_t)tenc); /* size */
+	mov_buffer_write(&mov->io, "schi", 4);
+
+	mov_buffer_w32(&mov->io, (uint32_t)tenc); /* size */
+	mov_buffer_write(&mov->io, "tenc", 4);
+	mov_buffer_w8(&mov->io, MOV_CBCS == cenc->scheme ? 1 : 0); /* version */
+	mov_buffer_w24(&mov->io, 0); /* flags */
+	mov_buffer_w8(&mov->io, 0); /* reserved */
+	mov_buffer_w8(&mov->io, (cenc->crypt_byte_block << 4) | cenc->skip_byte_block); /* default_crypt_byte_block/default_skip_byte_block */
+	mov_buffer_w8(&mov->io, 1); /* default_isProtected */
+	mov_buffer_w8(&mov->io, cenc->iv_size); /* default_Per_Sample_IV_Size */
+	mov_buffer_write(&mov->io, cenc->kid, 16); /* default_KID */
+	if (0 == cenc->iv_size)
+	{
+		mov_buffer_w8(&mov->io, 16); /* default_constant_IV_size */
+		mov_buffer_write(&mov->io, cenc->iv, 16); /* default_constant_IV */
+	}
+
+	return 8 + 12 + 20 + 8 + tenc;
+}
+
+// ISO/IEC 23001-7:2016(E) 8.1 Protection System Specific Header Box (p12)
+size_t mov_write_pssh(const struct mov_t* mov, const struct mov_pssh_t* pssh)
+{
+	size_t size;
+	size = 12 /* full box */ + 16 /* SystemID */ + (pssh->kid_count > 0 ? 4 + 16 * pssh->kid_count : 0) + 4 + pssh->bytes;
+
+	mov_buffer_w32(&mov->io, (uint32_t)size); /* size */
+	mov_buffer_write(&mov->io, "pssh", 4);
+	mov_buffer_w8(&mov->io, pssh->kid_count > 0 ? 1 : 0); /* version */
+	mov_buffer_w24(&mov->io, 0); /* flags */
+	mov_buffer_write(&mov->io, pssh->system_id, 16);
+	if (pssh->kid_count > 0)
+	{
+		mov_buffer_w32(&mov->io, pssh->kid_count); /* KID_count */
+		mov_buffer_write(&mov->io, pssh->kids, 16 * pssh->kid_count);
+	}
+	mov_buffer_w32(&mov->io, pssh->bytes); /* DataSize */
+	mov_buffer_write(&mov->io, pssh->data, pssh->bytes);
+	return size;
+}
+
+// ISO/IEC 14496-12:2015(E) 8.7.8 Sample Auxiliary Information Sizes Box (p62)
+// sample_info_size is 8-bits: a sample with 40+ subsamples can't be described,
+// omit saiz/saio of the fragment, the senc box is self-describing(ISO/IEC 23001-7:2016(E) 7.2)
+size_t mov_write_saiz(const struct mov_t* mov)
+{
+	uint32_t i;
+	size_t size;
+	uint16_t sample_info_size;
+	const struct mov_cenc_t* cenc;
+	cenc = mov->track->cenc;
+
+	for (i = 0; i < cenc->count; i++)
+	{
+		if (cenc->sizes[i] > 0xFF)
+			return 0;
+	}
+
+	sample_info_size = cenc->count > 0 ? cenc->sizes[0] : 0;
+	for (i = 1; i < cenc->count && 0 != sample_info_size; i++)
+	{
+		if (cenc->sizes[i] != sample_info_size)
+			sample_info_size = 0;
+	}
+
+	size = 12 /* full box */ + 1 + 4 + (0 == sample_info_size ? cenc->count : 0);
+	mov_buffer_w32(&mov->io, (uint32_t)size); /* size */
+	mov_buffer_write(&mov->io, "saiz", 4);
+	mov_buffer_w32(&mov->io, 0); /* version & flags, aux_info_type = scheme_type */
+	mov_buffer_w8(&mov->io, (uint8_t)sample_info_size); /* default_sample_info_size */
+	mov_buffer_w32(&mov->io, cenc->count); /* sample_count */
+	for (i = 0; i < cenc->count && 0 == sample_info_size; i++)
+		mov_buffer_w8(&mov->io, (uint8_t)cenc->sizes[i]); /* sample_info_size */
+	return size;
+}
+
+// ISO/IEC 14496-12:2015(E) 8.7.9 Sample Auxiliary Information Offsets Box (p63)
+size_t mov_write_saio(const struct mov_t* mov, uint32_t offset)
+{
+	mov_buffer_w32(&mov->io, 20); /* size */
+	mov_buffer_write(&mov->io, "saio", 4);
+	mov_buffer_w32(&mov->io, 0); /* version & flags */
+	mov_buffer_w32(&mov->io, 1); /* entry_count */
+	mov_buffer_w32(&mov->io, offset); /* offset */
+	return 20;
+}
+
+// ISO/IEC 23001-7:2016(E) 7.2 Sample Encryption Box (p9)
+size_t mov_write_senc(const struct mov_t* mov)
+{
+	const struct mov_cenc_t* cenc;
+	cenc = mov->track->cenc;
+
+	mov_buffer_w32(&mov->io, 16 + (uint32_t)cenc->bytes); /* size */
+	mov_buffer_write(&mov->io, "senc", 4);
+	mov_buffer_w8(&mov->io, 0); /* version */
+	mov_buffer_w24(&mov->io, cenc->subsample ? 0x000002 : 0); /* flags: UseSubSampleEncryption */
+	mov_buffer_w32(&mov->io, cenc->count); /* sample_count */
+	mov_buffer_write(&mov->io, cenc->aux, cenc->bytes);
+	return 16 + cenc->bytes;
+}
+
+#if defined(_DEBUG) || defined(DEBUG)
+static void mov_cenc_test_init(struct mov_cenc_t* cenc, uint32_t handler, uint8_t object, uint32_t scheme, const uint8_t key[16], const uint8_t iv[16])
+{
+	static uint8_t avcc[] = { 0x01, 0x64, 0x00, 0x1F, 0xFF, 0xE0, 0x00 };
+	struct mov_track_t track;
+	struct mov_sample_entry_t entry;
+	memset(&track, 0, sizeof(track));
+	memset(&entry, 0, sizeof(entry));
+	entry.object_type_indication = object;
+	entry.extra_data = avcc;
+	entry.extra_data_size = sizeof(avcc);
+	track.handler_type = handler;
+	track.stsd.entries = &entry;
+	track.stsd.entry_count = 1;
+	assert(0 == mov_cenc_init(cenc, &track, scheme, key, key, iv));
+}
+
+void mov_cenc_test(void)
+{
+	// SP800-38A F.5.1 CTR-AES128.Encrypt/F.2.1 CBC-AES128.Encrypt
+	static const uint8_t key[16] = { 0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c };
+	static const uint8_t ctr[16] = { 0xf0, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa, 0xfb, 0xfc, 0xfd, 0xfe, 0xff };
+	static const uint8_t iv[16] = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f };
+	static const uint8_t plain[16] = { 0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96, 0xe9, 0x3d, 0x7e, 0x11, 0x73, 0x93, 0x17, 0x2a };
+	static const uint8_t ctr1[16] = { 0x87, 0x4d, 0x61, 0x91, 0xb6, 0x20, 0xe3, 0x26, 0x1b, 0xef, 0x68, 0x64, 0x99, 0x0d, 0xb6, 0xce };
+	static const uint8_t cbc1[16] = { 0x76, 0x49, 0xab, 0xac, 0x81, 0x19, 0xb2, 0x46, 0xce, 0xe9, 0x8e, 0x9b, 0x12, 0xe9, 0x19, 0x7d };
+	static const uint8_t sub1[] = { 0x00, 0x01, 0x00, 0x11, 0x00, 0x00, 0x00, 0x60 }; // 1 subsample: 17 clear + 96 protected
+	static const uint8_t sub2[] = { 0x00, 0x01, 0x00, 0x15, 0x00, 0x00, 0x00, 0x50 }; // H.265: NAL length + header + 15 bytes clear, 80 protected
+
+	int i;
+	uint8_t* big;
+	uint8_t data[512];
+	uint8_t copy[sizeof(data)];
+	struct mov_cenc_t cenc;
+
+	// audio cenc: counter mode
+	mov_cenc_test_init(&cenc, MOV_AUDIO, MOV_OBJECT_AAC, MOV_CENC, key, ctr);
+	memcpy(data, plain, 16);
+	mov_cenc_begin(&cenc, ctr);
+	assert(0 == mov_cenc_update(&cenc, data, 5) && 0 == mov_cenc_update(&cenc, data + 5, 11) && 0 == memcmp(data, ctr1, 16));
+	assert(0 == mov_cenc_sample(&cenc, data, 16) && 1 == cenc.count && 8 == cenc.sizes[0] && 0 == memcmp(cenc.aux, ctr, 8));
+	assert(0xf8 == cenc.iv[7]); // next sample IV
+	mov_cenc_free(&cenc);
+
+	// audio cbcs: all blocks, the last partial block is clear, no sample auxiliary information
+	mov_cenc_test_init(&cenc, MOV_AUDIO, MOV_OBJECT_AAC, MOV_CBCS, key, iv);
+	memcpy(data, plain, 16);
+	memset(data + 16, 0x5A, 5);
+	assert(0 == mov_cenc_sample(&cenc, data, 21) && 0 == memcmp(data, cbc1, 16) && 0x5A == data[20]);
+	assert(1 == cenc.count && 0 == cenc.bytes && 0 == cenc.sizes[0]);
+	mov_cenc_free(&cenc);
+
+	// H.264 cenc: SPS clear, IDR NAL length + header + 3 bytes clear
+	mov_cenc_test_init(&cenc, MOV_VIDEO, MOV_OBJECT_H264, MOV_CENC, key, ctr);
+	for (i = 0; i < (int)sizeof(data); i++)
+		data[i] = (uint8_t)i;
+	memcpy(data, "\x00\x00\x00\x05\x67\x64\x00\x1F\xAC" "\x00\x00\x00\x64\x65", 14);
+	memcpy(copy, data, sizeof(data));
+	assert(0 == mov_cenc_sample(&cenc, data, 9 + 104));
+	assert(0 == memcmp(data, copy, 17) && 0 != memcmp(data + 17, copy + 17, 96));
+	assert(1 == cenc.count && 16 == cenc.sizes[0] && 0 == memcmp(cenc.aux + 8, sub1, sizeof(sub1)));
+	memcpy(copy + 8, "\x00\x00\x00\x00\x00\x00\x00\x00", 8);
+	memcpy(copy + 0, ctr, 8); // decrypt: same key stream
+	mov_cenc_begin(&cenc, copy);
+	mov_cenc_update(&cenc, data + 17, 96);
+	assert(0x65 == data[13] && 16 == data[16] && 17 == data[17] && 112 == data[112]);
+
+	// next fragment, H.265 IDR: NAL length + 2-bytes header clear
+	mov_cenc_reset(&cenc);
+	cenc.object = MOV_OBJECT_H265;
+	memcpy(data, "\x00\x00\x00\x61\x26\x01", 6);
+	assert(0 == mov_cenc_sample(&cenc, data, 4 + 97) && 1 == cenc.count);
+	assert(0 == memcmp(cenc.aux + 8, sub2, sizeof(sub2)) && 0xf8 == cenc.aux[7]);
+
+	// 70000 IDR NAL units(4 + 28 bytes): sample info size > 255, 16-bits subsample_count
+	mov_cenc_reset(&cenc);
+	cenc.object = MOV_OBJECT_H264;
+	big = (uint8_t*)malloc(70000 * 32);
+	for (i = 0; i < 70000; i++)
+		memcpy(big + i * 32, "\x00\x00\x00\x1C\x65", 5);
+	assert(0 == mov_cenc_sample(&cenc, big, 48 * 32) && 1 == cenc.count && 8 + 2 + 48 * 6 == cenc.sizes[0]);
+	assert(0 == mov_cenc_sample(&cenc, big, 70000 * 32) && 2 == cenc.count && 0xFF == cenc.aux[cenc.sizes[0] + 8] && 0xFE == cenc.aux[cenc.sizes[0] + 9]);
+	free(big);
+	mov_cenc_free(&cenc);
+
+	// H.264 cbcs: 1:9 pattern, slice header clear, chain restart per subsample
+	mov_cenc_test_init(&cenc, MOV_VIDEO, MOV_OBJECT_H264, MOV_CBCS, key, iv);
+	for (i = 0; i < (int)sizeof(data); i++)
+		data[i] = (uint8_t)i;
+	memcpy(data, "\x00\x00\x01\xFC\x65", 5); // 4 + 508
+	memcpy(copy, data, sizeof(data));
+	assert(0 == mov_cenc_sample(&cenc, data, sizeof(data)));
+	assert(1 == cenc.count && 8 == cenc.bytes && 0 == memcmp(cenc.aux, "\x00\x01\x00\x30\x00\x00\x01\xD0", 8)); // 48 + 464
+	assert(0 == memcmp(data, copy, 48) && 0 != memcmp(data + 48, copy + 48, 16) && 0 == memcmp(data + 64, copy + 64, 144));
+	assert(0 != memcmp(data + 208, copy + 208, 16) && 0 == memcmp(data + 224, copy + 224, 144) && 0 != memcmp(data + 368, copy + 368, 16));
+	assert(0 == memcmp(data + 384, copy + 384, 128));
+	mov_cenc_free(&cenc);
+}
+#endif
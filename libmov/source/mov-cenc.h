@@ -0,0 +1,74 @@
+#ifndef _mov_cenc_h_
+#define _mov_cenc_h_
+
+#include "mov-internal.h"
+
+#if defined(_OPENSSL_)
+#include "openssl/evp.h"
+#endif
+
+#define MOV_CENC    MOV_TAG('c', 'e', 'n', 'c') // ISO/IEC 23001-7:2016(E) 10.1 AES-CTR mode full sample and video NAL Subsample encryption
+#define MOV_CBCS    MOV_TAG('c', 'b', 'c', 's') // ISO/IEC 23001-7:2016(E) 10.4 AES-CBC mode pattern encryption with constant IV
+#define MOV_ENCV    MOV_TAG('e', 'n', 'c', 'v')
+#define MOV_ENCA    MOV_TAG('e', 'n', 'c', 'a')
+
+struct mov_cenc_t
+{
+	uint32_t scheme; // MOV_CENC/MOV_CBCS
+	uint8_t kid[16]; // default_KID
+	uint8_t iv[16]; // cenc: next sample IV(8-bytes), cbcs: constant IV
+	uint8_t iv_size; // Per_Sample_IV_Size: cenc-8, cbcs-0
+	uint8_t crypt_byte_block; // cbcs pattern: video 1:9, audio 0:0(all blocks)
+	uint8_t skip_byte_block;
+	uint8_t object; // MOV_OBJECT_XXX
+	uint8_t subsample; // 1-video subsample encryption, 0-audio full sample encryption
+	int nalu_length; // H.264/H.265 NALU length size
+
+#if defined(_OPENSSL_)
+	EVP_CIPHER_CTX* evp; // AES-NI/ARMv8-CE accelerated if available
+#else
+	uint8_t rk[176]; // AES-128 round keys
+	uint8_t block[16]; // cenc: counter block, cbcs: chain block
+	uint8_t stream[16]; // cenc key stream
+	unsigned int num; // cenc key stream used bytes
+#endif
+
+	// sample auxiliary information(senc/saiz) of the current fragment
+	uint8_t* aux;
+	size_t bytes;
+	size_t capacity;
+	uint16_t* sizes; // saiz sample_info_size(> 255 with 40+ subsamples)
+	uint32_t count;
+	uint32_t max;
+};
+
+struct mov_pssh_t
+{
+	uint8_t system_id[16];
+	uint8_t* kids; // kid_count * 16 bytes, follow by data
+	uint32_t kid_count;
+	uint8_t* data;
+	uint32_t bytes;
+};
+
+/// @param[in] iv cenc: initial 8-bytes per-sample IV, cbcs: 16-bytes constant IV
+/// @return 0-ok, -ENOTSUP-codec can't be encrypted
+int mov_cenc_init(struct mov_cenc_t* cenc, const struct mov_track_t* track, uint32_t scheme, const uint8_t kid[16], const uint8_t key[16], const uint8_t iv[16]);
+void mov_cenc_free(struct mov_cenc_t* cenc);
+
+/// New fragment: clear the sample auxiliary information
+void mov_cenc_reset(struct mov_cenc_t* cenc);
+
+/// Encrypt one sample in place(H.264/H.265 MP4 format, audio frame)
+/// and append its sample auxiliary information
+/// @return 0-ok, other-error
+int mov_cenc_sample(struct mov_cenc_t* cenc, uint8_t* data, size_t bytes);
+
+size_t mov_write_sinf(const struct mov_t* mov);
+size_t mov_write_pssh(const struct mov_t* mov, const struct mov_pssh_t* pssh);
+/// @return 0 if any sample info size > 255, write neither saiz nor saio
+size_t mov_write_saiz(const struct mov_t* mov);
+size_t mov_write_saio(const struct mov_t* mov, uint32_t offset);
+size_t mov_write_senc(const struct mov_t* mov);
+
+#endif /* !_mov_cenc_h_ */
@@ -189,6 +189,7 @@ struct mov_track_t
     uint64_t offset; // write only
     int64_t last_dts; // write fmp4 only
     int64_t turn_last_duration; // write fmp4 only
+    struct mov_cenc_t* cenc; // write fmp4 only, Common Encryption
 
 	unsigned int flags;
 };
@@ -1,4 +1,5 @@
 #include "mov-internal.h"
+#include "mov-cenc.h"
 #include <assert.h>
 #include <stdlib.h>
 #include <string.h>
@@ -411,7 +412,7 @@ static size_t mov_write_video(const struct mov_t* mov, const struct mov_sample_e
 
 	offset = mov_buffer_tell(&mov->io);
 	mov_buffer_w32(&mov->io, 0); /* size */
-	mov_buffer_w32(&mov->io, mov->track->tag); // "h264"
+	mov_buffer_w32(&mov->io, mov->track->cenc ? MOV_ENCV : mov->track->tag); // "h264"
 
 	mov_buffer_w32(&mov->io, 0); /* Reserved */
 	mov_buffer_w16(&mov->io, 0); /* Reserved */
@@ -455,6 +456,10 @@ static size_t mov_write_video(const struct mov_t* mov, const struct mov_sample_e
 	else if (MOV_OBJECT_VP8 == entry->object_type_indication || MOV_OBJECT_VP9 == entry->object_type_indication)
 		size += mov_write_vpcc(mov);
 
+	// ISO/IEC 23001-7:2016(E) 4 Scheme signaling: encv with sinf
+	if (mov->track->cenc)
+		size += mov_write_sinf(mov);
+
 	//size += mov_write_btrt(mov, entry);
 	mov_write_size(mov, offset, size); /* update size */
 	return size;
@@ -469,7 +474,7 @@ static size_t mov_write_audio(const struct mov_t* mov, const struct mov_sample_e
 
 	offset = mov_buffer_tell(&mov->io);
 	mov_buffer_w32(&mov->io, 0); /* size */
-	mov_buffer_w32(&mov->io, mov->track->tag); // "mp4a"
+	mov_buffer_w32(&mov->io, mov->track->cenc ? MOV_ENCA : mov->track->tag); // "mp4a"
 
 	mov_buffer_w32(&mov->io, 0); /* Reserved */
 	mov_buffer_w16(&mov->io, 0); /* Reserved */
@@ -498,6 +503,9 @@ static size_t mov_write_audio(const struct mov_t* mov, const struct mov_sample_e
 	else if(MOV_OBJECT_OPUS == entry->object_type_indication)
 		size += mov_write_dops(mov);
 
+	if (mov->track->cenc)
+		size += mov_write_sinf(mov);
+
 	//size += mov_write_btrt(mov, entry);
 	mov_write_size(mov, offset, size); /* update size */
 	return size;
@@ -1,4 +1,5 @@
 #include "mov-internal.h"
+#include "mov-cenc.h"
 #include <errno.h>
 #include <stdlib.h>
 #include <string.h>
@@ -43,6 +44,12 @@ void mov_free_track(struct mov_track_t* track)
 			free(track->stsd.entries[i].extra_data);
 	}
 
+	if (track->cenc)
+	{
+		mov_cenc_free(track->cenc);
+		free(track->cenc);
+	}
+
     FREE(track->elst);
     FREE(track->frags);
     FREE(track->samples);
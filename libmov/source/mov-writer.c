@@ -1,5 +1,6 @@
 #include "mov-writer.h"
 #include "mov-internal.h"
+#include "media-metrics.h"
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
@@ -11,6 +12,10 @@ struct mov_writer_t
 	struct mov_t mov;
 	uint64_t mdat_size;
 	uint64_t mdat_offset;
+
+#if defined(MEDIA_METRICS)
+	struct media_metrics_t metrics;
+#endif
 };
 
 static int mov_write_tail(struct mov_t* mov)
@@ -242,6 +247,7 @@ static int mov_writer_move(struct mov_t* mov, uint64_t to, uint64_t from, size_t
 
 int mov_writer_write(struct mov_writer_t* writer, int track, const void* data, size_t bytes, int64_t pts, int64_t dts, int flags)
 {
+	int r;
 	struct mov_t* mov;
 	struct mov_sample_t* sample;
 
@@ -249,6 +255,8 @@ int mov_writer_write(struct mov_writer_t* writer, int track, const void* data, s
 	if (track < 0 || track >= (int)writer->mov.track_count)
 		return -ENOENT;
 	
+	MEDIA_METRICS_ADD(&writer->metrics, frames_in, 1);
+	MEDIA_METRICS_ADD(&writer->metrics, bytes_in, bytes);
 	mov = &writer->mov;
 	mov->track = &mov->tracks[track];
 
@@ -258,6 +266,8 @@ int mov_writer_write(struct mov_writer_t* writer, int track, const void* data, s
 		if (NULL == ptr) return -ENOMEM;
 		mov->track->samples = ptr;
 		mov->track->sample_offset += 1024;
+		MEDIA_METRICS_ADD(&writer->metrics, allocs, 1);
+		MEDIA_METRICS_MAX(&writer->metrics, buffer_hwm, sizeof(struct mov_sample_t) * mov->track->sample_offset);
 	}
 
 	pts = pts * mov->track->mdhd.timescale / 1000;
@@ -273,11 +283,16 @@ int mov_writer_write(struct mov_writer_t* writer, int track, const void* data, s
 	
 	sample->offset = mov_buffer_tell(&mov->io);
 	mov_buffer_write(&mov->io, data, bytes);
+	r = mov_buffer_error(&mov->io);
+	MEDIA_METRICS_ADD(&writer->metrics, frames_out, 1);
+	MEDIA_METRICS_ADD(&writer->metrics, bytes_out, bytes);
 
 	if (INT64_MIN == mov->track->start_dts)
 		mov->track->start_dts = sample->dts;
 	writer->mdat_size += bytes; // update media data size
-	return mov_buffer_error(&mov->io);
+	if (0 != r)
+		MEDIA_METRICS_ADD(&writer->metrics, errors, 1);
+	return r;
 }
 
 int mov_writer_add_audio(struct mov_writer_t* writer, uint8_t object, int channel_count, int bits_per_sample, int sample_rate, const void* extra_data, size_t extra_data_size)
@@ -341,3 +356,15 @@ int mov_writer_add_udta(mov_writer_t* mov, const void* data, size_t size)
 	mov->mov.udta_size = size;
 	return 0;
 }
+
+int mov_writer_get_metrics(struct mov_writer_t* writer, struct media_metrics_t* metrics)
+{
+#if defined(MEDIA_METRICS)
+	media_metrics_snapshot(metrics, &writer->metrics);
+	return 0;
+#else
+	(void)writer;
+	memset(metrics, 0, sizeof(*metrics));
+	return -ENOSYS;
+#endif
+}
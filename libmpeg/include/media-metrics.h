@@ -0,0 +1,122 @@
+#ifndef _media_metrics_h_
+#define _media_metrics_h_
+
+// Hot-path metrics of the demuxer/muxer/payload objects.
+// Build the libraries with -DMEDIA_METRICS(make METRICS=1) to enable, otherwise all counters are compiled out
+// and xxx_get_metrics return -ENOSYS.
+// libflv/libmov/libmpeg/librtp each keep an identical copy of this file(librtmp use the libflv one),
+// so every library builds standalone. Keep the copies in sync.
+//
+// Counters are written by the thread which drives the object(single writer, no lock, no atomic RMW)
+// and can be read from any other thread by xxx_get_metrics. Both sides access the counters with
+// relaxed 64-bits atomic loads/stores only, so a value never tears(32-bits platform included),
+// but a snapshot may mix values of two adjacent inputs.
+
+#include <stdint.h>
+
+#define MEDIA_METRICS_HISTOGRAM 16
+
+struct media_metrics_t
+{
+	uint64_t frames_in; // input packets/frames/messages
+	uint64_t bytes_in;
+	uint64_t frames_out; // output packets/frames(user callback)
+	uint64_t bytes_out;
+	uint64_t allocs; // memory allocations(malloc/realloc/alloc callback)
+	uint64_t errors; // invalid input or callback error
+	uint64_t buffer_hwm; // internal buffer high-water mark in bytes
+	uint64_t reorder_hwm; // max packet reorder depth(rtp_demuxer only)
+
+	// user callback time(mov/fmp4 writer write through mov_buffer_t, not counted)
+	uint64_t callback_ns; // total
+	uint64_t callback[MEDIA_METRICS_HISTOGRAM]; // [0]: < 1us, [i]: [2^(i-1), 2^i) us, [15]: >= 16.384ms
+};
+
+#if defined(MEDIA_METRICS)
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#include <time.h>
+#define media_metrics_load(p)		((uint64_t)_InterlockedCompareExchange64((volatile __int64*)(p), 0, 0))
+static inline void media_metrics_store(uint64_t* p, uint64_t v)
+{
+	__int64 o;
+	do
+	{
+		o = *(volatile __int64*)p;
+	} while (o != _InterlockedCompareExchange64((volatile __int64*)p, (__int64)v, o)); // x86 has no _InterlockedExchange64
+}
+#else
+#include <time.h>
+#define media_metrics_load(p)		__atomic_load_n(p, __ATOMIC_RELAXED)
+#define media_metrics_store(p, v)	__atomic_store_n(p, v, __ATOMIC_RELAXED)
+#endif
+
+static inline void media_metrics_add(uint64_t* counter, uint64_t v)
+{
+	media_metrics_store(counter, media_metrics_load(counter) + v); // single writer
+}
+
+static inline void media_metrics_max(uint64_t* counter, uint64_t v)
+{
+	if (v > media_metrics_load(counter))
+		media_metrics_store(counter, v);
+}
+
+/// @return clock in ns
+static inline uint64_t media_metrics_clock(void)
+{
+	struct timespec ts;
+#if defined(_MSC_VER)
+	timespec_get(&ts, TIME_UTC); // high resolution, but not monotonic
+#else
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+#endif
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/// record a user callback time
+/// @param[in] clock callback start time(media_metrics_clock)
+static inline void media_metrics_callback(struct media_metrics_t* m, uint64_t clock)
+{
+	int i;
+	uint64_t ns, us;
+	ns = media_metrics_clock();
+	ns = ns > clock ? ns - clock : 0; // wall clock adjusted
+	for (i = 0, us = ns / 1000; us > 0 && i + 1 < MEDIA_METRICS_HISTOGRAM; us >>= 1)
+		i++;
+	media_metrics_add(&m->callback_ns, ns);
+	media_metrics_add(&m->callback[i], 1);
+}
+
+static inline void media_metrics_snapshot(struct media_metrics_t* snapshot, const struct media_metrics_t* m)
+{
+	int i;
+	snapshot->frames_in = media_metrics_load(&m->frames_in);
+	snapshot->bytes_in = media_metrics_load(&m->bytes_in);
+	snapshot->frames_out = media_metrics_load(&m->frames_out);
+	snapshot->bytes_out = media_metrics_load(&m->bytes_out);
+	snapshot->allocs = media_metrics_load(&m->allocs);
+	snapshot->errors = media_metrics_load(&m->errors);
+	snapshot->buffer_hwm = media_metrics_load(&m->buffer_hwm);
+	snapshot->reorder_hwm = media_metrics_load(&m->reorder_hwm);
+	snapshot->callback_ns = media_metrics_load(&m->callback_ns);
+	for (i = 0; i < MEDIA_METRICS_HISTOGRAM; i++)
+		snapshot->callback[i] = media_metrics_load(&m->callback[i]);
+}
+
+#define MEDIA_METRICS_ADD(m, counter, v)	media_metrics_add(&(m)->counter, (uint64_t)(v))
+#define MEDIA_METRICS_MAX(m, counter, v)	media_metrics_max(&(m)->counter, (uint64_t)(v))
+
+/// r = callback(...), and record the callback time
+#define MEDIA_METRICS_CALL(m, r, callback) do { uint64_t clock_ = media_metrics_clock(); r = (callback); media_metrics_callback(m, clock_); } while (0)
+
+#else
+
+#define MEDIA_METRICS_ADD(m, counter, v)	((void)0)
+#define MEDIA_METRICS_MAX(m, counter, v)	((void)0)
+#define MEDIA_METRICS_CALL(m, r, callback)	r = (callback)
+
+#endif /* MEDIA_METRICS */
+
+#endif /* !_media_metrics_h_ */
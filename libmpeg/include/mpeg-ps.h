@@ -106,6 +106,12 @@ struct ps_demuxer_notify_t
 /// Set ps notify on PSM change
 void ps_demuxer_set_notify(struct ps_demuxer_t* demuxer, struct ps_demuxer_notify_t* notify, void* param);
 
+/// Hot-path metrics snapshot(build with -DMEDIA_METRICS), see more @media-metrics.h
+/// frames_in/bytes_in-ps_demuxer_input, frames_out/bytes_out-onpacket, buffer_hwm-stash/PES buffer capacity
+/// @return 0-ok, -ENOSYS-metrics disabled
+struct media_metrics_t;
+int ps_demuxer_get_metrics(struct ps_demuxer_t* demuxer, struct media_metrics_t* metrics);
+
 #ifdef __cplusplus
 }
 #endif
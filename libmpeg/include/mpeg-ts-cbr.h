@@ -0,0 +1,59 @@
+#ifndef _mpeg_ts_cbr_h_
+#define _mpeg_ts_cbr_h_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct mpeg_ts_cbr_t;
+
+struct mpeg_ts_cbr_func_t
+{
+	/// monotonic clock(system clock for live output, or a simulated clock for offline test)
+	/// @param[in] param user-defined parameter(by mpeg_ts_cbr_create)
+	/// @return current time in microsecond(us)
+	int64_t (*clock)(void* param);
+
+	/// paced TS packets output
+	/// @param[in] param user-defined parameter(by mpeg_ts_cbr_create)
+	/// @param[in] packets TS packets(batch packets of mpeg_ts_cbr_create)
+	/// @param[in] bytes packets size in byte(multiple of 188)
+	/// @return 0-ok, other-error
+	int (*write)(void* param, const void* packets, size_t bytes);
+};
+
+/// Constant bitrate MPEG2-TS scheduler over the TS muxer(ITU-T H.222.0 2.4.2 transport stream system target decoder)
+/// 1. Output slot k is released at time (first write time + k * 188 * 8 / muxrate) and its STC is (first DTS - delay + k * 188 * 8 / muxrate)
+/// 2. Access unit packets are queued until the slot STC reaches DTS - delay, empty slots are filled with null packets(PID 0x1FFF)
+/// 3. PCR is stamped with the slot STC, a PCR-only adaptation packet is inserted on the PCR_PID if no PCR in pcr_interval
+/// @param[in] muxrate transport rate in bits per second, (0, 200Mbps], MUST be larger than the peak rate of all streams with TS/PES overhead
+/// @param[in] pcr_interval maximum PCR interval in ms, [1, 100], e.g. 20(DVB 40ms)
+/// @param[in] delay maximum time(ms) a packet arrives ahead of its DTS(T-STD buffer), e.g. 500
+/// @param[in] batch packets per write, e.g. 7 for UDP/RTP(7 * 188 bytes), queued packets are copied into the batch buffer
+/// @return NULL-invalid parameter or no memory, other-scheduler
+struct mpeg_ts_cbr_t* mpeg_ts_cbr_create(int64_t muxrate, int pcr_interval, int delay, int batch, const struct mpeg_ts_cbr_func_t* func, void* param);
+void mpeg_ts_cbr_destroy(struct mpeg_ts_cbr_t* cbr);
+
+/// Internal TS muxer for mpeg_ts_add_stream/mpeg_ts_add_program/mpeg_ts_add_program_stream/mpeg_ts_set_sample_aes
+/// Don't call mpeg_ts_write/mpeg_ts_set_buffer/mpeg_ts_destroy with it
+void* mpeg_ts_cbr_muxer(struct mpeg_ts_cbr_t* cbr);
+
+/// Queue audio/video stream data, see more mpeg_ts_write
+/// The scheduler clock starts on the first write
+/// @return 0-ok, other-error
+int mpeg_ts_cbr_write(struct mpeg_ts_cbr_t* cbr, int stream, int flags, int64_t pts, int64_t dts, const void* data, size_t bytes);
+
+/// Release the due packets batch by batch, call on timer and/or after mpeg_ts_cbr_write
+/// @return >=0-time(us) to the next batch, <0-write error
+int64_t mpeg_ts_cbr_send(struct mpeg_ts_cbr_t* cbr);
+
+/// @return queued TS packets(excluding null packets)
+size_t mpeg_ts_cbr_pending(struct mpeg_ts_cbr_t* cbr);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* !_mpeg_ts_cbr_h_ */
@@ -54,6 +54,25 @@ int mpeg_ts_write(void* ts, int stream, int flags, int64_t pts, int64_t dts, con
 /// Reset PAT/PCR period
 int mpeg_ts_reset(void* ts);
 
+/// Batched output: TS packets are built in place in the caller buffer(no alloc/free callback),
+/// and func.write is called once per batch packets, when the buffer is full, and at the end of each mpeg_ts_write.
+/// If func.write failed, the batch is kept and written again by the next mpeg_ts_write(before new packets),
+/// the rest of the failed access unit is lost.
+/// @param[in] buffer contiguous memory, NULL-default per-packet alloc/write/free mode
+/// @param[in] bytes buffer size in byte, at least one TS packet(188)
+/// @param[in] batch packets per write, e.g. 7 for RTP/UDP(7 * 188 bytes), 0-one write per access unit(or full buffer)
+/// @return 0-ok, other-error
+int mpeg_ts_set_buffer(void* ts, void* buffer, size_t bytes, int batch);
+
+/// HLS SAMPLE-AES(MPEG-2 Stream Encryption Format for HTTP Live Streaming) stream signaling:
+/// H.264 stream_type 0xDB + private_data_indicator_descriptor('zavc'),
+/// AAC stream_type 0xCF + private_data_indicator_descriptor('aacd') + registration_descriptor('apad' audio setup information)
+/// The muxer don't encrypt, input data MUST be encrypted by caller(see hls_media_set_encrypt)
+/// @param[in] stream stream id by mpeg_ts_add_stream, H.264/AAC only
+/// @param[in] setup AAC AudioSpecificConfig(audio setup information), NULL for H.264
+/// @return 0-ok, other-error
+int mpeg_ts_set_sample_aes(void* ts, int stream, const void* setup, size_t bytes);
+
 
 /// FOR MULTI-PROGRAM TS STREAM ONLY
 /// Add a program
@@ -96,6 +115,12 @@ struct ts_demuxer_notify_t
 /// Set ts notify on PMT change
 void ts_demuxer_set_notify(struct ts_demuxer_t* demuxer, struct ts_demuxer_notify_t* notify, void* param);
 
+/// Hot-path metrics snapshot(build with -DMEDIA_METRICS), see more @media-metrics.h
+/// frames_in/bytes_in-TS packets, frames_out/bytes_out-onpacket, buffer_hwm-PES buffer capacity
+/// @return 0-ok, -ENOSYS-metrics disabled
+struct media_metrics_t;
+int ts_demuxer_get_metrics(struct ts_demuxer_t* demuxer, struct media_metrics_t* metrics);
+
 #ifdef __cplusplus
 }
 #endif
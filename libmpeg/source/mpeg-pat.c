@@ -201,4 +201,5 @@ void pat_clear(struct pat_t* pat)
 
 	pat->pmt_count = 0;
 	pat->pmt_capacity = 0;
+	pat->crc = 0;
 }
@@ -33,6 +33,7 @@ struct pes_t
 	uint8_t sid;		// PES stream_id : 8
 	uint8_t codecid;	// PMT/PSM stream_type : 8
 	uint8_t cc;			// continuity_counter : 4;
+	uint8_t sample_aes;	// HLS SAMPLE-AES encrypted stream(muxer only)
 	uint8_t* esinfo;	// es_info
 	uint16_t esinfo_len;// es_info_length : 12
 
@@ -143,7 +143,31 @@ static int pmt_write_descriptor(const struct pes_t* stream, uint8_t* data, int b
 	uint8_t* p;
 
 	p = data;
-	if (PSI_STREAM_AUDIO_OPUS == stream->codecid && bytes > 2 + 4 /*fourcc*/ + 4 /*DVI OPUS*/ )
+	if (stream->sample_aes && (PSI_STREAM_H264 == stream->codecid || PSI_STREAM_AAC == stream->codecid) && bytes > 6 + 2 + 12 + stream->esinfo_len)
+	{
+		// HLS MPEG-2 Stream Encryption Format: 2.3 private_data_indicator_descriptor
+		*p++ = 0x0F;
+		*p++ = 4;
+		memcpy(p, PSI_STREAM_H264 == stream->codecid ? "zavc" : "aacd", 4);
+		p += 4;
+
+		if (PSI_STREAM_AAC == stream->codecid)
+		{
+			// 2.4.3.2 registration_descriptor with audio_setup_information
+			*p++ = 0x05;
+			*p++ = (uint8_t)(4 + 8 + stream->esinfo_len);
+			memcpy(p, "apad", 4); // format_identifier
+			memcpy(p + 4, "zaac", 4); // audio_type
+			p[8] = 0; // priming
+			p[9] = 0;
+			p[10] = 1; // version
+			p[11] = (uint8_t)stream->esinfo_len; // setup_data_length
+			if (stream->esinfo_len > 0)
+				memcpy(p + 12, stream->esinfo, stream->esinfo_len); // AudioSpecificConfig
+			p += 12 + stream->esinfo_len;
+		}
+	}
+	else if (PSI_STREAM_AUDIO_OPUS == stream->codecid && bytes > 2 + 4 /*fourcc*/ + 4 /*DVI OPUS*/ )
 	{
 		*p++ = 0x05; // 2.6.8 Registration descriptor(p94)
 		*p++ = 4;
@@ -293,6 +317,8 @@ size_t pmt_write(const struct pmt_t *pmt, uint8_t *data)
 	{
 		// stream_type
 		*p = (uint8_t)(PSI_STREAM_AUDIO_OPUS == pmt->streams[i].codecid) ? PSI_STREAM_PRIVATE_DATA : pmt->streams[i].codecid;
+		if (pmt->streams[i].sample_aes)
+			*p = PSI_STREAM_H264 == pmt->streams[i].codecid ? 0xDB : (PSI_STREAM_AAC == pmt->streams[i].codecid ? 0xCF : *p); // SAMPLE-AES
 
 		// reserved '111'
 		// elementary_PID 13-bits
@@ -8,6 +8,7 @@
 #include "mpeg-ps-internal.h"
 #include "mpeg-pes-internal.h"
 #include "mpeg-util.h"
+#include "media-metrics.h"
 #include <assert.h>
 #include <string.h>
 #include <stdbool.h>
@@ -49,6 +50,10 @@ struct ps_demuxer_t
     struct ps_demuxer_notify_t notify;
     void* notify_param;
     uint32_t ver; // psm notify version
+
+#if defined(MEDIA_METRICS)
+    struct media_metrics_t metrics;
+#endif
 };
 
 static void ps_demuxer_notify(struct ps_demuxer_t* ps);
@@ -111,10 +116,14 @@ static int ps_sync_start_probe(struct mpeg_bits_t* reader)
 
 static int ps_demuxer_onpes(void* param, int program, int stream, int codecid, int flags, int64_t pts, int64_t dts, const void* data, size_t bytes)
 {
+    int r;
     struct ps_demuxer_t* ps;
     ps = (struct ps_demuxer_t*)param;
     assert(0 == program); // unused(ts demux only)
-    return ps->onpacket(ps->param, stream, codecid, flags, pts, dts, data, bytes);
+    MEDIA_METRICS_ADD(&ps->metrics, frames_out, 1);
+    MEDIA_METRICS_ADD(&ps->metrics, bytes_out, bytes);
+    MEDIA_METRICS_CALL(&ps->metrics, r, ps->onpacket(ps->param, stream, codecid, flags, pts, dts, data, bytes));
+    return r;
 }
 
 static struct pes_t* psm_fetch(struct psm_t* psm, uint8_t sid)
@@ -163,6 +172,9 @@ static int ps_demuxer_packet(struct ps_demuxer_t *ps, const uint8_t* data, size_
 {
     int r;
     struct pes_t* pes;
+#if defined(MEDIA_METRICS)
+    size_t capacity;
+#endif
 
     pes = ps->pes;
 
@@ -175,8 +187,18 @@ static int ps_demuxer_packet(struct ps_demuxer_t *ps, const uint8_t* data, size_
 #endif
 
     pes->flags = pes->data_alignment_indicator ? MPEG_FLAG_IDR_FRAME : 0;
+#if defined(MEDIA_METRICS)
+    capacity = pes->pkt.capacity;
+#endif
     r = pes_packet(&pes->pkt, pes, data, bytes, consume, ps->start, ps_demuxer_onpes, ps);
     ps->start = 0; // clear start flags
+#if defined(MEDIA_METRICS)
+    if (capacity != pes->pkt.capacity)
+    {
+        MEDIA_METRICS_ADD(&ps->metrics, allocs, 1);
+        MEDIA_METRICS_MAX(&ps->metrics, buffer_hwm, pes->pkt.capacity);
+    }
+#endif
     return r;
 }
 
@@ -339,6 +361,8 @@ static int ps_demuxer_buffer(struct ps_demuxer_t* ps, const uint8_t* data, size_
             memcpy(ptr, ps->buffer.ptr, ps->buffer.len);
         ps->buffer.ptr = (uint8_t*)ptr;
         ps->buffer.cap = ps->buffer.len + bytes + N_BUFFER_INC;
+        MEDIA_METRICS_ADD(&ps->metrics, allocs, 1);
+        MEDIA_METRICS_MAX(&ps->metrics, buffer_hwm, ps->buffer.cap);
     }
 
     memmove(ps->buffer.ptr + ps->buffer.len, data, bytes);
@@ -352,6 +376,8 @@ int ps_demuxer_input(struct ps_demuxer_t* ps, const uint8_t* data, size_t bytes)
     size_t i, consume;
     struct mpeg_bits_t reader;
 
+    MEDIA_METRICS_ADD(&ps->metrics, frames_in, 1);
+    MEDIA_METRICS_ADD(&ps->metrics, bytes_in, bytes);
     for(i = 0; i < bytes; )
     {
         switch (ps->state)
@@ -450,6 +476,7 @@ int ps_demuxer_input(struct ps_demuxer_t* ps, const uint8_t* data, size_t bytes)
         {
             ps->state = PS_DEMUXER_STATE_START; // skip error, try find next start code
             ps->buffer.len = 0; // clear buffer
+            MEDIA_METRICS_ADD(&ps->metrics, errors, 1);
             return r;
         }
     }
@@ -517,3 +544,15 @@ static void ps_demuxer_notify(struct ps_demuxer_t* ps)
         ps->notify.onstream(ps->notify_param, pes->pid, pes->codecid, pes->esinfo, pes->esinfo_len, i + 1 >= ps->psm.stream_count ? 1 : 0);
     }
 }
+
+int ps_demuxer_get_metrics(struct ps_demuxer_t* ps, struct media_metrics_t* metrics)
+{
+#if defined(MEDIA_METRICS)
+    media_metrics_snapshot(metrics, &ps->metrics);
+    return 0;
+#else
+    (void)ps;
+    memset(metrics, 0, sizeof(*metrics));
+    return -ENOSYS;
+#endif
+}
@@ -0,0 +1,294 @@
+// ITU-T H.222.0(06/2012)
+// 2.4.2 Transport stream system target decoder
+// 2.7.2 Frequency of coding the program clock reference
+// ETSI TR 101 290 5.2.2 PCR_repetition_error/PCR_accuracy_error
+
+#include "mpeg-ts-cbr.h"
+#include "mpeg-ts-internal.h"
+#include "mpeg-util.h"
+#include "mpeg-ts.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#define TS_PID_NULL			0x1FFF
+#define TS_PACKET_BITS		(TS_PACKET_SIZE * 8)
+#define PCR_WRAP			(0x200000000LL * 300) // 33-bits base * 300
+
+struct mpeg_ts_cbr_packet_t
+{
+	int64_t ready; // STC(27MHz) can be sent: DTS - delay
+	uint8_t data[TS_PACKET_SIZE];
+};
+
+struct mpeg_ts_cbr_t
+{
+	void* ts;
+	struct mpeg_ts_cbr_func_t func;
+	void* param;
+
+	int64_t muxrate; // bps
+	int64_t pcr_interval; // 27MHz
+	int64_t delay; // 27MHz
+	int batch;
+
+	// slot k: release at clock0 + k * slot, STC = pcr0 + k * slot
+	int started;
+	int64_t clock0; // us
+	int64_t pcr0; // 27MHz
+	int64_t k;
+
+	int pcr_pid; // learned from muxer PCR packets, -1-unknown
+	unsigned int pcr_cc; // last continuity_counter on PCR_PID
+	int64_t pcr_last; // last PCR STC
+
+	// queued packets(ring), the muxer builds packets in the ring slots(no alloc/free per packet),
+	// a released packet is copied once into the batch buffer(interleaved with PCR/null packets)
+	struct mpeg_ts_cbr_packet_t* packets;
+	size_t capacity;
+	size_t head;
+	size_t count;
+	int64_t ready; // current access unit
+
+	uint8_t* out; // batch * TS_PACKET_SIZE
+};
+
+static int64_t mpeg_ts_cbr_slot_clock(const struct mpeg_ts_cbr_t* cbr, int64_t k)
+{
+	return cbr->clock0 + k * TS_PACKET_BITS * 1000000 / cbr->muxrate;
+}
+
+static int64_t mpeg_ts_cbr_slot_stc(const struct mpeg_ts_cbr_t* cbr, int64_t k)
+{
+	return cbr->pcr0 + k * TS_PACKET_BITS * 27000000 / cbr->muxrate;
+}
+
+static void* mpeg_ts_cbr_alloc(void* param, size_t bytes)
+{
+	void* p;
+	size_t n;
+	struct mpeg_ts_cbr_t* cbr;
+	cbr = (struct mpeg_ts_cbr_t*)param;
+	assert(bytes <= TS_PACKET_SIZE);
+
+	if (cbr->count >= cbr->capacity)
+	{
+		n = cbr->capacity ? cbr->capacity * 2 : 256;
+		p = realloc(cbr->packets, n * sizeof(cbr->packets[0]));
+		if (!p)
+			return NULL;
+		cbr->packets = (struct mpeg_ts_cbr_packet_t*)p;
+
+		// unwrap the ring: [0, head + count - capacity) => [capacity, ...)
+		if (cbr->head + cbr->count > cbr->capacity)
+			memcpy(cbr->packets + cbr->capacity, cbr->packets, (cbr->head + cbr->count - cbr->capacity) * sizeof(cbr->packets[0]));
+		cbr->capacity = n;
+	}
+
+	return cbr->packets[(cbr->head + cbr->count) % cbr->capacity].data;
+}
+
+static void mpeg_ts_cbr_free(void* param, void* packet)
+{
+	(void)param; (void)packet; // ring slot
+}
+
+static int mpeg_ts_cbr_onpacket(void* param, const void* packet, size_t bytes)
+{
+	struct mpeg_ts_cbr_t* cbr;
+	struct mpeg_ts_cbr_packet_t* pkt;
+	cbr = (struct mpeg_ts_cbr_t*)param;
+
+	pkt = &cbr->packets[(cbr->head + cbr->count) % cbr->capacity];
+	assert(packet == pkt->data && TS_PACKET_SIZE == bytes);
+	pkt->ready = cbr->ready;
+	cbr->count++;
+	return 0;
+}
+
+struct mpeg_ts_cbr_t* mpeg_ts_cbr_create(int64_t muxrate, int pcr_interval, int delay, int batch, const struct mpeg_ts_cbr_func_t* func, void* param)
+{
+	struct mpeg_ts_cbr_t* cbr;
+	struct mpeg_ts_func_t h;
+
+	if (muxrate <= 0 || muxrate > 200000000 || pcr_interval < 1 || pcr_interval > 100 || delay < 0 || batch < 1 || !func)
+		return NULL;
+
+	cbr = (struct mpeg_ts_cbr_t*)calloc(1, sizeof(*cbr));
+	if (!cbr)
+		return NULL;
+
+	cbr->out = (uint8_t*)malloc(batch * TS_PACKET_SIZE);
+	if (!cbr->out)
+	{
+		free(cbr);
+		return NULL;
+	}
+
+	h.alloc = mpeg_ts_cbr_alloc;
+	h.free = mpeg_ts_cbr_free;
+	h.write = mpeg_ts_cbr_onpacket;
+	cbr->ts = mpeg_ts_create(&h, cbr);
+	if (!cbr->ts)
+	{
+		mpeg_ts_cbr_destroy(cbr);
+		return NULL;
+	}
+
+	memcpy(&cbr->func, func, sizeof(cbr->func));
+	cbr->param = param;
+	cbr->muxrate = muxrate;
+	cbr->pcr_interval = (int64_t)pcr_interval * 27000;
+	cbr->delay = (int64_t)delay * 27000;
+	cbr->batch = batch;
+	cbr->pcr_pid = -1;
+	return cbr;
+}
+
+void mpeg_ts_cbr_destroy(struct mpeg_ts_cbr_t* cbr)
+{
+	if (cbr->ts)
+		mpeg_ts_destroy(cbr->ts);
+	free(cbr->packets);
+	free(cbr->out);
+	free(cbr);
+}
+
+void* mpeg_ts_cbr_muxer(struct mpeg_ts_cbr_t* cbr)
+{
+	return cbr->ts;
+}
+
+int mpeg_ts_cbr_write(struct mpeg_ts_cbr_t* cbr, int stream, int flags, int64_t pts, int64_t dts, const void* data, size_t bytes)
+{
+	int r;
+	size_t count;
+
+	count = cbr->count;
+	cbr->ready = (PTS_NO_VALUE == dts ? pts : dts) * 300 - cbr->delay;
+	r = mpeg_ts_write(cbr->ts, stream, flags, pts, dts, data, bytes);
+	if (0 != r)
+	{
+		cbr->count = count; // drop packets of failed write
+		return r;
+	}
+
+	if (!cbr->started && cbr->count > 0)
+	{
+		cbr->started = 1;
+		cbr->clock0 = cbr->func.clock(cbr->param);
+		cbr->pcr0 = cbr->ready;
+		cbr->pcr_last = cbr->ready - cbr->pcr_interval; // PCR on first slot
+		cbr->k = 0;
+	}
+	return 0;
+}
+
+static int mpeg_ts_cbr_has_pcr(const uint8_t* data)
+{
+	// adaptation_field_control & 0x02, adaptation_field_length >= 7, PCR_flag
+	return (data[3] & 0x20) && data[4] >= 7 && (data[5] & 0x10);
+}
+
+static void mpeg_ts_cbr_pcr_write(uint8_t* data, int64_t stc)
+{
+	stc %= PCR_WRAP;
+	pcr_write(data + 6, stc < 0 ? stc + PCR_WRAP : stc);
+}
+
+// PCR_PID adaptation field only(adaptation_field_control = '10', continuity_counter not incremented)
+static void mpeg_ts_cbr_pcr_packet(struct mpeg_ts_cbr_t* cbr, uint8_t* data, int64_t stc)
+{
+	data[0] = TS_SYNC_BYTE;
+	data[1] = (uint8_t)((cbr->pcr_pid >> 8) & 0x1F);
+	data[2] = (uint8_t)(cbr->pcr_pid & 0xFF);
+	data[3] = (uint8_t)(0x20 | (cbr->pcr_cc & 0x0F));
+	data[4] = TS_PACKET_SIZE - 5; // adaptation_field_length
+	data[5] = 0x10; // PCR_flag
+	mpeg_ts_cbr_pcr_write(data, stc);
+	memset(data + 12, 0xFF, TS_PACKET_SIZE - 12); // stuffing_byte
+}
+
+static void mpeg_ts_cbr_null_packet(uint8_t* data)
+{
+	data[0] = TS_SYNC_BYTE;
+	data[1] = (TS_PID_NULL >> 8) & 0x1F;
+	data[2] = TS_PID_NULL & 0xFF;
+	data[3] = 0x10; // payload only
+	memset(data + 4, 0xFF, TS_PACKET_SIZE - 4);
+}
+
+// fill slot k packet
+static void mpeg_ts_cbr_slot(struct mpeg_ts_cbr_t* cbr, uint8_t* data)
+{
+	int pid;
+	int64_t stc;
+	struct mpeg_ts_cbr_packet_t* pkt;
+
+	stc = mpeg_ts_cbr_slot_stc(cbr, cbr->k);
+	pkt = cbr->count > 0 && cbr->packets[cbr->head].ready <= stc ? &cbr->packets[cbr->head] : NULL;
+
+	// PCR now if the next slot exceed the interval
+	if (cbr->pcr_pid >= 0 && mpeg_ts_cbr_slot_stc(cbr, cbr->k + 1) - cbr->pcr_last > cbr->pcr_interval && !(pkt && mpeg_ts_cbr_has_pcr(pkt->data)))
+	{
+		mpeg_ts_cbr_pcr_packet(cbr, data, stc);
+		cbr->pcr_last = stc;
+	}
+	else if (pkt)
+	{
+		memcpy(data, pkt->data, TS_PACKET_SIZE);
+		cbr->head = (cbr->head + 1) % cbr->capacity;
+		cbr->count--;
+
+		pid = ((data[1] & 0x1F) << 8) | data[2];
+		if (mpeg_ts_cbr_has_pcr(data))
+		{
+			// muxer PCR(DTS based) => slot STC
+			mpeg_ts_cbr_pcr_write(data, stc);
+			cbr->pcr_pid = pid;
+			cbr->pcr_last = stc;
+		}
+		if (pid == cbr->pcr_pid && (data[3] & 0x10))
+			cbr->pcr_cc = data[3] & 0x0F;
+	}
+	else
+	{
+		mpeg_ts_cbr_null_packet(data);
+	}
+
+	// rebase every muxrate slots(188 * 8 seconds), keep the slot math in 64-bits
+	if (++cbr->k >= cbr->muxrate)
+	{
+		cbr->k -= cbr->muxrate;
+		cbr->clock0 += TS_PACKET_BITS * 1000000LL;
+		cbr->pcr0 += TS_PACKET_BITS * 27000000LL;
+	}
+}
+
+int64_t mpeg_ts_cbr_send(struct mpeg_ts_cbr_t* cbr)
+{
+	int i, r;
+	int64_t clock, next;
+
+	if (!cbr->started)
+		return cbr->pcr_interval / 27;
+
+	clock = cbr->func.clock(cbr->param);
+	for (next = mpeg_ts_cbr_slot_clock(cbr, cbr->k); next <= clock; next = mpeg_ts_cbr_slot_clock(cbr, cbr->k))
+	{
+		for (i = 0; i < cbr->batch; i++)
+			mpeg_ts_cbr_slot(cbr, cbr->out + i * TS_PACKET_SIZE);
+
+		r = cbr->func.write(cbr->param, cbr->out, cbr->batch * TS_PACKET_SIZE);
+		if (0 != r)
+			return r < 0 ? r : -r;
+	}
+
+	return next - clock;
+}
+
+size_t mpeg_ts_cbr_pending(struct mpeg_ts_cbr_t* cbr)
+{
+	return cbr->count;
+}
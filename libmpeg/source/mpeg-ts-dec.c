@@ -6,6 +6,7 @@
 #include "mpeg-ts-internal.h"
 #include "mpeg-util.h"
 #include "mpeg-ts.h"
+#include "media-metrics.h"
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
@@ -21,10 +22,51 @@ struct ts_demuxer_t
 
 	struct ts_demuxer_notify_t notify;
 	void* notify_param;
+
+#if defined(MEDIA_METRICS)
+	struct media_metrics_t metrics;
+	ts_demuxer_onpacket handler; // user callback
+	void* cbparam;
+#endif
 };
 
 static void ts_demuxer_notify(struct ts_demuxer_t* ts, const struct pmt_t* pmt);
 
+#if defined(MEDIA_METRICS)
+static int ts_demuxer_onpacket_metrics(void* param, int program, int stream, int codecid, int flags, int64_t pts, int64_t dts, const void* data, size_t bytes)
+{
+	int r;
+	struct ts_demuxer_t* ts;
+	ts = (struct ts_demuxer_t*)param;
+	MEDIA_METRICS_ADD(&ts->metrics, frames_out, 1);
+	MEDIA_METRICS_ADD(&ts->metrics, bytes_out, bytes);
+	MEDIA_METRICS_CALL(&ts->metrics, r, ts->handler(ts->cbparam, program, stream, codecid, flags, pts, dts, data, bytes));
+	return r;
+}
+#endif
+
+/// PSI repetition(PAT/PMT every 40~500ms): the CRC32 covers the version_number and table data
+/// @param[in] crc last parsed section CRC32, 0-none
+/// @param[out] v this section CRC32, save it only after the section is parsed
+/// @return 1-same section(skip parse), 0-new/changed section, <0-CRC error(skip parse)
+static int ts_demuxer_section_repeat(const uint8_t* data, size_t bytes, uint32_t crc, uint32_t* v)
+{
+	uint32_t n;
+	*v = 0;
+	if (bytes < 3)
+		return 0;
+
+	n = (((data[1] & 0x0F) << 8) | data[2]) + 3; // section_length + 3
+	if (n < 12 || n > bytes)
+		return 0; // invalid section, let pat_read/pmt_read handle it
+
+	if (0 != mpeg_crc32(0xffffffff, data, n))
+		return -1; // corrupted section, wait next repetition
+
+	*v = ((uint32_t)data[n - 4] << 24) | ((uint32_t)data[n - 3] << 16) | ((uint32_t)data[n - 2] << 8) | data[n - 1];
+	return *v == crc ? 1 : 0;
+}
+
 static uint32_t adaptation_filed_read(struct ts_adaptation_field_t *adp, const uint8_t* data, size_t bytes)
 {
 	// 2.4.3.4 Adaptation field
@@ -167,8 +209,15 @@ int ts_demuxer_input(struct ts_demuxer_t* ts, const uint8_t* data, size_t bytes)
 	uint32_t PID;
 	size_t consume;
 	unsigned int count, ver;
+	uint32_t crc;
 	struct mpeg_bits_t reader;
     struct ts_packet_header_t pkhd;
+#if defined(MEDIA_METRICS)
+	size_t capacity;
+#endif
+
+	MEDIA_METRICS_ADD(&ts->metrics, frames_in, 1);
+	MEDIA_METRICS_ADD(&ts->metrics, bytes_in, bytes);
 
 	// 2.4.3 Specification of the transport stream syntax and semantics
 	// Transport stream packets shall be 188 bytes long.
@@ -214,7 +263,8 @@ int ts_demuxer_input(struct ts_demuxer_t* ts, const uint8_t* data, size_t bytes)
 				i += 1; // pointer 0x00
 
 			// TODO: PAT lost
-			pat_read(&ts->pat, data + i, bytes - i);
+			if (0 == ts_demuxer_section_repeat(data + i, bytes - i, ts->pat.crc, &crc) && pat_read(&ts->pat, data + i, bytes - i) > 0)
+				ts->pat.crc = crc;
 		}
         else if(TS_PID_SDT == PID)
         {
@@ -232,9 +282,13 @@ int ts_demuxer_input(struct ts_demuxer_t* ts, const uint8_t* data, size_t bytes)
 					if(pkhd.payload_unit_start_indicator)
 						i += 1; // pointer 0x00
 
+					if (0 != ts_demuxer_section_repeat(data + i, bytes - i, ts->pat.pmts[j].crc, &crc))
+						break; // same version and CRC, or CRC error
+
 					ver = ts->pat.pmts[j].ver;
 					count = ts->pat.pmts[j].stream_count;
-					pmt_read(&ts->pat.pmts[j], data + i, bytes - i);
+					if (pmt_read(&ts->pat.pmts[j], data + i, bytes - i) > 0)
+						ts->pat.pmts[j].crc = crc;
 					if(ver != ts->pat.pmts[j].ver || count != ts->pat.pmts[j].stream_count)
 						ts_demuxer_notify(ts, &ts->pat.pmts[j]);
 					break;
@@ -259,6 +313,7 @@ int ts_demuxer_input(struct ts_demuxer_t* ts, const uint8_t* data, size_t bytes)
                             if (MPEG_ERROR_OK != pes_read_header(pes, &reader) || s != 0x000001)
 							{
 								assert(0);
+								MEDIA_METRICS_ADD(&ts->metrics, errors, 1);
 								return 0; // ignore
 							}
                             i += (uint32_t)mpeg_bits_tell(&reader);
@@ -272,7 +327,19 @@ int ts_demuxer_input(struct ts_demuxer_t* ts, const uint8_t* data, size_t bytes)
 							return 0; // ignore, don't have pes header yet
 						}
 
+#if defined(MEDIA_METRICS)
+						capacity = pes->pkt.capacity;
+#endif
                         r = pes_packet(&pes->pkt, pes, data + i, bytes - i, &consume, pkhd.payload_unit_start_indicator, ts->onpacket, ts->param);
+#if defined(MEDIA_METRICS)
+						if (capacity != pes->pkt.capacity)
+						{
+							MEDIA_METRICS_ADD(&ts->metrics, allocs, 1);
+							MEDIA_METRICS_MAX(&ts->metrics, buffer_hwm, pes->pkt.capacity);
+						}
+						if (r < 0)
+							MEDIA_METRICS_ADD(&ts->metrics, errors, 1);
+#endif
 						pes->have_pes_header = (r || (0 == pes->pkt.size && pes->len > 0)) ? 0 : 1; // packet completed
                         return r; // find stream
 					}
@@ -314,6 +381,12 @@ struct ts_demuxer_t* ts_demuxer_create(ts_demuxer_onpacket onpacket, void* param
 
     ts->onpacket = onpacket;
     ts->param = param;
+#if defined(MEDIA_METRICS)
+	ts->handler = onpacket;
+	ts->cbparam = param;
+	ts->onpacket = ts_demuxer_onpacket_metrics;
+	ts->param = ts;
+#endif
     return ts;
 }
 
@@ -355,3 +428,15 @@ static void ts_demuxer_notify(struct ts_demuxer_t* ts, const struct pmt_t* pmt)
 		ts->notify.onstream(ts->notify_param, pes->pid, pes->codecid, pes->esinfo, pes->esinfo_len, i + 1 >= pmt->stream_count ? 1 : 0);
 	}
 }
+
+int ts_demuxer_get_metrics(struct ts_demuxer_t* ts, struct media_metrics_t* metrics)
+{
+#if defined(MEDIA_METRICS)
+	media_metrics_snapshot(metrics, &ts->metrics);
+	return 0;
+#else
+	(void)ts;
+	memset(metrics, 0, sizeof(*metrics));
+	return -ENOSYS;
+#endif
+}
@@ -39,16 +39,56 @@ typedef struct _mpeg_ts_enc_context_t
 	struct mpeg_ts_func_t func;
 	void* param;
 
+	// batched output(mpeg_ts_set_buffer)
+	uint8_t* buffer;
+	size_t capacity; // buffer packets
+	size_t packets; // pending packets
+	int batch;
+
+	// serialized SDT/PAT/PMT packets(continuity_counter patched on write)
+	uint8_t* psi; // SDT + PAT + PMTs
+	int psi_valid; // 0-rebuild on next write(program/stream/PCR_PID changed)
+
 	uint8_t payload[1024]; // maximum PAT/PMT payload length
 } mpeg_ts_enc_context_t;
 
-static int mpeg_ts_write_section_header(const mpeg_ts_enc_context_t *ts, int pid, unsigned int* cc, const void* payload, size_t len)
+static uint8_t* mpeg_ts_alloc_packet(mpeg_ts_enc_context_t* ts)
+{
+	if (ts->buffer)
+		return ts->buffer + ts->packets * TS_PACKET_SIZE;
+	return (uint8_t*)ts->func.alloc(ts->param, TS_PACKET_SIZE);
+}
+
+/// keep the packets on failure, the continuity_counter has been advanced
+static int mpeg_ts_flush(mpeg_ts_enc_context_t* ts)
 {
 	int r;
-	uint8_t *data = NULL;
-	data = ts->func.alloc(ts->param, TS_PACKET_SIZE);
-	if(!data) return -ENOMEM;
+	if (!ts->buffer || 0 == ts->packets)
+		return 0;
+	r = ts->func.write(ts->param, ts->buffer, ts->packets * TS_PACKET_SIZE);
+	if (0 == r)
+		ts->packets = 0;
+	return r;
+}
+
+static int mpeg_ts_write_packet(mpeg_ts_enc_context_t* ts, uint8_t* data)
+{
+	int r;
+	if (!ts->buffer)
+	{
+		r = ts->func.write(ts->param, data, TS_PACKET_SIZE);
+		ts->func.free(ts->param, data);
+		return r;
+	}
+
+	// one write callback per batch(or full buffer)
+	if (++ts->packets >= ts->capacity || (ts->batch > 0 && ts->packets >= (size_t)ts->batch))
+		return mpeg_ts_flush(ts);
+	return 0;
+}
 
+static void mpeg_ts_write_section_header(uint8_t* data, int pid, const void* payload, size_t len)
+{
 	assert(len < TS_PACKET_SIZE - 5); // TS-header + pointer
 
 	// TS Header
@@ -62,8 +102,7 @@ static int mpeg_ts_write_section_header(const mpeg_ts_enc_context_t *ts, int pid
 	data[2] = pid & 0xFF;
 	// transport_scrambling_control = 0x00
 	// adaptation_field_control = 0x01-No adaptation_field, payload only, 0x03-adaptation and payload
-	data[3] = 0x10 | (*cc & 0x0F);
-	*cc = (*cc + 1) % 16; // update continuity_counter
+	data[3] = 0x10; // continuity_counter: mpeg_ts_write_section
 
 //	// Adaptation
 //	if(len < TS_PACKET_SIZE - 5)
@@ -86,12 +125,49 @@ static int mpeg_ts_write_section_header(const mpeg_ts_enc_context_t *ts, int pid
     //memmove(data + TS_PACKET_SIZE - len, payload, len);
     memmove(data + 5, payload, len);
     memset(data+5+len, 0xff, TS_PACKET_SIZE-len-5);
+}
 
-	r = ts->func.write(ts->param, data, TS_PACKET_SIZE);
-	ts->func.free(ts->param, data);
-	return r;
+static int mpeg_ts_write_section(mpeg_ts_enc_context_t* ts, const uint8_t* packet, unsigned int* cc)
+{
+	uint8_t* data = NULL;
+	data = mpeg_ts_alloc_packet(ts);
+	if (!data) return -ENOMEM;
+
+	memcpy(data, packet, TS_PACKET_SIZE);
+	data[3] = 0x10 | (*cc & 0x0F);
+	*cc = (*cc + 1) % 16; // update continuity_counter
+	return mpeg_ts_write_packet(ts, data);
 }
 
+static int mpeg_ts_psi_update(mpeg_ts_enc_context_t* ts)
+{
+	void* p;
+	size_t i, n;
+
+	p = realloc(ts->psi, (2 + ts->pat.pmt_count) * TS_PACKET_SIZE);
+	if (!p) return -ENOMEM;
+	ts->psi = (uint8_t*)p;
+
+	// SDT
+	n = sdt_write(&ts->pat, ts->payload);
+	mpeg_ts_write_section_header(ts->psi, TS_PID_SDT, ts->payload, n);
+
+	// PAT(program_association_section)
+	n = pat_write(&ts->pat, ts->payload);
+	mpeg_ts_write_section_header(ts->psi + TS_PACKET_SIZE, TS_PID_PAT, ts->payload, n); // PID = 0x00 program association table
+
+	// PMT(Transport stream program map section)
+	for (i = 0; i < ts->pat.pmt_count; i++)
+	{
+		n = pmt_write(&ts->pat.pmts[i], ts->payload);
+		mpeg_ts_write_section_header(ts->psi + (2 + i) * TS_PACKET_SIZE, ts->pat.pmts[i].pid, ts->payload, n);
+	}
+
+	ts->psi_valid = 1;
+	return 0;
+}
+
+
 
 // Generate Opus control header according to ETSI TS 103 491 section 6.2.1
 static uint8_t* mpeg_ts_write_opus_control_header(uint8_t* p, size_t payload_size)
@@ -175,7 +251,7 @@ static int ts_write_pes(mpeg_ts_enc_context_t *tsctx, const struct pmt_t* pmt, s
 
 	while(0 == r && bytes > 0)
 	{
-		data = tsctx->func.alloc(tsctx->param, TS_PACKET_SIZE);
+		data = mpeg_ts_alloc_packet(tsctx);
 		if(!data) return -ENOMEM;
 
 		// TS Header
@@ -290,8 +366,7 @@ static int ts_write_pes(mpeg_ts_enc_context_t *tsctx, const struct pmt_t* pmt, s
 		start = 0;
 
 		// send with TS-header
-		r = tsctx->func.write(tsctx->param, data, TS_PACKET_SIZE);
-		tsctx->func.free(tsctx->param, data);
+		r = mpeg_ts_write_packet(tsctx, data);
 	}
 
 	return r;
@@ -319,7 +394,7 @@ static struct pes_t *mpeg_ts_find(mpeg_ts_enc_context_t *ts, int pid, struct pmt
 int mpeg_ts_write(void* ts, int pid, int flags, int64_t pts, int64_t dts, const void* data, size_t bytes)
 {
 	int r = 0;
-	size_t i, n;
+	size_t i;
     struct pmt_t *pmt = NULL;
 	struct pes_t *stream = NULL;
 	mpeg_ts_enc_context_t *tsctx;
@@ -329,6 +404,11 @@ int mpeg_ts_write(void* ts, int pid, int flags, int64_t pts, int64_t dts, const
     if (NULL == stream)
         return -ENOENT; // not found
 
+    // retry pending packets of the last failed write first
+    r = mpeg_ts_flush(tsctx);
+    if (0 != r)
+        return r;
+
     stream->pts = pts;
     stream->dts = dts;
     stream->data_alignment_indicator = (flags & MPEG_FLAG_IDR_FRAME) ? 1 : 0; // idr frame
@@ -338,6 +418,7 @@ int mpeg_ts_write(void* ts, int pid, int flags, int64_t pts, int64_t dts, const
     if (0x1FFF == pmt->PCR_PID || (PES_SID_VIDEO == (stream->sid & PES_SID_VIDEO) && pmt->PCR_PID != stream->pid))
     {
         pmt->PCR_PID = stream->pid;
+        tsctx->psi_valid = 0;
         tsctx->pat_period = 0;
 		tsctx->pat_cycle = 0;
     }
@@ -351,30 +432,46 @@ int mpeg_ts_write(void* ts, int pid, int flags, int64_t pts, int64_t dts, const
 		tsctx->pat_cycle = 0;
 		tsctx->pat_period = dts;
 
+		// serialize once, re-emit cached sections
+		if (!tsctx->psi_valid && 0 != (r = mpeg_ts_psi_update(tsctx)))
+			return r;
+
 		if (0 == tsctx->sdt_period)
 		{
 			// SDT
 			tsctx->sdt_period = dts;
-			n = sdt_write(&tsctx->pat, tsctx->payload);
-			r = mpeg_ts_write_section_header(ts, TS_PID_SDT, &tsctx->pat.cc /*fixme*/ , tsctx->payload, n);
+			r = mpeg_ts_write_section(tsctx, tsctx->psi, &tsctx->pat.cc /*fixme*/);
 			if (0 != r) return r;
 		}
 
-		// PAT(program_association_section)
-		n = pat_write(&tsctx->pat, tsctx->payload);
-		r = mpeg_ts_write_section_header(ts, TS_PID_PAT, &tsctx->pat.cc, tsctx->payload, n); // PID = 0x00 program association table
+		// PAT
+		r = mpeg_ts_write_section(tsctx, tsctx->psi + TS_PACKET_SIZE, &tsctx->pat.cc);
 		if (0 != r) return r;
 
-		// PMT(Transport stream program map section)
+		// PMT
 		for(i = 0; i < tsctx->pat.pmt_count; i++)
 		{
-			n = pmt_write(&tsctx->pat.pmts[i], tsctx->payload);
-			r = mpeg_ts_write_section_header(ts, tsctx->pat.pmts[i].pid, &tsctx->pat.pmts[i].cc, tsctx->payload, n);
+			r = mpeg_ts_write_section(tsctx, tsctx->psi + (2 + i) * TS_PACKET_SIZE, &tsctx->pat.pmts[i].cc);
 			if (0 != r) return r;
 		}
 	}
 
-	return ts_write_pes(tsctx, pmt, stream, data, bytes);
+	r = ts_write_pes(tsctx, pmt, stream, data, bytes);
+	return 0 == r ? mpeg_ts_flush(tsctx) : r;
+}
+
+int mpeg_ts_set_buffer(void* ts, void* buffer, size_t bytes, int batch)
+{
+	mpeg_ts_enc_context_t *tsctx;
+	tsctx = (mpeg_ts_enc_context_t*)ts;
+	if (buffer && bytes < TS_PACKET_SIZE)
+		return -EINVAL;
+
+	tsctx->buffer = (uint8_t*)buffer;
+	tsctx->capacity = bytes / TS_PACKET_SIZE;
+	tsctx->packets = 0;
+	tsctx->batch = batch;
+	return 0;
 }
 
 void* mpeg_ts_create(const struct mpeg_ts_func_t *func, void* param)
@@ -421,6 +518,7 @@ int mpeg_ts_destroy(void* ts)
 	tsctx = (mpeg_ts_enc_context_t*)ts;
 
 	pat_clear(&tsctx->pat);
+	free(tsctx->psi);
 	free(tsctx);
 	return 0;
 }
@@ -434,6 +532,7 @@ int mpeg_ts_reset(void* ts)
 	tsctx->pcr_period = 80 * 90; // 100ms maximum
 	tsctx->pcr_clock = 0;
 	tsctx->pat_cycle = 0;
+	tsctx->psi_valid = 0; // update PAT/PMT
 	return 0;
 }
 
@@ -503,6 +602,39 @@ int mpeg_ts_remove_program(void* ts, uint16_t pn)
 	return -1; // ENOTFOUND
 }
 
+int mpeg_ts_set_sample_aes(void* ts, int pid, const void* setup, size_t bytes)
+{
+	struct pmt_t* pmt = NULL;
+	struct pes_t* stream = NULL;
+	mpeg_ts_enc_context_t* tsctx;
+
+	tsctx = (mpeg_ts_enc_context_t*)ts;
+	stream = mpeg_ts_find(tsctx, pid, &pmt);
+	if (NULL == stream)
+		return -ENOENT; // not found
+	if ((PSI_STREAM_H264 != stream->codecid && PSI_STREAM_AAC != stream->codecid) || bytes > 64)
+		return -EINVAL;
+
+	// AAC audio setup information
+	if (stream->esinfo)
+		free(stream->esinfo);
+	stream->esinfo = NULL;
+	stream->esinfo_len = 0;
+	if (bytes > 0 && setup)
+	{
+		stream->esinfo = malloc(bytes);
+		if (!stream->esinfo)
+			return -ENOMEM;
+		memcpy(stream->esinfo, setup, bytes);
+		stream->esinfo_len = (uint16_t)bytes;
+	}
+
+	stream->sample_aes = 1;
+	pmt->ver = (pmt->ver + 1) % 32;
+	mpeg_ts_reset(ts); // immediate update pat/pmt
+	return 0;
+}
+
 static int mpeg_ts_pmt_add_stream(mpeg_ts_enc_context_t* ts, struct pmt_t* pmt, int codecid, const void* extra_data, size_t extra_data_size)
 {
 	struct pes_t* stream = NULL;
@@ -65,6 +65,7 @@ struct pmt_t
 	unsigned int pn;		// program_number: 16 [1, 0xFFFF]
 	unsigned int ver;		// version_number : 5
 	unsigned int cc;		// continuity_counter : 4
+	uint32_t crc;			// last parsed section CRC32(demuxer only)
 	unsigned int PCR_PID;	// 13-bits
 	unsigned int pminfo_len;// program_info_length : 12
 	uint8_t* pminfo;	// program_info;
@@ -82,6 +83,7 @@ struct pat_t
 	unsigned int tsid;	// transport_stream_id : 16;
 	unsigned int ver;	// version_number : 5;
 	unsigned int cc;	//continuity_counter : 4;
+	uint32_t crc;		// last parsed section CRC32(demuxer only)
 
 	unsigned int pmt_count;
 	unsigned int pmt_capacity;
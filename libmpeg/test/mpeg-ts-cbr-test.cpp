@@ -0,0 +1,142 @@
+#include "mpeg-ts-cbr.h"
+#include "mpeg-ts.h"
+#include <assert.h>
+#include <string.h>
+#include <stdio.h>
+#include <vector>
+
+#define MUXRATE			2000000 // 2Mbps
+#define PCR_INTERVAL	20 // ms
+#define DELAY			300 // ms
+#define BATCH			7
+
+struct mpeg_ts_cbr_test_t
+{
+	int64_t clock; // simulated clock(us)
+	std::vector<uint8_t> ts;
+	size_t writes;
+};
+
+static int64_t mpeg_ts_cbr_test_clock(void* param)
+{
+	return ((mpeg_ts_cbr_test_t*)param)->clock;
+}
+
+static int mpeg_ts_cbr_test_write(void* param, const void* packets, size_t bytes)
+{
+	mpeg_ts_cbr_test_t* ctx = (mpeg_ts_cbr_test_t*)param;
+	assert(BATCH * 188 == bytes);
+	ctx->ts.insert(ctx->ts.end(), (const uint8_t*)packets, (const uint8_t*)packets + bytes);
+	ctx->writes++;
+	return 0;
+}
+
+static int64_t mpeg_ts_cbr_test_pcr(const uint8_t* p)
+{
+	int64_t base = ((int64_t)p[6] << 25) | ((int64_t)p[7] << 17) | ((int64_t)p[8] << 9) | ((int64_t)p[9] << 1) | (p[10] >> 7);
+	return base * 300 + (((p[10] & 0x01) << 8) | p[11]);
+}
+
+static int64_t mpeg_ts_cbr_test_timestamp(const uint8_t* p)
+{
+	return (((int64_t)(p[0] >> 1) & 0x07) << 30) | ((int64_t)p[1] << 22) | ((int64_t)(p[2] >> 1) << 15) | ((int64_t)p[3] << 7) | (p[4] >> 1);
+}
+
+// 1s H.264 25fps(5000 bytes) + AAC(300 bytes, 1024 samples 44.1kHz), live input: frame arrives at its DTS
+void mpeg_ts_cbr_test(void)
+{
+	static uint8_t s_video[5000];
+	static uint8_t s_audio[300];
+	mpeg_ts_cbr_test_t ctx;
+	struct mpeg_ts_cbr_func_t func = { mpeg_ts_cbr_test_clock, mpeg_ts_cbr_test_write };
+
+	memset(s_video, 0x55, sizeof(s_video));
+	memcpy(s_video, "\x00\x00\x00\x01\x09\xF0\x00\x00\x00\x01\x65", 11); // AUD + IDR
+	memset(s_audio, 0x33, sizeof(s_audio));
+	memcpy(s_audio, "\xFF\xF1\x50\x80\x25\x9F\xFC", 7); // ADTS header
+
+	assert(NULL == mpeg_ts_cbr_create(MUXRATE, 200, DELAY, BATCH, &func, &ctx)); // PCR interval > 100ms
+
+	ctx.clock = 1000000;
+	ctx.writes = 0;
+	mpeg_ts_cbr_t* cbr = mpeg_ts_cbr_create(MUXRATE, PCR_INTERVAL, DELAY, BATCH, &func, &ctx);
+	int video = mpeg_ts_add_stream(mpeg_ts_cbr_muxer(cbr), PSI_STREAM_H264, NULL, 0);
+	int audio = mpeg_ts_add_stream(mpeg_ts_cbr_muxer(cbr), PSI_STREAM_AAC, NULL, 0);
+	assert(mpeg_ts_cbr_send(cbr) > 0 && 0 == ctx.writes); // not started
+
+	int64_t vdts = 90000, adts = 90000;
+	int64_t start = ctx.clock;
+	for (int64_t t = 0; t <= 2000000; t += 1000, ctx.clock += 1000)
+	{
+		for (; vdts <= 90000 + 90000 && (vdts - 90000) * 100 / 9 <= t; vdts += 3600)
+			assert(0 == mpeg_ts_cbr_write(cbr, video, (vdts - 90000) % 90000 ? MPEG_FLAG_H264_H265_WITH_AUD : (MPEG_FLAG_IDR_FRAME | MPEG_FLAG_H264_H265_WITH_AUD), vdts + 3600, vdts, s_video, sizeof(s_video)));
+		for (; adts <= 90000 + 90000 && (adts - 90000) * 100 / 9 <= t; adts += 1024 * 90000 / 44100)
+			assert(0 == mpeg_ts_cbr_write(cbr, audio, 0, adts, adts, s_audio, sizeof(s_audio)));
+
+		int64_t next = mpeg_ts_cbr_send(cbr);
+		assert(next > 0 && next <= BATCH * 188 * 8 * 1000000LL / MUXRATE + 1);
+	}
+	assert(0 == mpeg_ts_cbr_pending(cbr));
+
+	// constant bitrate: 2s output(+1 batch) in 7-packets write
+	size_t n = ctx.ts.size() / 188;
+	assert(ctx.writes * BATCH == n);
+	assert(n >= (size_t)(2 * MUXRATE / (188 * 8)) && n <= (size_t)(2 * MUXRATE / (188 * 8)) + BATCH);
+
+	int pes = 0, nulls = 0, pcrs = 0;
+	int64_t pcr0 = -1, pcr_last = -1;
+	int cc[0x2000];
+	memset(cc, -1, sizeof(cc));
+	for (size_t i = 0; i < n; i++)
+	{
+		const uint8_t* p = &ctx.ts[i * 188];
+		int pid = ((p[1] & 0x1F) << 8) | p[2];
+		assert(0x47 == p[0]);
+
+		if (0x1FFF == pid)
+		{
+			nulls++;
+			continue;
+		}
+
+		// continuity_counter increase on payload only
+		if (p[3] & 0x10)
+		{
+			assert(-1 == cc[pid] || ((cc[pid] + 1) & 0x0F) == (p[3] & 0x0F));
+			cc[pid] = p[3] & 0x0F;
+		}
+
+		const uint8_t* payload = p + 4;
+		if (p[3] & 0x20)
+		{
+			if (p[4] >= 7 && (p[5] & 0x10))
+			{
+				// PCR = slot STC: linear with packet index(byte position), no jitter
+				int64_t pcr = mpeg_ts_cbr_test_pcr(p);
+				if (pcr0 < 0)
+					pcr0 = pcr - (int64_t)i * 188 * 8 * 27000000 / MUXRATE;
+				assert(pcr == pcr0 + (int64_t)i * 188 * 8 * 27000000 / MUXRATE);
+				assert(pcr_last < 0 || pcr - pcr_last <= PCR_INTERVAL * 27000);
+				pcr_last = pcr;
+				pcrs++;
+			}
+			payload += 1 + p[4];
+		}
+
+		if ((p[1] & 0x40) && (pid == video || pid == audio))
+		{
+			// T-STD: each access unit arrives in [DTS - delay, DTS]
+			int64_t dts, stc = pcr0 + (int64_t)i * 188 * 8 * 27000000 / MUXRATE;
+			assert(0 == payload[0] && 0 == payload[1] && 1 == payload[2]);
+			dts = mpeg_ts_cbr_test_timestamp(payload + 9 + ((payload[7] & 0x40) ? 5 : 0));
+			assert(pcr0 >= 0 && stc >= dts * 300 - DELAY * 27000 && stc <= dts * 300);
+			pes++;
+		}
+	}
+
+	assert(pes == 26 + 44); // 1s + 1 frame
+	assert(nulls > 0 && pcrs >= 2000 / PCR_INTERVAL);
+	assert(pcr0 == 90000 * 300 - DELAY * 27000);
+	printf("mpeg_ts_cbr_test: %d packets(%d null), %d PCR, %u bytes in %.3fs\n", (int)n, nulls, pcrs, (unsigned int)ctx.ts.size(), (ctx.clock - start) / 1000000.0);
+	mpeg_ts_cbr_destroy(cbr);
+}
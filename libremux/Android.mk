@@ -0,0 +1,18 @@
+LOCAL_PATH := $(call my-dir)
+
+include $(CLEAR_VARS)
+LOCAL_CFLAGS += -DOS_LINUX -DOS_ANDROID
+LOCAL_LDLIBS +=
+
+LOCAL_C_INCLUDES := $(LOCAL_PATH)
+LOCAL_C_INCLUDES += $(LOCAL_PATH)/include
+LOCAL_C_INCLUDES += $(LOCAL_PATH)/../libmov/include
+LOCAL_C_INCLUDES += $(LOCAL_PATH)/../libmkv/include
+LOCAL_C_INCLUDES += $(LOCAL_PATH)/../libmpeg/include
+LOCAL_C_INCLUDES += $(LOCAL_PATH)/../libflv/include
+
+LOCAL_SRC_FILES := $(wildcard source/*.c)
+LOCAL_SRC_FILES += $(wildcard source/*.cpp)
+
+LOCAL_MODULE := remux
+include $(BUILD_STATIC_LIBRARY)
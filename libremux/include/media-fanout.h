@@ -0,0 +1,84 @@
+#ifndef _media_fanout_h_
+#define _media_fanout_h_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/// Live media fanout: single-producer multi-consumer lock-free ring of ref-counted frames.
+/// The publisher writes each frame once, every subscriber reads with its own cursor(from any thread),
+/// so a slow subscriber never blocks the publisher or the other subscribers.
+/// 1. GOP cache: a new subscriber starts from the latest key frame still in the ring
+/// 2. slow consumer: a subscriber lagging more than 3/4 ring skips to the latest key frame
+typedef struct media_fanout_t media_fanout_t;
+
+enum
+{
+	MEDIA_FRAME_FLAG_KEYFRAME = 0x01, // video key frame, audio-only stream should set every frame
+	MEDIA_FRAME_FLAG_CONFIG = 0x02, // decoder configuration, e.g. FLV AVC/AAC sequence header, SPS/PPS
+};
+
+struct media_frame_t
+{
+	int32_t ref; // don't modify, use media_frame_addref/media_frame_release
+
+	int stream; // user-defined track/stream index
+	int codec; // user-defined codec id, e.g. FLV_VIDEO_H264, RTP payload type
+	int flags; // MEDIA_FRAME_FLAG_XXX
+	int64_t pts;
+	int64_t dts;
+
+	uint8_t* data; // frame payload(FLV tag data, mp4/annexb stream, ...)
+	size_t bytes;
+};
+
+/// @param[in] bytes frame payload size, data point to the internal buffer
+/// @return frame with reference 1, NULL-ENOMEM
+struct media_frame_t* media_frame_alloc(size_t bytes);
+void media_frame_addref(struct media_frame_t* frame);
+/// free on last reference
+void media_frame_release(struct media_frame_t* frame);
+
+/// @param[in] capacity ring size in frames, round up to power of 2, MUST hold a GOP for instant start
+/// @param[in] subscribers max subscriber count
+media_fanout_t* media_fanout_create(int capacity, int subscribers);
+void media_fanout_destroy(media_fanout_t* fanout);
+
+/// @param[in] param media_fanout_set_notify param
+/// @param[in] id subscriber id which has new frames
+typedef void (*media_fanout_notify)(void* param, int id);
+
+/// Wake up idle subscribers, e.g. write subscriber eventfd, signal condition variable.
+/// The notify is called on the publisher thread(in media_fanout_write) once after media_fanout_read
+/// returned 0 and a new frame is written, so subscribers can block instead of polling.
+/// NOTICE: call before media_fanout_write
+void media_fanout_set_notify(media_fanout_t* fanout, media_fanout_notify notify, void* param);
+
+/// Publisher only(single thread), the fanout hold a reference of the frame
+/// @return 0-ok, -ENOMEM-no memory(the frame isn't written)
+int media_fanout_write(media_fanout_t* fanout, struct media_frame_t* frame);
+
+/// Subscribe the live stream from the latest key frame(or next key frame if the GOP is out of the ring)
+/// @return >=0-subscriber id, <0-error(-ENOSPC: too many subscribers)
+int media_fanout_subscribe(media_fanout_t* fanout);
+int media_fanout_unsubscribe(media_fanout_t* fanout, int id);
+
+/// Subscriber only(one thread per subscriber id)
+/// @param[out] frame next frame, call media_frame_release after use
+/// @return 1-got frame, 0-no more frame, <0-error
+int media_fanout_read(media_fanout_t* fanout, int id, struct media_frame_t** frame);
+
+struct media_fanout_stats_t
+{
+	int64_t lag; // unread frames
+	int64_t dropped; // skipped frames by slow consumer policy
+};
+int media_fanout_get_stats(media_fanout_t* fanout, int id, struct media_fanout_stats_t* stats);
+
+#if defined(__cplusplus)
+}
+#endif
+#endif /* !_media_fanout_h_ */
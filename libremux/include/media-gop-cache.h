@@ -0,0 +1,51 @@
+#ifndef _media_gop_cache_h_
+#define _media_gop_cache_h_
+
+#include "media-fanout.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/// Live stream GOP cache for instant start(RTMP/HTTP-FLV/RTSP play)
+/// Keep the latest decoder configuration of each track and the frames since the last key frame
+/// as shared references(media_frame_t), then replay them to a new player with rebased timestamp.
+/// Thread-safe: publisher input and player replay can run on different threads.
+typedef struct media_gop_cache_t media_gop_cache_t;
+
+/// @param[in] max_bytes max cached bytes per stream, the GOP is dropped(until next key frame) if overflow, 0-no limit
+media_gop_cache_t* media_gop_cache_create(size_t max_bytes);
+void media_gop_cache_destroy(media_gop_cache_t* cache);
+
+/// Publisher input, the cache hold a reference of the frame
+/// 1. MEDIA_FRAME_FLAG_CONFIG: replace the decoder configuration of frame->stream track
+/// 2. MEDIA_FRAME_FLAG_KEYFRAME: a video track key frame start a new GOP, other key frames(e.g. AAC) are appended.
+///    A video track is the track with both key frames and non-key frames, no video track: any key frame start a new GOP
+/// 3. other frames: append to the current GOP(ignore before the first key frame)
+/// @param[in] stream stream name, e.g. app/stream
+/// @return 0-ok, other-error
+int media_gop_cache_input(media_gop_cache_t* cache, const char* stream, struct media_frame_t* frame);
+
+/// Remove stream(publisher closed)
+/// @return 0-ok, -ENOENT-not found
+int media_gop_cache_remove(media_gop_cache_t* cache, const char* stream);
+
+/// @param[in] param user-defined parameter(media_gop_cache_replay)
+/// @param[in] frame decoder configuration(first) or GOP frame, don't modify
+/// @param[in] pts/dts rebased timestamp, same unit as frame->pts/dts
+/// @return 0-ok, other-stop replay
+typedef int (*media_gop_cache_handler)(void* param, const struct media_frame_t* frame, int64_t pts, int64_t dts);
+
+/// Replay decoder configurations and the cached GOP to a new player(don't hold lock in handler)
+/// The first key frame dts is mapped to base, the player MUST apply the same offset to live frames:
+///   RTMP/HTTP-FLV: base = 0, timestamp = (uint32_t)(dts + offset)
+///   RTSP/RTP: base = 0, rtp timestamp = rtp base timestamp + (pts + offset) * frequency / 1000
+/// @param[in] base first replayed frame timestamp
+/// @param[out] offset timestamp offset for live frames(after replay)
+/// @return >=0-replayed frame count, -ENOENT-stream not found, other-handler error
+int media_gop_cache_replay(media_gop_cache_t* cache, const char* stream, int64_t base, media_gop_cache_handler handler, void* param, int64_t* offset);
+
+#if defined(__cplusplus)
+}
+#endif
+#endif /* !_media_gop_cache_h_ */
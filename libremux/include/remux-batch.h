@@ -0,0 +1,74 @@
+#ifndef _remux_batch_h_
+#define _remux_batch_h_
+
+#include "remux.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Batch transmux: many files remuxed concurrently on a work-stealing thread pool.
+/// Jobs are dealt to per-thread queues(largest input file first), a thread takes jobs from its own
+/// queue head and steals from the tail of the other queues when its own queue is empty.
+/// Input/output files are read/written sequentially with one large block buffer each.
+typedef struct remux_batch_t remux_batch_t;
+
+struct remux_batch_progress_t
+{
+	int jobs; // total jobs
+	int running;
+	int done; // finished jobs(include failed)
+	int failed;
+
+	uint64_t bytes_total; // input file bytes(all jobs)
+	uint64_t bytes_read; // input file bytes read
+	uint64_t bytes_written; // output file bytes written
+	uint64_t packets; // remuxed packets(finished jobs)
+
+	int64_t elapsed; // ms
+	double mbps; // input throughput MB/s(bytes_read / elapsed)
+};
+
+struct remux_batch_result_t
+{
+	int code; // 0-ok, <0-error, 1-not run
+	int64_t elapsed; // ms
+	struct remux_stats_t stats;
+};
+
+/// @param[in] threads worker threads, <=0-cpu count
+/// @param[in] memory per-job memory limit in bytes(I/O block buffers + remux buffers, see remux_set_memory_limit), 0-unlimited
+/// @param[in] block file I/O block size in bytes, 0-default(1MB), shrink to memory/4 if memory limit is set
+/// @return NULL-error, other-batch
+remux_batch_t* remux_batch_create(int threads, size_t memory, size_t block);
+void remux_batch_destroy(remux_batch_t* batch);
+
+/// Add a job before remux_batch_run
+/// @param[in] input input file name
+/// @param[in] format input container REMUX_FORMAT_XXX, 0-by file extension
+/// @param[in] output output file name
+/// @param[in] oformat output container REMUX_FORMAT_XXX, 0-by file extension
+/// @return >=0-job id, <0-error
+int remux_batch_add(remux_batch_t* batch, const char* input, int format, const char* output, int oformat);
+
+/// Progress callback, called by the remux_batch_run caller thread
+typedef void (*remux_batch_onprogress)(void* param, const struct remux_batch_progress_t* progress);
+
+/// Run all jobs and wait
+/// @param[in] onprogress progress callback, NULL if don't need
+/// @param[in] interval progress callback interval in ms, a final callback is made after all jobs done
+/// @return >=0-failed jobs, <0-error(e.g. create thread failed)
+int remux_batch_run(remux_batch_t* batch, remux_batch_onprogress onprogress, void* param, int interval);
+
+/// @param[in] job remux_batch_add return value
+/// @return 0-ok, <0-invalid job
+int remux_batch_get_result(remux_batch_t* batch, int job, struct remux_batch_result_t* result);
+
+/// @param[in] name file name, e.g. a.mp4, b.ts
+/// @return REMUX_FORMAT_XXX, 0-unknown
+int remux_format_from_name(const char* name);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* !_remux_batch_h_ */
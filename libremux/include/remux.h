@@ -0,0 +1,142 @@
+#ifndef _remux_h_
+#define _remux_h_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Stream-copy remuxer: container A => common packet => container B, no decode/encode
+/// Codec is identified by MOV_OBJECT_XXX(see more @mov-format.h) on both sides.
+/// H.264/H.265/H.266/AAC bitstream is converted only if the input and output bitstream differ
+/// (e.g. MP4 => TS: length-prefixed NALU => AnnexB, raw AAC => ADTS), otherwise packet is passed through as-is.
+typedef struct remux_t remux_t;
+typedef struct remux_reader_t remux_reader_t;
+
+enum
+{
+	REMUX_FORMAT_MP4 = 1,	// mov_reader/mov_writer
+	REMUX_FORMAT_FMP4,		// fmp4_writer(output only, input as REMUX_FORMAT_MP4)
+	REMUX_FORMAT_MKV,		// mkv_reader/mkv_writer(webm)
+	REMUX_FORMAT_FLV,		// flv_reader/flv_writer
+	REMUX_FORMAT_TS,		// ts_demuxer/mpeg_ts
+	REMUX_FORMAT_PS,		// ps_demuxer/ps_muxer
+};
+
+enum
+{
+	REMUX_BITSTREAM_MP4 = 0,	// H.26x: 4-bytes length + NALU, AAC: raw frame(extra: decoder configuration record/AudioSpecificConfig)
+	REMUX_BITSTREAM_ANNEXB,		// H.26x: start code + NALU, AAC: ADTS frame(s)
+};
+
+#define REMUX_FLAG_KEYFRAME		0x0001
+
+struct remux_buffer_t
+{
+	/// read data from buffer
+	/// @param[in] param user-defined parameter
+	/// @param[out] data user buffer
+	/// @param[in] bytes data buffer size
+	/// @return >0-read bytes, 0-end of file, <0-error
+	int (*read)(void* param, void* data, uint64_t bytes);
+
+	/// write data to buffer
+	/// @return 0-ok, <0-error
+	int (*write)(void* param, const void* data, uint64_t bytes);
+
+	/// move buffer position
+	/// @param[in] offset >=0-seek buffer read/write position to offset(from buffer begin), <0-seek from file end(SEEK_END)
+	/// @return 0-ok, <0-error
+	int (*seek)(void* param, int64_t offset);
+
+	/// get buffer read/write position
+	/// @return <0-error, other-current read/write position
+	int64_t (*tell)(void* param);
+};
+
+struct remux_stream_t
+{
+	uint8_t object; // MOV_OBJECT_XXX
+	int bitstream; // REMUX_BITSTREAM_XXX, H.26x/AAC only
+
+	int width; // video, 0 if unknown
+	int height;
+	int channels; // audio
+	int bits_per_sample;
+	int sample_rate;
+
+	const void* extra; // decoder configuration record(avcC/hvcC/vvcC/av1C), AudioSpecificConfig, OpusHead, NULL if unknown
+	size_t bytes;
+};
+
+struct remux_packet_t
+{
+	int stream; // remux_add_stream return value
+	int flags; // REMUX_FLAG_XXX
+	int64_t pts; // ms
+	int64_t dts; // ms
+	const void* data;
+	size_t bytes;
+};
+
+struct remux_stats_t
+{
+	uint64_t packets; // input packets(remux_input)
+	uint64_t bytes_in; // input packet bytes
+	uint64_t bytes_out; // output container bytes(buffer write)
+	uint64_t passthrough; // packets written as-is
+	uint64_t converted; // packets with bitstream conversion
+	uint64_t dropped; // unsupported codec, before decoder configuration or probe overflow
+	uint64_t memory; // peak remux buffer bytes(probe queue, bitstream conversion, reader buffer)
+};
+
+/// @param[in] format output container REMUX_FORMAT_XXX
+/// @param[in] buffer output buffer, read/seek/tell is used by REMUX_FORMAT_MP4(moov/faststart) and REMUX_FORMAT_MKV(cues)
+/// @param[in] param buffer user-defined parameter
+/// @return NULL-error, other-remuxer
+remux_t* remux_create(int format, const struct remux_buffer_t* buffer, void* param);
+
+/// Flush(if not yet) and finish the output container(e.g. MP4 moov box, MKV cues)
+void remux_destroy(remux_t* remux);
+
+/// Add an input stream, all streams should be added before the first packet(remux_input).
+/// Output track is created when every stream has its decoder configuration(e.g. TS SPS/PPS, ADTS header),
+/// packets before that are copied into the probe queue and replayed.
+/// @return >=0-stream index, <0-error
+int remux_add_stream(remux_t* remux, const struct remux_stream_t* stream);
+
+/// @param[in] pkt packet, pkt->data is only valid within the call(don't need to hold)
+/// @return 0-ok, other-error
+int remux_input(remux_t* remux, const struct remux_packet_t* pkt);
+
+/// End of input: write out the probe queue(streams without decoder configuration are dropped)
+/// @return 0-ok, other-error
+int remux_flush(remux_t* remux);
+
+/// @return 0-ok, other-error
+int remux_get_stats(remux_t* remux, struct remux_stats_t* stats);
+
+/// Limit remux buffer memory(probe queue, bitstream conversion and reader buffer, see remux_stats_t.memory).
+/// Probe queue is written out early at half of the limit, remux_input/remux_reader_read return -ENOMEM over the limit.
+/// Container writer index(e.g. MP4 sample table, MKV cues) isn't counted.
+/// @param[in] bytes memory limit in bytes, 0-unlimited(default)
+/// @return 0-ok, other-error
+int remux_set_memory_limit(remux_t* remux, size_t bytes);
+
+/// Input container reader, push all streams/packets into remux
+/// @param[in] format input container REMUX_FORMAT_XXX(REMUX_FORMAT_FMP4 is same as REMUX_FORMAT_MP4)
+/// @param[in] buffer input buffer, seek/tell is used by REMUX_FORMAT_MP4/REMUX_FORMAT_MKV only
+/// @return NULL-error(invalid container), other-reader
+remux_reader_t* remux_reader_create(remux_t* remux, int format, const struct remux_buffer_t* buffer, void* param);
+void remux_reader_destroy(remux_reader_t* reader);
+
+/// Read and remux next frame(MP4/MKV/FLV) or data block(TS/PS), remux_flush on end of file
+/// @return 1-ok, 0-end of file, <0-error
+int remux_reader_read(remux_reader_t* reader);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* !_remux_h_ */
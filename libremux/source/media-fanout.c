@@ -0,0 +1,455 @@
+#include "media-fanout.h"
+#include "remux-sync.h"
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+
+// seq_cst atomics: the subscriber hazard store/slot load and
+// the publisher slot store/hazard load are ordered as Dekker's algorithm
+#define MEDIA_FANOUT_IDLE -1
+
+struct media_fanout_slot_t
+{
+	int64_t seq; // -1-writing
+	struct media_frame_t* frame;
+};
+
+struct media_fanout_retire_t
+{
+	int64_t seq;
+	struct media_frame_t* frame;
+};
+
+struct media_fanout_subscriber_t
+{
+	int32_t used;
+	int32_t idle; // media_fanout_read returned 0, notify on next write
+	int64_t hazard; // reading seq, MEDIA_FANOUT_IDLE-none
+
+	// subscriber thread only
+	int64_t cursor; // next seq
+	int64_t dropped;
+	int wait; // wait for next key frame
+};
+
+struct media_fanout_t
+{
+	int64_t head; // next write seq
+	int64_t keyframe; // latest key frame seq, -1-none
+	int64_t capacity;
+	int64_t limit; // slow consumer lag
+
+	struct media_fanout_slot_t* slots;
+
+	int subscribers;
+	struct media_fanout_subscriber_t* subs;
+
+	media_fanout_notify notify;
+	void* param;
+
+	// evicted frames still protected by hazard, publisher thread only
+	int retires;
+	int retire_capacity; // >= 2 * subscribers, grow on demand
+	struct media_fanout_retire_t* retired;
+};
+
+struct media_frame_t* media_frame_alloc(size_t bytes)
+{
+	struct media_frame_t* frame;
+	frame = (struct media_frame_t*)malloc(sizeof(*frame) + bytes);
+	if (!frame)
+		return NULL;
+
+	memset(frame, 0, sizeof(*frame));
+	frame->ref = 1;
+	frame->data = (uint8_t*)(frame + 1);
+	frame->bytes = bytes;
+	return frame;
+}
+
+void media_frame_addref(struct media_frame_t* frame)
+{
+	atomic_add32(&frame->ref, 1);
+}
+
+void media_frame_release(struct media_frame_t* frame)
+{
+	if (0 == atomic_add32(&frame->ref, -1))
+		free(frame);
+}
+
+media_fanout_t* media_fanout_create(int capacity, int subscribers)
+{
+	int i;
+	int64_t n;
+	struct media_fanout_t* fanout;
+
+	if (capacity < 2 || subscribers < 1)
+		return NULL;
+	for (n = 2; n < capacity; n *= 2);
+
+	fanout = (struct media_fanout_t*)calloc(1, sizeof(*fanout) + sizeof(fanout->slots[0]) * (size_t)n + sizeof(fanout->subs[0]) * subscribers);
+	if (!fanout)
+		return NULL;
+
+	fanout->retired = (struct media_fanout_retire_t*)malloc(sizeof(fanout->retired[0]) * subscribers * 2);
+	if (!fanout->retired)
+	{
+		free(fanout);
+		return NULL;
+	}
+
+	fanout->capacity = n;
+	fanout->limit = n - n / 4;
+	fanout->keyframe = -1;
+	fanout->slots = (struct media_fanout_slot_t*)(fanout + 1);
+	fanout->subs = (struct media_fanout_subscriber_t*)(fanout->slots + n);
+	fanout->retire_capacity = subscribers * 2;
+	fanout->subscribers = subscribers;
+	for (i = 0; i < (int)n; i++)
+		fanout->slots[i].seq = -1;
+	for (i = 0; i < subscribers; i++)
+		fanout->subs[i].hazard = MEDIA_FANOUT_IDLE;
+	return fanout;
+}
+
+void media_fanout_destroy(media_fanout_t* fanout)
+{
+	int i;
+	for (i = 0; i < (int)fanout->capacity; i++)
+	{
+		if (fanout->slots[i].frame)
+			media_frame_release(fanout->slots[i].frame);
+	}
+	for (i = 0; i < fanout->retires; i++)
+		media_frame_release(fanout->retired[i].frame);
+	free(fanout->retired);
+	free(fanout);
+}
+
+void media_fanout_set_notify(media_fanout_t* fanout, media_fanout_notify notify, void* param)
+{
+	fanout->notify = notify;
+	fanout->param = param;
+}
+
+static int media_fanout_protected(struct media_fanout_t* fanout, int64_t seq)
+{
+	int i;
+	for (i = 0; i < fanout->subscribers; i++)
+	{
+		if (seq == atomic_load64(&fanout->subs[i].hazard))
+			return 1;
+	}
+	return 0;
+}
+
+/// release retired frames which aren't protected by any hazard
+static void media_fanout_collect(struct media_fanout_t* fanout)
+{
+	int i;
+	for (i = 0; i < fanout->retires; i++)
+	{
+		if (media_fanout_protected(fanout, fanout->retired[i].seq))
+			continue;
+		media_frame_release(fanout->retired[i].frame);
+		memcpy(&fanout->retired[i], &fanout->retired[--fanout->retires], sizeof(fanout->retired[0]));
+		--i;
+	}
+}
+
+/// Hazards are read one by one, a reader moving forward during the scan may protect
+/// an old and a new entry, so the retired list may hold more than one frame per subscriber.
+/// Grow the list instead of waiting for the readers.
+static int media_fanout_reserve(struct media_fanout_t* fanout)
+{
+	void* p;
+	if (fanout->retires < fanout->retire_capacity)
+		return 0;
+
+	p = realloc(fanout->retired, sizeof(fanout->retired[0]) * fanout->retire_capacity * 2);
+	if (!p)
+		return -ENOMEM;
+	fanout->retired = (struct media_fanout_retire_t*)p;
+	fanout->retire_capacity *= 2;
+	return 0;
+}
+
+/// release evicted frame, or keep it until the reader take a reference
+static void media_fanout_retire(struct media_fanout_t* fanout, int64_t seq, struct media_frame_t* frame)
+{
+	if (!media_fanout_protected(fanout, seq))
+	{
+		media_frame_release(frame);
+		return;
+	}
+
+	assert(fanout->retires < fanout->retire_capacity);
+	fanout->retired[fanout->retires].seq = seq;
+	fanout->retired[fanout->retires++].frame = frame;
+}
+
+/// wake up the subscribers waiting for a new frame
+static void media_fanout_wakeup(struct media_fanout_t* fanout)
+{
+	int i;
+	for (i = 0; i < fanout->subscribers; i++)
+	{
+		if (atomic_load32(&fanout->subs[i].idle) && atomic_cas32(&fanout->subs[i].idle, 1, 0))
+			fanout->notify(fanout->param, i);
+	}
+}
+
+int media_fanout_write(media_fanout_t* fanout, struct media_frame_t* frame)
+{
+	int64_t seq;
+	struct media_frame_t* evicted;
+	struct media_fanout_slot_t* slot;
+
+	seq = fanout->head;
+	slot = &fanout->slots[seq & (fanout->capacity - 1)];
+	evicted = slot->frame;
+
+	if (fanout->retires > 0)
+		media_fanout_collect(fanout);
+	if (evicted && 0 != media_fanout_reserve(fanout))
+		return -ENOMEM;
+
+	media_frame_addref(frame);
+	atomic_store64(&slot->seq, -1);
+	atomic_storeptr(&slot->frame, frame);
+	atomic_store64(&slot->seq, seq);
+	if (MEDIA_FRAME_FLAG_KEYFRAME & frame->flags)
+		atomic_store64(&fanout->keyframe, seq);
+	atomic_store64(&fanout->head, seq + 1);
+
+	if (evicted)
+		media_fanout_retire(fanout, seq - fanout->capacity, evicted);
+	if (fanout->notify)
+		media_fanout_wakeup(fanout);
+	return 0;
+}
+
+/// @return frame with reference, NULL-overwritten
+static struct media_frame_t* media_fanout_load(struct media_fanout_t* fanout, struct media_fanout_subscriber_t* sub, int64_t seq)
+{
+	struct media_frame_t* frame;
+	struct media_fanout_slot_t* slot;
+
+	slot = &fanout->slots[seq & (fanout->capacity - 1)];
+	atomic_store64(&sub->hazard, seq);
+	if (seq != atomic_load64(&slot->seq))
+	{
+		atomic_store64(&sub->hazard, MEDIA_FANOUT_IDLE);
+		return NULL;
+	}
+
+	frame = (struct media_frame_t*)atomic_loadptr(&slot->frame);
+	if (seq != atomic_load64(&slot->seq))
+		frame = NULL; // overwritten during load
+	else
+		media_frame_addref(frame);
+	atomic_store64(&sub->hazard, MEDIA_FANOUT_IDLE);
+	return frame;
+}
+
+/// start from the latest key frame in ring, or wait the next key frame
+static void media_fanout_seek(struct media_fanout_t* fanout, struct media_fanout_subscriber_t* sub, int64_t head)
+{
+	int64_t keyframe;
+	keyframe = atomic_load64(&fanout->keyframe);
+	if (keyframe >= 0 && keyframe >= sub->cursor && head - keyframe <= fanout->limit)
+	{
+		sub->cursor = keyframe;
+		sub->wait = 0;
+	}
+	else
+	{
+		sub->cursor = head;
+		sub->wait = 1;
+	}
+}
+
+int media_fanout_subscribe(media_fanout_t* fanout)
+{
+	int i;
+	struct media_fanout_subscriber_t* sub;
+
+	for (i = 0; i < fanout->subscribers; i++)
+	{
+		sub = &fanout->subs[i];
+		if (!atomic_cas32(&sub->used, 0, 1))
+			continue;
+
+		sub->cursor = 0;
+		sub->dropped = 0;
+		atomic_store32(&sub->idle, 0);
+		media_fanout_seek(fanout, sub, atomic_load64(&fanout->head));
+		return i;
+	}
+	return -ENOSPC;
+}
+
+int media_fanout_unsubscribe(media_fanout_t* fanout, int id)
+{
+	if (id < 0 || id >= fanout->subscribers || !atomic_load32(&fanout->subs[id].used))
+		return -EINVAL;
+
+	atomic_store64(&fanout->subs[id].hazard, MEDIA_FANOUT_IDLE);
+	atomic_store32(&fanout->subs[id].idle, 0);
+	atomic_add32(&fanout->subs[id].used, -1);
+	return 0;
+}
+
+int media_fanout_read(media_fanout_t* fanout, int id, struct media_frame_t** frame)
+{
+	int64_t head, cursor;
+	struct media_frame_t* f;
+	struct media_fanout_subscriber_t* sub;
+
+	if (id < 0 || id >= fanout->subscribers || !atomic_load32(&fanout->subs[id].used))
+		return -EINVAL;
+
+	sub = &fanout->subs[id];
+	while (1)
+	{
+		head = atomic_load64(&fanout->head);
+		if (sub->cursor >= head)
+		{
+			if (!fanout->notify)
+				return 0;
+
+			// set idle before recheck head, the publisher store head before check idle
+			atomic_store32(&sub->idle, 1);
+			if (sub->cursor >= atomic_load64(&fanout->head))
+				return 0;
+			atomic_store32(&sub->idle, 0);
+			continue;
+		}
+
+		f = head - sub->cursor > fanout->limit ? NULL : media_fanout_load(fanout, sub, sub->cursor);
+		if (!f)
+		{
+			// slow consumer: skip to the latest key frame
+			cursor = sub->cursor;
+			media_fanout_seek(fanout, sub, head);
+			sub->dropped += sub->cursor - cursor;
+			continue;
+		}
+
+		sub->cursor++;
+		if (sub->wait && 0 == (MEDIA_FRAME_FLAG_KEYFRAME & f->flags))
+		{
+			sub->dropped++;
+			media_frame_release(f);
+			continue;
+		}
+
+		sub->wait = 0;
+		*frame = f;
+		return 1;
+	}
+}
+
+int media_fanout_get_stats(media_fanout_t* fanout, int id, struct media_fanout_stats_t* stats)
+{
+	if (id < 0 || id >= fanout->subscribers || !atomic_load32(&fanout->subs[id].used))
+		return -EINVAL;
+
+	stats->lag = atomic_load64(&fanout->head) - fanout->subs[id].cursor;
+	stats->dropped = fanout->subs[id].dropped;
+	return 0;
+}
+
+#if defined(_DEBUG) || defined(DEBUG)
+static struct media_frame_t* media_fanout_test_frame(int64_t pts, int flags)
+{
+	struct media_frame_t* frame;
+	frame = media_frame_alloc(sizeof(pts));
+	frame->pts = frame->dts = pts;
+	frame->flags = flags;
+	memcpy(frame->data, &pts, sizeof(pts));
+	return frame;
+}
+
+static void media_fanout_test_write(media_fanout_t* fanout, int64_t from, int64_t to, int gop)
+{
+	struct media_frame_t* frame;
+	for (; from < to; from++)
+	{
+		frame = media_fanout_test_frame(from, 0 == from % gop ? MEDIA_FRAME_FLAG_KEYFRAME : 0);
+		assert(0 == media_fanout_write(fanout, frame));
+		media_frame_release(frame);
+	}
+}
+
+static void media_fanout_test_onnotify(void* param, int id)
+{
+	((int*)param)[id]++;
+}
+
+void media_fanout_test(void)
+{
+	int a, b, c;
+	int notify[3];
+	struct media_frame_t* frame;
+	struct media_fanout_stats_t stats;
+	media_fanout_t* fanout;
+
+	fanout = media_fanout_create(60, 3);
+	assert(fanout);
+
+	// GOP cache: join at the latest key frame
+	media_fanout_test_write(fanout, 0, 37, 25);
+	a = media_fanout_subscribe(fanout);
+	assert(1 == media_fanout_read(fanout, a, &frame) && 25 == frame->pts && (MEDIA_FRAME_FLAG_KEYFRAME & frame->flags));
+	media_frame_release(frame);
+
+	// follow the live stream
+	b = media_fanout_subscribe(fanout);
+	media_fanout_test_write(fanout, 37, 40, 25);
+	assert(0 == media_fanout_get_stats(fanout, a, &stats) && 14 == stats.lag);
+	while (1 == media_fanout_read(fanout, b, &frame))
+	{
+		assert(0 == memcmp(frame->data, &frame->pts, sizeof(frame->pts)));
+		media_frame_release(frame);
+	}
+	assert(0 == media_fanout_get_stats(fanout, b, &stats) && 0 == stats.lag && 0 == stats.dropped);
+
+	// slow consumer(a) skip to the latest key frame, don't block the others
+	media_fanout_test_write(fanout, 40, 100, 25);
+	assert(1 == media_fanout_read(fanout, a, &frame) && 75 == frame->pts);
+	media_frame_release(frame);
+	assert(0 == media_fanout_get_stats(fanout, a, &stats) && 24 == stats.lag && 75 - 26 == stats.dropped);
+
+	// b lag 60 frames, skip to key frame 75
+	assert(1 == media_fanout_read(fanout, b, &frame) && 75 == frame->pts);
+	media_frame_release(frame);
+
+	// the GOP is out of the ring: wait for the next key frame
+	media_fanout_test_write(fanout, 100, 170, 100);
+	c = media_fanout_subscribe(fanout);
+	assert(-ENOSPC == media_fanout_subscribe(fanout));
+	assert(0 == media_fanout_read(fanout, c, &frame));
+	media_fanout_test_write(fanout, 170, 201, 100);
+	assert(1 == media_fanout_read(fanout, c, &frame) && 200 == frame->pts);
+	media_frame_release(frame);
+
+	assert(0 == media_fanout_unsubscribe(fanout, a));
+	assert(a == media_fanout_subscribe(fanout));
+
+	// notify idle subscriber once per new data
+	memset(notify, 0, sizeof(notify));
+	media_fanout_set_notify(fanout, media_fanout_test_onnotify, notify);
+	while (1 == media_fanout_read(fanout, c, &frame))
+		media_frame_release(frame);
+	media_fanout_test_write(fanout, 201, 203, 100);
+	assert(0 == notify[a] && 0 == notify[b] && 1 == notify[c]);
+	assert(1 == media_fanout_read(fanout, c, &frame) && 201 == frame->pts);
+	media_frame_release(frame);
+	media_fanout_test_write(fanout, 203, 204, 100);
+	assert(1 == notify[c]);
+	media_fanout_destroy(fanout);
+}
+#endif
@@ -0,0 +1,525 @@
+#include "media-gop-cache.h"
+#include "remux-sync.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+
+#define N_TRACK 8
+#define N_PROBE 64 // max GOP frames before a video track is found
+#define N_BUCKET 64 // stream name hash buckets, MUST be power of 2
+
+struct media_gop_stream_t
+{
+	struct media_gop_stream_t* next; // bucket list
+	uint32_t hash;
+	char* name;
+	struct media_frame_t* configs[N_TRACK]; // by frame->stream
+
+	struct media_frame_t** frames; // frames[0] is key frame
+	int count;
+	uint32_t keys; // track bitmap, track with key frames
+	uint32_t deltas; // track bitmap, track with non-key frames
+	uint32_t video; // keys & deltas, audio frames are all key frames(or none)
+	int capacity;
+	size_t bytes;
+};
+
+// streams of one bucket share the locker, memory is allocated without lock
+struct media_gop_bucket_t
+{
+	remux_locker_t locker;
+	struct media_gop_stream_t* streams;
+};
+
+struct media_gop_cache_t
+{
+	size_t max_bytes;
+	struct media_gop_bucket_t buckets[N_BUCKET];
+};
+
+media_gop_cache_t* media_gop_cache_create(size_t max_bytes)
+{
+	int i;
+	struct media_gop_cache_t* cache;
+	cache = (struct media_gop_cache_t*)calloc(1, sizeof(*cache));
+	if (!cache)
+		return NULL;
+
+	cache->max_bytes = max_bytes;
+	for (i = 0; i < N_BUCKET; i++)
+		locker_create(&cache->buckets[i].locker);
+	return cache;
+}
+
+static void media_gop_stream_reset(struct media_gop_stream_t* s)
+{
+	int i;
+	for (i = 0; i < s->count; i++)
+		media_frame_release(s->frames[i]);
+	s->count = 0;
+	s->bytes = 0;
+}
+
+static void media_gop_stream_free(struct media_gop_stream_t* s)
+{
+	int i;
+	media_gop_stream_reset(s);
+	for (i = 0; i < N_TRACK; i++)
+	{
+		if (s->configs[i])
+			media_frame_release(s->configs[i]);
+	}
+	free(s->frames);
+	free(s);
+}
+
+void media_gop_cache_destroy(media_gop_cache_t* cache)
+{
+	int i;
+	struct media_gop_stream_t* s;
+	for (i = 0; i < N_BUCKET; i++)
+	{
+		while (cache->buckets[i].streams)
+		{
+			s = cache->buckets[i].streams;
+			cache->buckets[i].streams = s->next;
+			media_gop_stream_free(s);
+		}
+		locker_destroy(&cache->buckets[i].locker);
+	}
+	free(cache);
+}
+
+/// FNV-1a
+static uint32_t media_gop_cache_hash(const char* stream)
+{
+	uint32_t h;
+	for (h = 2166136261u; *stream; stream++)
+		h = (h ^ (uint8_t)*stream) * 16777619u;
+	return h;
+}
+
+/// NOTICE: call with bucket locker
+static struct media_gop_stream_t* media_gop_cache_find(struct media_gop_bucket_t* bucket, uint32_t hash, const char* stream)
+{
+	struct media_gop_stream_t* s;
+	for (s = bucket->streams; s; s = s->next)
+	{
+		if (s->hash == hash && 0 == strcmp(s->name, stream))
+			return s;
+	}
+	return NULL;
+}
+
+static struct media_gop_stream_t* media_gop_stream_create(uint32_t hash, const char* stream)
+{
+	size_t n;
+	struct media_gop_stream_t* s;
+
+	n = strlen(stream);
+	s = (struct media_gop_stream_t*)calloc(1, sizeof(*s) + n + 1);
+	if (!s)
+		return NULL;
+
+	s->hash = hash;
+	s->name = (char*)(s + 1);
+	memcpy(s->name, stream, n + 1);
+	return s;
+}
+
+/// @return frames capacity for one more frame, 0-enough
+static int media_gop_stream_need(const struct media_gop_stream_t* s, const struct media_frame_t* frame)
+{
+	if ((MEDIA_FRAME_FLAG_CONFIG & frame->flags) || s->count < s->capacity)
+		return 0;
+	return s->capacity > 0 ? s->capacity * 2 : 256;
+}
+
+/// NOTICE: call with bucket locker, the capacity is reserved by media_gop_stream_need
+static void media_gop_stream_append(struct media_gop_stream_t* s, struct media_frame_t* frame)
+{
+	assert(s->count < s->capacity);
+	media_frame_addref(frame);
+	s->frames[s->count++] = frame;
+	s->bytes += frame->bytes;
+}
+
+/// key frame of the track start a new GOP: video track,
+/// or if no video track is known yet(stream start, audio-only stream):
+/// all GOP frames are from the track, or too many frames(e.g. multi audio tracks without video)
+static int media_gop_stream_keytrack(struct media_gop_stream_t* s, int track)
+{
+	int i;
+	if (s->video)
+		return (s->video & (1u << track)) ? 1 : 0;
+
+	for (i = 0; i < s->count && i < N_PROBE; i++)
+	{
+		if (s->frames[i]->stream != track)
+			return s->count >= N_PROBE ? 1 : 0;
+	}
+	return 1;
+}
+
+/// a track is found to be video after the GOP start(e.g. started by an audio frame),
+/// restart the GOP from the last key frame of the video track
+/// @return 0-ok, -1-no key frame of the track
+static int media_gop_stream_trim(struct media_gop_stream_t* s, int track)
+{
+	int i, j;
+	for (i = s->count - 1; i >= 0; i--)
+	{
+		if (s->frames[i]->stream == track && (MEDIA_FRAME_FLAG_KEYFRAME & s->frames[i]->flags))
+			break;
+	}
+	if (i < 0)
+		return -1;
+
+	for (j = 0; j < i; j++)
+	{
+		s->bytes -= s->frames[j]->bytes;
+		media_frame_release(s->frames[j]);
+	}
+	memmove(s->frames, s->frames + i, sizeof(s->frames[0]) * (s->count - i));
+	s->count -= i;
+	return 0;
+}
+
+/// video track: both key frames and non-key frames
+static void media_gop_stream_track(struct media_gop_stream_t* s, const struct media_frame_t* frame)
+{
+	uint32_t bit;
+	bit = 1u << frame->stream;
+	if (MEDIA_FRAME_FLAG_KEYFRAME & frame->flags)
+		s->keys |= bit;
+	else
+		s->deltas |= bit;
+
+	if (0 == (s->video & bit) && (s->keys & s->deltas & bit))
+	{
+		s->video |= bit;
+		if (s->count > 0 && s->frames[0]->stream != frame->stream && 0 != media_gop_stream_trim(s, frame->stream))
+			media_gop_stream_reset(s); // no key frame of the video track, wait next key frame
+	}
+}
+
+int media_gop_cache_input(media_gop_cache_t* cache, const char* stream, struct media_frame_t* frame)
+{
+	int need, size;
+	uint32_t hash;
+	struct media_frame_t** frames, **old;
+	struct media_gop_stream_t* s, *news;
+	struct media_gop_bucket_t* bucket;
+
+	if (frame->stream < 0 || frame->stream >= N_TRACK)
+		return -EINVAL;
+
+	size = 0;
+	news = NULL;
+	frames = NULL;
+	hash = media_gop_cache_hash(stream);
+	bucket = &cache->buckets[hash & (N_BUCKET - 1)];
+
+	// allocate the new stream or frames buffer without lock, then retry
+	for (s = NULL; !s; )
+	{
+		locker_lock(&bucket->locker);
+		s = media_gop_cache_find(bucket, hash, stream);
+		if (!s && news)
+		{
+			news->next = bucket->streams;
+			bucket->streams = news;
+			s = news;
+			news = NULL;
+		}
+
+		need = s ? media_gop_stream_need(s, frame) : 0;
+		if (s && need <= size)
+			break; // with lock
+		locker_unlock(&bucket->locker);
+
+		if (s)
+		{
+			free(frames);
+			frames = (struct media_frame_t**)malloc(sizeof(frames[0]) * need);
+			size = frames ? need : 0;
+		}
+		else
+		{
+			news = media_gop_stream_create(hash, stream);
+		}
+
+		if (s ? !frames : !news)
+		{
+			if (news)
+				media_gop_stream_free(news);
+			return -ENOMEM;
+		}
+		s = NULL; // retry
+	}
+
+	old = NULL;
+	if (need > 0)
+	{
+		if (s->count > 0)
+			memcpy(frames, s->frames, sizeof(frames[0]) * s->count);
+		old = s->frames;
+		s->frames = frames;
+		s->capacity = size;
+		frames = NULL;
+	}
+
+	if (MEDIA_FRAME_FLAG_CONFIG & frame->flags)
+	{
+		media_frame_addref(frame);
+		if (s->configs[frame->stream])
+			media_frame_release(s->configs[frame->stream]);
+		s->configs[frame->stream] = frame;
+	}
+	else
+	{
+		media_gop_stream_track(s, frame);
+		if ((MEDIA_FRAME_FLAG_KEYFRAME & frame->flags) && media_gop_stream_keytrack(s, frame->stream))
+		{
+			media_gop_stream_reset(s);
+			media_gop_stream_append(s, frame);
+		}
+		else if (s->count > 0)
+		{
+			if (cache->max_bytes > 0 && s->bytes + frame->bytes > cache->max_bytes)
+				media_gop_stream_reset(s); // GOP too large, wait next key frame
+			else
+				media_gop_stream_append(s, frame);
+		}
+	}
+	locker_unlock(&bucket->locker);
+
+	free(old);
+	free(frames); // unused buffer(another thread grew the frames)
+	if (news)
+		media_gop_stream_free(news); // another thread added the stream
+	return 0;
+}
+
+int media_gop_cache_remove(media_gop_cache_t* cache, const char* stream)
+{
+	uint32_t hash;
+	struct media_gop_stream_t** pp, *s;
+	struct media_gop_bucket_t* bucket;
+
+	hash = media_gop_cache_hash(stream);
+	bucket = &cache->buckets[hash & (N_BUCKET - 1)];
+
+	s = NULL;
+	locker_lock(&bucket->locker);
+	for (pp = &bucket->streams; *pp; pp = &(*pp)->next)
+	{
+		if ((*pp)->hash == hash && 0 == strcmp((*pp)->name, stream))
+		{
+			s = *pp;
+			*pp = s->next;
+			break;
+		}
+	}
+	locker_unlock(&bucket->locker);
+
+	if (!s)
+		return -ENOENT;
+	media_gop_stream_free(s); // release frames without lock
+	return 0;
+}
+
+int media_gop_cache_replay(media_gop_cache_t* cache, const char* stream, int64_t base, media_gop_cache_handler handler, void* param, int64_t* offset)
+{
+	int i, n, r, size;
+	uint32_t hash;
+	int64_t delta;
+	struct media_frame_t** frames;
+	struct media_gop_stream_t* s;
+	struct media_gop_bucket_t* bucket;
+
+	hash = media_gop_cache_hash(stream);
+	bucket = &cache->buckets[hash & (N_BUCKET - 1)];
+
+	// take references under lock, replay without lock
+	for (size = 0, frames = NULL; 1; )
+	{
+		locker_lock(&bucket->locker);
+		s = media_gop_cache_find(bucket, hash, stream);
+		if (!s)
+		{
+			locker_unlock(&bucket->locker);
+			free(frames);
+			return -ENOENT;
+		}
+
+		if (N_TRACK + s->count <= size)
+			break; // with lock
+
+		n = N_TRACK + s->count + 8;
+		locker_unlock(&bucket->locker);
+
+		free(frames);
+		frames = (struct media_frame_t**)malloc(sizeof(frames[0]) * n);
+		if (!frames)
+			return -ENOMEM;
+		size = n;
+	}
+
+	for (n = i = 0; i < N_TRACK; i++)
+	{
+		if (s->configs[i])
+			frames[n++] = s->configs[i];
+	}
+	for (i = 0; i < s->count; i++)
+		frames[n++] = s->frames[i];
+	for (i = 0; i < n; i++)
+		media_frame_addref(frames[i]);
+	delta = s->count > 0 ? base - s->frames[0]->dts : 0;
+	locker_unlock(&bucket->locker);
+
+	// decoder configurations use the first frame timestamp
+	for (r = i = 0; i < n && 0 == r; i++)
+	{
+		if (MEDIA_FRAME_FLAG_CONFIG & frames[i]->flags)
+			r = handler(param, frames[i], base, base);
+		else
+			r = handler(param, frames[i], frames[i]->pts + delta, frames[i]->dts + delta);
+	}
+
+	for (i = 0; i < n; i++)
+		media_frame_release(frames[i]);
+	free(frames);
+
+	if (offset)
+		*offset = delta;
+	return 0 == r ? n : r;
+}
+
+#if defined(_DEBUG) || defined(DEBUG)
+struct media_gop_cache_test_t
+{
+	int n;
+	int64_t pts[8];
+	int64_t dts[8];
+	int flags[8];
+};
+
+static int media_gop_cache_test_onframe(void* param, const struct media_frame_t* frame, int64_t pts, int64_t dts)
+{
+	struct media_gop_cache_test_t* ctx;
+	ctx = (struct media_gop_cache_test_t*)param;
+	assert(ctx->n < 8);
+	ctx->pts[ctx->n] = pts;
+	ctx->dts[ctx->n] = dts;
+	ctx->flags[ctx->n++] = frame->flags;
+	return 0;
+}
+
+static int media_gop_cache_test_count(void* param, const struct media_frame_t* frame, int64_t pts, int64_t dts)
+{
+	(void)frame, (void)pts, (void)dts;
+	++*(int*)param;
+	return 0;
+}
+
+static void media_gop_cache_test_input(media_gop_cache_t* cache, const char* stream, int track, int flags, int64_t pts, int64_t dts, size_t bytes)
+{
+	struct media_frame_t* frame;
+	frame = media_frame_alloc(bytes);
+	frame->stream = track;
+	frame->flags = flags;
+	frame->pts = pts;
+	frame->dts = dts;
+	assert(0 == media_gop_cache_input(cache, stream, frame));
+	media_frame_release(frame);
+}
+
+void media_gop_cache_test(void)
+{
+	int i, n;
+	char name[32];
+	int64_t offset;
+	struct media_gop_cache_test_t ctx;
+	media_gop_cache_t* cache;
+
+	cache = media_gop_cache_create(1000);
+	media_gop_cache_test_input(cache, "live/a", 0, 0, 0, 0, 10); // before key frame
+	media_gop_cache_test_input(cache, "live/a", 0, MEDIA_FRAME_FLAG_CONFIG, 0, 0, 30); // AVC sequence header
+	media_gop_cache_test_input(cache, "live/a", 1, MEDIA_FRAME_FLAG_CONFIG, 0, 0, 2); // AAC sequence header
+	media_gop_cache_test_input(cache, "live/a", 0, MEDIA_FRAME_FLAG_KEYFRAME, 1000, 1000, 100);
+	media_gop_cache_test_input(cache, "live/a", 1, 0, 1010, 1010, 10);
+	media_gop_cache_test_input(cache, "live/a", 0, 0, 1120, 1040, 100);
+	media_gop_cache_test_input(cache, "live/b", 0, MEDIA_FRAME_FLAG_KEYFRAME, 5000, 5000, 100);
+
+	// RTMP: player timestamp start from 0
+	memset(&ctx, 0, sizeof(ctx));
+	assert(5 == media_gop_cache_replay(cache, "live/a", 0, media_gop_cache_test_onframe, &ctx, &offset));
+	assert(-1000 == offset);
+	assert(MEDIA_FRAME_FLAG_CONFIG == ctx.flags[0] && MEDIA_FRAME_FLAG_CONFIG == ctx.flags[1] && 0 == ctx.dts[1]);
+	assert(MEDIA_FRAME_FLAG_KEYFRAME == ctx.flags[2] && 0 == ctx.pts[2] && 0 == ctx.dts[2]);
+	assert(10 == ctx.dts[3] && 120 == ctx.pts[4] && 40 == ctx.dts[4]);
+
+	// new GOP, overflow drop the GOP until next key frame
+	media_gop_cache_test_input(cache, "live/a", 0, MEDIA_FRAME_FLAG_KEYFRAME, 3000, 3000, 600);
+	memset(&ctx, 0, sizeof(ctx));
+	assert(3 == media_gop_cache_replay(cache, "live/a", 90000, media_gop_cache_test_onframe, &ctx, &offset));
+	assert(87000 == offset && 90000 == ctx.dts[2]);
+	media_gop_cache_test_input(cache, "live/a", 0, 0, 3040, 3040, 600);
+	memset(&ctx, 0, sizeof(ctx));
+	assert(2 == media_gop_cache_replay(cache, "live/a", 0, media_gop_cache_test_onframe, &ctx, &offset));
+
+	// AAC frames are all key frames: appended to the video GOP
+	media_gop_cache_test_input(cache, "live/c", 1, MEDIA_FRAME_FLAG_KEYFRAME, 0, 0, 10); // GOP start by audio
+	media_gop_cache_test_input(cache, "live/c", 0, MEDIA_FRAME_FLAG_KEYFRAME, 10, 10, 100);
+	media_gop_cache_test_input(cache, "live/c", 1, MEDIA_FRAME_FLAG_KEYFRAME, 23, 23, 10);
+	media_gop_cache_test_input(cache, "live/c", 0, 0, 50, 50, 50); // track 0 is video, restart GOP from video key frame
+	media_gop_cache_test_input(cache, "live/c", 1, MEDIA_FRAME_FLAG_KEYFRAME, 46, 46, 10);
+	media_gop_cache_test_input(cache, "live/c", 0, 0, 90, 90, 50);
+	memset(&ctx, 0, sizeof(ctx));
+	assert(5 == media_gop_cache_replay(cache, "live/c", 0, media_gop_cache_test_onframe, &ctx, &offset));
+	assert(-10 == offset && MEDIA_FRAME_FLAG_KEYFRAME == ctx.flags[0] && 0 == ctx.dts[0] && 13 == ctx.dts[1] && 80 == ctx.dts[4]);
+	media_gop_cache_test_input(cache, "live/c", 0, MEDIA_FRAME_FLAG_KEYFRAME, 130, 130, 100); // new video GOP
+	media_gop_cache_test_input(cache, "live/c", 1, MEDIA_FRAME_FLAG_KEYFRAME, 139, 139, 10);
+	media_gop_cache_test_input(cache, "live/c", 1, MEDIA_FRAME_FLAG_KEYFRAME, 162, 162, 10);
+	memset(&ctx, 0, sizeof(ctx));
+	assert(3 == media_gop_cache_replay(cache, "live/c", 0, media_gop_cache_test_onframe, &ctx, &offset));
+	assert(-130 == offset && 0 == ctx.dts[0] && 32 == ctx.dts[2]);
+
+	// audio-only stream: every key frame start a new GOP
+	media_gop_cache_test_input(cache, "live/d", 1, MEDIA_FRAME_FLAG_KEYFRAME, 0, 0, 10);
+	media_gop_cache_test_input(cache, "live/d", 1, MEDIA_FRAME_FLAG_KEYFRAME, 23, 23, 10);
+	assert(1 == media_gop_cache_replay(cache, "live/d", 0, media_gop_cache_test_onframe, &ctx, &offset) && -23 == offset);
+
+	assert(0 == media_gop_cache_remove(cache, "live/a"));
+	assert(-ENOENT == media_gop_cache_replay(cache, "live/a", 0, media_gop_cache_test_onframe, &ctx, &offset));
+	assert(1 == media_gop_cache_replay(cache, "live/b", 0, media_gop_cache_test_onframe, &ctx, &offset));
+	media_gop_cache_destroy(cache);
+
+	// streams share buckets, GOP grow over the initial capacity
+	cache = media_gop_cache_create(0);
+	for (i = 0; i < 200; i++)
+	{
+		snprintf(name, sizeof(name), "live/%d", i);
+		media_gop_cache_test_input(cache, name, 0, MEDIA_FRAME_FLAG_KEYFRAME, i, i, 1);
+		media_gop_cache_test_input(cache, name, 0, 0, i + 1, i + 1, 1);
+	}
+	for (i = 0; i < 1000; i++)
+		media_gop_cache_test_input(cache, "live/0", 0, 0, i + 2, i + 2, 1);
+	for (i = 1; i < 200; i += 2)
+	{
+		snprintf(name, sizeof(name), "live/%d", i);
+		assert(0 == media_gop_cache_remove(cache, name));
+		assert(-ENOENT == media_gop_cache_remove(cache, name));
+	}
+	for (i = 0; i < 200; i += 2)
+	{
+		n = 0;
+		snprintf(name, sizeof(name), "live/%d", i);
+		assert((0 == i ? 1002 : 2) == media_gop_cache_replay(cache, name, 0, media_gop_cache_test_count, &n, &offset) && n == (0 == i ? 1002 : 2));
+	}
+	media_gop_cache_destroy(cache);
+}
+#endif
@@ -0,0 +1,655 @@
+#if !defined(_MSC_VER) && !defined(_FILE_OFFSET_BITS)
+#define _FILE_OFFSET_BITS 64 // fseeko/ftello 64-bits offset on 32-bits system
+#endif
+
+#include "remux-batch.h"
+#include "remux-internal.h"
+#include "remux-sync.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+
+#if defined(_MSC_VER)
+#include <windows.h>
+#define fseek64 _fseeki64
+#define ftell64 _ftelli64
+#define strcasecmp _stricmp
+#else
+#include <strings.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/stat.h>
+#define fseek64 fseeko
+#define ftell64 ftello
+#endif
+
+#define REMUX_BATCH_BLOCK		(1024 * 1024)
+#define REMUX_BATCH_READ_MAX	(1 << 30) // remux_buffer_t read return int
+
+struct remux_batch_job_t
+{
+	char* input;
+	char* output;
+	int format;
+	int oformat;
+	uint64_t size; // input file size, 0-don't exist
+	struct remux_batch_result_t result;
+};
+
+// per-thread job queue: owner pop from head, thief steal from tail
+struct remux_batch_queue_t
+{
+	remux_locker_t locker;
+	int* jobs; // job index, largest input first
+	int head;
+	int tail;
+};
+
+struct remux_batch_worker_t
+{
+	struct remux_batch_t* batch;
+	struct remux_batch_queue_t queue;
+	remux_thread_t thread;
+	int id;
+};
+
+struct remux_batch_t
+{
+	int threads;
+	size_t memory; // per-job memory limit, 0-unlimited
+	size_t block; // file I/O block size
+
+	struct remux_batch_job_t* jobs;
+	int count;
+	int capacity;
+
+	struct remux_batch_worker_t* workers;
+	int running; // thread count
+
+	// progress, updated by worker threads
+	int32_t doing;
+	int32_t done;
+	int32_t failed;
+	int64_t bytes_read;
+	int64_t bytes_written;
+	int64_t packets;
+
+	// worker exit notify
+	remux_locker_t locker;
+	remux_event_t event;
+	int exited;
+};
+
+struct remux_batch_file_t
+{
+	FILE* fp;
+	int64_t* counter; // batch bytes_read/bytes_written
+};
+
+static int64_t remux_batch_clock(void)
+{
+#if defined(_MSC_VER)
+	return (int64_t)GetTickCount64();
+#else
+	struct timespec tp;
+	clock_gettime(CLOCK_MONOTONIC, &tp);
+	return (int64_t)tp.tv_sec * 1000 + tp.tv_nsec / 1000000;
+#endif
+}
+
+static int remux_batch_cpus(void)
+{
+#if defined(_MSC_VER)
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return (int)info.dwNumberOfProcessors;
+#else
+	long n = sysconf(_SC_NPROCESSORS_ONLN);
+	return n > 0 ? (int)n : 1;
+#endif
+}
+
+static int remux_batch_file_read(void* param, void* data, uint64_t bytes)
+{
+	size_t n;
+	struct remux_batch_file_t* f = (struct remux_batch_file_t*)param;
+	n = fread(data, 1, (size_t)(bytes < REMUX_BATCH_READ_MAX ? bytes : REMUX_BATCH_READ_MAX), f->fp);
+	if (0 == n)
+		return ferror(f->fp) ? -EIO : 0;
+	atomic_add64(f->counter, (int64_t)n);
+	return (int)n;
+}
+
+static int remux_batch_file_write(void* param, const void* data, uint64_t bytes)
+{
+	struct remux_batch_file_t* f = (struct remux_batch_file_t*)param;
+	if (bytes != fwrite(data, 1, (size_t)bytes, f->fp))
+		return ferror(f->fp) ? -EIO : -1;
+	atomic_add64(f->counter, (int64_t)bytes);
+	return 0;
+}
+
+static int remux_batch_file_seek(void* param, int64_t offset)
+{
+	struct remux_batch_file_t* f = (struct remux_batch_file_t*)param;
+	return 0 == fseek64(f->fp, offset, offset >= 0 ? SEEK_SET : SEEK_END) ? 0 : -EIO;
+}
+
+static int64_t remux_batch_file_tell(void* param)
+{
+	struct remux_batch_file_t* f = (struct remux_batch_file_t*)param;
+	return (int64_t)ftell64(f->fp);
+}
+
+static const struct remux_buffer_t s_file = { remux_batch_file_read, remux_batch_file_write, remux_batch_file_seek, remux_batch_file_tell };
+
+// one large block buffer per file: the file is read/written sequentially(except MP4 moov/MKV cues)
+static FILE* remux_batch_file_open(const char* name, const char* mode, char* block, size_t bytes)
+{
+	FILE* fp;
+	fp = fopen(name, mode);
+	if (!fp)
+		return NULL;
+
+	setvbuf(fp, block, _IOFBF, bytes);
+#if defined(POSIX_FADV_SEQUENTIAL)
+	if ('r' == *mode)
+		posix_fadvise(fileno(fp), 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+	return fp;
+}
+
+static int remux_batch_job_run(struct remux_batch_t* batch, struct remux_batch_job_t* job)
+{
+	int r;
+	char* block;
+	remux_t* remux;
+	remux_reader_t* reader;
+	struct remux_batch_file_t in, out;
+
+	// input/output block buffer
+	block = (char*)malloc(batch->block * 2);
+	if (!block)
+		return -ENOMEM;
+
+	memset(&in, 0, sizeof(in));
+	memset(&out, 0, sizeof(out));
+	in.counter = &batch->bytes_read;
+	out.counter = &batch->bytes_written;
+	in.fp = remux_batch_file_open(job->input, "rb", block, batch->block);
+	out.fp = in.fp ? remux_batch_file_open(job->output, "wb+", block + batch->block, batch->block) : NULL;
+	if (!in.fp || !out.fp)
+	{
+		if (in.fp)
+			fclose(in.fp);
+		free(block);
+		return -ENOENT;
+	}
+
+	r = -ENOMEM;
+	reader = NULL;
+	remux = remux_create(job->oformat, &s_file, &out);
+	if (remux)
+	{
+		if (batch->memory > 0)
+			remux_set_memory_limit(remux, batch->memory - batch->block * 2);
+
+		reader = remux_reader_create(remux, job->format, &s_file, &in);
+		r = reader ? 1 : -EINVAL;
+		while (1 == r)
+			r = remux_reader_read(reader);
+
+		remux_get_stats(remux, &job->result.stats);
+		if (reader)
+			remux_reader_destroy(reader);
+		remux_destroy(remux); // MP4 moov/MKV cues
+	}
+
+	fclose(in.fp);
+	if (0 != fclose(out.fp) && 0 == r)
+		r = -EIO;
+	free(block);
+
+	if (0 != r)
+		remove(job->output); // don't leave a broken file
+	return r;
+}
+
+// @return job index, -1-all queues are empty
+static int remux_batch_pop(struct remux_batch_t* batch, int id)
+{
+	int i, job;
+	struct remux_batch_queue_t* q;
+
+	for (job = -1, i = 0; i < batch->running && job < 0; i++)
+	{
+		q = &batch->workers[(id + i) % batch->running].queue;
+		locker_lock(&q->locker);
+		if (q->head < q->tail)
+			job = 0 == i ? q->jobs[q->head++] : q->jobs[--q->tail]; // own head or steal the smallest job
+		locker_unlock(&q->locker);
+	}
+	return job;
+}
+
+static REMUX_THREAD_API remux_batch_worker(void* param)
+{
+	int job;
+	int64_t clock;
+	struct remux_batch_job_t* j;
+	struct remux_batch_worker_t* w = (struct remux_batch_worker_t*)param;
+	struct remux_batch_t* batch = w->batch;
+
+	while ((job = remux_batch_pop(batch, w->id)) >= 0)
+	{
+		j = &batch->jobs[job];
+		atomic_add32(&batch->doing, 1);
+		clock = remux_batch_clock();
+		j->result.code = remux_batch_job_run(batch, j);
+		j->result.elapsed = remux_batch_clock() - clock;
+		atomic_add64(&batch->packets, (int64_t)j->result.stats.packets);
+		if (0 != j->result.code)
+			atomic_add32(&batch->failed, 1);
+		atomic_add32(&batch->done, 1);
+		atomic_add32(&batch->doing, -1);
+	}
+
+	locker_lock(&batch->locker);
+	batch->exited++;
+	event_signal(&batch->event);
+	locker_unlock(&batch->locker);
+	return REMUX_THREAD_EXIT;
+}
+
+remux_batch_t* remux_batch_create(int threads, size_t memory, size_t block)
+{
+	struct remux_batch_t* batch;
+	batch = (struct remux_batch_t*)calloc(1, sizeof(*batch));
+	if (!batch)
+		return NULL;
+
+	batch->threads = threads > 0 ? threads : remux_batch_cpus();
+	batch->memory = memory;
+	batch->block = block > 0 ? block : REMUX_BATCH_BLOCK;
+	if (memory > 0 && batch->block > memory / 4)
+		batch->block = memory / 4; // half of the memory for remux buffers
+	if (batch->block < 4096)
+	{
+		free(batch);
+		return NULL; // memory limit too small
+	}
+
+	locker_create(&batch->locker);
+	event_create(&batch->event);
+	return batch;
+}
+
+void remux_batch_destroy(remux_batch_t* batch)
+{
+	int i;
+	for (i = 0; i < batch->count; i++)
+	{
+		free(batch->jobs[i].input);
+		free(batch->jobs[i].output);
+	}
+	free(batch->workers);
+	free(batch->jobs);
+	event_destroy(&batch->event);
+	locker_destroy(&batch->locker);
+	free(batch);
+}
+
+/// @return 1-input and output are the same file
+static int remux_batch_same_file(const char* input, const char* output)
+{
+#if defined(_MSC_VER)
+	char a[MAX_PATH], b[MAX_PATH];
+	if (!_fullpath(a, input, sizeof(a)) || !_fullpath(b, output, sizeof(b)))
+		return 0 == _stricmp(input, output) ? 1 : 0;
+	return 0 == _stricmp(a, b) ? 1 : 0;
+#else
+	struct stat a, b;
+	if (0 == strcmp(input, output))
+		return 1;
+	// hard/symbolic link, relative path
+	return 0 == stat(input, &a) && 0 == stat(output, &b) && a.st_dev == b.st_dev && a.st_ino == b.st_ino ? 1 : 0;
+#endif
+}
+
+int remux_batch_add(remux_batch_t* batch, const char* input, int format, const char* output, int oformat)
+{
+	FILE* fp;
+	void* p;
+	struct remux_batch_job_t* job;
+
+	format = format > 0 ? format : remux_format_from_name(input);
+	oformat = oformat > 0 ? oformat : remux_format_from_name(output);
+	if (format <= 0 || oformat <= 0 || remux_batch_same_file(input, output))
+		return -EINVAL; // the output "wb+" truncate the input
+
+	if (batch->count >= batch->capacity)
+	{
+		p = realloc(batch->jobs, sizeof(batch->jobs[0]) * (batch->capacity + 64));
+		if (!p)
+			return -ENOMEM;
+		batch->jobs = (struct remux_batch_job_t*)p;
+		batch->capacity += 64;
+	}
+
+	job = &batch->jobs[batch->count];
+	memset(job, 0, sizeof(*job));
+	job->input = (char*)malloc(strlen(input) + 1);
+	job->output = (char*)malloc(strlen(output) + 1);
+	if (!job->input || !job->output)
+	{
+		free(job->input);
+		free(job->output);
+		return -ENOMEM;
+	}
+	strcpy(job->input, input);
+	strcpy(job->output, output);
+	job->format = format;
+	job->oformat = oformat;
+	job->result.code = 1; // not run
+
+	// job schedule order
+	fp = fopen(input, "rb");
+	if (fp)
+	{
+		if (0 == fseek64(fp, 0, SEEK_END))
+			job->size = (uint64_t)ftell64(fp);
+		fclose(fp);
+	}
+	return batch->count++;
+}
+
+struct remux_batch_order_t
+{
+	uint64_t size;
+	int job;
+};
+
+static int remux_batch_compare(const void* a, const void* b)
+{
+	const struct remux_batch_order_t* x = (const struct remux_batch_order_t*)a;
+	const struct remux_batch_order_t* y = (const struct remux_batch_order_t*)b;
+	return x->size > y->size ? -1 : (x->size < y->size ? 1 : x->job - y->job);
+}
+
+// deal jobs to per-thread queues round-robin, largest input first
+static int remux_batch_deal(struct remux_batch_t* batch, struct remux_batch_order_t* order)
+{
+	int i, n;
+	struct remux_batch_queue_t* q;
+
+	for (i = 0; i < batch->count; i++)
+	{
+		order[i].size = batch->jobs[i].size;
+		order[i].job = i;
+	}
+	qsort(order, batch->count, sizeof(order[0]), remux_batch_compare);
+
+	n = (batch->count + batch->running - 1) / batch->running;
+	for (i = 0; i < batch->running; i++)
+	{
+		q = &batch->workers[i].queue;
+		q->jobs = (int*)malloc(sizeof(q->jobs[0]) * n);
+		if (!q->jobs)
+			return -ENOMEM;
+	}
+
+	// a thread that fails to start leaves its queue to the others
+	for (i = 0; i < batch->running; i++)
+		locker_create(&batch->workers[i].queue.locker);
+
+	for (i = 0; i < batch->count; i++)
+	{
+		q = &batch->workers[i % batch->running].queue;
+		q->jobs[q->tail++] = order[i].job;
+	}
+	return 0;
+}
+
+static void remux_batch_progress(struct remux_batch_t* batch, int64_t clock, remux_batch_onprogress onprogress, void* param)
+{
+	int i;
+	struct remux_batch_progress_t progress;
+
+	memset(&progress, 0, sizeof(progress));
+	progress.jobs = batch->count;
+	progress.running = (int)atomic_load32(&batch->doing);
+	progress.done = (int)atomic_load32(&batch->done);
+	progress.failed = (int)atomic_load32(&batch->failed);
+	progress.bytes_read = (uint64_t)atomic_load64(&batch->bytes_read);
+	progress.bytes_written = (uint64_t)atomic_load64(&batch->bytes_written);
+	progress.packets = (uint64_t)atomic_load64(&batch->packets);
+	for (i = 0; i < batch->count; i++)
+		progress.bytes_total += batch->jobs[i].size;
+
+	progress.elapsed = remux_batch_clock() - clock;
+	progress.mbps = progress.elapsed > 0 ? progress.bytes_read / 1048576.0 / (progress.elapsed / 1000.0) : 0.0;
+	onprogress(param, &progress);
+}
+
+// wait worker exit or timeout, @return exited threads
+static int remux_batch_wait(struct remux_batch_t* batch, int threads, int interval)
+{
+	int exited;
+	locker_lock(&batch->locker);
+	if (batch->exited >= threads)
+	{
+		locker_unlock(&batch->locker);
+		return threads;
+	}
+	event_timewait(&batch->event, &batch->locker, interval);
+	exited = batch->exited;
+	locker_unlock(&batch->locker);
+	return exited;
+}
+
+int remux_batch_run(remux_batch_t* batch, remux_batch_onprogress onprogress, void* param, int interval)
+{
+	int i, r, n;
+	int64_t clock;
+	struct remux_batch_order_t* order;
+
+	if (!batch->workers && batch->count > 0)
+	{
+		batch->running = batch->threads < batch->count ? batch->threads : batch->count;
+		batch->workers = (struct remux_batch_worker_t*)calloc(batch->running, sizeof(batch->workers[0]));
+		order = (struct remux_batch_order_t*)malloc(sizeof(order[0]) * batch->count);
+		r = batch->workers && order ? remux_batch_deal(batch, order) : -ENOMEM;
+		free(order);
+		if (0 != r)
+		{
+			for (i = 0; batch->workers && i < batch->running; i++)
+				free(batch->workers[i].queue.jobs);
+			free(batch->workers);
+			batch->workers = NULL;
+			return r;
+		}
+	}
+	else if (batch->workers)
+	{
+		return -EBUSY; // run once
+	}
+
+	clock = remux_batch_clock();
+	for (n = 0, r = 0; n < batch->running && 0 == r; n++)
+	{
+		batch->workers[n].batch = batch;
+		batch->workers[n].id = n;
+		r = thread_create(&batch->workers[n].thread, remux_batch_worker, &batch->workers[n]);
+	}
+	n -= 0 != r ? 1 : 0; // started threads, the others jobs are stolen by started threads
+
+	while (n > 0 && remux_batch_wait(batch, n, onprogress ? interval : 0) < n)
+	{
+		if (onprogress)
+			remux_batch_progress(batch, clock, onprogress, param);
+	}
+
+	for (i = 0; i < n; i++)
+		thread_join(batch->workers[i].thread);
+	for (i = 0; i < batch->running; i++)
+	{
+		locker_destroy(&batch->workers[i].queue.locker);
+		free(batch->workers[i].queue.jobs);
+	}
+
+	if (onprogress)
+		remux_batch_progress(batch, clock, onprogress, param);
+	return n > 0 || 0 == batch->count ? (int)atomic_load32(&batch->failed) : -1;
+}
+
+int remux_batch_get_result(remux_batch_t* batch, int job, struct remux_batch_result_t* result)
+{
+	if (job < 0 || job >= batch->count)
+		return -ENOENT;
+	memcpy(result, &batch->jobs[job].result, sizeof(*result));
+	return 0;
+}
+
+int remux_format_from_name(const char* name)
+{
+	static const struct
+	{
+		const char* ext;
+		int format;
+	} s_formats[] = {
+		{ "mp4", REMUX_FORMAT_MP4 },
+		{ "m4v", REMUX_FORMAT_MP4 },
+		{ "m4a", REMUX_FORMAT_MP4 },
+		{ "mov", REMUX_FORMAT_MP4 },
+		{ "3gp", REMUX_FORMAT_MP4 },
+		{ "m4s", REMUX_FORMAT_FMP4 },
+		{ "mkv", REMUX_FORMAT_MKV },
+		{ "mka", REMUX_FORMAT_MKV },
+		{ "webm", REMUX_FORMAT_MKV },
+		{ "flv", REMUX_FORMAT_FLV },
+		{ "ts", REMUX_FORMAT_TS },
+		{ "m2ts", REMUX_FORMAT_TS },
+		{ "mts", REMUX_FORMAT_TS },
+		{ "ps", REMUX_FORMAT_PS },
+		{ "mpg", REMUX_FORMAT_PS },
+		{ "mpeg", REMUX_FORMAT_PS },
+		{ "vob", REMUX_FORMAT_PS },
+	};
+
+	size_t i;
+	const char* ext;
+	ext = strrchr(name, '.');
+	if (!ext || strchr(ext, '/') || strchr(ext, '\\'))
+		return 0;
+
+	for (i = 0; i < sizeof(s_formats) / sizeof(s_formats[0]); i++)
+	{
+		if (0 == strcasecmp(ext + 1, s_formats[i].ext))
+			return s_formats[i].format;
+	}
+	return 0;
+}
+
+#if defined(_DEBUG) || defined(DEBUG)
+static void remux_batch_test_file(const char* name, int format, int frames)
+{
+	remux_t* remux;
+	struct remux_batch_file_t f;
+	int64_t bytes = 0;
+
+	f.counter = &bytes;
+	f.fp = fopen(name, "wb+");
+	assert(f.fp);
+	remux = remux_create(format, &s_file, &f);
+	remux_test_source(remux, frames);
+	remux_destroy(remux);
+	fclose(f.fp);
+	assert(bytes > 0);
+}
+
+static void remux_batch_test_onprogress(void* param, const struct remux_batch_progress_t* progress)
+{
+	struct remux_batch_progress_t* last = (struct remux_batch_progress_t*)param;
+	assert(progress->done <= progress->jobs && progress->running <= progress->jobs);
+	assert(progress->bytes_read <= progress->bytes_total);
+	memcpy(last, progress, sizeof(*last));
+}
+
+void remux_batch_test(void)
+{
+	static const struct
+	{
+		const char* input;
+		const char* output;
+		int frames;
+	} s_jobs[] = {
+		{ "remux-batch-test-1.mp4", "remux-batch-test-1.ts", 500 },
+		{ "remux-batch-test-2.ts", "remux-batch-test-2.flv", 50 },
+		{ "remux-batch-test-3.flv", "remux-batch-test-3.mkv", 250 },
+		{ "remux-batch-test-4.mp4", "remux-batch-test-4.mkv", 25 },
+		{ "remux-batch-test-5.ts", "remux-batch-test-5.mp4", 100 },
+		{ "remux-batch-test-0.flv", "remux-batch-test-0.mp4", 0 }, // don't exist
+	};
+
+	int i, id[sizeof(s_jobs) / sizeof(s_jobs[0])];
+	remux_batch_t* batch;
+	struct remux_batch_result_t result;
+	struct remux_batch_progress_t progress;
+
+	assert(REMUX_FORMAT_MKV == remux_format_from_name("a/b.c/d.WebM") && REMUX_FORMAT_TS == remux_format_from_name("x.m2ts"));
+	assert(0 == remux_format_from_name("a.mp4/b") && 0 == remux_format_from_name("a.txt"));
+
+	for (i = 0; i < (int)(sizeof(s_jobs) / sizeof(s_jobs[0])); i++)
+	{
+		if (s_jobs[i].frames > 0)
+			remux_batch_test_file(s_jobs[i].input, remux_format_from_name(s_jobs[i].input), s_jobs[i].frames);
+	}
+
+	// 3 threads, 1MB per job(256KB I/O block)
+	batch = remux_batch_create(3, 1024 * 1024, 0);
+	assert(batch);
+	for (i = 0; i < (int)(sizeof(s_jobs) / sizeof(s_jobs[0])); i++)
+		id[i] = remux_batch_add(batch, s_jobs[i].input, 0, s_jobs[i].output, 0);
+	assert(-EINVAL == remux_batch_add(batch, "a.avi", 0, "b.mp4", 0));
+	assert(-EINVAL == remux_batch_add(batch, s_jobs[0].input, 0, s_jobs[0].input, REMUX_FORMAT_MP4));
+	assert(-EINVAL == remux_batch_add(batch, s_jobs[0].input, 0, "./remux-batch-test-1.mp4", REMUX_FORMAT_MP4));
+
+	memset(&progress, 0, sizeof(progress));
+	assert(1 == remux_batch_run(batch, remux_batch_test_onprogress, &progress, 10));
+	assert(-EBUSY == remux_batch_run(batch, NULL, NULL, 0));
+	assert(6 == progress.jobs && 6 == progress.done && 1 == progress.failed && 0 == progress.running);
+	assert(progress.bytes_read > 0 && progress.bytes_read <= progress.bytes_total && progress.bytes_written > 0); // MP4 mdat header is skipped
+
+	for (i = 0; i < (int)(sizeof(s_jobs) / sizeof(s_jobs[0])); i++)
+	{
+		assert(0 == remux_batch_get_result(batch, id[i], &result));
+		if (s_jobs[i].frames > 0)
+		{
+			assert(0 == result.code && (uint64_t)s_jobs[i].frames * 2 == result.stats.packets && 0 == result.stats.dropped);
+			assert(result.stats.memory > 0 && result.stats.memory <= 1024 * 1024 - 512 * 1024);
+		}
+		else
+		{
+			assert(result.code < 0);
+		}
+		remove(s_jobs[i].input);
+		remove(s_jobs[i].output);
+	}
+	assert(-ENOENT == remux_batch_get_result(batch, 6, &result));
+	remux_batch_destroy(batch);
+
+	// memory limit too small for the TS reader block: job fail, no output file
+	remux_batch_test_file(s_jobs[1].input, REMUX_FORMAT_TS, 50);
+	batch = remux_batch_create(1, 16 * 1024, 0);
+	assert(batch && 0 == remux_batch_add(batch, s_jobs[1].input, 0, s_jobs[1].output, 0));
+	assert(1 == remux_batch_run(batch, NULL, NULL, 0));
+	assert(0 == remux_batch_get_result(batch, 0, &result) && result.code < 0);
+	assert(NULL == fopen(s_jobs[1].output, "rb"));
+	remux_batch_destroy(batch);
+	remove(s_jobs[1].input);
+	assert(NULL == remux_batch_create(1, 4096, 0));
+}
+#endif
@@ -0,0 +1,71 @@
+#include "remux-internal.h"
+#include "mov-format.h"
+#include "mkv-format.h"
+#include "flv-proto.h"
+#include "mpeg-proto.h"
+#include <stdlib.h>
+
+// MOV object id is the remux codec id, the other containers map to it
+static const struct remux_codec_t s_codecs[] = {
+	// object			mkv							flv					mpeg2					video
+	{ MOV_OBJECT_H264,	MKV_CODEC_VIDEO_H264,		FLV_VIDEO_H264,		PSI_STREAM_H264,		1 },
+	{ MOV_OBJECT_H265,	MKV_CODEC_VIDEO_H265,		FLV_VIDEO_H265,		PSI_STREAM_H265,		1 },
+	{ MOV_OBJECT_H266,	MKV_CODEC_VIDEO_H266,		FLV_VIDEO_H266,		PSI_STREAM_H266,		1 },
+	{ MOV_OBJECT_AV1,	MKV_CODEC_VIDEO_AV1,		FLV_VIDEO_AV1,		0,						1 },
+	{ MOV_OBJECT_VP9,	MKV_CODEC_VIDEO_VP9,		0,					0,						1 },
+	{ MOV_OBJECT_VP8,	MKV_CODEC_VIDEO_VP8,		0,					0,						1 },
+
+	{ MOV_OBJECT_AAC,	MKV_CODEC_AUDIO_AAC,		FLV_AUDIO_AAC,		PSI_STREAM_AAC,			0 },
+	{ MOV_OBJECT_MP3,	MKV_CODEC_AUDIO_MP3,		FLV_AUDIO_MP3,		PSI_STREAM_MP3,			0 },
+	{ MOV_OBJECT_MP1A,	MKV_CODEC_AUDIO_MP3,		FLV_AUDIO_MP3,		PSI_STREAM_AUDIO_MPEG1,	0 },
+	{ MOV_OBJECT_OPUS,	MKV_CODEC_AUDIO_OPUS,		FLV_AUDIO_OPUS,		0,						0 },
+	{ MOV_OBJECT_AC3,	MKV_CODEC_AUDIO_AC3,		0,					PSI_STREAM_AUDIO_AC3,	0 },
+	{ MOV_OBJECT_EAC3,	MKV_CODEC_AUDIO_EAC3,		0,					PSI_STREAM_AUDIO_EAC3,	0 },
+	{ MOV_OBJECT_FLAC,	MKV_CODEC_AUDIO_FLAC,		0,					0,						0 },
+	{ MOV_OBJECT_G711a,	0,							FLV_AUDIO_G711A,	PSI_STREAM_AUDIO_G711A,	0 },
+	{ MOV_OBJECT_G711u,	0,							FLV_AUDIO_G711U,	PSI_STREAM_AUDIO_G711U,	0 },
+};
+
+const struct remux_codec_t* remux_codec_find_by_mov(uint8_t object)
+{
+	size_t i;
+	for (i = 0; i < sizeof(s_codecs) / sizeof(s_codecs[0]); i++)
+	{
+		if (s_codecs[i].object == object)
+			return &s_codecs[i];
+	}
+	return NULL;
+}
+
+const struct remux_codec_t* remux_codec_find_by_mkv(int codec)
+{
+	size_t i;
+	for (i = 0; codec && i < sizeof(s_codecs) / sizeof(s_codecs[0]); i++)
+	{
+		if (s_codecs[i].mkv == codec)
+			return &s_codecs[i];
+	}
+	return NULL;
+}
+
+const struct remux_codec_t* remux_codec_find_by_flv(int codec)
+{
+	size_t i;
+	for (i = 0; codec && i < sizeof(s_codecs) / sizeof(s_codecs[0]); i++)
+	{
+		if (s_codecs[i].flv == codec)
+			return &s_codecs[i];
+	}
+	return NULL;
+}
+
+const struct remux_codec_t* remux_codec_find_by_mpeg2(int codec)
+{
+	size_t i;
+	for (i = 0; codec && i < sizeof(s_codecs) / sizeof(s_codecs[0]); i++)
+	{
+		if (s_codecs[i].mpeg2 == codec)
+			return &s_codecs[i];
+	}
+	return NULL;
+}
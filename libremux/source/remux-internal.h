@@ -0,0 +1,84 @@
+#ifndef _remux_internal_h_
+#define _remux_internal_h_
+
+#include "remux.h"
+
+// output container
+struct remux_writer_t
+{
+	int bitstream; // REMUX_BITSTREAM_XXX, H.26x/AAC input bitstream
+
+	/// @param[in] stream stream->extra/bytes in writer bitstream(e.g. avcC for MP4, NULL for TS)
+	/// @return >=0-track, <0-unsupported codec or error
+	int (*add_stream)(struct remux_writer_t* writer, const struct remux_stream_t* stream);
+
+	/// all tracks added(before the first write), NULL if don't need
+	/// @return 0-ok, other-error
+	int (*start)(struct remux_writer_t* writer);
+
+	/// @param[in] pkt pkt->stream is writer track(add_stream return value)
+	/// @return 0-ok, other-error
+	int (*write)(struct remux_writer_t* writer, const struct remux_packet_t* pkt);
+
+	void (*destroy)(struct remux_writer_t* writer);
+};
+
+struct remux_writer_t* remux_writer_mov_create(const struct remux_buffer_t* buffer, void* param, int fmp4);
+struct remux_writer_t* remux_writer_mkv_create(const struct remux_buffer_t* buffer, void* param);
+struct remux_writer_t* remux_writer_flv_create(const struct remux_buffer_t* buffer, void* param);
+struct remux_writer_t* remux_writer_ts_create(const struct remux_buffer_t* buffer, void* param);
+struct remux_writer_t* remux_writer_ps_create(const struct remux_buffer_t* buffer, void* param);
+
+// input container
+struct remux_reader_t
+{
+	remux_t* remux;
+
+	/// @return 1-ok, 0-end of file, <0-error
+	int (*read)(struct remux_reader_t* reader);
+	void (*destroy)(struct remux_reader_t* reader);
+};
+
+struct remux_reader_t* remux_reader_mov_create(remux_t* remux, const struct remux_buffer_t* buffer, void* param);
+struct remux_reader_t* remux_reader_mkv_create(remux_t* remux, const struct remux_buffer_t* buffer, void* param);
+struct remux_reader_t* remux_reader_flv_create(remux_t* remux, const struct remux_buffer_t* buffer, void* param);
+struct remux_reader_t* remux_reader_ts_create(remux_t* remux, const struct remux_buffer_t* buffer, void* param);
+struct remux_reader_t* remux_reader_ps_create(remux_t* remux, const struct remux_buffer_t* buffer, void* param);
+
+/// Stream list isn't known before the first packet(e.g. FLV tags, TS before PMT),
+/// remux wait all streams in probe queue until remux_set_probe(remux, 0), probe limit or remux_flush
+void remux_set_probe(remux_t* remux, int probe);
+
+/// read exactly bytes(mov_buffer_t/mkv_buffer_t read semantic)
+/// @return 0-ok, <0-error or end of file
+int remux_buffer_read(const struct remux_buffer_t* buffer, void* param, void* data, uint64_t bytes);
+
+/// grow buffer to at least bytes, keep old data
+/// @return 0-ok, -ENOMEM-alloc failed
+int remux_alloc(uint8_t** ptr, size_t* capacity, size_t bytes);
+
+/// remux_alloc with remux memory accounting(remux_set_memory_limit)
+/// @return 0-ok, -ENOMEM-alloc failed or over memory limit
+int remux_reserve(remux_t* remux, uint8_t** ptr, size_t* capacity, size_t bytes);
+
+// codec id mapping, 0 if the container don't support the codec
+struct remux_codec_t
+{
+	uint8_t object; // MOV_OBJECT_XXX
+	int mkv; // enum mkv_codec_t
+	int flv; // FLV_VIDEO_XXX/FLV_AUDIO_XXX
+	int mpeg2; // PSI_STREAM_XXX
+	int video; // 1-video, 0-audio
+};
+
+const struct remux_codec_t* remux_codec_find_by_mov(uint8_t object);
+const struct remux_codec_t* remux_codec_find_by_mkv(int codec);
+const struct remux_codec_t* remux_codec_find_by_flv(int codec);
+const struct remux_codec_t* remux_codec_find_by_mpeg2(int codec);
+
+#if defined(_DEBUG) || defined(DEBUG)
+/// test source: AnnexB H.264(25fps, gop 1s) + ADTS AAC elementary stream, frames * 2 packets
+void remux_test_source(remux_t* remux, int frames);
+#endif
+
+#endif /* !_remux_internal_h_ */
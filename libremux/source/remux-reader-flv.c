@@ -0,0 +1,195 @@
+#include "remux-internal.h"
+#include "flv-header.h"
+#include "flv-parser.h"
+#include "flv-proto.h"
+#include "mov-format.h"
+#include "mpeg4-aac.h"
+#include "mp3-header.h"
+#include "opus-head.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#define FLV_HEADER_SIZE		9 // DataOffset included
+#define FLV_TAG_HEADER_SIZE	11 // StreamID included
+
+// FLV tag body: VideoTagHeader/AudioTagHeader + MP4 bitstream(AVCC NALU, raw AAC)
+// stream is added on sequence header(or the first MP3/G711 frame), remux probe wait all streams
+// flv_reader isn't used: it need a caller buffer for the max tag size(16MB), tag buffer here grow on demand
+struct remux_reader_flv_t
+{
+	struct remux_reader_t base;
+	struct remux_buffer_t io; // user input buffer
+	void* param;
+
+	int video; // remux stream, <0-no video sequence header
+	int audio; // remux stream, <0-no audio sequence header
+
+	// tag buffer, reused by all tags
+	uint8_t* ptr;
+	size_t capacity;
+};
+
+static int remux_reader_flv_header(struct remux_reader_flv_t* r)
+{
+	int n;
+	uint8_t data[FLV_HEADER_SIZE];
+	struct flv_header_t h;
+
+	if (0 != remux_buffer_read(&r->io, r->param, data, FLV_HEADER_SIZE) || FLV_HEADER_SIZE != flv_header_read(&h, data, FLV_HEADER_SIZE))
+		return -1;
+
+	// skip extra header data and PreviousTagSize0
+	for (n = (int)h.offset - FLV_HEADER_SIZE + 4; n > 0; n -= sizeof(data))
+	{
+		if (0 != remux_buffer_read(&r->io, r->param, data, n > (int)sizeof(data) ? sizeof(data) : (size_t)n))
+			return -1;
+	}
+	return 0;
+}
+
+static int remux_reader_flv_add(struct remux_reader_flv_t* r, int* stream, uint8_t object, int channels, int sample_rate, const void* data, size_t bytes)
+{
+	struct remux_stream_t info;
+	if (*stream >= 0)
+		return 0; // ignore repeated sequence header
+
+	memset(&info, 0, sizeof(info));
+	info.object = object;
+	info.bitstream = REMUX_BITSTREAM_MP4;
+	info.channels = channels;
+	info.bits_per_sample = channels > 0 ? 16 : 0;
+	info.sample_rate = sample_rate;
+	info.extra = data;
+	info.bytes = bytes;
+	*stream = remux_add_stream(r->base.remux, &info);
+	return *stream < 0 ? *stream : 0;
+}
+
+static int remux_reader_flv_input(struct remux_reader_flv_t* r, int stream, const void* data, size_t bytes, uint32_t pts, uint32_t dts, int flags)
+{
+	struct remux_packet_t pkt;
+	if (stream < 0)
+		return 0; // drop frame before sequence header
+
+	pkt.stream = stream;
+	pkt.flags = flags ? REMUX_FLAG_KEYFRAME : 0;
+	pkt.pts = pts;
+	pkt.dts = dts;
+	pkt.data = data;
+	pkt.bytes = bytes;
+	return remux_input(r->base.remux, &pkt);
+}
+
+static int remux_reader_flv_handler(void* param, int codec, const void* data, size_t bytes, uint32_t pts, uint32_t dts, int flags)
+{
+	struct mp3_header_t mp3;
+	struct opus_head_t opus;
+	struct mpeg4_aac_t aac;
+	struct remux_reader_flv_t* r;
+	r = (struct remux_reader_flv_t*)param;
+
+	switch (codec)
+	{
+	case FLV_VIDEO_AVCC:
+		return remux_reader_flv_add(r, &r->video, MOV_OBJECT_H264, 0, 0, data, bytes);
+	case FLV_VIDEO_HVCC:
+		return remux_reader_flv_add(r, &r->video, MOV_OBJECT_HEVC, 0, 0, data, bytes);
+	case FLV_VIDEO_VVCC:
+		return remux_reader_flv_add(r, &r->video, MOV_OBJECT_H266, 0, 0, data, bytes);
+	case FLV_VIDEO_AV1C:
+		return remux_reader_flv_add(r, &r->video, MOV_OBJECT_AV1, 0, 0, data, bytes);
+
+	case FLV_AUDIO_ASC:
+		if (mpeg4_aac_audio_specific_config_load((const uint8_t*)data, bytes, &aac) < 0)
+			return -EINVAL;
+		return remux_reader_flv_add(r, &r->audio, MOV_OBJECT_AAC, aac.channel_configuration, mpeg4_aac_audio_frequency_to((enum mpeg4_aac_frequency)aac.sampling_frequency_index), data, bytes);
+
+	case FLV_AUDIO_OPUS_HEAD:
+		if (opus_head_load((const uint8_t*)data, bytes, &opus) < 0)
+			return -EINVAL;
+		return remux_reader_flv_add(r, &r->audio, MOV_OBJECT_OPUS, opus.channels, opus.input_sample_rate, data, bytes);
+
+	case FLV_VIDEO_H264:
+	case FLV_VIDEO_H265:
+	case FLV_VIDEO_H266:
+	case FLV_VIDEO_AV1:
+		return remux_reader_flv_input(r, r->video, data, bytes, pts, dts, flags);
+
+	case FLV_AUDIO_AAC:
+	case FLV_AUDIO_OPUS:
+		return remux_reader_flv_input(r, r->audio, data, bytes, pts, dts, 0);
+
+	case FLV_AUDIO_MP3:
+		// no sequence header, add stream on first frame
+		if (r->audio < 0 && (0 == mp3_header_load(&mp3, data, (int)bytes) || 0 != remux_reader_flv_add(r, &r->audio, MOV_OBJECT_MP3, mp3_get_channel(&mp3), mp3_get_frequency(&mp3), NULL, 0)))
+			return 0;
+		return remux_reader_flv_input(r, r->audio, data, bytes, pts, dts, 0);
+
+	case FLV_AUDIO_G711A:
+	case FLV_AUDIO_G711U:
+		if (r->audio < 0 && 0 != remux_reader_flv_add(r, &r->audio, FLV_AUDIO_G711A == codec ? MOV_OBJECT_G711a : MOV_OBJECT_G711u, 1, 8000, NULL, 0))
+			return 0;
+		return remux_reader_flv_input(r, r->audio, data, bytes, pts, dts, 0);
+
+	default:
+		return 0; // ignore script data and unsupported codec
+	}
+}
+
+static int remux_reader_flv_read(struct remux_reader_t* reader)
+{
+	int r;
+	uint8_t header[FLV_TAG_HEADER_SIZE];
+	struct flv_tag_header_t tag;
+	struct remux_reader_flv_t* flv = (struct remux_reader_flv_t*)reader;
+
+	r = flv->io.read(flv->param, header, 1);
+	if (r <= 0)
+		return r; // 0-EOF
+	if (0 != remux_buffer_read(&flv->io, flv->param, header + 1, FLV_TAG_HEADER_SIZE - 1) || FLV_TAG_HEADER_SIZE != flv_tag_header_read(&tag, header, FLV_TAG_HEADER_SIZE))
+		return -1;
+
+	// tag data + PreviousTagSize
+	if (0 != remux_reserve(reader->remux, &flv->ptr, &flv->capacity, tag.size + 4))
+		return -ENOMEM;
+	if (0 != remux_buffer_read(&flv->io, flv->param, flv->ptr, tag.size + 4))
+		return -1;
+
+	if (tag.size > 0 && 0 != (r = flv_parser_tag(tag.type, flv->ptr, tag.size, tag.timestamp, remux_reader_flv_handler, flv)))
+		return r;
+	return 1;
+}
+
+static void remux_reader_flv_destroy(struct remux_reader_t* reader)
+{
+	struct remux_reader_flv_t* r = (struct remux_reader_flv_t*)reader;
+	free(r->ptr);
+	free(r);
+}
+
+struct remux_reader_t* remux_reader_flv_create(remux_t* remux, const struct remux_buffer_t* buffer, void* param)
+{
+	struct remux_reader_flv_t* r;
+	r = (struct remux_reader_flv_t*)calloc(1, sizeof(*r));
+	if (!r)
+		return NULL;
+
+	memcpy(&r->io, buffer, sizeof(r->io));
+	r->param = param;
+	r->video = -1;
+	r->audio = -1;
+	r->base.remux = remux;
+	r->base.read = remux_reader_flv_read;
+	r->base.destroy = remux_reader_flv_destroy;
+
+	if (0 != remux_reader_flv_header(r))
+	{
+		remux_reader_flv_destroy(&r->base);
+		return NULL;
+	}
+
+	// FLV header audio/video flags are unreliable, probe stream list by tags
+	remux_set_probe(remux, 1);
+	return &r->base;
+}
@@ -0,0 +1,167 @@
+#include "remux-internal.h"
+#include "mkv-reader.h"
+#include "mkv-format.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#define REMUX_READER_TRACKS 8
+
+struct remux_reader_mkv_t
+{
+	struct remux_reader_t base;
+	struct remux_buffer_t io; // user input buffer
+	void* param;
+
+	mkv_reader_t* mkv;
+	struct
+	{
+		uint32_t id; // mkv track number
+		int stream; // remux stream, <0-unsupported
+	} tracks[REMUX_READER_TRACKS];
+	int count;
+
+	// frame buffer, reused by all frames
+	uint8_t* ptr;
+	size_t capacity;
+	struct remux_packet_t pkt;
+};
+
+static int remux_reader_mkv_read_buffer(void* param, void* data, uint64_t bytes)
+{
+	struct remux_reader_mkv_t* r = (struct remux_reader_mkv_t*)param;
+	return remux_buffer_read(&r->io, r->param, data, bytes);
+}
+
+static int remux_reader_mkv_write(void* param, const void* data, uint64_t bytes)
+{
+	(void)param, (void)data, (void)bytes;
+	return -ENOSYS;
+}
+
+static int remux_reader_mkv_seek(void* param, int64_t offset)
+{
+	struct remux_reader_mkv_t* r = (struct remux_reader_mkv_t*)param;
+	return r->io.seek(r->param, offset);
+}
+
+static int64_t remux_reader_mkv_tell(void* param)
+{
+	struct remux_reader_mkv_t* r = (struct remux_reader_mkv_t*)param;
+	return r->io.tell(r->param);
+}
+
+static const struct mkv_buffer_t s_buffer = { remux_reader_mkv_read_buffer, remux_reader_mkv_write, remux_reader_mkv_seek, remux_reader_mkv_tell };
+
+static void remux_reader_mkv_add(struct remux_reader_mkv_t* r, uint32_t track, enum mkv_codec_t codecid, struct remux_stream_t* stream)
+{
+	const struct remux_codec_t* codec;
+	if (r->count >= REMUX_READER_TRACKS)
+		return;
+
+	codec = remux_codec_find_by_mkv(codecid);
+	stream->object = codec ? codec->object : 0;
+	r->tracks[r->count].id = track;
+	r->tracks[r->count].stream = codec ? remux_add_stream(r->base.remux, stream) : -1;
+	r->count++;
+}
+
+static void remux_reader_mkv_onvideo(void* param, uint32_t track, enum mkv_codec_t codec, int width, int height, const void* extra, size_t bytes)
+{
+	struct remux_stream_t stream;
+	memset(&stream, 0, sizeof(stream));
+	stream.bitstream = REMUX_BITSTREAM_MP4;
+	stream.width = width;
+	stream.height = height;
+	stream.extra = extra;
+	stream.bytes = bytes;
+	remux_reader_mkv_add((struct remux_reader_mkv_t*)param, track, codec, &stream);
+}
+
+static void remux_reader_mkv_onaudio(void* param, uint32_t track, enum mkv_codec_t codec, int channel_count, int bit_per_sample, int sample_rate, const void* extra, size_t bytes)
+{
+	struct remux_stream_t stream;
+	memset(&stream, 0, sizeof(stream));
+	stream.bitstream = REMUX_BITSTREAM_MP4;
+	stream.channels = channel_count;
+	stream.bits_per_sample = bit_per_sample;
+	stream.sample_rate = sample_rate;
+	stream.extra = extra;
+	stream.bytes = bytes;
+	remux_reader_mkv_add((struct remux_reader_mkv_t*)param, track, codec, &stream);
+}
+
+static void remux_reader_mkv_onsubtitle(void* param, uint32_t track, enum mkv_codec_t codec, const void* extra, size_t bytes)
+{
+	(void)param, (void)track, (void)codec, (void)extra, (void)bytes;
+}
+
+static void* remux_reader_mkv_onread(void* param, uint32_t track, size_t bytes, int64_t pts, int64_t dts, int flags)
+{
+	int i;
+	struct remux_reader_mkv_t* r = (struct remux_reader_mkv_t*)param;
+
+	r->pkt.stream = -1;
+	for (i = 0; i < r->count; i++)
+	{
+		if (r->tracks[i].id == track)
+			r->pkt.stream = r->tracks[i].stream;
+	}
+
+	r->pkt.flags = (flags & MKV_FLAGS_KEYFRAME) ? REMUX_FLAG_KEYFRAME : 0;
+	r->pkt.pts = pts;
+	r->pkt.dts = dts;
+	r->pkt.bytes = bytes;
+	return 0 == remux_reserve(r->base.remux, &r->ptr, &r->capacity, bytes > 0 ? bytes : 1) ? r->ptr : NULL;
+}
+
+static int remux_reader_mkv_read(struct remux_reader_t* reader)
+{
+	int r;
+	struct remux_reader_mkv_t* mkv = (struct remux_reader_mkv_t*)reader;
+
+	r = mkv_reader_read2(mkv->mkv, remux_reader_mkv_onread, mkv);
+	if (r <= 0)
+		return r;
+
+	if (mkv->pkt.stream < 0)
+		return 1; // subtitle/unsupported track
+
+	mkv->pkt.data = mkv->ptr;
+	r = remux_input(reader->remux, &mkv->pkt);
+	return 0 == r ? 1 : r;
+}
+
+static void remux_reader_mkv_destroy(struct remux_reader_t* reader)
+{
+	struct remux_reader_mkv_t* r = (struct remux_reader_mkv_t*)reader;
+	if (r->mkv)
+		mkv_reader_destroy(r->mkv);
+	free(r->ptr);
+	free(r);
+}
+
+struct remux_reader_t* remux_reader_mkv_create(remux_t* remux, const struct remux_buffer_t* buffer, void* param)
+{
+	struct remux_reader_mkv_t* r;
+	struct mkv_reader_trackinfo_t info = { remux_reader_mkv_onvideo, remux_reader_mkv_onaudio, remux_reader_mkv_onsubtitle };
+
+	r = (struct remux_reader_mkv_t*)calloc(1, sizeof(*r));
+	if (!r)
+		return NULL;
+
+	memcpy(&r->io, buffer, sizeof(r->io));
+	r->param = param;
+	r->base.remux = remux;
+	r->base.read = remux_reader_mkv_read;
+	r->base.destroy = remux_reader_mkv_destroy;
+
+	// Tracks element: all tracks are known before the first cluster
+	r->mkv = mkv_reader_create(&s_buffer, r);
+	if (!r->mkv || 0 != mkv_reader_getinfo(r->mkv, &info, r))
+	{
+		remux_reader_mkv_destroy(&r->base);
+		return NULL;
+	}
+	return &r->base;
+}
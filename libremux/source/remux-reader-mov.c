@@ -0,0 +1,161 @@
+#include "remux-internal.h"
+#include "mov-reader.h"
+#include "mov-format.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#define REMUX_READER_TRACKS 8
+
+struct remux_reader_mov_t
+{
+	struct remux_reader_t base;
+	struct remux_buffer_t io; // user input buffer
+	void* param;
+
+	mov_reader_t* mov;
+	struct
+	{
+		uint32_t id; // mov track id
+		int stream; // remux stream, <0-unsupported
+	} tracks[REMUX_READER_TRACKS];
+	int count;
+
+	// frame buffer, reused by all frames
+	uint8_t* ptr;
+	size_t capacity;
+	struct remux_packet_t pkt;
+};
+
+static int remux_reader_mov_read_buffer(void* param, void* data, uint64_t bytes)
+{
+	struct remux_reader_mov_t* r = (struct remux_reader_mov_t*)param;
+	return remux_buffer_read(&r->io, r->param, data, bytes);
+}
+
+static int remux_reader_mov_write(void* param, const void* data, uint64_t bytes)
+{
+	(void)param, (void)data, (void)bytes;
+	return -ENOSYS;
+}
+
+static int remux_reader_mov_seek(void* param, int64_t offset)
+{
+	struct remux_reader_mov_t* r = (struct remux_reader_mov_t*)param;
+	return r->io.seek(r->param, offset);
+}
+
+static int64_t remux_reader_mov_tell(void* param)
+{
+	struct remux_reader_mov_t* r = (struct remux_reader_mov_t*)param;
+	return r->io.tell(r->param);
+}
+
+static const struct mov_buffer_t s_buffer = { remux_reader_mov_read_buffer, remux_reader_mov_write, remux_reader_mov_seek, remux_reader_mov_tell };
+
+static void remux_reader_mov_add(struct remux_reader_mov_t* r, uint32_t track, const struct remux_stream_t* stream)
+{
+	if (r->count >= REMUX_READER_TRACKS)
+		return;
+
+	r->tracks[r->count].id = track;
+	r->tracks[r->count].stream = remux_codec_find_by_mov(stream->object) ? remux_add_stream(r->base.remux, stream) : -1;
+	r->count++;
+}
+
+static void remux_reader_mov_onvideo(void* param, uint32_t track, uint8_t object, int width, int height, const void* extra, size_t bytes)
+{
+	struct remux_stream_t stream;
+	memset(&stream, 0, sizeof(stream));
+	stream.object = object;
+	stream.bitstream = REMUX_BITSTREAM_MP4;
+	stream.width = width;
+	stream.height = height;
+	stream.extra = extra;
+	stream.bytes = bytes;
+	remux_reader_mov_add((struct remux_reader_mov_t*)param, track, &stream);
+}
+
+static void remux_reader_mov_onaudio(void* param, uint32_t track, uint8_t object, int channel_count, int bit_per_sample, int sample_rate, const void* extra, size_t bytes)
+{
+	struct remux_stream_t stream;
+	memset(&stream, 0, sizeof(stream));
+	stream.object = object;
+	stream.bitstream = REMUX_BITSTREAM_MP4;
+	stream.channels = channel_count;
+	stream.bits_per_sample = bit_per_sample;
+	stream.sample_rate = sample_rate;
+	stream.extra = extra;
+	stream.bytes = bytes;
+	remux_reader_mov_add((struct remux_reader_mov_t*)param, track, &stream);
+}
+
+static void* remux_reader_mov_onread(void* param, uint32_t track, size_t bytes, int64_t pts, int64_t dts, int flags)
+{
+	int i;
+	struct remux_reader_mov_t* r = (struct remux_reader_mov_t*)param;
+
+	r->pkt.stream = -1;
+	for (i = 0; i < r->count; i++)
+	{
+		if (r->tracks[i].id == track)
+			r->pkt.stream = r->tracks[i].stream;
+	}
+
+	r->pkt.flags = (flags & MOV_AV_FLAG_KEYFREAME) ? REMUX_FLAG_KEYFRAME : 0;
+	r->pkt.pts = pts;
+	r->pkt.dts = dts;
+	r->pkt.bytes = bytes;
+	return 0 == remux_reserve(r->base.remux, &r->ptr, &r->capacity, bytes > 0 ? bytes : 1) ? r->ptr : NULL;
+}
+
+static int remux_reader_mov_read(struct remux_reader_t* reader)
+{
+	int r;
+	struct remux_reader_mov_t* mov = (struct remux_reader_mov_t*)reader;
+
+	r = mov_reader_read2(mov->mov, remux_reader_mov_onread, mov);
+	if (r <= 0)
+		return r;
+
+	if (mov->pkt.stream < 0)
+		return 1; // subtitle/unsupported track
+
+	mov->pkt.data = mov->ptr;
+	r = remux_input(reader->remux, &mov->pkt);
+	return 0 == r ? 1 : r;
+}
+
+static void remux_reader_mov_destroy(struct remux_reader_t* reader)
+{
+	struct remux_reader_mov_t* r = (struct remux_reader_mov_t*)reader;
+	if (r->mov)
+		mov_reader_destroy(r->mov);
+	free(r->ptr);
+	free(r);
+}
+
+struct remux_reader_t* remux_reader_mov_create(remux_t* remux, const struct remux_buffer_t* buffer, void* param)
+{
+	struct remux_reader_mov_t* r;
+	struct mov_reader_trackinfo_t info = { remux_reader_mov_onvideo, remux_reader_mov_onaudio, NULL };
+
+	r = (struct remux_reader_mov_t*)calloc(1, sizeof(*r));
+	if (!r)
+		return NULL;
+
+	memcpy(&r->io, buffer, sizeof(r->io));
+	r->param = param;
+	r->base.remux = remux;
+	r->base.read = remux_reader_mov_read;
+	r->base.destroy = remux_reader_mov_destroy;
+
+	// moov box: all tracks are known before the first frame
+	r->mov = mov_reader_create(&s_buffer, r);
+	if (!r->mov || 0 != mov_reader_getinfo(r->mov, &info, r))
+	{
+		remux_reader_mov_destroy(&r->base);
+		return NULL;
+	}
+	return &r->base;
+}
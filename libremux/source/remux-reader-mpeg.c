@@ -0,0 +1,221 @@
+#include "remux-internal.h"
+#include "mpeg-ts.h"
+#include "mpeg-ps.h"
+#include "mpeg-proto.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#define REMUX_READER_STREAMS	8
+#define REMUX_TS_PACKETS		348 // 348 * 188 = 65424 bytes per read
+#define REMUX_PS_BLOCK			(64 * 1024)
+
+// MPEG-2 TS/PS: AnnexB/ADTS bitstream, 90kHz timestamp
+// streams are added on PMT/PSM(ts_demuxer_set_notify/ps_demuxer_set_notify), or on the first PES
+struct remux_reader_mpeg_t
+{
+	struct remux_reader_t base;
+	struct remux_buffer_t io; // user input buffer
+	void* param;
+
+	struct ts_demuxer_t* ts;
+	struct ps_demuxer_t* ps;
+	struct
+	{
+		int pid; // TS PID/PS stream id
+		int stream; // remux stream, <0-unsupported
+	} streams[REMUX_READER_STREAMS];
+	int count;
+	int eof;
+
+	// read block buffer, reused by all reads
+	uint8_t* ptr;
+	size_t capacity;
+	size_t bytes; // PS remain data
+};
+
+static int remux_reader_mpeg_find(struct remux_reader_mpeg_t* r, int pid, int codecid)
+{
+	int i;
+	const struct remux_codec_t* codec;
+	struct remux_stream_t stream;
+
+	for (i = 0; i < r->count; i++)
+	{
+		if (r->streams[i].pid == pid)
+			return r->streams[i].stream;
+	}
+
+	if (r->count >= REMUX_READER_STREAMS)
+		return -1;
+
+	codec = remux_codec_find_by_mpeg2(codecid);
+	memset(&stream, 0, sizeof(stream));
+	stream.object = codec ? codec->object : 0;
+	stream.bitstream = REMUX_BITSTREAM_ANNEXB; // width/height/sample rate is derived from the bitstream
+	r->streams[r->count].pid = pid;
+	r->streams[r->count].stream = codec ? remux_add_stream(r->base.remux, &stream) : -1;
+	return r->streams[r->count++].stream;
+}
+
+static void remux_reader_mpeg_onstream(void* param, int stream, int codecid, const void* extra, int bytes, int finish)
+{
+	struct remux_reader_mpeg_t* r = (struct remux_reader_mpeg_t*)param;
+	(void)extra, (void)bytes;
+	remux_reader_mpeg_find(r, stream, codecid);
+	if (finish)
+		remux_set_probe(r->base.remux, 0); // PMT/PSM: stream list is known
+}
+
+static int remux_reader_mpeg_input(struct remux_reader_mpeg_t* r, int pid, int codecid, int flags, int64_t pts, int64_t dts, const void* data, size_t bytes)
+{
+	struct remux_packet_t pkt;
+	pkt.stream = remux_reader_mpeg_find(r, pid, codecid);
+	if (pkt.stream < 0)
+		return 0; // unsupported codec
+
+	pkt.flags = (flags & MPEG_FLAG_IDR_FRAME) ? REMUX_FLAG_KEYFRAME : 0;
+	pkt.pts = pts / 90;
+	pkt.dts = dts / 90;
+	pkt.data = data;
+	pkt.bytes = bytes;
+	return remux_input(r->base.remux, &pkt);
+}
+
+static int remux_reader_ts_onpacket(void* param, int program, int stream, int codecid, int flags, int64_t pts, int64_t dts, const void* data, size_t bytes)
+{
+	(void)program;
+	return remux_reader_mpeg_input((struct remux_reader_mpeg_t*)param, stream, codecid, flags, pts, dts, data, bytes);
+}
+
+static int remux_reader_ps_onpacket(void* param, int stream, int codecid, int flags, int64_t pts, int64_t dts, const void* data, size_t bytes)
+{
+	return remux_reader_mpeg_input((struct remux_reader_mpeg_t*)param, stream, codecid, flags, pts, dts, data, bytes);
+}
+
+// fill read buffer from r->bytes, @return >0-buffer bytes, 0-end of file, <0-error
+static int remux_reader_mpeg_fill(struct remux_reader_mpeg_t* r)
+{
+	int n;
+	while (r->bytes < r->capacity && !r->eof)
+	{
+		n = r->io.read(r->param, r->ptr + r->bytes, r->capacity - r->bytes);
+		if (n < 0)
+			return n;
+		r->eof = 0 == n ? 1 : 0;
+		r->bytes += n;
+	}
+	return (int)r->bytes;
+}
+
+static int remux_reader_ts_read(struct remux_reader_t* reader)
+{
+	int r;
+	size_t i;
+	struct remux_reader_mpeg_t* ts = (struct remux_reader_mpeg_t*)reader;
+
+	r = remux_reader_mpeg_fill(ts);
+	if (r < 188)
+		return r < 0 ? r : ts_demuxer_flush(ts->ts); // drop incomplete packet, 0-EOF
+
+	for (r = 0, i = 0; i + 188 <= ts->bytes && 0 == r; i += 188)
+		r = ts_demuxer_input(ts->ts, ts->ptr + i, 188);
+
+	memmove(ts->ptr, ts->ptr + i, ts->bytes - i);
+	ts->bytes -= i;
+	return 0 == r ? 1 : r;
+}
+
+static int remux_reader_ps_read(struct remux_reader_t* reader)
+{
+	int r;
+	struct remux_reader_mpeg_t* ps = (struct remux_reader_mpeg_t*)reader;
+
+	r = remux_reader_mpeg_fill(ps);
+	if (r <= 0)
+		return r;
+
+	// the remain data MUST save and merge with next block
+	r = ps_demuxer_input(ps->ps, ps->ptr, ps->bytes);
+	if (r < 0)
+		return r;
+	if (0 == r && ps->eof)
+		return 0; // incomplete pack at end of file
+
+	memmove(ps->ptr, ps->ptr + r, ps->bytes - r);
+	ps->bytes -= r;
+	return 1;
+}
+
+static void remux_reader_mpeg_destroy(struct remux_reader_t* reader)
+{
+	struct remux_reader_mpeg_t* r = (struct remux_reader_mpeg_t*)reader;
+	if (r->ts)
+		ts_demuxer_destroy(r->ts);
+	if (r->ps)
+		ps_demuxer_destroy(r->ps);
+	free(r->ptr);
+	free(r);
+}
+
+static struct remux_reader_mpeg_t* remux_reader_mpeg_create(remux_t* remux, const struct remux_buffer_t* buffer, void* param, size_t block)
+{
+	struct remux_reader_mpeg_t* r;
+	r = (struct remux_reader_mpeg_t*)calloc(1, sizeof(*r));
+	if (!r)
+		return NULL;
+
+	memcpy(&r->io, buffer, sizeof(r->io));
+	r->param = param;
+	r->base.remux = remux;
+	r->base.destroy = remux_reader_mpeg_destroy;
+	if (0 != remux_reserve(remux, &r->ptr, &r->capacity, block))
+	{
+		free(r);
+		return NULL;
+	}
+
+	// wait PMT/PSM or probe duration
+	remux_set_probe(remux, 1);
+	return r;
+}
+
+struct remux_reader_t* remux_reader_ts_create(remux_t* remux, const struct remux_buffer_t* buffer, void* param)
+{
+	struct remux_reader_mpeg_t* r;
+	struct ts_demuxer_notify_t notify = { remux_reader_mpeg_onstream };
+
+	r = remux_reader_mpeg_create(remux, buffer, param, REMUX_TS_PACKETS * 188);
+	if (!r)
+		return NULL;
+
+	r->base.read = remux_reader_ts_read;
+	r->ts = ts_demuxer_create(remux_reader_ts_onpacket, r);
+	if (!r->ts)
+	{
+		remux_reader_mpeg_destroy(&r->base);
+		return NULL;
+	}
+	ts_demuxer_set_notify(r->ts, &notify, r);
+	return &r->base;
+}
+
+struct remux_reader_t* remux_reader_ps_create(remux_t* remux, const struct remux_buffer_t* buffer, void* param)
+{
+	struct remux_reader_mpeg_t* r;
+	struct ps_demuxer_notify_t notify = { remux_reader_mpeg_onstream };
+
+	r = remux_reader_mpeg_create(remux, buffer, param, REMUX_PS_BLOCK);
+	if (!r)
+		return NULL;
+
+	r->base.read = remux_reader_ps_read;
+	r->ps = ps_demuxer_create(remux_reader_ps_onpacket, r);
+	if (!r->ps)
+	{
+		remux_reader_mpeg_destroy(&r->base);
+		return NULL;
+	}
+	ps_demuxer_set_notify(r->ps, &notify, r);
+	return &r->base;
+}
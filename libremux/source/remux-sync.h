@@ -0,0 +1,83 @@
+#ifndef _remux_sync_h_
+#define _remux_sync_h_
+
+// seq_cst atomics, locker/event/thread shared by media-fanout/media-gop-cache/remux-batch
+#if defined(_MSC_VER)
+#include <windows.h>
+typedef HANDLE remux_thread_t;
+typedef CRITICAL_SECTION remux_locker_t;
+typedef CONDITION_VARIABLE remux_event_t;
+#define REMUX_THREAD_API		DWORD WINAPI
+#define REMUX_THREAD_EXIT		0
+#define thread_create(t, proc, param) ((*(t) = CreateThread(NULL, 0, proc, param, 0, NULL)) ? 0 : -1)
+#define thread_join(t)			(WaitForSingleObject(t, INFINITE), CloseHandle(t))
+#define locker_create(l)		InitializeCriticalSection(l)
+#define locker_destroy(l)		DeleteCriticalSection(l)
+#define locker_lock(l)			EnterCriticalSection(l)
+#define locker_unlock(l)		LeaveCriticalSection(l)
+#define event_create(e)			InitializeConditionVariable(e)
+#define event_destroy(e)		(void)(e)
+#define event_signal(e)			WakeConditionVariable(e)
+
+#define atomic_load32(p)		InterlockedCompareExchange((volatile LONG*)(p), 0, 0)
+#define atomic_load64(p)		InterlockedCompareExchange64((volatile LONG64*)(p), 0, 0)
+#define atomic_store32(p, v)	InterlockedExchange((volatile LONG*)(p), (LONG)(v))
+#define atomic_store64(p, v)	InterlockedExchange64((volatile LONG64*)(p), (LONG64)(v))
+#define atomic_loadptr(p)		InterlockedCompareExchangePointer((PVOID volatile*)(p), NULL, NULL)
+#define atomic_storeptr(p, v)	InterlockedExchangePointer((PVOID volatile*)(p), (PVOID)(v))
+#define atomic_add32(p, v)		(InterlockedExchangeAdd((volatile LONG*)(p), (LONG)(v)) + (v))
+#define atomic_add64(p, v)		(InterlockedExchangeAdd64((volatile LONG64*)(p), (LONG64)(v)) + (v))
+#define atomic_cas32(p, o, n)	((LONG)(o) == InterlockedCompareExchange((volatile LONG*)(p), (LONG)(n), (LONG)(o)))
+#else
+#include <time.h>
+#include <pthread.h>
+typedef pthread_t remux_thread_t;
+typedef pthread_mutex_t remux_locker_t;
+typedef pthread_cond_t remux_event_t;
+#define REMUX_THREAD_API		void*
+#define REMUX_THREAD_EXIT		NULL
+#define thread_create(t, proc, param) pthread_create(t, NULL, proc, param)
+#define thread_join(t)			pthread_join(t, NULL)
+#define locker_create(l)		pthread_mutex_init(l, NULL)
+#define locker_destroy(l)		pthread_mutex_destroy(l)
+#define locker_lock(l)			pthread_mutex_lock(l)
+#define locker_unlock(l)		pthread_mutex_unlock(l)
+#define event_create(e)			pthread_cond_init(e, NULL)
+#define event_destroy(e)		pthread_cond_destroy(e)
+#define event_signal(e)			pthread_cond_signal(e)
+
+#define atomic_load32(p)		__atomic_load_n(p, __ATOMIC_SEQ_CST)
+#define atomic_load64(p)		__atomic_load_n(p, __ATOMIC_SEQ_CST)
+#define atomic_store32(p, v)	__atomic_store_n(p, v, __ATOMIC_SEQ_CST)
+#define atomic_store64(p, v)	__atomic_store_n(p, v, __ATOMIC_SEQ_CST)
+#define atomic_loadptr(p)		__atomic_load_n(p, __ATOMIC_SEQ_CST)
+#define atomic_storeptr(p, v)	__atomic_store_n(p, v, __ATOMIC_SEQ_CST)
+#define atomic_add32(p, v)		__atomic_add_fetch(p, v, __ATOMIC_SEQ_CST)
+#define atomic_add64(p, v)		__atomic_add_fetch(p, v, __ATOMIC_SEQ_CST)
+#define atomic_cas32(p, o, n)	__extension__({ int32_t o_ = (o); __atomic_compare_exchange_n(p, &o_, n, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST); })
+#endif
+
+/// wait event with locker held
+/// @param[in] ms timeout in ms, <=0-infinite
+static inline void event_timewait(remux_event_t* e, remux_locker_t* l, int ms)
+{
+#if defined(_MSC_VER)
+	SleepConditionVariableCS(e, l, ms > 0 ? (DWORD)ms : INFINITE);
+#else
+	struct timespec ts;
+	if (ms <= 0)
+	{
+		pthread_cond_wait(e, l);
+		return;
+	}
+
+	clock_gettime(CLOCK_REALTIME, &ts);
+	ts.tv_sec += ms / 1000;
+	ts.tv_nsec += (ms % 1000) * 1000000L;
+	ts.tv_sec += ts.tv_nsec / 1000000000L;
+	ts.tv_nsec %= 1000000000L;
+	pthread_cond_timedwait(e, l, &ts);
+#endif
+}
+
+#endif /* !_remux_sync_h_ */
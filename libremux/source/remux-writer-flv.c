@@ -0,0 +1,160 @@
+#include "remux-internal.h"
+#include "flv-writer.h"
+#include "flv-header.h"
+#include "flv-proto.h"
+#include "mov-format.h"
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+
+// FLV tag body = AudioTagHeader/VideoTagHeader + MP4 bitstream(AVCC NALU, raw AAC),
+// tag is written by flv_writer_input_v without payload copy.
+// flv_muxer isn't used: flv_muxer_avc/flv_muxer_aac input is AnnexB/ADTS(round trip conversion).
+struct remux_writer_flv_t
+{
+	struct remux_writer_t base;
+	const struct remux_buffer_t* io;
+	void* param;
+
+	void* flv;
+	struct
+	{
+		int codec; // FLV_VIDEO_XXX/FLV_AUDIO_XXX, 0-don't have
+		struct flv_audio_tag_header_t audio;
+		uint8_t* extra; // sequence header
+		size_t bytes;
+	} tracks[2]; // 0-video, 1-audio
+};
+
+static int remux_writer_flv_onwrite(void* param, const struct flv_vec_t* vec, int n)
+{
+	int i, r;
+	struct remux_writer_flv_t* w = (struct remux_writer_flv_t*)param;
+	for (r = i = 0; i < n && 0 == r; i++)
+		r = w->io->write(w->param, vec[i].ptr, vec[i].len);
+	return r;
+}
+
+// FLV SoundRate: 0-5.5kHz, 1-11kHz, 2-22kHz, 3-44kHz
+static uint8_t remux_writer_flv_rate(int sample_rate)
+{
+	return sample_rate >= 44100 ? 3 : (sample_rate >= 22050 ? 2 : (sample_rate >= 11025 ? 1 : 0));
+}
+
+static int remux_writer_flv_add_stream(struct remux_writer_t* writer, const struct remux_stream_t* stream)
+{
+	int track;
+	const struct remux_codec_t* codec;
+	struct remux_writer_flv_t* w = (struct remux_writer_flv_t*)writer;
+
+	// legacy FLV codec only(no enhanced-rtmp FourCC)
+	codec = remux_codec_find_by_mov(stream->object);
+	if (!codec || (FLV_VIDEO_H264 != codec->flv && FLV_VIDEO_H265 != codec->flv && FLV_AUDIO_AAC != codec->flv
+		&& FLV_AUDIO_MP3 != codec->flv && FLV_AUDIO_G711A != codec->flv && FLV_AUDIO_G711U != codec->flv))
+		return -ENOTSUP;
+
+	track = codec->video ? 0 : 1;
+	if (w->tracks[track].codec)
+		return -ENOTSUP; // one audio and one video track only
+
+	if (stream->extra && stream->bytes > 0)
+	{
+		w->tracks[track].extra = (uint8_t*)malloc(stream->bytes);
+		if (!w->tracks[track].extra)
+			return -ENOMEM;
+		memcpy(w->tracks[track].extra, stream->extra, stream->bytes);
+		w->tracks[track].bytes = stream->bytes;
+	}
+
+	w->tracks[track].codec = codec->flv;
+	w->tracks[track].audio.codecid = (uint8_t)codec->flv;
+	w->tracks[track].audio.rate = FLV_AUDIO_AAC == codec->flv ? 3 : remux_writer_flv_rate(stream->sample_rate);
+	w->tracks[track].audio.bits = 1; // 16-bit samples
+	w->tracks[track].audio.channels = stream->channels > 1 || FLV_AUDIO_AAC == codec->flv ? 1 : 0;
+	return track;
+}
+
+static int remux_writer_flv_tag(struct remux_writer_flv_t* w, int track, int avpacket, int keyframe, const void* data, size_t bytes, int64_t pts, int64_t dts)
+{
+	int n;
+	uint8_t header[16];
+	struct flv_vec_t vec[2];
+	struct flv_video_tag_header_t video;
+
+	if (0 == track)
+	{
+		memset(&video, 0, sizeof(video));
+		video.codecid = (uint8_t)w->tracks[0].codec;
+		video.keyframe = keyframe ? FLV_VIDEO_KEY_FRAME : FLV_VIDEO_INTER_FRAME;
+		video.avpacket = (uint8_t)avpacket;
+		video.cts = (int32_t)(pts - dts);
+		n = flv_video_tag_header_write(&video, header, sizeof(header));
+	}
+	else
+	{
+		w->tracks[1].audio.avpacket = (uint8_t)avpacket;
+		n = flv_audio_tag_header_write(&w->tracks[1].audio, header, sizeof(header));
+	}
+
+	if (n < 0)
+		return -EINVAL;
+
+	vec[0].ptr = header;
+	vec[0].len = n;
+	vec[1].ptr = (void*)data;
+	vec[1].len = (int)bytes;
+	return flv_writer_input_v(w->flv, 0 == track ? FLV_TYPE_VIDEO : FLV_TYPE_AUDIO, vec, 2, (uint32_t)dts);
+}
+
+static int remux_writer_flv_start(struct remux_writer_t* writer)
+{
+	int i, r;
+	struct remux_writer_flv_t* w = (struct remux_writer_flv_t*)writer;
+
+	w->flv = flv_writer_create2(w->tracks[1].codec ? 1 : 0, w->tracks[0].codec ? 1 : 0, remux_writer_flv_onwrite, w);
+	if (!w->flv)
+		return -ENOMEM;
+
+	// AVCDecoderConfigurationRecord/HEVCDecoderConfigurationRecord/AudioSpecificConfig
+	for (r = i = 0; i < 2 && 0 == r; i++)
+	{
+		if (w->tracks[i].codec && w->tracks[i].bytes > 0 && (0 == i || FLV_AUDIO_AAC == w->tracks[i].codec))
+			r = remux_writer_flv_tag(w, i, FLV_SEQUENCE_HEADER, 1, w->tracks[i].extra, w->tracks[i].bytes, 0, 0);
+	}
+	return r;
+}
+
+static int remux_writer_flv_write(struct remux_writer_t* writer, const struct remux_packet_t* pkt)
+{
+	struct remux_writer_flv_t* w = (struct remux_writer_flv_t*)writer;
+	assert(0 == pkt->stream || 1 == pkt->stream);
+	return remux_writer_flv_tag(w, pkt->stream, FLV_AVPACKET, pkt->flags & REMUX_FLAG_KEYFRAME, pkt->data, pkt->bytes, pkt->pts, pkt->dts);
+}
+
+static void remux_writer_flv_destroy(struct remux_writer_t* writer)
+{
+	struct remux_writer_flv_t* w = (struct remux_writer_flv_t*)writer;
+	if (w->flv)
+		flv_writer_destroy(w->flv);
+	free(w->tracks[0].extra);
+	free(w->tracks[1].extra);
+	free(w);
+}
+
+struct remux_writer_t* remux_writer_flv_create(const struct remux_buffer_t* buffer, void* param)
+{
+	struct remux_writer_flv_t* w;
+	w = (struct remux_writer_flv_t*)calloc(1, sizeof(*w));
+	if (!w)
+		return NULL;
+
+	w->io = buffer;
+	w->param = param;
+	w->base.bitstream = REMUX_BITSTREAM_MP4;
+	w->base.add_stream = remux_writer_flv_add_stream;
+	w->base.start = remux_writer_flv_start;
+	w->base.write = remux_writer_flv_write;
+	w->base.destroy = remux_writer_flv_destroy;
+	return &w->base;
+}
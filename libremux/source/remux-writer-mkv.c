@@ -0,0 +1,89 @@
+#include "remux-internal.h"
+#include "mkv-writer.h"
+#include "mkv-format.h"
+#include <stdlib.h>
+#include <errno.h>
+
+struct remux_writer_mkv_t
+{
+	struct remux_writer_t base;
+	const struct remux_buffer_t* io;
+	void* param;
+
+	mkv_writer_t* mkv;
+};
+
+static int remux_writer_mkv_read(void* param, void* data, uint64_t bytes)
+{
+	struct remux_writer_mkv_t* w = (struct remux_writer_mkv_t*)param;
+	return remux_buffer_read(w->io, w->param, data, bytes);
+}
+
+static int remux_writer_mkv_write(void* param, const void* data, uint64_t bytes)
+{
+	struct remux_writer_mkv_t* w = (struct remux_writer_mkv_t*)param;
+	return w->io->write(w->param, data, bytes);
+}
+
+static int remux_writer_mkv_seek(void* param, int64_t offset)
+{
+	struct remux_writer_mkv_t* w = (struct remux_writer_mkv_t*)param;
+	return w->io->seek(w->param, offset);
+}
+
+static int64_t remux_writer_mkv_tell(void* param)
+{
+	struct remux_writer_mkv_t* w = (struct remux_writer_mkv_t*)param;
+	return w->io->tell(w->param);
+}
+
+static const struct mkv_buffer_t s_buffer = { remux_writer_mkv_read, remux_writer_mkv_write, remux_writer_mkv_seek, remux_writer_mkv_tell };
+
+static int remux_writer_mkv_add_stream(struct remux_writer_t* writer, const struct remux_stream_t* stream)
+{
+	const struct remux_codec_t* codec;
+	struct remux_writer_mkv_t* w = (struct remux_writer_mkv_t*)writer;
+
+	codec = remux_codec_find_by_mov(stream->object);
+	if (!codec || MKV_CODEC_UNKNOWN == codec->mkv)
+		return -ENOTSUP;
+
+	return codec->video ? mkv_writer_add_video(w->mkv, (enum mkv_codec_t)codec->mkv, stream->width, stream->height, stream->extra, stream->bytes)
+		: mkv_writer_add_audio(w->mkv, (enum mkv_codec_t)codec->mkv, stream->channels, stream->bits_per_sample, stream->sample_rate, stream->extra, stream->bytes);
+}
+
+static int remux_writer_mkv_write_packet(struct remux_writer_t* writer, const struct remux_packet_t* pkt)
+{
+	struct remux_writer_mkv_t* w = (struct remux_writer_mkv_t*)writer;
+	return mkv_writer_write(w->mkv, pkt->stream, pkt->data, pkt->bytes, pkt->pts, pkt->dts, (pkt->flags & REMUX_FLAG_KEYFRAME) ? MKV_FLAGS_KEYFRAME : 0);
+}
+
+static void remux_writer_mkv_destroy(struct remux_writer_t* writer)
+{
+	struct remux_writer_mkv_t* w = (struct remux_writer_mkv_t*)writer;
+	mkv_writer_destroy(w->mkv);
+	free(w);
+}
+
+struct remux_writer_t* remux_writer_mkv_create(const struct remux_buffer_t* buffer, void* param)
+{
+	struct remux_writer_mkv_t* w;
+	w = (struct remux_writer_mkv_t*)calloc(1, sizeof(*w));
+	if (!w)
+		return NULL;
+
+	w->io = buffer;
+	w->param = param;
+	w->base.bitstream = REMUX_BITSTREAM_MP4;
+	w->base.add_stream = remux_writer_mkv_add_stream;
+	w->base.write = remux_writer_mkv_write_packet;
+	w->base.destroy = remux_writer_mkv_destroy;
+
+	w->mkv = mkv_writer_create(&s_buffer, w, 0);
+	if (!w->mkv)
+	{
+		free(w);
+		return NULL;
+	}
+	return &w->base;
+}
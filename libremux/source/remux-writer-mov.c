@@ -0,0 +1,108 @@
+#include "remux-internal.h"
+#include "mov-writer.h"
+#include "fmp4-writer.h"
+#include "mov-format.h"
+#include <stdlib.h>
+#include <errno.h>
+
+struct remux_writer_mov_t
+{
+	struct remux_writer_t base;
+	const struct remux_buffer_t* io;
+	void* param;
+
+	mov_writer_t* mov;
+	fmp4_writer_t* fmp4;
+};
+
+static int remux_writer_mov_read(void* param, void* data, uint64_t bytes)
+{
+	struct remux_writer_mov_t* w = (struct remux_writer_mov_t*)param;
+	return remux_buffer_read(w->io, w->param, data, bytes);
+}
+
+static int remux_writer_mov_write(void* param, const void* data, uint64_t bytes)
+{
+	struct remux_writer_mov_t* w = (struct remux_writer_mov_t*)param;
+	return w->io->write(w->param, data, bytes);
+}
+
+static int remux_writer_mov_seek(void* param, int64_t offset)
+{
+	struct remux_writer_mov_t* w = (struct remux_writer_mov_t*)param;
+	return w->io->seek(w->param, offset);
+}
+
+static int64_t remux_writer_mov_tell(void* param)
+{
+	struct remux_writer_mov_t* w = (struct remux_writer_mov_t*)param;
+	return w->io->tell(w->param);
+}
+
+static const struct mov_buffer_t s_buffer = { remux_writer_mov_read, remux_writer_mov_write, remux_writer_mov_seek, remux_writer_mov_tell };
+
+static int remux_writer_mov_add_stream(struct remux_writer_t* writer, const struct remux_stream_t* stream)
+{
+	const struct remux_codec_t* codec;
+	struct remux_writer_mov_t* w = (struct remux_writer_mov_t*)writer;
+
+	codec = remux_codec_find_by_mov(stream->object);
+	if (!codec)
+		return -ENOTSUP;
+
+	if (w->fmp4)
+		return codec->video ? fmp4_writer_add_video(w->fmp4, stream->object, stream->width, stream->height, stream->extra, stream->bytes)
+			: fmp4_writer_add_audio(w->fmp4, stream->object, stream->channels, stream->bits_per_sample, stream->sample_rate, stream->extra, stream->bytes);
+
+	return codec->video ? mov_writer_add_video(w->mov, stream->object, stream->width, stream->height, stream->extra, stream->bytes)
+		: mov_writer_add_audio(w->mov, stream->object, stream->channels, stream->bits_per_sample, stream->sample_rate, stream->extra, stream->bytes);
+}
+
+static int remux_writer_mov_write_packet(struct remux_writer_t* writer, const struct remux_packet_t* pkt)
+{
+	int flags;
+	struct remux_writer_mov_t* w = (struct remux_writer_mov_t*)writer;
+
+	flags = (pkt->flags & REMUX_FLAG_KEYFRAME) ? MOV_AV_FLAG_KEYFREAME : 0;
+	if (w->fmp4)
+		return fmp4_writer_write(w->fmp4, pkt->stream, pkt->data, pkt->bytes, pkt->pts, pkt->dts, flags);
+	return mov_writer_write(w->mov, pkt->stream, pkt->data, pkt->bytes, pkt->pts, pkt->dts, flags);
+}
+
+static void remux_writer_mov_destroy(struct remux_writer_t* writer)
+{
+	struct remux_writer_mov_t* w = (struct remux_writer_mov_t*)writer;
+	if (w->fmp4)
+		fmp4_writer_destroy(w->fmp4);
+	if (w->mov)
+		mov_writer_destroy(w->mov);
+	free(w);
+}
+
+struct remux_writer_t* remux_writer_mov_create(const struct remux_buffer_t* buffer, void* param, int fmp4)
+{
+	struct remux_writer_mov_t* w;
+	w = (struct remux_writer_mov_t*)calloc(1, sizeof(*w));
+	if (!w)
+		return NULL;
+
+	w->io = buffer;
+	w->param = param;
+	w->base.bitstream = REMUX_BITSTREAM_MP4;
+	w->base.add_stream = remux_writer_mov_add_stream;
+	w->base.write = remux_writer_mov_write_packet;
+	w->base.destroy = remux_writer_mov_destroy;
+
+	// moov at the end of file: no mdat move(MOV_FLAG_FASTSTART), output is written sequentially
+	if (fmp4)
+		w->fmp4 = fmp4_writer_create(&s_buffer, w, 0);
+	else
+		w->mov = mov_writer_create(&s_buffer, w, 0);
+
+	if (!w->fmp4 && !w->mov)
+	{
+		free(w);
+		return NULL;
+	}
+	return &w->base;
+}
@@ -0,0 +1,136 @@
+#include "remux-internal.h"
+#include "mpeg-ts.h"
+#include "mpeg-ps.h"
+#include "mpeg-proto.h"
+#include <stdlib.h>
+#include <errno.h>
+
+#define REMUX_TS_PACKETS 348 // 348 * 188 = 65424 bytes per write
+
+// MPEG-2 TS/PS: AnnexB/ADTS bitstream, 90kHz timestamp
+struct remux_writer_mpeg_t
+{
+	struct remux_writer_t base;
+	const struct remux_buffer_t* io;
+	void* param;
+
+	void* ts;
+	struct ps_muxer_t* ps;
+
+	uint8_t* ptr; // TS batch buffer/PS packet
+	size_t capacity;
+};
+
+static void* remux_writer_mpeg_alloc(void* param, size_t bytes)
+{
+	struct remux_writer_mpeg_t* w = (struct remux_writer_mpeg_t*)param;
+	return 0 == remux_alloc(&w->ptr, &w->capacity, bytes) ? w->ptr : NULL;
+}
+
+static void remux_writer_mpeg_free(void* param, void* packet)
+{
+	(void)param, (void)packet; // reuse packet buffer
+}
+
+static int remux_writer_ts_onwrite(void* param, const void* packet, size_t bytes)
+{
+	struct remux_writer_mpeg_t* w = (struct remux_writer_mpeg_t*)param;
+	return w->io->write(w->param, packet, bytes);
+}
+
+static int remux_writer_ps_onwrite(void* param, int stream, void* packet, size_t bytes)
+{
+	struct remux_writer_mpeg_t* w = (struct remux_writer_mpeg_t*)param;
+	(void)stream;
+	return w->io->write(w->param, packet, bytes);
+}
+
+static int remux_writer_mpeg_add_stream(struct remux_writer_t* writer, const struct remux_stream_t* stream)
+{
+	const struct remux_codec_t* codec;
+	struct remux_writer_mpeg_t* w = (struct remux_writer_mpeg_t*)writer;
+
+	codec = remux_codec_find_by_mov(stream->object);
+	if (!codec || 0 == codec->mpeg2)
+		return -ENOTSUP;
+
+	// H.26x SPS/PPS and AAC ADTS header are in-band
+	return w->ts ? mpeg_ts_add_stream(w->ts, codec->mpeg2, NULL, 0) : ps_muxer_add_stream(w->ps, codec->mpeg2, NULL, 0);
+}
+
+static int remux_writer_mpeg_write(struct remux_writer_t* writer, const struct remux_packet_t* pkt)
+{
+	int flags;
+	struct remux_writer_mpeg_t* w = (struct remux_writer_mpeg_t*)writer;
+
+	flags = (pkt->flags & REMUX_FLAG_KEYFRAME) ? MPEG_FLAG_IDR_FRAME : 0;
+	if (w->ts)
+		return mpeg_ts_write(w->ts, pkt->stream, flags, pkt->pts * 90, pkt->dts * 90, pkt->data, pkt->bytes);
+	return ps_muxer_input(w->ps, pkt->stream, flags, pkt->pts * 90, pkt->dts * 90, pkt->data, pkt->bytes);
+}
+
+static void remux_writer_mpeg_destroy(struct remux_writer_t* writer)
+{
+	struct remux_writer_mpeg_t* w = (struct remux_writer_mpeg_t*)writer;
+	if (w->ts)
+		mpeg_ts_destroy(w->ts);
+	if (w->ps)
+		ps_muxer_destroy(w->ps);
+	free(w->ptr);
+	free(w);
+}
+
+static struct remux_writer_mpeg_t* remux_writer_mpeg_create(const struct remux_buffer_t* buffer, void* param)
+{
+	struct remux_writer_mpeg_t* w;
+	w = (struct remux_writer_mpeg_t*)calloc(1, sizeof(*w));
+	if (!w)
+		return NULL;
+
+	w->io = buffer;
+	w->param = param;
+	w->base.bitstream = REMUX_BITSTREAM_ANNEXB;
+	w->base.add_stream = remux_writer_mpeg_add_stream;
+	w->base.write = remux_writer_mpeg_write;
+	w->base.destroy = remux_writer_mpeg_destroy;
+	return w;
+}
+
+struct remux_writer_t* remux_writer_ts_create(const struct remux_buffer_t* buffer, void* param)
+{
+	struct remux_writer_mpeg_t* w;
+	struct mpeg_ts_func_t func = { remux_writer_mpeg_alloc, remux_writer_mpeg_free, remux_writer_ts_onwrite };
+
+	w = remux_writer_mpeg_create(buffer, param);
+	if (!w)
+		return NULL;
+
+	w->ts = mpeg_ts_create(&func, w);
+	if (!w->ts || 0 != remux_alloc(&w->ptr, &w->capacity, REMUX_TS_PACKETS * 188))
+	{
+		remux_writer_mpeg_destroy(&w->base);
+		return NULL;
+	}
+
+	// TS packets are built in place, one write per access unit
+	mpeg_ts_set_buffer(w->ts, w->ptr, w->capacity, 0);
+	return &w->base;
+}
+
+struct remux_writer_t* remux_writer_ps_create(const struct remux_buffer_t* buffer, void* param)
+{
+	struct remux_writer_mpeg_t* w;
+	struct ps_muxer_func_t func = { remux_writer_mpeg_alloc, remux_writer_mpeg_free, remux_writer_ps_onwrite };
+
+	w = remux_writer_mpeg_create(buffer, param);
+	if (!w)
+		return NULL;
+
+	w->ps = ps_muxer_create(&func, w);
+	if (!w->ps)
+	{
+		remux_writer_mpeg_destroy(&w->base);
+		return NULL;
+	}
+	return &w->base;
+}
@@ -0,0 +1,963 @@
+#include "remux-internal.h"
+#include "mov-format.h"
+#include "mpeg4-avc.h"
+#include "mpeg4-hevc.h"
+#include "mpeg4-vvc.h"
+#include "mpeg4-aac.h"
+#include "aom-av1.h"
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+
+#define REMUX_STREAM_MAX		8
+#define REMUX_PROBE_PACKETS		1024
+#define REMUX_PROBE_BYTES		(16 * 1024 * 1024)
+#define REMUX_PROBE_DURATION	1000 // ms, stream list probe(FLV/TS/PS)
+#define REMUX_CONFIG_BYTES		(4 * 1024) // max in-band SPS/PPS/VPS(mpeg4_avc_t/mpeg4_hevc_t data)
+
+enum
+{
+	REMUX_PATH_PASSTHROUGH = 0,
+	REMUX_PATH_MP4_TO_ANNEXB,	// length-prefixed NALU => start code + NALU(+ SPS/PPS before IDR)
+	REMUX_PATH_ANNEXB_TO_MP4,	// start code + NALU => length-prefixed NALU
+	REMUX_PATH_AAC_TO_ADTS,		// raw AAC => ADTS header + raw AAC
+	REMUX_PATH_ADTS_TO_AAC,		// ADTS frames => raw AAC frames
+};
+
+struct remux_track_t
+{
+	struct remux_stream_t info; // info.extra => extra
+	uint8_t* extra;
+	size_t capacity;
+
+	int track; // writer track, <0-not added or dropped
+	int path; // REMUX_PATH_XXX
+	int ready; // decoder configuration available(or not needed by writer)
+
+	union
+	{
+		struct mpeg4_avc_t avc;
+		struct mpeg4_hevc_t hevc;
+		struct mpeg4_vvc_t vvc;
+	} *v; // H.26x conversion only
+	struct mpeg4_aac_t aac;
+};
+
+struct remux_probe_t
+{
+	struct remux_packet_t pkt; // pkt.data is invalid, see offset
+	size_t offset; // probe_data offset
+};
+
+struct remux_t
+{
+	struct remux_writer_t* writer;
+	struct remux_buffer_t io; // user output buffer
+	void* param;
+
+	struct remux_track_t streams[REMUX_STREAM_MAX];
+	int count;
+	int probe; // stream list unknown
+	int started; // writer tracks added
+	int flushed;
+
+	// probe queue
+	struct remux_probe_t* probes;
+	size_t nprobe;
+	size_t nprobe_capacity;
+	uint8_t* probe_data;
+	size_t probe_bytes;
+	size_t probe_capacity;
+
+	// bitstream conversion buffer, reused by all packets
+	uint8_t* ptr;
+	size_t capacity;
+
+	size_t limit; // memory limit, 0-unlimited
+	size_t memory; // remux_reserve buffer bytes
+
+	struct remux_stats_t stats;
+};
+
+static int remux_io_read(void* param, void* data, uint64_t bytes)
+{
+	struct remux_t* remux = (struct remux_t*)param;
+	return remux->io.read ? remux->io.read(remux->param, data, bytes) : -ENOSYS;
+}
+
+static int remux_io_write(void* param, const void* data, uint64_t bytes)
+{
+	struct remux_t* remux = (struct remux_t*)param;
+	remux->stats.bytes_out += bytes;
+	return remux->io.write(remux->param, data, bytes);
+}
+
+static int remux_io_seek(void* param, int64_t offset)
+{
+	struct remux_t* remux = (struct remux_t*)param;
+	return remux->io.seek ? remux->io.seek(remux->param, offset) : -ENOSYS;
+}
+
+static int64_t remux_io_tell(void* param)
+{
+	struct remux_t* remux = (struct remux_t*)param;
+	return remux->io.tell ? remux->io.tell(remux->param) : -ENOSYS;
+}
+
+// count output bytes
+static const struct remux_buffer_t s_io = { remux_io_read, remux_io_write, remux_io_seek, remux_io_tell };
+
+int remux_buffer_read(const struct remux_buffer_t* buffer, void* param, void* data, uint64_t bytes)
+{
+	int r;
+	while (bytes > 0)
+	{
+		r = buffer->read(param, data, bytes);
+		if (r <= 0)
+			return 0 == r ? -1 : r; // EOF
+		data = (uint8_t*)data + r;
+		bytes -= r;
+	}
+	return 0;
+}
+
+int remux_alloc(uint8_t** ptr, size_t* capacity, size_t bytes)
+{
+	void* p;
+	if (*capacity >= bytes)
+		return 0;
+
+	bytes = bytes > *capacity * 2 ? bytes : *capacity * 2;
+	p = realloc(*ptr, bytes);
+	if (!p)
+		return -ENOMEM;
+	*ptr = (uint8_t*)p;
+	*capacity = bytes;
+	return 0;
+}
+
+int remux_reserve(remux_t* remux, uint8_t** ptr, size_t* capacity, size_t bytes)
+{
+	void* p;
+	size_t n;
+	if (*capacity >= bytes)
+		return 0;
+
+	// double the buffer if the limit allow, otherwise grow to bytes only
+	n = bytes > *capacity * 2 ? bytes : *capacity * 2;
+	if (remux->limit > 0 && remux->memory - *capacity + n > remux->limit)
+		n = bytes;
+	if (remux->limit > 0 && remux->memory - *capacity + n > remux->limit)
+		return -ENOMEM;
+
+	p = realloc(*ptr, n);
+	if (!p)
+		return -ENOMEM;
+
+	remux->memory = remux->memory - *capacity + n;
+	remux->stats.memory = remux->memory > remux->stats.memory ? remux->memory : remux->stats.memory;
+	*ptr = (uint8_t*)p;
+	*capacity = n;
+	return 0;
+}
+
+remux_t* remux_create(int format, const struct remux_buffer_t* buffer, void* param)
+{
+	struct remux_t* remux;
+	remux = (struct remux_t*)calloc(1, sizeof(*remux));
+	if (!remux)
+		return NULL;
+
+	memcpy(&remux->io, buffer, sizeof(remux->io));
+	remux->param = param;
+
+	switch (format)
+	{
+	case REMUX_FORMAT_MP4:
+		remux->writer = remux_writer_mov_create(&s_io, remux, 0);
+		break;
+	case REMUX_FORMAT_FMP4:
+		remux->writer = remux_writer_mov_create(&s_io, remux, 1);
+		break;
+	case REMUX_FORMAT_MKV:
+		remux->writer = remux_writer_mkv_create(&s_io, remux);
+		break;
+	case REMUX_FORMAT_FLV:
+		remux->writer = remux_writer_flv_create(&s_io, remux);
+		break;
+	case REMUX_FORMAT_TS:
+		remux->writer = remux_writer_ts_create(&s_io, remux);
+		break;
+	case REMUX_FORMAT_PS:
+		remux->writer = remux_writer_ps_create(&s_io, remux);
+		break;
+	default:
+		break;
+	}
+
+	if (!remux->writer)
+	{
+		free(remux);
+		return NULL;
+	}
+	return remux;
+}
+
+void remux_destroy(remux_t* remux)
+{
+	int i;
+	if (!remux->flushed)
+		remux_flush(remux);
+
+	remux->writer->destroy(remux->writer);
+	for (i = 0; i < remux->count; i++)
+	{
+		free(remux->streams[i].extra);
+		free(remux->streams[i].v);
+	}
+	free(remux->probes);
+	free(remux->probe_data);
+	free(remux->ptr);
+	free(remux);
+}
+
+int remux_set_memory_limit(remux_t* remux, size_t bytes)
+{
+	remux->limit = bytes;
+	return 0;
+}
+
+void remux_set_probe(remux_t* remux, int probe)
+{
+	remux->probe = probe;
+}
+
+int remux_get_stats(remux_t* remux, struct remux_stats_t* stats)
+{
+	memcpy(stats, &remux->stats, sizeof(*stats));
+	return 0;
+}
+
+static int remux_is_h26x(uint8_t object)
+{
+	return MOV_OBJECT_H264 == object || MOV_OBJECT_H265 == object || MOV_OBJECT_H266 == object;
+}
+
+static int remux_stream_extra(struct remux_track_t* s, const void* extra, size_t bytes)
+{
+	if (0 != remux_alloc(&s->extra, &s->capacity, bytes))
+		return -ENOMEM;
+	memcpy(s->extra, extra, bytes);
+	s->info.extra = s->extra;
+	s->info.bytes = bytes;
+	return 0;
+}
+
+// load decoder configuration record/AudioSpecificConfig for MP4 => AnnexB
+static int remux_stream_load(struct remux_track_t* s)
+{
+	int r;
+	switch (s->info.object)
+	{
+	case MOV_OBJECT_H264:
+		r = mpeg4_avc_decoder_configuration_record_load(s->extra, s->info.bytes, &s->v->avc);
+		break;
+	case MOV_OBJECT_H265:
+		r = mpeg4_hevc_decoder_configuration_record_load(s->extra, s->info.bytes, &s->v->hevc);
+		break;
+	case MOV_OBJECT_H266:
+		r = mpeg4_vvc_decoder_configuration_record_load(s->extra, s->info.bytes, &s->v->vvc);
+		break;
+	case MOV_OBJECT_AAC:
+		r = mpeg4_aac_audio_specific_config_load(s->extra, s->info.bytes, &s->aac);
+		break;
+	default:
+		r = 0;
+	}
+	return r;
+}
+
+// save decoder configuration record from AnnexB in-band SPS/PPS or ADTS header
+/// @return 1-ready, 0-need more data, <0-error
+static int remux_stream_save(struct remux_track_t* s)
+{
+	int r;
+	uint8_t extra[REMUX_CONFIG_BYTES + 64];
+
+	switch (s->info.object)
+	{
+	case MOV_OBJECT_H264:
+		if (s->v->avc.nb_sps < 1 || s->v->avc.nb_pps < 1)
+			return 0;
+		r = mpeg4_avc_decoder_configuration_record_save(&s->v->avc, extra, sizeof(extra));
+		break;
+	case MOV_OBJECT_H265:
+		if (s->v->hevc.numOfArrays < 3) // vps + sps + pps
+			return 0;
+		r = mpeg4_hevc_decoder_configuration_record_save(&s->v->hevc, extra, sizeof(extra));
+		break;
+	case MOV_OBJECT_H266:
+		if (s->v->vvc.numOfArrays < 2) // sps + pps, vps is optional
+			return 0;
+		r = mpeg4_vvc_decoder_configuration_record_save(&s->v->vvc, extra, sizeof(extra));
+		break;
+	case MOV_OBJECT_AAC:
+		r = mpeg4_aac_audio_specific_config_save(&s->aac, extra, sizeof(extra));
+		s->info.channels = s->aac.channel_configuration;
+		s->info.sample_rate = mpeg4_aac_audio_frequency_to((enum mpeg4_aac_frequency)s->aac.sampling_frequency_index);
+		break;
+	default:
+		return 1;
+	}
+
+	if (r <= 0)
+		return r < 0 ? r : -EINVAL;
+	return 0 == remux_stream_extra(s, extra, r) ? 1 : -ENOMEM;
+}
+
+// video size from decoder configuration record, FLV/TS/PS input don't have tkhd/PixelWidth
+static void remux_stream_resolution(struct remux_track_t* s)
+{
+	int r, width, height;
+	union
+	{
+		struct mpeg4_avc_t avc;
+		struct mpeg4_hevc_t hevc;
+		struct mpeg4_vvc_t vvc;
+		struct aom_av1_t av1[2]; // av1C, sequence header
+	} v;
+
+	if ((s->info.width > 0 && s->info.height > 0) || !s->info.extra || s->info.bytes < 1)
+		return;
+
+	memset(&v, 0, sizeof(v));
+	switch (s->info.object)
+	{
+	case MOV_OBJECT_H264:
+		r = mpeg4_avc_decoder_configuration_record_load(s->info.extra, s->info.bytes, &v.avc) > 0 ? mpeg4_avc_get_resolution(&v.avc, &width, &height) : -1;
+		break;
+	case MOV_OBJECT_H265:
+		r = mpeg4_hevc_decoder_configuration_record_load(s->info.extra, s->info.bytes, &v.hevc) > 0 ? mpeg4_hevc_get_resolution(&v.hevc, &width, &height) : -1;
+		break;
+	case MOV_OBJECT_H266:
+		r = mpeg4_vvc_decoder_configuration_record_load(s->info.extra, s->info.bytes, &v.vvc) > 0 && v.vvc.max_picture_width > 0 ? 0 : -1;
+		width = v.vvc.max_picture_width;
+		height = v.vvc.max_picture_height;
+		break;
+	case MOV_OBJECT_AV1:
+		r = aom_av1_codec_configuration_record_load(s->info.extra, s->info.bytes, &v.av1[0]) > 0 ? aom_av1_codec_configuration_record_init(&v.av1[1], v.av1[0].data, v.av1[0].bytes) : -1;
+		width = (int)v.av1[1].width; // max_frame_width_minus_1 + 1
+		height = (int)v.av1[1].height;
+		break;
+	default:
+		r = -1; // audio
+	}
+
+	if (0 == r && width > 0 && height > 0)
+	{
+		s->info.width = width;
+		s->info.height = height;
+	}
+}
+
+int remux_add_stream(remux_t* remux, const struct remux_stream_t* stream)
+{
+	int bitstream;
+	struct remux_track_t* s;
+	if (remux->count >= REMUX_STREAM_MAX)
+		return -E2BIG;
+
+	s = &remux->streams[remux->count];
+	memset(s, 0, sizeof(*s));
+	memcpy(&s->info, stream, sizeof(s->info));
+	s->info.extra = NULL;
+	s->info.bytes = 0;
+	s->track = -1;
+	if (stream->extra && stream->bytes > 0 && 0 != remux_stream_extra(s, stream->extra, stream->bytes))
+		return -ENOMEM;
+
+	// cheapest path: passthrough if input/output bitstream is the same
+	bitstream = remux->writer->bitstream;
+	if (remux_is_h26x(s->info.object) && s->info.bitstream != bitstream)
+		s->path = REMUX_BITSTREAM_MP4 == bitstream ? REMUX_PATH_ANNEXB_TO_MP4 : REMUX_PATH_MP4_TO_ANNEXB;
+	else if (MOV_OBJECT_AAC == s->info.object && s->info.bitstream != bitstream)
+		s->path = REMUX_BITSTREAM_MP4 == bitstream ? REMUX_PATH_ADTS_TO_AAC : REMUX_PATH_AAC_TO_ADTS;
+	else
+		s->path = REMUX_PATH_PASSTHROUGH;
+
+	if (REMUX_PATH_MP4_TO_ANNEXB == s->path || REMUX_PATH_ANNEXB_TO_MP4 == s->path)
+	{
+		s->v = calloc(1, sizeof(*s->v));
+		if (!s->v)
+			return -ENOMEM;
+	}
+
+	switch (s->path)
+	{
+	case REMUX_PATH_MP4_TO_ANNEXB:
+	case REMUX_PATH_AAC_TO_ADTS:
+		// ADTS header need AudioSpecificConfig, SPS/PPS is optional(in-band)
+		s->ready = s->info.bytes > 0 && remux_stream_load(s) > 0;
+		if (!s->ready && REMUX_PATH_MP4_TO_ANNEXB == s->path)
+		{
+			// without decoder configuration record: 4-bytes NALU length
+			memset(s->v, 0, sizeof(*s->v));
+			if (MOV_OBJECT_H264 == s->info.object)
+				s->v->avc.nalu = 4;
+			else if (MOV_OBJECT_H265 == s->info.object)
+				s->v->hevc.lengthSizeMinusOne = 3;
+			else
+				s->v->vvc.lengthSizeMinusOne = 3;
+			s->ready = 1;
+		}
+		break;
+	case REMUX_PATH_ANNEXB_TO_MP4:
+	case REMUX_PATH_ADTS_TO_AAC:
+		s->ready = 0; // rebuild from bitstream, ignore input extra
+		s->info.bytes = 0;
+		break;
+	default:
+		// MP4 container need decoder configuration record
+		s->ready = REMUX_BITSTREAM_MP4 != bitstream || (!remux_is_h26x(s->info.object) && MOV_OBJECT_AAC != s->info.object) || s->info.bytes > 0;
+	}
+
+	// stream added after the writer started(e.g. late FLV sequence header) is dropped
+	return remux->count++;
+}
+
+// H.26x bitstream conversion into remux->ptr, retry once with a larger buffer(short NALU length)
+static int remux_h26x(struct remux_t* remux, struct remux_track_t* s, const struct remux_packet_t* pkt, int* vcl, int* update)
+{
+	int i, r;
+	size_t need;
+
+	need = pkt->bytes + pkt->bytes / 2 + REMUX_CONFIG_BYTES;
+	for (r = i = 0; i < 2; i++, need = pkt->bytes * 3 + REMUX_CONFIG_BYTES)
+	{
+		if (0 != remux_reserve(remux, &remux->ptr, &remux->capacity, need))
+			return -ENOMEM;
+
+		switch (s->path * 0x100 + s->info.object)
+		{
+		case REMUX_PATH_MP4_TO_ANNEXB * 0x100 + MOV_OBJECT_H264:
+			r = h264_mp4toannexb(&s->v->avc, pkt->data, pkt->bytes, remux->ptr, remux->capacity);
+			break;
+		case REMUX_PATH_MP4_TO_ANNEXB * 0x100 + MOV_OBJECT_H265:
+			r = h265_mp4toannexb(&s->v->hevc, pkt->data, pkt->bytes, remux->ptr, remux->capacity);
+			break;
+		case REMUX_PATH_MP4_TO_ANNEXB * 0x100 + MOV_OBJECT_H266:
+			r = h266_mp4toannexb(&s->v->vvc, pkt->data, pkt->bytes, remux->ptr, remux->capacity);
+			break;
+		case REMUX_PATH_ANNEXB_TO_MP4 * 0x100 + MOV_OBJECT_H264:
+			r = h264_annexbtomp4(&s->v->avc, pkt->data, pkt->bytes, remux->ptr, remux->capacity, vcl, update);
+			break;
+		case REMUX_PATH_ANNEXB_TO_MP4 * 0x100 + MOV_OBJECT_H265:
+			r = h265_annexbtomp4(&s->v->hevc, pkt->data, pkt->bytes, remux->ptr, remux->capacity, vcl, update);
+			break;
+		case REMUX_PATH_ANNEXB_TO_MP4 * 0x100 + MOV_OBJECT_H266:
+			r = h266_annexbtomp4(&s->v->vvc, pkt->data, pkt->bytes, remux->ptr, remux->capacity, vcl, update);
+			break;
+		default:
+			assert(0);
+			return -EINVAL;
+		}
+
+		if (0 != r || 0 == pkt->bytes)
+			break; // 0-output buffer too small
+	}
+	return r;
+}
+
+static int remux_write(struct remux_t* remux, struct remux_track_t* s, const struct remux_packet_t* pkt)
+{
+	int r, n, vcl, update;
+	int64_t samples;
+	const uint8_t* p, *end;
+	struct remux_packet_t out;
+
+	memcpy(&out, pkt, sizeof(out));
+	out.stream = s->track;
+
+	switch (s->path)
+	{
+	case REMUX_PATH_MP4_TO_ANNEXB:
+		r = remux_h26x(remux, s, pkt, NULL, NULL);
+		if (r <= 0)
+			return r < 0 ? r : -EINVAL;
+		out.data = remux->ptr;
+		out.bytes = r;
+		remux->stats.converted++;
+		return remux->writer->write(remux->writer, &out);
+
+	case REMUX_PATH_ANNEXB_TO_MP4:
+		vcl = 0;
+		r = remux_h26x(remux, s, pkt, &vcl, &update);
+		if (r < 0)
+			return r;
+		if (0 == vcl || 0 == r)
+			return 0; // SPS/PPS/SEI only, don't have video frame
+		out.data = remux->ptr;
+		out.bytes = r;
+		out.flags |= 1 == vcl ? REMUX_FLAG_KEYFRAME : 0;
+		remux->stats.converted++;
+		return remux->writer->write(remux->writer, &out);
+
+	case REMUX_PATH_AAC_TO_ADTS:
+		if (0 != remux_reserve(remux, &remux->ptr, &remux->capacity, pkt->bytes + 9))
+			return -ENOMEM;
+		n = mpeg4_aac_adts_save(&s->aac, pkt->bytes, remux->ptr, remux->capacity);
+		if (n <= 0)
+			return -EINVAL;
+		memcpy(remux->ptr + n, pkt->data, pkt->bytes);
+		out.data = remux->ptr;
+		out.bytes = n + pkt->bytes;
+		remux->stats.converted++;
+		return remux->writer->write(remux->writer, &out);
+
+	case REMUX_PATH_ADTS_TO_AAC:
+		// strip ADTS header in place(no copy), one PES may have more than one ADTS frame
+		// frame timestamp from the sample count(1024 samples/frame), no accumulated rounding error
+		end = (const uint8_t*)pkt->data + pkt->bytes;
+		for (r = 0, samples = 0, p = (const uint8_t*)pkt->data; 0 == r && p + 7 <= end; p += n, samples += 1024)
+		{
+			n = mpeg4_aac_adts_frame_length(p, end - p);
+			if (n < 7 || p + n > end)
+				return -EINVAL;
+
+			out.data = p + ((p[1] & 0x01) ? 7 : 9); // protection_absent
+			out.bytes = n - ((p[1] & 0x01) ? 7 : 9);
+			out.pts = pkt->pts + (s->info.sample_rate > 0 ? samples * 1000 / s->info.sample_rate : 0);
+			out.dts = pkt->dts + (s->info.sample_rate > 0 ? samples * 1000 / s->info.sample_rate : 0);
+			r = remux->writer->write(remux->writer, &out);
+		}
+		remux->stats.converted++; // packets, same as the other paths
+		return r;
+
+	default:
+		remux->stats.passthrough++;
+		return remux->writer->write(remux->writer, &out);
+	}
+}
+
+// derive decoder configuration from the packet(output is discarded)
+static int remux_probe_config(struct remux_t* remux, struct remux_track_t* s, const struct remux_packet_t* pkt)
+{
+	int r, vcl, update;
+	if (REMUX_PATH_ANNEXB_TO_MP4 == s->path)
+	{
+		r = remux_h26x(remux, s, pkt, &vcl, &update);
+		if (r < 0)
+			return r;
+	}
+	else if (REMUX_PATH_ADTS_TO_AAC == s->path)
+	{
+		if (mpeg4_aac_adts_load((const uint8_t*)pkt->data, pkt->bytes, &s->aac) <= 0)
+			return 0; // wait next packet
+	}
+	else
+	{
+		return 0; // AAC without AudioSpecificConfig
+	}
+
+	r = remux_stream_save(s);
+	s->ready = 1 == r ? 1 : 0;
+	return r < 0 ? r : 0;
+}
+
+static int remux_probe(struct remux_t* remux, const struct remux_packet_t* pkt)
+{
+	void* p;
+	struct remux_probe_t* probe;
+
+	if (remux->nprobe >= remux->nprobe_capacity)
+	{
+		if (remux->limit > 0 && remux->memory + sizeof(remux->probes[0]) * 64 > remux->limit)
+			return -ENOMEM;
+		p = realloc(remux->probes, sizeof(remux->probes[0]) * (remux->nprobe_capacity + 64));
+		if (!p)
+			return -ENOMEM;
+		remux->probes = (struct remux_probe_t*)p;
+		remux->nprobe_capacity += 64;
+		remux->memory += sizeof(remux->probes[0]) * 64;
+	}
+
+	if (0 != remux_reserve(remux, &remux->probe_data, &remux->probe_capacity, remux->probe_bytes + pkt->bytes))
+		return -ENOMEM;
+
+	probe = &remux->probes[remux->nprobe++];
+	memcpy(&probe->pkt, pkt, sizeof(probe->pkt));
+	probe->pkt.data = NULL;
+	probe->offset = remux->probe_bytes;
+	memcpy(remux->probe_data + remux->probe_bytes, pkt->data, pkt->bytes);
+	remux->probe_bytes += pkt->bytes;
+	return 0;
+}
+
+// add writer tracks and replay probe queue
+static int remux_start(struct remux_t* remux)
+{
+	int i, r;
+	size_t j;
+	struct remux_track_t* s;
+	struct remux_packet_t pkt;
+
+	remux->started = 1;
+	for (i = 0; i < remux->count; i++)
+	{
+		s = &remux->streams[i];
+		if (s->ready)
+			remux_stream_resolution(s);
+		s->track = s->ready ? remux->writer->add_stream(remux->writer, &s->info) : -1;
+	}
+
+	r = remux->writer->start ? remux->writer->start(remux->writer) : 0;
+	for (j = 0; j < remux->nprobe && 0 == r; j++)
+	{
+		memcpy(&pkt, &remux->probes[j].pkt, sizeof(pkt));
+		pkt.data = remux->probe_data + remux->probes[j].offset;
+		s = &remux->streams[pkt.stream];
+		if (s->track < 0)
+			remux->stats.dropped++;
+		else
+			r = remux_write(remux, s, &pkt);
+	}
+
+	// release probe memory
+	remux->memory -= remux->probe_capacity + sizeof(remux->probes[0]) * remux->nprobe_capacity;
+	free(remux->probes);
+	free(remux->probe_data);
+	remux->probes = NULL;
+	remux->probe_data = NULL;
+	remux->nprobe = remux->nprobe_capacity = 0;
+	remux->probe_bytes = remux->probe_capacity = 0;
+	return r;
+}
+
+static int remux_probe_done(struct remux_t* remux)
+{
+	int i;
+	if (remux->nprobe >= REMUX_PROBE_PACKETS || remux->probe_bytes >= REMUX_PROBE_BYTES || (remux->limit > 0 && remux->probe_bytes >= remux->limit / 2))
+		return 1; // probe overflow, drop the streams without decoder configuration
+
+	if (remux->probe && (remux->nprobe < 2 || remux->probes[remux->nprobe - 1].pkt.dts - remux->probes[0].pkt.dts < REMUX_PROBE_DURATION))
+		return 0;
+
+	for (i = 0; i < remux->count; i++)
+	{
+		if (!remux->streams[i].ready)
+			return 0;
+	}
+	return 1;
+}
+
+int remux_input(remux_t* remux, const struct remux_packet_t* pkt)
+{
+	int r;
+	struct remux_track_t* s;
+	if (pkt->stream < 0 || pkt->stream >= remux->count || remux->flushed)
+		return -EINVAL;
+
+	remux->stats.packets++;
+	remux->stats.bytes_in += pkt->bytes;
+	s = &remux->streams[pkt->stream];
+	if (remux->started)
+	{
+		if (s->track >= 0)
+			return remux_write(remux, s, pkt);
+		remux->stats.dropped++;
+		return 0;
+	}
+
+	if (!s->ready && 0 != (r = remux_probe_config(remux, s, pkt)))
+		return r;
+
+	r = remux_probe(remux, pkt);
+	if (0 == r && remux_probe_done(remux))
+		r = remux_start(remux);
+	return r;
+}
+
+int remux_flush(remux_t* remux)
+{
+	int r;
+	if (remux->flushed)
+		return 0;
+
+	r = remux->started ? 0 : remux_start(remux);
+	remux->flushed = 1;
+	return r;
+}
+
+remux_reader_t* remux_reader_create(remux_t* remux, int format, const struct remux_buffer_t* buffer, void* param)
+{
+	switch (format)
+	{
+	case REMUX_FORMAT_MP4:
+	case REMUX_FORMAT_FMP4:
+		return remux_reader_mov_create(remux, buffer, param);
+	case REMUX_FORMAT_MKV:
+		return remux_reader_mkv_create(remux, buffer, param);
+	case REMUX_FORMAT_FLV:
+		return remux_reader_flv_create(remux, buffer, param);
+	case REMUX_FORMAT_TS:
+		return remux_reader_ts_create(remux, buffer, param);
+	case REMUX_FORMAT_PS:
+		return remux_reader_ps_create(remux, buffer, param);
+	default:
+		return NULL;
+	}
+}
+
+void remux_reader_destroy(remux_reader_t* reader)
+{
+	reader->destroy(reader);
+}
+
+int remux_reader_read(remux_reader_t* reader)
+{
+	int r;
+	r = reader->read(reader);
+	if (0 == r)
+		r = remux_flush(reader->remux);
+	return r;
+}
+
+#if defined(_DEBUG) || defined(DEBUG)
+struct remux_test_buffer_t
+{
+	uint8_t* ptr;
+	size_t capacity;
+	size_t bytes;
+	size_t off;
+};
+
+static int remux_test_read(void* param, void* data, uint64_t bytes)
+{
+	struct remux_test_buffer_t* b = (struct remux_test_buffer_t*)param;
+	bytes = bytes < b->bytes - b->off ? bytes : b->bytes - b->off;
+	memcpy(data, b->ptr + b->off, (size_t)bytes);
+	b->off += (size_t)bytes;
+	return (int)bytes;
+}
+
+static int remux_test_write(void* param, const void* data, uint64_t bytes)
+{
+	struct remux_test_buffer_t* b = (struct remux_test_buffer_t*)param;
+	if (0 != remux_alloc(&b->ptr, &b->capacity, b->off + (size_t)bytes))
+		return -ENOMEM;
+	if (b->off > b->bytes)
+		memset(b->ptr + b->bytes, 0, b->off - b->bytes); // seek after end of file
+	memcpy(b->ptr + b->off, data, (size_t)bytes);
+	b->off += (size_t)bytes;
+	b->bytes = b->off > b->bytes ? b->off : b->bytes;
+	return 0;
+}
+
+static int remux_test_seek(void* param, int64_t offset)
+{
+	struct remux_test_buffer_t* b = (struct remux_test_buffer_t*)param;
+	b->off = (size_t)(offset >= 0 ? offset : (int64_t)b->bytes + offset);
+	return 0;
+}
+
+static int64_t remux_test_tell(void* param)
+{
+	return (int64_t)((struct remux_test_buffer_t*)param)->off;
+}
+
+// remux src(format) => dst(format), return output stats
+static void remux_test_remux(int format, struct remux_test_buffer_t* src, int output, struct remux_test_buffer_t* dst, struct remux_stats_t* stats)
+{
+	int r;
+	remux_t* remux;
+	remux_reader_t* reader;
+	const struct remux_buffer_t io = { remux_test_read, remux_test_write, remux_test_seek, remux_test_tell };
+
+	src->off = 0;
+	memset(dst, 0, sizeof(*dst));
+	remux = remux_create(output, &io, dst);
+	reader = remux_reader_create(remux, format, &io, src);
+	assert(remux && reader);
+	while (1 == (r = remux_reader_read(reader)))
+	{
+	}
+	assert(0 == r);
+	remux_get_stats(remux, stats);
+	remux_reader_destroy(reader);
+	remux_destroy(remux);
+}
+
+// AnnexB H.264(25fps, gop 1s) + ADTS AAC elementary stream, frames * 2 packets
+void remux_test_source(remux_t* remux, int frames)
+{
+	// H.264 SPS/PPS(baseline, 320x240)
+	static const uint8_t s_sps[] = { 0x00, 0x00, 0x00, 0x01, 0x67, 0x42, 0xc0, 0x1e, 0xda, 0x05, 0x07, 0xe4, 0x00, 0x00, 0x00, 0x01, 0x68, 0xcb, 0x83, 0xcb };
+	int i;
+	uint8_t video[sizeof(s_sps) + 4 + 32];
+	uint8_t audio[7 + 32];
+	struct mpeg4_aac_t aac;
+	struct remux_stream_t stream;
+	struct remux_packet_t pkt;
+	int v, a;
+
+	memset(&stream, 0, sizeof(stream));
+	stream.object = MOV_OBJECT_H264;
+	stream.bitstream = REMUX_BITSTREAM_ANNEXB;
+	v = remux_add_stream(remux, &stream);
+	stream.object = MOV_OBJECT_AAC;
+	a = remux_add_stream(remux, &stream);
+	assert(0 == v && 1 == a);
+
+	memset(&aac, 0, sizeof(aac));
+	aac.profile = MPEG4_AAC_LC;
+	aac.sampling_frequency_index = MPEG4_AAC_44100;
+	aac.channel_configuration = 2;
+	memset(audio, 0, sizeof(audio));
+	assert(7 == mpeg4_aac_adts_save(&aac, sizeof(audio) - 7, audio, sizeof(audio)));
+
+	memset(video, 0, sizeof(video));
+	memcpy(video, s_sps, sizeof(s_sps));
+	video[sizeof(s_sps) + 3] = 0x01;
+	for (i = 0; i < frames; i++)
+	{
+		// IDR with in-band SPS/PPS
+		memset(&pkt, 0, sizeof(pkt));
+		pkt.stream = v;
+		pkt.pts = pkt.dts = i * 40;
+		if (0 == i % 25)
+		{
+			video[sizeof(s_sps) + 4] = 0x65;
+			video[sizeof(s_sps) + 5] = 0x88;
+			pkt.data = video;
+			pkt.bytes = sizeof(video);
+		}
+		else
+		{
+			video[sizeof(s_sps) + 4] = 0x41;
+			video[sizeof(s_sps) + 5] = 0x9a;
+			pkt.data = video + sizeof(s_sps);
+			pkt.bytes = sizeof(video) - sizeof(s_sps);
+		}
+		assert(0 == remux_input(remux, &pkt));
+
+		pkt.stream = a;
+		pkt.pts = pkt.dts = i * 40;
+		pkt.data = audio;
+		pkt.bytes = sizeof(audio);
+		assert(0 == remux_input(remux, &pkt));
+	}
+}
+
+// VisualSampleEntry width/height of the first stsd avc1(ftyp has avc1 brand)
+static void remux_test_avc1_size(const struct remux_test_buffer_t* mp4, int width, int height)
+{
+	size_t i;
+	const uint8_t* p;
+	for (i = 0; i + 4 <= mp4->bytes && 0 != memcmp(mp4->ptr + i, "stsd", 4); i++)
+	{
+	}
+	for (; i + 4 + 28 <= mp4->bytes && 0 != memcmp(mp4->ptr + i, "avc1", 4); i++)
+	{
+	}
+	assert(i + 4 + 28 <= mp4->bytes);
+	p = mp4->ptr + i + 4 + 24; // reserved + data_reference_index + pre_defined + reserved + pre_defined
+	assert(width == ((p[0] << 8) | p[1]) && height == ((p[2] << 8) | p[3]));
+}
+
+// one PES with 4 ADTS frames(22050Hz) => FLV, one packet
+static void remux_test_adts(void)
+{
+	int i, n;
+	uint8_t audio[4 * (7 + 8)];
+	uint32_t timestamp;
+	struct mpeg4_aac_t aac;
+	struct remux_stream_t stream;
+	struct remux_packet_t pkt;
+	struct remux_stats_t stats;
+	struct remux_test_buffer_t flv;
+	const struct remux_buffer_t io = { remux_test_read, remux_test_write, remux_test_seek, remux_test_tell };
+	remux_t* remux;
+
+	memset(&aac, 0, sizeof(aac));
+	aac.profile = MPEG4_AAC_LC;
+	aac.sampling_frequency_index = MPEG4_AAC_22050;
+	aac.channel_configuration = 2;
+	memset(audio, 0, sizeof(audio));
+	for (i = 0; i < 4; i++)
+		assert(7 == mpeg4_aac_adts_save(&aac, 8, audio + i * 15, sizeof(audio) - i * 15));
+
+	memset(&flv, 0, sizeof(flv));
+	remux = remux_create(REMUX_FORMAT_FLV, &io, &flv);
+	memset(&stream, 0, sizeof(stream));
+	stream.object = MOV_OBJECT_AAC;
+	stream.bitstream = REMUX_BITSTREAM_ANNEXB;
+	assert(0 == remux_add_stream(remux, &stream));
+	memset(&pkt, 0, sizeof(pkt));
+	pkt.pts = pkt.dts = 1000;
+	pkt.data = audio;
+	pkt.bytes = sizeof(audio);
+	assert(0 == remux_input(remux, &pkt));
+	assert(0 == remux_flush(remux));
+	remux_get_stats(remux, &stats);
+	assert(1 == stats.packets && 1 == stats.converted && 0 == stats.dropped);
+	remux_destroy(remux);
+
+	// last FLV audio tag: 1000 + 3 * 1024 * 1000 / 22050 = 1139(per-frame 46ms step gives 1138)
+	for (timestamp = 0, i = 9 + 4; i + 11 <= (int)flv.bytes; i += 11 + n + 4)
+	{
+		n = (flv.ptr[i + 1] << 16) | (flv.ptr[i + 2] << 8) | flv.ptr[i + 3];
+		if (8 == flv.ptr[i]) // audio tag
+			timestamp = ((uint32_t)flv.ptr[i + 7] << 24) | (flv.ptr[i + 4] << 16) | (flv.ptr[i + 5] << 8) | flv.ptr[i + 6];
+	}
+	assert(1139 == timestamp);
+	free(flv.ptr);
+}
+
+void remux_test(void)
+{
+	struct remux_stats_t stats;
+	struct remux_test_buffer_t mp4, ts, flv, mkv, out;
+	const struct remux_buffer_t io = { remux_test_read, remux_test_write, remux_test_seek, remux_test_tell };
+	remux_t* remux;
+
+	// AnnexB/ADTS elementary stream => MP4(decoder configuration from bitstream)
+	memset(&mp4, 0, sizeof(mp4));
+	remux = remux_create(REMUX_FORMAT_MP4, &io, &mp4);
+	remux_test_source(remux, 50);
+	assert(0 == remux_flush(remux));
+	remux_get_stats(remux, &stats);
+	assert(100 == stats.packets && 100 == stats.converted && 0 == stats.dropped);
+	remux_destroy(remux);
+	assert(mp4.bytes > stats.bytes_out && stats.bytes_out > 0); // moov is written on destroy
+	remux_test_avc1_size(&mp4, 320, 240); // from in-band SPS
+
+	// MP4 => TS: length-prefixed NALU => AnnexB, raw AAC => ADTS
+	remux_test_remux(REMUX_FORMAT_MP4, &mp4, REMUX_FORMAT_TS, &ts, &stats);
+	assert(100 == stats.packets && 100 == stats.converted && 0 == stats.dropped);
+	assert(ts.bytes > 0 && 0 == ts.bytes % 188 && 0x47 == ts.ptr[0]);
+
+	// TS => FLV: AnnexB => AVCC, ADTS => raw AAC
+	remux_test_remux(REMUX_FORMAT_TS, &ts, REMUX_FORMAT_FLV, &flv, &stats);
+	assert(100 == stats.packets && 100 == stats.converted && 0 == stats.dropped);
+	assert(flv.bytes > 0 && 0 == memcmp(flv.ptr, "FLV", 3));
+
+	// FLV => MKV => MP4: passthrough
+	remux_test_remux(REMUX_FORMAT_FLV, &flv, REMUX_FORMAT_MKV, &mkv, &stats);
+	assert(100 == stats.packets && 100 == stats.passthrough && 0 == stats.dropped);
+	remux_test_remux(REMUX_FORMAT_MKV, &mkv, REMUX_FORMAT_MP4, &out, &stats);
+	assert(100 == stats.packets && 100 == stats.passthrough && 0 == stats.dropped);
+
+	// FLV/MKV/MP4 frames are the same as the first MP4, FLV => MKV size from avcC
+	assert(out.bytes == mp4.bytes);
+	remux_test_avc1_size(&out, 320, 240);
+
+	remux_test_adts();
+
+	free(mp4.ptr);
+	free(ts.ptr);
+	free(flv.ptr);
+	free(mkv.ptr);
+	free(out.ptr);
+}
+#endif
@@ -61,6 +61,13 @@ int rtmp_client_push_audio(rtmp_client_t* rtmp, const void* audio, size_t bytes,
 ///@param[in] data FLV onMetaData
 int rtmp_client_push_script(struct rtmp_client_t* ctx, const void* data, size_t bytes, uint32_t timestamp);
 
+/// Hot-path metrics snapshot(build with -DMEDIA_METRICS), see more @media-metrics.h
+///@param[out] read received messages => audio/video/script callback, NULL-ignore
+///@param[out] write sent messages => chunks(send callback), NULL-ignore
+///@return 0-ok, -ENOSYS-metrics disabled
+struct media_metrics_t;
+int rtmp_client_get_metrics(rtmp_client_t* rtmp, struct media_metrics_t* read, struct media_metrics_t* write);
+
 #if defined(__cplusplus)
 }
 #endif
@@ -4,6 +4,10 @@
 #include <stdint.h>
 #include <stddef.h>
 
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
 enum
 {
 	RTMP_VERSION		= 3,
@@ -26,4 +30,7 @@ int rtmp_handshake_s0(uint8_t* s0, int version);
 int rtmp_handshake_s1(uint8_t* s1, uint32_t timestamp, const uint8_t* c1, size_t bytes);
 int rtmp_handshake_s2(uint8_t* s2, uint32_t timestamp, const uint8_t* c1, size_t bytes);
 
+#if defined(__cplusplus)
+}
+#endif
 #endif /* !_rtmp_handshake_h_ */
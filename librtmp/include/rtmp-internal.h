@@ -5,6 +5,8 @@
 #include "rtmp-netconnection.h"
 #include "rtmp-netstream.h"
 
+struct media_metrics_t;
+
 #define N_CHUNK_STREAM	8 // maximum chunk stream count
 #define N_STREAM_NAME	256
 
@@ -160,6 +162,10 @@ struct rtmp_t
 		// 4. / realtimeapp
 		int (*onreconnect)(void* param, const char* tcurl, const char* descritpion);
 	} client;
+
+	// NULL if MEDIA_METRICS disabled, keep rtmp_t layout for all builds
+	struct media_metrics_t* chunk_read; // messages => onaudio/onvideo/onscript
+	struct media_metrics_t* chunk_write; // messages => send chunks
 };
 
 /// @return 0-ok, other-error
@@ -168,6 +174,12 @@ int rtmp_chunk_read(struct rtmp_t* rtmp, const uint8_t* data, size_t bytes);
 int rtmp_chunk_write(struct rtmp_t* rtmp, const struct rtmp_chunk_header_t* header, const uint8_t* payload);
 
 int rtmp_handler(struct rtmp_t* rtmp, struct rtmp_chunk_header_t* header, const uint8_t* payload);
+/// alloc chunk_read/chunk_write if MEDIA_METRICS enabled
+/// @return 0-ok, -ENOMEM-no memory
+int rtmp_metrics_create(struct rtmp_t* rtmp);
+void rtmp_metrics_destroy(struct rtmp_t* rtmp);
+/// @return 0-ok, -ENOSYS-metrics disabled
+int rtmp_get_metrics(struct rtmp_t* rtmp, struct media_metrics_t* read, struct media_metrics_t* write);
 int rtmp_event_handler(struct rtmp_t* rtmp, const struct rtmp_chunk_header_t* header, const uint8_t* data);
 int rtmp_invoke_handler(struct rtmp_t* rtmp, const struct rtmp_chunk_header_t* header, const uint8_t* data);
 /// @return >0-ok, 0-error
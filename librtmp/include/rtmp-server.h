@@ -76,6 +76,13 @@ int rtmp_server_send_script(rtmp_server_t* rtmp, const void* data, size_t bytes,
 /// @return 0-ok, other-error
 int rtmp_server_start(rtmp_server_t* rtmp, int code, const char* msg);
 
+/// Hot-path metrics snapshot(build with -DMEDIA_METRICS), see more @media-metrics.h
+/// @param[out] read received messages => audio/video/script callback, NULL-ignore
+/// @param[out] write sent messages => chunks(send callback), NULL-ignore
+/// @return 0-ok, -ENOSYS-metrics disabled
+struct media_metrics_t;
+int rtmp_server_get_metrics(rtmp_server_t* rtmp, struct media_metrics_t* read, struct media_metrics_t* write);
+
 #ifdef __cplusplus
 }
 #endif
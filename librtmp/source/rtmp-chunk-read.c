@@ -1,4 +1,5 @@
 #include "rtmp-internal.h"
+#include "media-metrics.h"
 #include "rtmp-msgtypeid.h"
 #include <stdlib.h>
 #include <string.h>
@@ -85,6 +86,8 @@ static int rtmp_packet_alloc(struct rtmp_t* rtmp, struct rtmp_packet_t* packet)
 			return -ENOMEM;
 		packet->payload = p;
 		packet->capacity = packet->header.length + 1024;
+		MEDIA_METRICS_ADD(rtmp->chunk_read, allocs, 1);
+		MEDIA_METRICS_MAX(rtmp->chunk_read, buffer_hwm, packet->capacity);
 	}
 
 	return 0;
@@ -232,8 +235,14 @@ int rtmp_chunk_read(struct rtmp_t* rtmp, const uint8_t* data, size_t bytes)
 
 				memcpy(&header, &parser->pkt->header, sizeof(header));
 				header.timestamp = parser->pkt->clock;
+				MEDIA_METRICS_ADD(rtmp->chunk_read, frames_in, 1);
+				MEDIA_METRICS_ADD(rtmp->chunk_read, bytes_in, header.length);
 				r = rtmp_handler(rtmp, &header, parser->pkt->payload);
-				if(0 != r) return r;
+				if (0 != r)
+				{
+					MEDIA_METRICS_ADD(rtmp->chunk_read, errors, 1);
+					return r;
+				}
 			}
 			else if (0 == (parser->pkt->bytes % rtmp->in_chunk_size))
 			{
@@ -1,5 +1,6 @@
 #include "rtmp-chunk-header.h"
 #include "rtmp-internal.h"
+#include "media-metrics.h"
 #include "rtmp-util.h"
 #include <stdlib.h>
 #include <string.h>
@@ -99,7 +100,12 @@ int rtmp_chunk_write(struct rtmp_t* rtmp, const struct rtmp_chunk_header_t* h, c
 	// compression rtmp chunk header
 	header = rtmp_chunk_header_zip(rtmp, h);
 	if (!header || header->length >= 0xFFFFFF)
+	{
+		MEDIA_METRICS_ADD(rtmp->chunk_write, errors, 1);
 		return -EINVAL; // invalid length
+	}
+	MEDIA_METRICS_ADD(rtmp->chunk_write, frames_in, 1);
+	MEDIA_METRICS_ADD(rtmp->chunk_write, bytes_in, header->length);
 
 	// alloc chunk header
 	N = (header->cid < 64 ? 1 : (header->cid < (64 + 256) ? 2 : 3) /*type-3 header*/) + (header->timestamp >= 0xFFFFFF ? 4 : 0);
@@ -110,6 +116,8 @@ int rtmp_chunk_write(struct rtmp_t* rtmp, const struct rtmp_chunk_header_t* h, c
 			return -ENOMEM;
 		rtmp->chunk_write_header.ptr = p;
 		rtmp->chunk_write_header.capacity = MAX_CHUNK_HEADER + header->length / rtmp->out_chunk_size * MAX_CHECK_TYPE3_WITH_TIMESTAMP;
+		MEDIA_METRICS_ADD(rtmp->chunk_write, allocs, 1);
+		MEDIA_METRICS_MAX(rtmp->chunk_write, buffer_hwm, rtmp->chunk_write_header.capacity);
 	}
 	p = rtmp->chunk_write_header.ptr;
 
@@ -123,7 +131,9 @@ int rtmp_chunk_write(struct rtmp_t* rtmp, const struct rtmp_chunk_header_t* h, c
 	while (payloadSize > 0 && 0 == r)
 	{
 		chunkSize = payloadSize < rtmp->out_chunk_size ? payloadSize : rtmp->out_chunk_size;
-		r = rtmp->send(rtmp->param, p, headerSize, payload, chunkSize); // callback
+		MEDIA_METRICS_ADD(rtmp->chunk_write, frames_out, 1);
+		MEDIA_METRICS_ADD(rtmp->chunk_write, bytes_out, headerSize + chunkSize);
+		MEDIA_METRICS_CALL(rtmp->chunk_write, r, rtmp->send(rtmp->param, p, headerSize, payload, chunkSize)); // callback
 
 		payload += chunkSize;
 		payloadSize -= chunkSize;
@@ -139,5 +149,7 @@ int rtmp_chunk_write(struct rtmp_t* rtmp, const struct rtmp_chunk_header_t* h, c
 		}
 	}
 
+	if (0 != r)
+		MEDIA_METRICS_ADD(rtmp->chunk_write, errors, 1);
 	return r;
 }
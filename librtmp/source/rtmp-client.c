@@ -354,6 +354,11 @@ struct rtmp_client_t* rtmp_client_create(const char* appname, const char* playpa
 	assert(appname && *appname && playpath && *playpath && handler);
 	ctx = (struct rtmp_client_t*)calloc(1, sizeof(struct rtmp_client_t));
 	if (!ctx) return NULL;
+	if (0 != rtmp_metrics_create(&ctx->rtmp))
+	{
+		free(ctx);
+		return NULL;
+	}
 
 	memcpy(&ctx->handler, handler, sizeof(ctx->handler));
 	snprintf(ctx->stream_name, sizeof(ctx->stream_name) - 1, "%s", playpath);
@@ -426,6 +431,7 @@ void rtmp_client_destroy(struct rtmp_client_t* ctx)
 		free(ctx->rtmp.chunk_write_header.ptr);
 		ctx->rtmp.chunk_write_header.capacity = 0;
 	}
+	rtmp_metrics_destroy(&ctx->rtmp);
 
 #if defined(DEBUG) || defined(_DEBUG)
 	memset(ctx, 0xCC, sizeof(*ctx));
@@ -555,6 +561,11 @@ int rtmp_client_getstate(struct rtmp_client_t* ctx)
 	return ctx->state;
 }
 
+int rtmp_client_get_metrics(struct rtmp_client_t* ctx, struct media_metrics_t* read, struct media_metrics_t* write)
+{
+	return rtmp_get_metrics(&ctx->rtmp, read, write);
+}
+
 int rtmp_client_push_video(struct rtmp_client_t* ctx, const void* video, size_t bytes, uint32_t timestamp)
 {
 	struct rtmp_chunk_header_t header;
@@ -1,30 +1,47 @@
 #include "rtmp-internal.h"
+#include "media-metrics.h"
 #include "rtmp-msgtypeid.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
+#include <errno.h>
 
 #define RTMP_MESSAGE_HEADER_LENGTH	11 // RTMP 6.1.1
 
 static int rtmp_audio(struct rtmp_t* rtmp, const uint8_t* payload, uint32_t bytes, uint32_t timestamp)
 {
-	return rtmp->onaudio(rtmp->param, payload, bytes, timestamp);
+	int r;
+	MEDIA_METRICS_ADD(rtmp->chunk_read, frames_out, 1);
+	MEDIA_METRICS_ADD(rtmp->chunk_read, bytes_out, bytes);
+	MEDIA_METRICS_CALL(rtmp->chunk_read, r, rtmp->onaudio(rtmp->param, payload, bytes, timestamp));
+	return r;
 }
 
 static int rtmp_video(struct rtmp_t* rtmp, const uint8_t* payload, uint32_t bytes, uint32_t timestamp)
 {
-	return rtmp->onvideo(rtmp->param, payload, bytes, timestamp);
+	int r;
+	MEDIA_METRICS_ADD(rtmp->chunk_read, frames_out, 1);
+	MEDIA_METRICS_ADD(rtmp->chunk_read, bytes_out, bytes);
+	MEDIA_METRICS_CALL(rtmp->chunk_read, r, rtmp->onvideo(rtmp->param, payload, bytes, timestamp));
+	return r;
 }
 
 static int rtmp_script(struct rtmp_t* rtmp, const uint8_t* payload, uint32_t bytes, uint32_t timestamp)
 {
+	int r;
 	// filter @setDataFrame
 	const static uint8_t s_setFrameData[] = { 0x02, 0x00, 0x0d, 0x40, 0x73, 0x65, 0x74, 0x44, 0x61, 0x74, 0x61, 0x46, 0x72, 0x61, 0x6d, 0x65 };
 	if (bytes > sizeof(s_setFrameData) && 0 == memcmp(s_setFrameData, payload, sizeof(s_setFrameData)))
-		return rtmp->onscript(rtmp->param, payload + sizeof(s_setFrameData), bytes - sizeof(s_setFrameData), timestamp);
+	{
+		payload += sizeof(s_setFrameData);
+		bytes -= sizeof(s_setFrameData);
+	}
 
-	return rtmp->onscript(rtmp->param, payload, bytes, timestamp);
+	MEDIA_METRICS_ADD(rtmp->chunk_read, frames_out, 1);
+	MEDIA_METRICS_ADD(rtmp->chunk_read, bytes_out, bytes);
+	MEDIA_METRICS_CALL(rtmp->chunk_read, r, rtmp->onscript(rtmp->param, payload, bytes, timestamp));
+	return r;
 }
 
 static int rtmp_aggregate(struct rtmp_t* rtmp, struct rtmp_chunk_header_t* header, const uint8_t* payload)
@@ -126,3 +143,40 @@ int rtmp_handler(struct rtmp_t* rtmp, struct rtmp_chunk_header_t* header, const
 
 	return 0;
 }
+
+int rtmp_get_metrics(struct rtmp_t* rtmp, struct media_metrics_t* read, struct media_metrics_t* write)
+{
+#if defined(MEDIA_METRICS)
+	if (read)
+		media_metrics_snapshot(read, rtmp->chunk_read);
+	if (write)
+		media_metrics_snapshot(write, rtmp->chunk_write);
+	return 0;
+#else
+	(void)rtmp;
+	if (read)
+		memset(read, 0, sizeof(*read));
+	if (write)
+		memset(write, 0, sizeof(*write));
+	return -ENOSYS;
+#endif
+}
+
+int rtmp_metrics_create(struct rtmp_t* rtmp)
+{
+#if defined(MEDIA_METRICS)
+	rtmp->chunk_read = (struct media_metrics_t*)calloc(2, sizeof(struct media_metrics_t));
+	if (!rtmp->chunk_read)
+		return -ENOMEM;
+	rtmp->chunk_write = rtmp->chunk_read + 1;
+#else
+	rtmp->chunk_read = rtmp->chunk_write = NULL;
+#endif
+	return 0;
+}
+
+void rtmp_metrics_destroy(struct rtmp_t* rtmp)
+{
+	free(rtmp->chunk_read); // chunk_write share the memory
+	rtmp->chunk_read = rtmp->chunk_write = NULL;
+}
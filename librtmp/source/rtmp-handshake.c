@@ -5,19 +5,34 @@
 #include <assert.h>
 #include <math.h>
 
-#if defined(_OPENSSL_)
-#include <openssl/sha.h>
-#include <openssl/hmac.h>
-#define _FLASH_HANDSHAKE_
-#elif defined(_IETF_HMAC_)
-#include "sha.h"
-#define SHA256_DIGEST_LENGTH SHA256HashSize
+// _SIMPLE_HANDSHAKE_: random C1/S1 without digest, C2/S2 echo
+// otherwise complex(Flash) handshake, HMAC-SHA256 digest by OpenSSL(_OPENSSL_) or the built-in SHA-256
+#if !defined(_SIMPLE_HANDSHAKE_)
 #define _FLASH_HANDSHAKE_
 #endif
 
 #if defined(_FLASH_HANDSHAKE_)
-// nginx-rtmp-module / ngx_rtmp_handshake.c
+#if defined(_OPENSSL_)
+#include <openssl/evp.h>
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+#include <openssl/core_names.h>
+#else
+#include <openssl/hmac.h>
+#endif
+#if defined(_WIN32)
+#include <Windows.h>
+#else
+#include <pthread.h>
+#endif
+#endif
+
+#if !defined(SHA256_DIGEST_LENGTH)
+#define SHA256_DIGEST_LENGTH 32
+#endif
 
+// nginx-rtmp-module / ngx_rtmp_handshake.c
+// OpenSSL keys the raw keys once, the built-in SHA-256 use the precomputed key schedules(s_client_key30...)
+#if defined(_OPENSSL_) || defined(_DEBUG) || defined(DEBUG)
 static const uint8_t rtmp_server_key[] = {
 	'G', 'e', 'n', 'u', 'i', 'n', 'e', ' ', 'A', 'd', 'o', 'b', 'e', ' ',
 	'F', 'l', 'a', 's', 'h', ' ', 'M', 'e', 'd', 'i', 'a', ' ',
@@ -38,6 +53,7 @@ static const uint8_t rtmp_client_key[] = {
 	0x02, 0x9E, 0x7E, 0x57, 0x6E, 0xEC, 0x5D, 0x2D, 0x29, 0x80, 0x6F, 0xAB,
 	0x93, 0xB8, 0xE6, 0x36, 0xCF, 0xEB, 0x31, 0xAE
 };
+#endif
 
 static const uint8_t rtmp_server_version[] = {
 	0x0D, 0x0E, 0x0A, 0x0D
@@ -48,54 +64,362 @@ static const uint8_t rtmp_client_version[] = {
 };
 
 #if defined(_OPENSSL_)
-static int rtmp_handshake_make_digest(const uint8_t* key, size_t len, const uint8_t* ptr, size_t ptrlen, const uint8_t* digest, uint8_t* dst)
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+typedef EVP_MAC_CTX rtmp_hmac_ctx_t;
+static EVP_MAC* s_hmac;
+#else
+typedef HMAC_CTX rtmp_hmac_ctx_t;
+#endif
+
+// HMAC-SHA256 keyed context, copied per digest(the source context is read only, thread-safe)
+struct rtmp_hmac_key_t
+{
+	rtmp_hmac_ctx_t* ctx;
+};
+
+// the well-known keys, keyed once by rtmp_hmac_init(process lifetime)
+static struct rtmp_hmac_key_t s_client_key30; // Genuine Adobe Flash Player 001
+static struct rtmp_hmac_key_t s_client_key62; // rtmp_client_key
+static struct rtmp_hmac_key_t s_server_key36; // Genuine Adobe Flash Media Server 001
+static struct rtmp_hmac_key_t s_server_key68; // rtmp_server_key
+
+static rtmp_hmac_ctx_t* rtmp_hmac_dup(const rtmp_hmac_ctx_t* src)
 {
-	static HMAC_CTX        *hmac;
-	unsigned int            digestlen;
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+	return src ? EVP_MAC_CTX_dup(src) : NULL;
+#else
+	HMAC_CTX* ctx;
+	ctx = src ? HMAC_CTX_new() : NULL;
+	if (ctx && 1 != HMAC_CTX_copy(ctx, (HMAC_CTX*)src))
+	{
+		HMAC_CTX_free(ctx);
+		ctx = NULL;
+	}
+	return ctx;
+#endif
+}
 
-	if (hmac == NULL) {
-#if OPENSSL_VERSION_NUMBER < 0x10100000L
-		static HMAC_CTX  shmac;
-		hmac = &shmac;
-		HMAC_CTX_init(hmac);
+static void rtmp_hmac_free(rtmp_hmac_ctx_t* ctx)
+{
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+	EVP_MAC_CTX_free(ctx);
+#else
+	HMAC_CTX_free(ctx);
+#endif
+}
+
+static int rtmp_hmac_update(rtmp_hmac_ctx_t* ctx, const uint8_t* p, size_t n)
+{
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+	return 1 == EVP_MAC_update(ctx, p, n) ? 0 : -1;
+#else
+	return 1 == HMAC_Update(ctx, p, n) ? 0 : -1;
+#endif
+}
+
+static int rtmp_hmac_final(rtmp_hmac_ctx_t* ctx, uint8_t md[SHA256_DIGEST_LENGTH])
+{
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+	size_t n;
+	return 1 == EVP_MAC_final(ctx, md, &n, SHA256_DIGEST_LENGTH) && SHA256_DIGEST_LENGTH == n ? 0 : -1;
 #else
-		hmac = HMAC_CTX_new();
+	unsigned int n;
+	return 1 == HMAC_Final(ctx, md, &n) && SHA256_DIGEST_LENGTH == n ? 0 : -1;
 #endif
+}
+
+static void rtmp_hmac_key(struct rtmp_hmac_key_t* hmac, const uint8_t* key, size_t len)
+{
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+	OSSL_PARAM params[2];
+	params[0] = OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, (char*)"SHA256", 0);
+	params[1] = OSSL_PARAM_construct_end();
+	hmac->ctx = s_hmac ? EVP_MAC_CTX_new(s_hmac) : NULL;
+	if (hmac->ctx && 1 != EVP_MAC_init(hmac->ctx, key, len, params))
+#else
+	hmac->ctx = HMAC_CTX_new();
+	if (hmac->ctx && 1 != HMAC_Init_ex(hmac->ctx, key, (int)len, EVP_sha256(), NULL))
+#endif
+	{
+		rtmp_hmac_free(hmac->ctx);
+		hmac->ctx = NULL;
 	}
+}
+
+static void rtmp_hmac_key_free(struct rtmp_hmac_key_t* hmac)
+{
+	if (hmac->ctx)
+		rtmp_hmac_free(hmac->ctx);
+	hmac->ctx = NULL;
+}
+
+static void rtmp_hmac_oninit(void)
+{
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+	s_hmac = EVP_MAC_fetch(NULL, "HMAC", NULL);
+#endif
+	rtmp_hmac_key(&s_client_key30, rtmp_client_key, 30);
+	rtmp_hmac_key(&s_client_key62, rtmp_client_key, sizeof(rtmp_client_key));
+	rtmp_hmac_key(&s_server_key36, rtmp_server_key, 36);
+	rtmp_hmac_key(&s_server_key68, rtmp_server_key, sizeof(rtmp_server_key));
+}
+
+#if defined(_WIN32)
+static INIT_ONCE s_hmac_once = INIT_ONCE_STATIC_INIT;
+static BOOL CALLBACK rtmp_hmac_oninit_win32(PINIT_ONCE once, PVOID param, PVOID* ctx)
+{
+	(void)once, (void)param, (void)ctx;
+	rtmp_hmac_oninit();
+	return TRUE;
+}
+#else
+static pthread_once_t s_hmac_once = PTHREAD_ONCE_INIT;
+#endif
+
+static void rtmp_hmac_init(void)
+{
+#if defined(_WIN32)
+	InitOnceExecuteOnce(&s_hmac_once, rtmp_hmac_oninit_win32, NULL, NULL);
+#else
+	pthread_once(&s_hmac_once, rtmp_hmac_oninit);
+#endif
+}
+
+/// HMAC-SHA256 of ptr, skip the 32-bytes digest if digest isn't NULL
+/// @param[out] dst can be the same as ptr/digest
+/// @return 0-ok, <0-OpenSSL error
+static int rtmp_handshake_make_digest(const struct rtmp_hmac_key_t* key, const uint8_t* ptr, size_t ptrlen, const uint8_t* digest, uint8_t* dst)
+{
+	int r;
+	uint8_t md[SHA256_DIGEST_LENGTH];
+	rtmp_hmac_ctx_t* ctx;
+
+	rtmp_hmac_init();
+	ctx = rtmp_hmac_dup(key->ctx);
+	if (!ctx)
+		return -1;
 
-	HMAC_Init_ex(hmac, key, len, EVP_sha256(), NULL);
 	if (digest)
 	{
 		assert(digest + SHA256_DIGEST_LENGTH <= ptr + ptrlen);
-		HMAC_Update(hmac, ptr, digest - ptr);
-		if (digest + SHA256_DIGEST_LENGTH < ptr + ptrlen)
-			HMAC_Update(hmac, digest + SHA256_DIGEST_LENGTH, ptrlen - (digest - ptr) - SHA256_DIGEST_LENGTH);
+		r = rtmp_hmac_update(ctx, ptr, digest - ptr);
+		if (0 == r && digest + SHA256_DIGEST_LENGTH < ptr + ptrlen)
+			r = rtmp_hmac_update(ctx, digest + SHA256_DIGEST_LENGTH, ptrlen - (digest - ptr) - SHA256_DIGEST_LENGTH);
 	}
 	else
 	{
-		HMAC_Update(hmac, ptr, ptrlen);
+		r = rtmp_hmac_update(ctx, ptr, ptrlen);
 	}
-	HMAC_Final(hmac, dst, &digestlen);
-	assert(digestlen == SHA256_DIGEST_LENGTH);
-	return 0;
+	r = 0 == r ? rtmp_hmac_final(ctx, md) : r;
+	rtmp_hmac_free(ctx);
+
+	if (0 == r)
+		memcpy(dst, md, sizeof(md));
+	return r;
 }
+
 #else
-static int rtmp_handshake_make_digest(const uint8_t* key, size_t len, const uint8_t* ptr, size_t ptrlen, const uint8_t* digest, uint8_t* dst)
+// FIPS 180-4 SHA-256 and RFC 2104 HMAC, the hash state lives on the caller stack(thread-safe, no allocation)
+struct rtmp_sha256_t
+{
+	uint32_t h[8];
+	uint64_t bytes; // message length
+	uint8_t block[64];
+};
+
+// HMAC-SHA256 key schedule: SHA-256 state after the (key ^ ipad)/(key ^ opad) block
+struct rtmp_hmac_key_t
+{
+	uint32_t ipad[8];
+	uint32_t opad[8];
+};
+
+static const uint32_t s_sha256_h0[8] = {
+	0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+// precomputed key schedules(rtmp_hmac_key) of the well-known keys, checked by rtmp_handshake_test
+static const struct rtmp_hmac_key_t s_client_key30 = { // Genuine Adobe Flash Player 001
+	{ 0xab9b2043, 0x9d576b06, 0x90cc6d17, 0x9e2d20d9, 0x430bbd1c, 0x0a5165be, 0xc8af2193, 0x406c37fe },
+	{ 0x941c2d2d, 0xa04e9891, 0x26ab56a5, 0xa3d018f6, 0xccc062d3, 0xa0c3be23, 0xbd8451ab, 0x3f597e24 },
+};
+static const struct rtmp_hmac_key_t s_client_key62 = { // rtmp_client_key
+	{ 0xf50c211e, 0xb4912e4e, 0xa654c4f4, 0xeaa22a44, 0x31f45f66, 0x22754a77, 0x9b30b532, 0xb18de0ad },
+	{ 0x2f089c78, 0x00cdebc1, 0xfd6934e4, 0x55f3acc6, 0xe5e8c528, 0x4dc7d7c3, 0xb6caf065, 0x34f8d755 },
+};
+static const struct rtmp_hmac_key_t s_server_key36 = { // Genuine Adobe Flash Media Server 001
+	{ 0xfbf1a037, 0x2e9a60b2, 0xa08c9325, 0xa4fd756d, 0x55368456, 0xbe012b6d, 0x476abc98, 0xc2e1cb14 },
+	{ 0x5e768abc, 0xa52128de, 0xf535f675, 0x8694d69c, 0x9d55fb0f, 0x3309589a, 0xb5b12beb, 0x87110ee9 },
+};
+static const struct rtmp_hmac_key_t s_server_key68 = { // rtmp_server_key
+	{ 0xc78bf1e1, 0xa17ea90d, 0x00159065, 0xba1d636f, 0x926f9349, 0xcf2494cb, 0xb2fced22, 0xfa713a6c },
+	{ 0xc064c25c, 0xcb2a2765, 0x5356df92, 0x50e16022, 0x3b478875, 0xdc6a0deb, 0xbb45db76, 0xcd8e4598 },
+};
+
+static const uint32_t s_sha256_k[64] = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+#define ROTR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+static void rtmp_sha256_transform(uint32_t h[8], const uint8_t* p)
+{
+	int i;
+	uint32_t w[64], s[8], t1, t2;
+
+	for (i = 0; i < 16; i++)
+		w[i] = ((uint32_t)p[4 * i] << 24) | ((uint32_t)p[4 * i + 1] << 16) | ((uint32_t)p[4 * i + 2] << 8) | p[4 * i + 3];
+	for (; i < 64; i++)
+		w[i] = (ROTR(w[i - 2], 17) ^ ROTR(w[i - 2], 19) ^ (w[i - 2] >> 10)) + w[i - 7] + (ROTR(w[i - 15], 7) ^ ROTR(w[i - 15], 18) ^ (w[i - 15] >> 3)) + w[i - 16];
+
+	memcpy(s, h, sizeof(s));
+	for (i = 0; i < 64; i++)
+	{
+		t1 = s[7] + (ROTR(s[4], 6) ^ ROTR(s[4], 11) ^ ROTR(s[4], 25)) + ((s[4] & s[5]) ^ (~s[4] & s[6])) + s_sha256_k[i] + w[i];
+		t2 = (ROTR(s[0], 2) ^ ROTR(s[0], 13) ^ ROTR(s[0], 22)) + ((s[0] & s[1]) ^ (s[0] & s[2]) ^ (s[1] & s[2]));
+		s[7] = s[6];
+		s[6] = s[5];
+		s[5] = s[4];
+		s[4] = s[3] + t1;
+		s[3] = s[2];
+		s[2] = s[1];
+		s[1] = s[0];
+		s[0] = t1 + t2;
+	}
+
+	for (i = 0; i < 8; i++)
+		h[i] += s[i];
+}
+
+/// @param[in] h initial hash value or HMAC key schedule
+/// @param[in] bytes hashed bytes of h(multiple of 64)
+static void rtmp_sha256_init(struct rtmp_sha256_t* sha, const uint32_t h[8], uint64_t bytes)
 {
-	HMACContext hmac;
-	hmacReset(&hmac, SHA256, key, len);
+	memcpy(sha->h, h, sizeof(sha->h));
+	sha->bytes = bytes;
+}
+
+static void rtmp_sha256_update(struct rtmp_sha256_t* sha, const uint8_t* p, size_t n)
+{
+	size_t i, m;
+
+	i = (size_t)(sha->bytes % 64);
+	sha->bytes += n;
+	if (i > 0)
+	{
+		m = n < 64 - i ? n : 64 - i;
+		memcpy(sha->block + i, p, m);
+		if (i + m < 64)
+			return;
+		rtmp_sha256_transform(sha->h, sha->block);
+		p += m;
+		n -= m;
+	}
+
+	for (; n >= 64; p += 64, n -= 64)
+		rtmp_sha256_transform(sha->h, p);
+	memcpy(sha->block, p, n);
+}
+
+static void rtmp_sha256_final(struct rtmp_sha256_t* sha, uint8_t digest[SHA256_DIGEST_LENGTH])
+{
+	int i;
+	size_t n;
+
+	n = (size_t)(sha->bytes % 64);
+	sha->block[n++] = 0x80;
+	if (n > 56)
+	{
+		memset(sha->block + n, 0, 64 - n);
+		rtmp_sha256_transform(sha->h, sha->block);
+		n = 0;
+	}
+	memset(sha->block + n, 0, 56 - n);
+	for (i = 0; i < 8; i++)
+		sha->block[56 + i] = (uint8_t)((sha->bytes * 8) >> (56 - i * 8));
+	rtmp_sha256_transform(sha->h, sha->block);
+
+	for (i = 0; i < 8; i++)
+		be_write_uint32(digest + i * 4, sha->h[i]);
+}
+
+/// SHA-256 state after one more block
+static void rtmp_sha256_block(uint32_t h[8], const uint8_t block[64])
+{
+	struct rtmp_sha256_t sha;
+	rtmp_sha256_init(&sha, h, 0);
+	rtmp_sha256_update(&sha, block, 64);
+	memcpy(h, sha.h, sizeof(sha.h));
+}
+
+static void rtmp_hmac_key(struct rtmp_hmac_key_t* hmac, const uint8_t* key, size_t len)
+{
+	size_t i;
+	uint8_t pad[64];
+	uint8_t md[SHA256_DIGEST_LENGTH];
+	struct rtmp_sha256_t sha;
+
+	// keys longer than the block size are hashed
+	if (len > sizeof(pad))
+	{
+		rtmp_sha256_init(&sha, s_sha256_h0, 0);
+		rtmp_sha256_update(&sha, key, len);
+		rtmp_sha256_final(&sha, md);
+		key = md;
+		len = sizeof(md);
+	}
+
+	memset(pad, 0x36, sizeof(pad));
+	for (i = 0; i < len; i++)
+		pad[i] ^= key[i];
+	memcpy(hmac->ipad, s_sha256_h0, sizeof(hmac->ipad));
+	rtmp_sha256_block(hmac->ipad, pad);
+
+	memset(pad, 0x5c, sizeof(pad));
+	for (i = 0; i < len; i++)
+		pad[i] ^= key[i];
+	memcpy(hmac->opad, s_sha256_h0, sizeof(hmac->opad));
+	rtmp_sha256_block(hmac->opad, pad);
+}
+
+static void rtmp_hmac_key_free(struct rtmp_hmac_key_t* hmac)
+{
+	(void)hmac; // key schedule on the stack
+}
+
+#define rtmp_hmac_init() // nothing to do, precomputed key schedules
+
+/// HMAC-SHA256 of ptr, skip the 32-bytes digest if digest isn't NULL
+/// @param[out] dst can be the same as ptr/digest
+static int rtmp_handshake_make_digest(const struct rtmp_hmac_key_t* key, const uint8_t* ptr, size_t ptrlen, const uint8_t* digest, uint8_t* dst)
+{
+	uint8_t md[SHA256_DIGEST_LENGTH];
+	struct rtmp_sha256_t sha;
+
+	rtmp_sha256_init(&sha, key->ipad, 64);
 	if (digest)
 	{
 		assert(digest + SHA256_DIGEST_LENGTH <= ptr + ptrlen);
-		hmacInput(&hmac, ptr, digest - ptr);
+		rtmp_sha256_update(&sha, ptr, digest - ptr);
 		if (digest + SHA256_DIGEST_LENGTH < ptr + ptrlen)
-			hmacInput(&hmac, digest + SHA256_DIGEST_LENGTH, ptrlen - (digest - ptr) - SHA256_DIGEST_LENGTH);
+			rtmp_sha256_update(&sha, digest + SHA256_DIGEST_LENGTH, ptrlen - (digest - ptr) - SHA256_DIGEST_LENGTH);
 	}
 	else
 	{
-		hmacInput(&hmac, ptr, ptrlen);
+		rtmp_sha256_update(&sha, ptr, ptrlen);
 	}
-	hmacResult(&hmac, dst);
+	rtmp_sha256_final(&sha, md);
+
+	rtmp_sha256_init(&sha, key->opad, 64);
+	rtmp_sha256_update(&sha, md, sizeof(md));
+	rtmp_sha256_final(&sha, dst);
 	return 0;
 }
 #endif
@@ -114,7 +438,7 @@ random-data: (offset)bytes
 digest-data: 32bytes
 random-data: (764-4-offset-32)bytes
 */
-static const uint8_t* rtmp_handshake_find_digest(const uint8_t* handshake, size_t offset, const uint8_t* key, size_t len)
+static const uint8_t* rtmp_handshake_find_digest(const uint8_t* handshake, size_t offset, const struct rtmp_hmac_key_t* key)
 {
 	uint32_t bytes;
 	uint8_t digest[SHA256_DIGEST_LENGTH];
@@ -125,13 +449,13 @@ static const uint8_t* rtmp_handshake_find_digest(const uint8_t* handshake, size_
 	bytes += handshake[offset + 3];
 	bytes %= 728;/*764 - 4bytesoffset - 32bytesdigest*/
 
-	rtmp_handshake_make_digest(key, len, handshake, RTMP_HANDSHAKE_SIZE, handshake + offset + 4 + bytes, digest);
-	if (0 == memcmp(digest, handshake + offset + 4 + bytes, SHA256_DIGEST_LENGTH))
+	if (0 == rtmp_handshake_make_digest(key, handshake, RTMP_HANDSHAKE_SIZE, handshake + offset + 4 + bytes, digest)
+		&& 0 == memcmp(digest, handshake + offset + 4 + bytes, SHA256_DIGEST_LENGTH))
 		return handshake + offset + 4 + bytes;
 	return NULL;
 }
 
-static int rtmp_handshake_parse_challenge(const uint8_t* handshake, const uint8_t* key, size_t len, uint8_t digest[SHA256_DIGEST_LENGTH])
+static int rtmp_handshake_parse_challenge(const uint8_t* handshake, const struct rtmp_hmac_key_t* key, uint8_t digest[SHA256_DIGEST_LENGTH])
 {
 	uint32_t epoch;
 	uint32_t version;
@@ -146,16 +470,16 @@ static int rtmp_handshake_parse_challenge(const uint8_t* handshake, const uint8_
 		return 0;
 	}
 
-	p = rtmp_handshake_find_digest(handshake, 764 + 8, key, len);
+	p = rtmp_handshake_find_digest(handshake, 764 + 8, key);
 	if(NULL == p)
-		p = rtmp_handshake_find_digest(handshake, 8, key, len);
+		p = rtmp_handshake_find_digest(handshake, 8, key);
 
 	if (p)
 		memcpy(digest, p, SHA256_DIGEST_LENGTH);
 	return p ? 1 : 0;
 }
 
-static int rtmp_handshake_create_challenge(uint8_t* handshake, const uint8_t* key, size_t len)
+static int rtmp_handshake_create_challenge(uint8_t* handshake, const struct rtmp_hmac_key_t* key)
 {
 	uint32_t offset;
 	uint8_t* digest;
@@ -166,15 +490,23 @@ static int rtmp_handshake_create_challenge(uint8_t* handshake, const uint8_t* ke
 	offset += handshake[11];
 	digest = handshake + 12 + (offset % 728/*764 - 4bytesoffset - 32bytesdigest*/);
 
-	return rtmp_handshake_make_digest(key, len, handshake, RTMP_HANDSHAKE_SIZE, digest, digest);
+	return rtmp_handshake_make_digest(key, handshake, RTMP_HANDSHAKE_SIZE, digest, digest);
 }
 
-static int rtmp_handshake_create_response(uint8_t* handshake, const uint8_t* key, size_t len)
+/// @param[in] key the peer challenge digest key schedule
+/// @param[in] digest the peer challenge digest
+static int rtmp_handshake_create_response(uint8_t* handshake, const struct rtmp_hmac_key_t* key, const uint8_t digest[SHA256_DIGEST_LENGTH])
 {
-	uint8_t digest[SHA256_DIGEST_LENGTH];
-	rtmp_handshake_make_digest(key, len, handshake, RTMP_HANDSHAKE_SIZE - SHA256_DIGEST_LENGTH, NULL, digest);
-	memcpy(handshake + RTMP_HANDSHAKE_SIZE - SHA256_DIGEST_LENGTH, digest, SHA256_DIGEST_LENGTH);
-	return 0;
+	int r;
+	struct rtmp_hmac_key_t response;
+	uint8_t md[SHA256_DIGEST_LENGTH];
+	r = rtmp_handshake_make_digest(key, digest, SHA256_DIGEST_LENGTH, NULL, md);
+	if (0 != r)
+		return r;
+	rtmp_hmac_key(&response, md, sizeof(md));
+	r = rtmp_handshake_make_digest(&response, handshake, RTMP_HANDSHAKE_SIZE - SHA256_DIGEST_LENGTH, NULL, handshake + RTMP_HANDSHAKE_SIZE - SHA256_DIGEST_LENGTH);
+	rtmp_hmac_key_free(&response);
+	return r;
 }
 
 #endif
@@ -182,11 +514,17 @@ static int rtmp_handshake_create_response(uint8_t* handshake, const uint8_t* key
 static void rtmp_handshake_random(uint8_t* p, uint32_t timestamp)
 {
 	int i;
-	
-	srand(timestamp);
-	for (i = 0; i * 4 < RTMP_HANDSHAKE_SIZE - 8; i++)
+	uint32_t x;
+
+	// xorshift32: srand/rand share the process global state(not thread-safe)
+	x = timestamp ^ (uint32_t)(uintptr_t)p;
+	x = x ? x : 0x2545F491;
+	for (i = 0; i + 4 <= RTMP_HANDSHAKE_SIZE - 8; i += 4)
 	{
-		*((int*)p + i) = rand();
+		x ^= x << 13;
+		x ^= x >> 17;
+		x ^= x << 5;
+		be_write_uint32(p + i, x);
 	}
 }
 
@@ -203,7 +541,7 @@ int rtmp_handshake_c1(uint8_t* c1, uint32_t timestamp)
 #if defined(_FLASH_HANDSHAKE_)
 	memcpy(c1 + 4, rtmp_client_version, 4);
 	rtmp_handshake_random(c1 + 8, timestamp);
-	rtmp_handshake_create_challenge(c1, rtmp_client_key, 30);
+	rtmp_handshake_create_challenge(c1, &s_client_key30);
 #else
 	be_write_uint32(c1 + 4, 0);
 	rtmp_handshake_random(c1 + 8, timestamp);
@@ -216,11 +554,10 @@ int rtmp_handshake_c2(uint8_t* c2, uint32_t timestamp, const uint8_t* s1, size_t
 #if defined(_FLASH_HANDSHAKE_)
 	uint8_t digest[SHA256_DIGEST_LENGTH];
 	assert(RTMP_HANDSHAKE_SIZE == bytes);
-	if (1 == rtmp_handshake_parse_challenge(s1, rtmp_server_key, 36, digest))
+	if (1 == rtmp_handshake_parse_challenge(s1, &s_server_key36, digest))
 	{
-		rtmp_handshake_make_digest(rtmp_client_key, sizeof(rtmp_client_key), digest, SHA256_DIGEST_LENGTH, NULL, digest);
 		rtmp_handshake_random(c2, timestamp);
-		rtmp_handshake_create_response(c2, digest, SHA256_DIGEST_LENGTH);
+		rtmp_handshake_create_response(c2, &s_client_key62, digest);
 	}
 	else
 	{
@@ -247,12 +584,12 @@ int rtmp_handshake_s1(uint8_t* s1, uint32_t timestamp, const uint8_t* c1, size_t
 #if defined(_FLASH_HANDSHAKE_)
 	uint8_t digest[SHA256_DIGEST_LENGTH];
 	assert(RTMP_HANDSHAKE_SIZE == bytes);
-	if (1 == rtmp_handshake_parse_challenge(c1, rtmp_client_key, 30, digest))
+	if (1 == rtmp_handshake_parse_challenge(c1, &s_client_key30, digest))
 	{
 		be_write_uint32(s1, timestamp);
 		memcpy(s1 + 4, rtmp_server_version, 4);
 		rtmp_handshake_random(s1 + 8, timestamp);
-		rtmp_handshake_create_challenge(s1, rtmp_server_key, 36);
+		rtmp_handshake_create_challenge(s1, &s_server_key36);
 		return RTMP_HANDSHAKE_SIZE;
 	}
 #else
@@ -269,11 +606,10 @@ int rtmp_handshake_s2(uint8_t* s2, uint32_t timestamp, const uint8_t* c1, size_t
 #if defined(_FLASH_HANDSHAKE_)
 	uint8_t digest[SHA256_DIGEST_LENGTH];
 	assert(RTMP_HANDSHAKE_SIZE == bytes);
-	if (1 == rtmp_handshake_parse_challenge(c1, rtmp_client_key, 30, digest))
+	if (1 == rtmp_handshake_parse_challenge(c1, &s_client_key30, digest))
 	{
-		rtmp_handshake_make_digest(rtmp_server_key, sizeof(rtmp_server_key), digest, SHA256_DIGEST_LENGTH, NULL, digest);
 		rtmp_handshake_random(s2, timestamp);
-		rtmp_handshake_create_response(s2, digest, SHA256_DIGEST_LENGTH);
+		rtmp_handshake_create_response(s2, &s_server_key68, digest);
 		return RTMP_HANDSHAKE_SIZE;
 	}
 #else
@@ -284,3 +620,60 @@ int rtmp_handshake_s2(uint8_t* s2, uint32_t timestamp, const uint8_t* c1, size_t
 #endif
 	return RTMP_HANDSHAKE_SIZE;
 }
+
+#if defined(_DEBUG) || defined(DEBUG)
+void rtmp_handshake_test(void)
+{
+	uint8_t c1[RTMP_HANDSHAKE_SIZE], s1[RTMP_HANDSHAKE_SIZE], s2[RTMP_HANDSHAKE_SIZE], c2[RTMP_HANDSHAKE_SIZE];
+
+#if defined(_FLASH_HANDSHAKE_)
+	// RFC 4231 4.3. Test Case 2
+	static const uint8_t hmac[] = { 0x5b, 0xdc, 0xc1, 0x46, 0xbf, 0x60, 0x75, 0x4e, 0x6a, 0x04, 0x24, 0x26, 0x08, 0x95, 0x75, 0xc7, 0x5a, 0x00, 0x3f, 0x08, 0x9d, 0x27, 0x39, 0x83, 0x9d, 0xec, 0x58, 0xb9, 0x64, 0xec, 0x38, 0x43 };
+	struct rtmp_hmac_key_t key;
+	uint8_t digest[SHA256_DIGEST_LENGTH];
+	uint8_t md[SHA256_DIGEST_LENGTH];
+
+	rtmp_hmac_init();
+	rtmp_hmac_key(&key, (const uint8_t*)"Jefe", 4);
+	rtmp_handshake_make_digest(&key, (const uint8_t*)"what do ya want for nothing?", 28, NULL, md);
+	assert(0 == memcmp(md, hmac, sizeof(hmac)));
+	rtmp_hmac_key_free(&key);
+
+#if !defined(_OPENSSL_)
+	rtmp_hmac_key(&key, rtmp_client_key, 30);
+	assert(0 == memcmp(&key, &s_client_key30, sizeof(key)));
+	rtmp_hmac_key(&key, rtmp_client_key, sizeof(rtmp_client_key));
+	assert(0 == memcmp(&key, &s_client_key62, sizeof(key)));
+	rtmp_hmac_key(&key, rtmp_server_key, 36);
+	assert(0 == memcmp(&key, &s_server_key36, sizeof(key)));
+	rtmp_hmac_key(&key, rtmp_server_key, sizeof(rtmp_server_key));
+	assert(0 == memcmp(&key, &s_server_key68, sizeof(key)));
+#endif
+#endif
+
+	assert(RTMP_HANDSHAKE_SIZE == rtmp_handshake_c1(c1, 1000));
+	assert(RTMP_HANDSHAKE_SIZE == rtmp_handshake_s1(s1, 2000, c1, sizeof(c1)));
+	assert(RTMP_HANDSHAKE_SIZE == rtmp_handshake_s2(s2, 2000, c1, sizeof(c1)));
+	assert(RTMP_HANDSHAKE_SIZE == rtmp_handshake_c2(c2, 3000, s1, sizeof(s1)));
+
+#if defined(_FLASH_HANDSHAKE_)
+	// S2 = HMAC(HMAC(FMS key, C1 digest), S2 random)
+	assert(1 == rtmp_handshake_parse_challenge(c1, &s_client_key30, digest));
+	rtmp_handshake_make_digest(&s_server_key68, digest, sizeof(digest), NULL, md);
+	rtmp_hmac_key(&key, md, sizeof(md));
+	rtmp_handshake_make_digest(&key, s2, RTMP_HANDSHAKE_SIZE - SHA256_DIGEST_LENGTH, NULL, md);
+	assert(0 == memcmp(md, s2 + RTMP_HANDSHAKE_SIZE - SHA256_DIGEST_LENGTH, sizeof(md)));
+	rtmp_hmac_key_free(&key);
+
+	// C2 = HMAC(HMAC(FP key, S1 digest), C2 random)
+	assert(1 == rtmp_handshake_parse_challenge(s1, &s_server_key36, digest));
+	rtmp_handshake_make_digest(&s_client_key62, digest, sizeof(digest), NULL, md);
+	rtmp_hmac_key(&key, md, sizeof(md));
+	rtmp_handshake_make_digest(&key, c2, RTMP_HANDSHAKE_SIZE - SHA256_DIGEST_LENGTH, NULL, md);
+	assert(0 == memcmp(md, c2 + RTMP_HANDSHAKE_SIZE - SHA256_DIGEST_LENGTH, sizeof(md)));
+	rtmp_hmac_key_free(&key);
+#else
+	assert(0 == memcmp(s2, c1, sizeof(c1)));
+#endif
+}
+#endif
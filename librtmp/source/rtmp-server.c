@@ -404,6 +404,11 @@ struct rtmp_server_t* rtmp_server_create(void* param, const struct rtmp_server_h
 	ctx = (struct rtmp_server_t*)calloc(1, sizeof(*ctx));
 	if (NULL == ctx)
 		return NULL;
+	if (0 != rtmp_metrics_create(&ctx->rtmp))
+	{
+		free(ctx);
+		return NULL;
+	}
 
 	memcpy(&ctx->handler, handler, sizeof(ctx->handler));
 	ctx->param = param;
@@ -463,6 +468,7 @@ void rtmp_server_destroy(struct rtmp_server_t* ctx)
 		free(ctx->rtmp.chunk_write_header.ptr);
 		ctx->rtmp.chunk_write_header.capacity = 0;
 	}
+	rtmp_metrics_destroy(&ctx->rtmp);
 
 	free(ctx);
 }
@@ -582,6 +588,11 @@ int rtmp_server_start(rtmp_server_t* rtmp, int r, const char* msg)
 	return r;
 }
 
+int rtmp_server_get_metrics(rtmp_server_t* rtmp, struct media_metrics_t* read, struct media_metrics_t* write)
+{
+	return rtmp_get_metrics(&rtmp->rtmp, read, write);
+}
+
 int rtmp_server_send_audio(struct rtmp_server_t* ctx, const void* data, size_t bytes, uint32_t timestamp)
 {
 	struct rtmp_chunk_header_t header;
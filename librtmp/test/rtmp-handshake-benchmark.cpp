@@ -0,0 +1,77 @@
+#include "rtmp-handshake.h"
+#include "sys/thread.h"
+#include "sys/system.h"
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+#define N_THREAD 64
+#define DURATION 3000 // ms
+
+struct rtmp_handshake_benchmark_t
+{
+    pthread_t thread;
+    volatile int* running;
+    uint64_t count;
+};
+
+// client C0+C1 -> server S0+S1+S2 -> client C2
+static int STDCALL rtmp_handshake_benchmark_onthread(void* param)
+{
+    uint8_t c0c1[1 + RTMP_HANDSHAKE_SIZE];
+    uint8_t s0s1s2[1 + 2 * RTMP_HANDSHAKE_SIZE];
+    uint8_t c2[RTMP_HANDSHAKE_SIZE];
+    rtmp_handshake_benchmark_t* ctx = (rtmp_handshake_benchmark_t*)param;
+
+    for (uint32_t timestamp = 0; *ctx->running; timestamp++)
+    {
+        rtmp_handshake_c0(c0c1, RTMP_VERSION);
+        rtmp_handshake_c1(c0c1 + 1, timestamp);
+
+        rtmp_handshake_s0(s0s1s2, RTMP_VERSION);
+        rtmp_handshake_s1(s0s1s2 + 1, timestamp, c0c1 + 1, RTMP_HANDSHAKE_SIZE);
+        rtmp_handshake_s2(s0s1s2 + 1 + RTMP_HANDSHAKE_SIZE, timestamp, c0c1 + 1, RTMP_HANDSHAKE_SIZE);
+
+        rtmp_handshake_c2(c2, timestamp, s0s1s2 + 1, RTMP_HANDSHAKE_SIZE);
+        ctx->count++;
+    }
+    return 0;
+}
+
+static double rtmp_handshake_benchmark_run(int n)
+{
+    volatile int running = 1;
+    rtmp_handshake_benchmark_t ctx[N_THREAD];
+    uint64_t count = 0;
+    uint64_t clock;
+
+    memset(ctx, 0, sizeof(ctx));
+    clock = system_clock();
+    for (int i = 0; i < n; i++)
+    {
+        ctx[i].running = &running;
+        thread_create(&ctx[i].thread, rtmp_handshake_benchmark_onthread, ctx + i);
+    }
+
+    system_sleep(DURATION);
+    running = 0;
+    for (int i = 0; i < n; i++)
+    {
+        thread_destroy(ctx[i].thread);
+        count += ctx[i].count;
+    }
+
+    clock = system_clock() - clock;
+    return count * 1000.0 / (clock ? clock : 1);
+}
+
+// complex handshake(default, OpenSSL digest with make OPENSSL=1): C1/S1/S2/C2 HMAC-SHA256 digest
+void rtmp_handshake_benchmark_test(void)
+{
+    int cpus = system_getcpucount();
+    for (int n = 1; n <= N_THREAD && n <= 2 * cpus; n *= 2)
+    {
+        double v = rtmp_handshake_benchmark_run(n);
+        printf("rtmp handshake threads: %d, handshakes/s: %.0f, per thread: %.0f\n", n, v, v / n);
+    }
+}
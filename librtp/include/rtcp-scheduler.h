@@ -0,0 +1,53 @@
+#ifndef _rtcp_scheduler_h_
+#define _rtcp_scheduler_h_
+
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/// RTCP report scheduler for many RTP sessions(hierarchical timer wheel)
+/// Only due sessions are touched, no need to poll every session's rtp_rtcp_interval.
+struct rtcp_scheduler_t;
+struct rtcp_scheduler_item_t;
+
+enum
+{
+	RTCP_SCHEDULER_FLAG_XR_RRT = 0x01, // append XR Receiver Reference Time Report Block(RFC3611 4.4) to compound RTCP packet
+};
+
+/// @param[in] param rtcp_scheduler_create input param
+/// @param[in] session rtcp_scheduler_add session param
+/// @param[in] rtcp compound RTCP packet(SR/RR + SDES [+ XR])
+/// @param[in] bytes RTCP packet size in byte
+/// @return 0-ok, other-error(don't reschedule, the item is removed)
+typedef int (*rtcp_scheduler_onreport)(void* param, void* session, const void* rtcp, int bytes);
+
+struct rtcp_scheduler_t* rtcp_scheduler_create(rtcp_scheduler_onreport onreport, void* param);
+int rtcp_scheduler_destroy(struct rtcp_scheduler_t* scheduler);
+
+/// @param[in] rtp RTP object(rtp_create), must be valid until rtcp_scheduler_remove
+/// @param[in] session user data(pass to onreport)
+/// @param[in] flags RTCP_SCHEDULER_FLAG_XXX
+/// @param[in] clock current time in microseconds(monotonic)
+/// @return NULL-error, other-scheduler item
+struct rtcp_scheduler_item_t* rtcp_scheduler_add(struct rtcp_scheduler_t* scheduler, void* rtp, void* session, int flags, uint64_t clock);
+
+/// can be called in onreport callback
+/// @return 0-ok, other-error
+int rtcp_scheduler_remove(struct rtcp_scheduler_t* scheduler, struct rtcp_scheduler_item_t* item);
+
+/// send RTCP report for all due sessions, and reschedule by rtp_rtcp_interval
+/// @param[in] clock current time in microseconds(monotonic)
+/// @return >=0-report count, <0-error
+int rtcp_scheduler_process(struct rtcp_scheduler_t* scheduler, uint64_t clock);
+
+/// @param[in] clock current time in microseconds(monotonic)
+/// @return <0-no session, >=0-milliseconds until next report deadline
+int rtcp_scheduler_next(struct rtcp_scheduler_t* scheduler, uint64_t clock);
+
+#if defined(__cplusplus)
+}
+#endif
+#endif /* !_rtcp_scheduler_h_ */
@@ -37,6 +37,13 @@ int rtp_demuxer_rtcp(struct rtp_demuxer_t* rtp, void* buf, int len);
 /// @param[out] duplicate exist in unread queue
 void rtp_demuxer_stats(struct rtp_demuxer_t* rtp, int* lost, int* late, int* misorder, int* duplicate);
 
+/// Hot-path metrics snapshot(build with -DMEDIA_METRICS), see more @media-metrics.h
+/// frames_in/bytes_in-RTP/RTCP packets, frames_out/bytes_out-output frames(onpkt),
+/// buffer_hwm-jitter queue bytes, reorder_hwm-packets behind the newest received packet
+/// @return 0-ok, -ENOSYS-metrics disabled
+struct media_metrics_t;
+int rtp_demuxer_get_metrics(struct rtp_demuxer_t* rtp, struct media_metrics_t* metrics);
+
 #if defined(__cplusplus)
 }
 #endif
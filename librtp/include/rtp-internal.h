@@ -34,6 +34,7 @@ struct rtp_context
 
 struct rtp_member* rtp_sender_fetch(struct rtp_context *ctx, uint32_t ssrc);
 struct rtp_member* rtp_member_fetch(struct rtp_context *ctx, uint32_t ssrc);
+void rtcp_timeout(struct rtp_context *ctx, uint64_t clock, uint64_t td);
 
 int rtcp_input_rtp(struct rtp_context *ctx, const void* data, int bytes);
 int rtcp_input_rtcp(struct rtp_context *ctx, const void* data, int bytes);
@@ -17,6 +17,7 @@ struct rtp_member
 	rtcp_sdes_item_t sdes[9];		// SDES item
 
 	uint64_t rtcp_clock;			// last RTCP SR/RR packet clock(local time)
+	uint64_t clock;					// last received RTP/RTCP packet clock(local time), for member timeout
 
 	uint16_t rtp_seq;				// last send/received RTP packet RTP sequence(in packet header)
 	uint32_t rtp_timestamp;			// last send/received RTP packet RTP timestamp(in packet header)
@@ -10,6 +10,10 @@
 #define RTCP_REPORT_INTERVAL			5000 /* milliseconds RFC3550 p25 */
 #define RTCP_REPORT_INTERVAL_MIN		2500 /* milliseconds RFC3550 p25 */
 
+// RFC3550 6.3.5 Timing Out an SSRC (p27)
+// It is RECOMMENDED that the multiplier M be 5
+#define RTCP_MEMBER_TIMEOUT				5
+
 #define RTP_PAYLOAD_MAX_SIZE			(10 * 1024 * 1024)
 
 #endif /* !_rtp_param_h_ */
@@ -64,6 +64,14 @@ void rtp_payload_decode_destroy(void* decoder);
 /// @return 1-packet handled, 0-packet discard, <0-failed
 int rtp_payload_decode_input(void* decoder, const void* packet, int bytes);
 
+/// Hot-path metrics snapshot(build with -DMEDIA_METRICS), see more @media-metrics.h
+/// encoder: frames_in/bytes_in-input frames, frames_out/bytes_out-RTP packets, allocs-alloc callback
+/// decoder: frames_in/bytes_in-RTP packets, frames_out/bytes_out-output frames
+/// @return 0-ok, -ENOSYS-metrics disabled
+struct media_metrics_t;
+int rtp_payload_encode_get_metrics(void* encoder, struct media_metrics_t* metrics);
+int rtp_payload_decode_get_metrics(void* decoder, struct media_metrics_t* metrics);
+
 /// Set/Get rtp encode packet size(include rtp header)
 void rtp_packet_setsize(int bytes);
 int rtp_packet_getsize(void);
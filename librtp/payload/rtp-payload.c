@@ -2,9 +2,11 @@
 #include "rtp-profile.h"
 #include "rtp-packet.h"
 #include "rtp-payload-internal.h"
+#include "media-metrics.h"
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
+#include <errno.h>
 
 #define TS_PACKET_SIZE 188
 
@@ -17,8 +19,55 @@ struct rtp_payload_delegate_t
 	struct rtp_payload_encode_t* encoder;
 	struct rtp_payload_decode_t* decoder;
 	void* packer;
+
+#if defined(MEDIA_METRICS)
+	struct rtp_payload_t handler; // user handler
+	void* cbparam;
+	struct media_metrics_t metrics;
+#endif
 };
 
+#if defined(MEDIA_METRICS)
+static void* rtp_payload_metrics_alloc(void* param, int bytes)
+{
+	struct rtp_payload_delegate_t* ctx;
+	ctx = (struct rtp_payload_delegate_t*)param;
+	MEDIA_METRICS_ADD(&ctx->metrics, allocs, 1);
+	return ctx->handler.alloc(ctx->cbparam, bytes);
+}
+
+static void rtp_payload_metrics_free(void* param, void *packet)
+{
+	struct rtp_payload_delegate_t* ctx;
+	ctx = (struct rtp_payload_delegate_t*)param;
+	ctx->handler.free(ctx->cbparam, packet);
+}
+
+static int rtp_payload_metrics_packet(void* param, const void *packet, int bytes, uint32_t timestamp, int flags)
+{
+	int r;
+	struct rtp_payload_delegate_t* ctx;
+	ctx = (struct rtp_payload_delegate_t*)param;
+	MEDIA_METRICS_ADD(&ctx->metrics, frames_out, 1);
+	MEDIA_METRICS_ADD(&ctx->metrics, bytes_out, bytes);
+	MEDIA_METRICS_CALL(&ctx->metrics, r, ctx->handler.packet(ctx->cbparam, packet, bytes, timestamp, flags));
+	if (0 != r)
+		MEDIA_METRICS_ADD(&ctx->metrics, errors, 1);
+	return r;
+}
+
+// hook the user handler(the packer copy the handler)
+static struct rtp_payload_t* rtp_payload_metrics_hook(struct rtp_payload_delegate_t* ctx, const struct rtp_payload_t* handler, void* cbparam, struct rtp_payload_t* hook)
+{
+	memcpy(&ctx->handler, handler, sizeof(ctx->handler));
+	ctx->cbparam = cbparam;
+	hook->alloc = handler->alloc ? rtp_payload_metrics_alloc : NULL;
+	hook->free = handler->free ? rtp_payload_metrics_free : NULL;
+	hook->packet = handler->packet ? rtp_payload_metrics_packet : NULL;
+	return hook;
+}
+#endif
+
 /// @return 0-ok, <0-error
 static int rtp_payload_find(int payload, const char* encoding, struct rtp_payload_delegate_t* codec);
 
@@ -26,11 +75,18 @@ void* rtp_payload_encode_create(int payload, const char* name, uint16_t seq, uin
 {
 	int size;
 	struct rtp_payload_delegate_t* ctx;
+#if defined(MEDIA_METRICS)
+	struct rtp_payload_t hook;
+#endif
 
 	ctx = calloc(1, sizeof(*ctx));
 	if (ctx)
 	{
 		size = rtp_packet_getsize();
+#if defined(MEDIA_METRICS)
+		handler = rtp_payload_metrics_hook(ctx, handler, cbparam, &hook);
+		cbparam = ctx;
+#endif
 		if (rtp_payload_find(payload, name, ctx) < 0
 			|| NULL == (ctx->packer = ctx->encoder->create(size, (uint8_t)payload, seq, ssrc, handler, cbparam)))
 		{
@@ -58,17 +114,30 @@ void rtp_payload_encode_getinfo(void* encoder, uint16_t* seq, uint32_t* timestam
 
 int rtp_payload_encode_input(void* encoder, const void* data, int bytes, uint32_t timestamp)
 {
+	int r;
 	struct rtp_payload_delegate_t* ctx;
 	ctx = (struct rtp_payload_delegate_t*)encoder;
-	return ctx->encoder->input(ctx->packer, data, bytes, timestamp);
+	MEDIA_METRICS_ADD(&ctx->metrics, frames_in, 1);
+	MEDIA_METRICS_ADD(&ctx->metrics, bytes_in, bytes);
+	r = ctx->encoder->input(ctx->packer, data, bytes, timestamp);
+	if (r < 0)
+		MEDIA_METRICS_ADD(&ctx->metrics, errors, 1);
+	return r;
 }
 
 void* rtp_payload_decode_create(int payload, const char* name, struct rtp_payload_t *handler, void* cbparam)
 {
 	struct rtp_payload_delegate_t* ctx;
+#if defined(MEDIA_METRICS)
+	struct rtp_payload_t hook;
+#endif
 	ctx = calloc(1, sizeof(*ctx));
 	if (ctx)
 	{
+#if defined(MEDIA_METRICS)
+		handler = rtp_payload_metrics_hook(ctx, handler, cbparam, &hook);
+		cbparam = ctx;
+#endif
 		if (rtp_payload_find(payload, name, ctx) < 0
 			|| NULL == (ctx->packer = ctx->decoder->create(handler, cbparam)))
 		{
@@ -89,9 +158,37 @@ void rtp_payload_decode_destroy(void* decoder)
 
 int rtp_payload_decode_input(void* decoder, const void* packet, int bytes)
 {
+	int r;
 	struct rtp_payload_delegate_t* ctx;
 	ctx = (struct rtp_payload_delegate_t*)decoder;
-	return ctx->decoder->input(ctx->packer, packet, bytes);
+	MEDIA_METRICS_ADD(&ctx->metrics, frames_in, 1);
+	MEDIA_METRICS_ADD(&ctx->metrics, bytes_in, bytes);
+	r = ctx->decoder->input(ctx->packer, packet, bytes);
+	if (r < 0)
+		MEDIA_METRICS_ADD(&ctx->metrics, errors, 1);
+	return r;
+}
+
+static int rtp_payload_get_metrics(void* delegate, struct media_metrics_t* metrics)
+{
+#if defined(MEDIA_METRICS)
+	media_metrics_snapshot(metrics, &((struct rtp_payload_delegate_t*)delegate)->metrics);
+	return 0;
+#else
+	(void)delegate;
+	memset(metrics, 0, sizeof(*metrics));
+	return -ENOSYS;
+#endif
+}
+
+int rtp_payload_encode_get_metrics(void* encoder, struct media_metrics_t* metrics)
+{
+	return rtp_payload_get_metrics(encoder, metrics);
+}
+
+int rtp_payload_decode_get_metrics(void* decoder, struct media_metrics_t* metrics)
+{
+	return rtp_payload_get_metrics(decoder, metrics);
 }
 
 // Default max packet size (1500, minus allowance for IP, UDP, UMTP headers)
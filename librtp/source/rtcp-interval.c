@@ -13,12 +13,13 @@ double drand48(void)
 }
 #endif
 
-double rtcp_interval(int members,
+static double rtcp_interval_calc(int members,
 					int senders,
 					double rtcp_bw,
 					int we_sent,
 					double avg_rtcp_size,
-					int initial)
+					int initial,
+					int deterministic)
 {
 	/*
 	* Minimum average time between RTCP packets from this site (in
@@ -86,8 +87,9 @@ double rtcp_interval(int members,
 	* time interval we send one report so this time is also our
 	* average time between reports.
 	*/
-	t = avg_rtcp_size * n / rtcp_bw;
+	t = rtcp_bw > 0 ? avg_rtcp_size * n / rtcp_bw : 0;
 	if (t < rtcp_min_time) t = rtcp_min_time;
+	if (deterministic) return t;
 
 	/*
 	* To avoid traffic bursts from unintended synchronization with
@@ -98,3 +100,23 @@ double rtcp_interval(int members,
 	t = t / COMPENSATION;
 	return t;
 }
+
+double rtcp_interval(int members,
+					int senders,
+					double rtcp_bw,
+					int we_sent,
+					double avg_rtcp_size,
+					int initial)
+{
+	return rtcp_interval_calc(members, senders, rtcp_bw, we_sent, avg_rtcp_size, initial, 0);
+}
+
+/// RFC3550 6.3.5 Timing Out an SSRC (p27)
+/// the deterministic calculated interval Td for a receiver, that is, with we_sent false
+double rtcp_interval_deterministic(int members,
+					int senders,
+					double rtcp_bw,
+					double avg_rtcp_size)
+{
+	return rtcp_interval_calc(members, senders, rtcp_bw, 0, avg_rtcp_size, 0, 1);
+}
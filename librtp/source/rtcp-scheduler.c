@@ -0,0 +1,420 @@
+// RTCP report scheduler, hierarchical timer wheel(like linux kernel timer)
+
+#include "rtcp-scheduler.h"
+#include "rtp-internal.h"
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+
+#define RTCP_SCHEDULER_TICK		10000 // 10ms(in microseconds)
+
+#define TV0_BITS 8 // 256 * 10ms = 2.56s
+#define TV1_BITS 6 // 64 * 2.56s = 163.84s
+#define TV2_BITS 6 // 64 * 163.84s = 2.9h
+#define TV0_SIZE (1 << TV0_BITS)
+#define TV1_SIZE (1 << TV1_BITS)
+#define TV2_SIZE (1 << TV2_BITS)
+#define TV0_MASK (TV0_SIZE - 1)
+#define TV1_MASK (TV1_SIZE - 1)
+#define TV2_MASK (TV2_SIZE - 1)
+#define TV1_INDEX(tick) (int)(((tick) >> TV0_BITS) & TV1_MASK)
+#define TV2_INDEX(tick) (int)(((tick) >> (TV0_BITS + TV1_BITS)) & TV2_MASK)
+#define TV_MAX_TICKS ((uint64_t)1 << (TV0_BITS + TV1_BITS + TV2_BITS))
+
+struct rtcp_scheduler_link_t
+{
+	struct rtcp_scheduler_link_t *prev, *next;
+};
+
+struct rtcp_scheduler_item_t
+{
+	struct rtcp_scheduler_link_t link; // must be the first member
+	uint64_t expire; // in tick
+
+	void* rtp;
+	void* session;
+	int flags;
+};
+
+struct rtcp_scheduler_t
+{
+	uint64_t tick; // next tick to be processed
+	int count; // session count
+
+	struct rtcp_scheduler_link_t tv0[TV0_SIZE];
+	struct rtcp_scheduler_link_t tv1[TV1_SIZE];
+	struct rtcp_scheduler_link_t tv2[TV2_SIZE];
+
+	struct rtcp_scheduler_item_t* running; // in onreport callback
+
+	rtcp_scheduler_onreport onreport;
+	void* param;
+
+	uint8_t rtcp[1500]; // compound RTCP packet, MTU
+};
+
+static inline void rtcp_scheduler_link_init(struct rtcp_scheduler_link_t* head)
+{
+	head->prev = head->next = head;
+}
+
+static inline void rtcp_scheduler_link_insert(struct rtcp_scheduler_link_t* head, struct rtcp_scheduler_link_t* link)
+{
+	link->prev = head->prev;
+	link->next = head;
+	head->prev->next = link;
+	head->prev = link;
+}
+
+static inline void rtcp_scheduler_link_remove(struct rtcp_scheduler_link_t* link)
+{
+	link->prev->next = link->next;
+	link->next->prev = link->prev;
+	link->prev = link->next = link;
+}
+
+/// move all items from src list to dst list(dst must be empty)
+static inline void rtcp_scheduler_link_replace(struct rtcp_scheduler_link_t* src, struct rtcp_scheduler_link_t* dst)
+{
+	if (src->next == src)
+	{
+		rtcp_scheduler_link_init(dst);
+		return;
+	}
+
+	dst->next = src->next;
+	dst->prev = src->prev;
+	dst->next->prev = dst;
+	dst->prev->next = dst;
+	rtcp_scheduler_link_init(src);
+}
+
+static void rtcp_scheduler_insert(struct rtcp_scheduler_t* s, struct rtcp_scheduler_item_t* item)
+{
+	uint64_t delta;
+	struct rtcp_scheduler_link_t* head;
+
+	if (item->expire < s->tick)
+	{
+		// expired, process at next tick
+		head = &s->tv0[s->tick & TV0_MASK];
+	}
+	else
+	{
+		delta = item->expire - s->tick;
+		if (delta < TV0_SIZE)
+		{
+			head = &s->tv0[item->expire & TV0_MASK];
+		}
+		else if (delta < (TV0_SIZE << TV1_BITS))
+		{
+			head = &s->tv1[TV1_INDEX(item->expire)];
+		}
+		else
+		{
+			if (delta >= TV_MAX_TICKS)
+				item->expire = s->tick + TV_MAX_TICKS - 1; // clamp
+			head = &s->tv2[TV2_INDEX(item->expire)];
+		}
+	}
+
+	rtcp_scheduler_link_insert(head, &item->link);
+}
+
+/// re-insert all items of the high level slot
+/// @return slot index
+static int rtcp_scheduler_cascade(struct rtcp_scheduler_t* s, struct rtcp_scheduler_link_t* tv, int index)
+{
+	struct rtcp_scheduler_link_t list, *link;
+	rtcp_scheduler_link_replace(&tv[index], &list);
+	while (list.next != &list)
+	{
+		link = list.next;
+		rtcp_scheduler_link_remove(link);
+		rtcp_scheduler_insert(s, (struct rtcp_scheduler_item_t*)link);
+	}
+	return index;
+}
+
+static int rtcp_scheduler_report(struct rtcp_scheduler_t* s, struct rtcp_scheduler_item_t* item)
+{
+	int n, r;
+	rtcp_xr_t xr;
+
+	n = rtp_rtcp_report(item->rtp, s->rtcp, sizeof(s->rtcp));
+	if (n <= 0 || n > (int)sizeof(s->rtcp))
+		return 0; // ignore, try again next interval
+
+	if (item->flags & RTCP_SCHEDULER_FLAG_XR_RRT)
+	{
+		memset(&xr, 0, sizeof(xr));
+		xr.u.rrt = clock2ntp(rtpclock());
+		r = rtp_rtcp_xr(item->rtp, s->rtcp + n, sizeof(s->rtcp) - n, RTCP_XR_RRT, &xr);
+		if (r > 0 && n + r <= (int)sizeof(s->rtcp))
+			n += r;
+	}
+
+	return s->onreport(s->param, item->session, s->rtcp, n);
+}
+
+struct rtcp_scheduler_t* rtcp_scheduler_create(rtcp_scheduler_onreport onreport, void* param)
+{
+	int i;
+	struct rtcp_scheduler_t* s;
+	s = (struct rtcp_scheduler_t*)calloc(1, sizeof(*s));
+	if (!s)
+		return NULL;
+
+	for (i = 0; i < TV0_SIZE; i++)
+		rtcp_scheduler_link_init(&s->tv0[i]);
+	for (i = 0; i < TV1_SIZE; i++)
+		rtcp_scheduler_link_init(&s->tv1[i]);
+	for (i = 0; i < TV2_SIZE; i++)
+		rtcp_scheduler_link_init(&s->tv2[i]);
+
+	s->onreport = onreport;
+	s->param = param;
+	return s;
+}
+
+static void rtcp_scheduler_free_list(struct rtcp_scheduler_link_t* tv, int n)
+{
+	int i;
+	struct rtcp_scheduler_link_t* link;
+	for (i = 0; i < n; i++)
+	{
+		while (tv[i].next != &tv[i])
+		{
+			link = tv[i].next;
+			rtcp_scheduler_link_remove(link);
+			free(link);
+		}
+	}
+}
+
+int rtcp_scheduler_destroy(struct rtcp_scheduler_t* s)
+{
+	if (!s)
+		return -1;
+
+	rtcp_scheduler_free_list(s->tv0, TV0_SIZE);
+	rtcp_scheduler_free_list(s->tv1, TV1_SIZE);
+	rtcp_scheduler_free_list(s->tv2, TV2_SIZE);
+	free(s);
+	return 0;
+}
+
+struct rtcp_scheduler_item_t* rtcp_scheduler_add(struct rtcp_scheduler_t* s, void* rtp, void* session, int flags, uint64_t clock)
+{
+	struct rtcp_scheduler_item_t* item;
+	item = (struct rtcp_scheduler_item_t*)calloc(1, sizeof(*item));
+	if (!item)
+		return NULL;
+
+	item->rtp = rtp;
+	item->session = session;
+	item->flags = flags;
+
+	if (0 == s->count && NULL == s->running)
+		s->tick = clock / RTCP_SCHEDULER_TICK; // idle, jump to now
+
+	// RFC3550 6.2 initial RTCP interval
+	item->expire = (clock + (uint64_t)rtp_rtcp_interval(rtp) * 1000) / RTCP_SCHEDULER_TICK;
+	rtcp_scheduler_link_init(&item->link);
+	rtcp_scheduler_insert(s, item);
+	s->count++;
+	return item;
+}
+
+int rtcp_scheduler_remove(struct rtcp_scheduler_t* s, struct rtcp_scheduler_item_t* item)
+{
+	if (!item)
+		return -EINVAL;
+
+	assert(s->count > 0);
+	s->count--;
+	if (item == s->running)
+	{
+		// free by rtcp_scheduler_process
+		s->running = NULL;
+		return 0;
+	}
+
+	rtcp_scheduler_link_remove(&item->link);
+	free(item);
+	return 0;
+}
+
+int rtcp_scheduler_process(struct rtcp_scheduler_t* s, uint64_t clock)
+{
+	int n, index;
+	uint64_t tick;
+	struct rtcp_scheduler_item_t* item;
+	struct rtcp_scheduler_link_t list;
+
+	n = 0;
+	tick = clock / RTCP_SCHEDULER_TICK;
+	while (s->tick <= tick)
+	{
+		index = (int)(s->tick & TV0_MASK);
+		if (0 == index && 0 == rtcp_scheduler_cascade(s, s->tv1, TV1_INDEX(s->tick)))
+			rtcp_scheduler_cascade(s, s->tv2, TV2_INDEX(s->tick));
+
+		s->tick++;
+		rtcp_scheduler_link_replace(&s->tv0[index], &list);
+		while (list.next != &list)
+		{
+			item = (struct rtcp_scheduler_item_t*)list.next;
+			rtcp_scheduler_link_remove(&item->link);
+
+			s->running = item;
+			if (0 != rtcp_scheduler_report(s, item) && s->running)
+				rtcp_scheduler_remove(s, item); // onreport failed
+			n++;
+
+			if (!s->running)
+			{
+				// removed in callback
+				free(item);
+				continue;
+			}
+
+			s->running = NULL;
+			item->expire = (clock + (uint64_t)rtp_rtcp_interval(item->rtp) * 1000) / RTCP_SCHEDULER_TICK;
+			rtcp_scheduler_insert(s, item);
+		}
+
+		if (0 == s->count)
+		{
+			s->tick = tick + 1; // idle, don't walk empty slots
+			break;
+		}
+	}
+
+	return n;
+}
+
+static int rtcp_scheduler_min_expire(struct rtcp_scheduler_link_t* head, uint64_t* expire)
+{
+	struct rtcp_scheduler_link_t* link;
+	for (link = head->next; link != head; link = link->next)
+	{
+		if (((struct rtcp_scheduler_item_t*)link)->expire < *expire)
+			*expire = ((struct rtcp_scheduler_item_t*)link)->expire;
+	}
+	return head->next != head ? 1 : 0;
+}
+
+int rtcp_scheduler_next(struct rtcp_scheduler_t* s, uint64_t clock)
+{
+	int i, found;
+	uint64_t now, expire;
+
+	if (0 == s->count)
+		return -1;
+
+	now = clock / RTCP_SCHEDULER_TICK;
+	if (now < s->tick)
+		now = s->tick;
+
+	// first level: exact tick
+	for (i = 0; s->tick + i <= (s->tick | TV0_MASK); i++)
+	{
+		if (s->tv0[(s->tick + i) & TV0_MASK].next != &s->tv0[(s->tick + i) & TV0_MASK])
+		{
+			expire = s->tick + i;
+			return expire <= now ? 0 : (int)((expire * RTCP_SCHEDULER_TICK - clock) / 1000);
+		}
+	}
+
+	// high level: min expire of the first non-empty slot(current slot is the last round)
+	found = 0;
+	expire = UINT64_MAX;
+	for (i = 1; i <= TV1_SIZE && !found; i++)
+		found = rtcp_scheduler_min_expire(&s->tv1[(TV1_INDEX(s->tick) + i) & TV1_MASK], &expire);
+	for (i = 1; i <= TV2_SIZE && !found; i++)
+		found = rtcp_scheduler_min_expire(&s->tv2[(TV2_INDEX(s->tick) + i) & TV2_MASK], &expire);
+
+	// items in the tail of the first level(wrapped)
+	for (i = 0; i < TV0_SIZE; i++)
+		rtcp_scheduler_min_expire(&s->tv0[i], &expire);
+
+	if (UINT64_MAX == expire)
+		return -1;
+	return expire <= now ? 0 : (int)((expire * RTCP_SCHEDULER_TICK - clock) / 1000);
+}
+
+#if defined(_DEBUG) || defined(DEBUG)
+#include <stdio.h>
+
+struct rtcp_scheduler_test_t
+{
+	int reports[64];
+	int bytes;
+};
+
+static int rtcp_scheduler_onreport_test(void* param, void* session, const void* rtcp, int bytes)
+{
+	struct rtcp_scheduler_test_t* t;
+	t = (struct rtcp_scheduler_test_t*)param;
+	t->reports[(intptr_t)session]++;
+	t->bytes += bytes;
+	assert(bytes > 0 && RTCP_RR == ((const uint8_t*)rtcp)[1]);
+	return 0;
+}
+
+static void rtcp_scheduler_onrtcp_test(void* param, const struct rtcp_msg_t* msg)
+{
+	(void)param, (void)msg;
+}
+
+void rtcp_scheduler_test(void)
+{
+	int i, n, total;
+	uint64_t clock;
+	void* rtp[64];
+	struct rtcp_scheduler_t* s;
+	struct rtcp_scheduler_item_t* items[64];
+	struct rtcp_scheduler_test_t t;
+	struct rtp_event_t handler;
+
+	memset(&t, 0, sizeof(t));
+	handler.on_rtcp = rtcp_scheduler_onrtcp_test;
+	s = rtcp_scheduler_create(rtcp_scheduler_onreport_test, &t);
+
+	clock = 1000000000;
+	for (i = 0; i < sizeof(rtp) / sizeof(rtp[0]); i++)
+	{
+		rtp[i] = rtp_create(&handler, NULL, (uint32_t)i + 1, 0, 90000, 2 * 1024 * 1024, 0);
+		items[i] = rtcp_scheduler_add(s, rtp[i], (void*)(intptr_t)i, (i % 2) ? RTCP_SCHEDULER_FLAG_XR_RRT : 0, clock);
+		assert(items[i]);
+	}
+
+	// initial interval: [0.5, 1.5] * 2.5s / 1.21828
+	n = rtcp_scheduler_next(s, clock);
+	assert(n >= 1000 && n <= 3100);
+	assert(0 == rtcp_scheduler_process(s, clock + (uint64_t)(n - 10) * 1000));
+
+	// 10 minutes, 1 second step
+	for (total = 0; total < 600; total++)
+	{
+		clock += 1000000;
+		rtcp_scheduler_process(s, clock);
+		n = rtcp_scheduler_next(s, clock);
+		assert(n >= 0 && n <= 7000);
+	}
+
+	for (i = 0; i < sizeof(rtp) / sizeof(rtp[0]); i++)
+	{
+		// RTCP interval [0.5, 1.5] * 5s / 1.21828 => 2.05s ~ 6.16s
+		assert(t.reports[i] >= 600 / 7 && t.reports[i] <= 600 / 2 + 1);
+		assert(0 == rtcp_scheduler_remove(s, items[i]));
+		rtp_destroy(rtp[i]);
+	}
+
+	assert(-1 == rtcp_scheduler_next(s, clock));
+	assert(0 == rtcp_scheduler_process(s, clock + 3600 * 1000000ULL));
+	rtcp_scheduler_destroy(s);
+}
+#endif
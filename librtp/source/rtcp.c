@@ -1,5 +1,6 @@
 #include "rtp-internal.h"
 #include "rtp-packet.h"
+#include "rtp-param.h"
 #include "rtp-util.h"
 #include <stdio.h>
 #include <stdlib.h>
@@ -102,6 +103,9 @@ struct rtp_member* rtp_member_fetch(struct rtp_context *ctx, uint32_t ssrc)
 			//ctx->handler.on_rtcp(ctx->cbparam, &msg);
 		}
 	}
+
+	if(p)
+		p->clock = rtpclock();
 	return p;
 }
 
@@ -118,9 +122,42 @@ struct rtp_member* rtp_sender_fetch(struct rtp_context *ctx, uint32_t ssrc)
 			rtp_member_list_add(ctx->senders, p);
 		}
 	}
+	else
+	{
+		p->clock = rtpclock();
+	}
 	return p;
 }
 
+void rtcp_timeout(struct rtp_context *ctx, uint64_t clock, uint64_t td)
+{
+	int i;
+	struct rtp_member *p;
+
+	// RFC3550 6.3.5 Timing Out an SSRC
+	// If a participant in the sender table has not sent RTP packets since time tc - 2T,
+	// the participant is removed from the sender table.
+	// Delete in reverse order, rtp_member_list_delete move the last member to the hole.
+	for (i = rtp_member_list_count(ctx->senders) - 1; i >= 0; i--)
+	{
+		p = rtp_member_list_get(ctx->senders, i);
+		if (MAX(p->rtp_clock, p->rtcp_clock) + 2 * td < clock)
+			rtp_member_list_delete(ctx->senders, p->ssrc);
+	}
+
+	// If no RTP or RTCP packet has been received since time tc - M*Td,
+	// the member is timed out.
+	for (i = rtp_member_list_count(ctx->members) - 1; i >= 0; i--)
+	{
+		p = rtp_member_list_get(ctx->members, i);
+		if (p != ctx->self && p->clock + RTCP_MEMBER_TIMEOUT * td < clock)
+		{
+			rtp_member_list_delete(ctx->senders, p->ssrc);
+			rtp_member_list_delete(ctx->members, p->ssrc);
+		}
+	}
+}
+
 static int rtcp_parse(struct rtp_context *ctx, const unsigned char* data, size_t bytes)
 {
 	int n;
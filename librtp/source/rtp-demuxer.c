@@ -6,6 +6,7 @@
 #include "rtp-param.h"
 #include "rtp.h"
 #include "rtcp-header.h"
+#include "media-metrics.h"
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
@@ -26,16 +27,30 @@ struct rtp_demuxer_t
     
     rtp_demuxer_onpacket onpkt;
     void* param;
+
+#if defined(MEDIA_METRICS)
+    struct media_metrics_t metrics;
+    uint64_t buffered; // bytes of the queued packets
+    uint16_t seq; // max received sequence number
+    int seq_valid;
+#endif
 };
 
 static int rtp_onpacket(void* param, const void *packet, int bytes, uint32_t timestamp, int flags)
 {
+    int r;
     struct rtp_demuxer_t* rtp;
     rtp = (struct rtp_demuxer_t*)param;
     
     // TODO: rtp timestamp -> pts/dts
     
-    return rtp->onpkt ? rtp->onpkt(rtp->param, packet, bytes, timestamp, flags) : -1;
+    if (!rtp->onpkt)
+        return -1;
+
+    MEDIA_METRICS_ADD(&rtp->metrics, frames_out, 1);
+    MEDIA_METRICS_ADD(&rtp->metrics, bytes_out, bytes);
+    MEDIA_METRICS_CALL(&rtp->metrics, r, rtp->onpkt(rtp->param, packet, bytes, timestamp, flags));
+    return r;
 }
 
 static void rtp_on_rtcp(void* param, const struct rtcp_msg_t* msg)
@@ -66,6 +81,7 @@ static struct rtp_packet_t* rtp_demuxer_alloc(struct rtp_demuxer_t* rtp, const v
         rtp->cap = r;
         rtp->ptr = ptr;
         *(int*)ptr = r; /*cap*/
+        MEDIA_METRICS_ADD(&rtp->metrics, allocs, 1);
     }
 
     *((int*)rtp->ptr + 1) = bytes; /*bytes*/
@@ -78,6 +94,10 @@ static struct rtp_packet_t* rtp_demuxer_alloc(struct rtp_demuxer_t* rtp, const v
     
     rtp->cap = 0; // need more memory
     rtp->ptr = NULL;
+#if defined(MEDIA_METRICS)
+    rtp->buffered += bytes;
+    MEDIA_METRICS_MAX(&rtp->metrics, buffer_hwm, rtp->buffered);
+#endif
     return pkt;
 }
 
@@ -89,6 +109,9 @@ static void rtp_demuxer_freepkt(void* param, struct rtp_packet_t* pkt)
     rtp = (struct rtp_demuxer_t*)param;
     ptr = (uint8_t*)pkt - sizeof(int) /*cap*/ - sizeof(int) /*bytes*/ ;
     cap = *(int*)ptr;
+#if defined(MEDIA_METRICS)
+    rtp->buffered -= *((int*)ptr + 1); /*bytes*/
+#endif
     
     if(cap <= rtp->cap)
     {
@@ -102,6 +125,23 @@ static void rtp_demuxer_freepkt(void* param, struct rtp_packet_t* pkt)
     rtp->ptr = ptr;
 }
 
+#if defined(MEDIA_METRICS)
+static void rtp_demuxer_reorder(struct rtp_demuxer_t* rtp, const struct rtp_packet_t* pkt)
+{
+    int16_t delta;
+    delta = (int16_t)(rtp->seq - (uint16_t)pkt->rtp.seq);
+    if (!rtp->seq_valid || delta < 0)
+    {
+        rtp->seq = (uint16_t)pkt->rtp.seq;
+        rtp->seq_valid = 1;
+    }
+    else
+    {
+        MEDIA_METRICS_MAX(&rtp->metrics, reorder_hwm, delta); // packets behind the newest one
+    }
+}
+#endif
+
 static int rtp_demuxer_init(struct rtp_demuxer_t* rtp, int jitter, int frequency, int payload, const char* encoding)
 {
     uint32_t timestamp;
@@ -176,8 +216,13 @@ int rtp_demuxer_input(struct rtp_demuxer_t* rtp, const void* data, int bytes)
     uint8_t pt;
     struct rtp_packet_t* pkt;
     
+    MEDIA_METRICS_ADD(&rtp->metrics, frames_in, 1);
+    MEDIA_METRICS_ADD(&rtp->metrics, bytes_in, bytes);
     if (bytes < 12 || bytes > rtp->max)
+    {
+        MEDIA_METRICS_ADD(&rtp->metrics, errors, 1);
         return -EINVAL;
+    }
 
     pt = ((uint8_t*)data)[1];
     // RFC7983 SRTP: https://tools.ietf.org/html/draft-ietf-avtcore-rfc5764-mux-fixes
@@ -190,6 +235,9 @@ int rtp_demuxer_input(struct rtp_demuxer_t* rtp, const void* data, int bytes)
         if (!pkt)
             return -ENOMEM;
 
+#if defined(MEDIA_METRICS)
+        rtp_demuxer_reorder(rtp, pkt);
+#endif
         r = rtp_queue_write(rtp->queue, pkt);
         if(r <= 0) // 0-discard packet(duplicate/too late)
         {
@@ -207,7 +255,10 @@ int rtp_demuxer_input(struct rtp_demuxer_t* rtp, const void* data, int bytes)
             r = rtp_payload_decode_input(rtp->payload, pkt + 1, bytes);
             rtp_demuxer_freepkt(rtp, pkt);
             if(r < 0)
+            {
+                MEDIA_METRICS_ADD(&rtp->metrics, errors, 1);
                 return r;
+            }
     
             pkt = rtp_queue_read(rtp->queue);
         }
@@ -251,3 +302,15 @@ void rtp_demuxer_stats(struct rtp_demuxer_t* rtp, int* lost, int* late, int* mis
     if (misorder) *misorder = stats.reorder;
     if (duplicate) *duplicate = stats.duplicate;
 }
+
+int rtp_demuxer_get_metrics(struct rtp_demuxer_t* rtp, struct media_metrics_t* metrics)
+{
+#if defined(MEDIA_METRICS)
+    media_metrics_snapshot(metrics, &rtp->metrics);
+    return 0;
+#else
+    (void)rtp;
+    memset(metrics, 0, sizeof(*metrics));
+    return -ENOSYS;
+#endif
+}
@@ -5,6 +5,7 @@
 #include <errno.h>
 
 #define N_SOURCE 2 // unicast(1S + 1R)
+#define N_INDEX_THRESHOLD 8 // build SSRC hash index when members more than threshold
 
 struct rtp_member_list
 {
@@ -12,8 +13,83 @@ struct rtp_member_list
 	struct rtp_member **ptr;
 	int count;
 	int capacity;
+
+	// SSRC hash index(open addressing, linear probing)
+	// slot value: member index + 1, 0-empty
+	int *index;
+	int slots; // power of 2
+	int shift; // 32 - log2(slots)
 };
 
+static inline struct rtp_member** rtp_member_list_at(struct rtp_member_list *p, int i)
+{
+	return i < N_SOURCE ? &p->members[i] : &p->ptr[i - N_SOURCE];
+}
+
+static inline int rtp_member_list_hash(struct rtp_member_list *p, uint32_t ssrc)
+{
+	// Fibonacci hashing, SSRC maybe chosen by a poor random generator
+	return (int)((ssrc * 2654435761U) >> p->shift);
+}
+
+/// @return slot of ssrc, -1 if not found
+static int rtp_member_list_index_find(struct rtp_member_list *p, uint32_t ssrc)
+{
+	int i;
+	for (i = rtp_member_list_hash(p, ssrc); p->index[i]; i = (i + 1) & (p->slots - 1))
+	{
+		if ((*rtp_member_list_at(p, p->index[i] - 1))->ssrc == ssrc)
+			return i;
+	}
+	return -1;
+}
+
+static void rtp_member_list_index_insert(struct rtp_member_list *p, uint32_t ssrc, int idx)
+{
+	int i;
+	for (i = rtp_member_list_hash(p, ssrc); p->index[i]; i = (i + 1) & (p->slots - 1))
+	{
+	}
+	p->index[i] = idx + 1;
+}
+
+/// remove slot i with backward shift deletion(no tombstone)
+static void rtp_member_list_index_remove(struct rtp_member_list *p, int i)
+{
+	int j, k;
+	for (j = (i + 1) & (p->slots - 1); p->index[j]; j = (j + 1) & (p->slots - 1))
+	{
+		k = rtp_member_list_hash(p, (*rtp_member_list_at(p, p->index[j] - 1))->ssrc);
+		// move j to i if home slot k is cyclically outside (i, j]
+		if (i <= j ? (i < k && k <= j) : (i < k || k <= j))
+			continue;
+
+		p->index[i] = p->index[j];
+		i = j;
+	}
+	p->index[i] = 0;
+}
+
+static int rtp_member_list_index_rebuild(struct rtp_member_list *p, int slots)
+{
+	int i;
+	int* index;
+	index = (int*)calloc(slots, sizeof(int));
+	if (!index)
+		return -ENOMEM;
+
+	if (p->index)
+		free(p->index);
+	p->index = index;
+	p->slots = slots;
+	for (p->shift = 32; slots > 1; slots >>= 1)
+		p->shift--;
+
+	for (i = 0; i < p->count; i++)
+		rtp_member_list_index_insert(p, (*rtp_member_list_at(p, i))->ssrc, i);
+	return 0;
+}
+
 void* rtp_member_list_create()
 {
 	return (struct rtp_member_list *)calloc(1, sizeof(struct rtp_member_list));
@@ -27,7 +103,7 @@ void rtp_member_list_destroy(void* members)
 
 	for(i = 0; i < p->count; i++)
 	{
-		rtp_member_release(i >= N_SOURCE ? p->ptr[i-N_SOURCE] : p->members[i]);
+		rtp_member_release(*rtp_member_list_at(p, i));
 	}
 
 	if(p->ptr)
@@ -36,6 +112,12 @@ void rtp_member_list_destroy(void* members)
 		free(p->ptr);
 	}
 
+	if (p->index)
+	{
+		assert(p->slots > 0);
+		free(p->index);
+	}
+
 	free(p);
 }
 
@@ -53,7 +135,7 @@ struct rtp_member* rtp_member_list_get(void* members, int index)
 	if(index >= p->count || index < 0)
 		return NULL;
 
-	return index >= N_SOURCE ? p->ptr[index-N_SOURCE] : p->members[index];
+	return *rtp_member_list_at(p, index);
 }
 
 struct rtp_member* rtp_member_list_find(void* members, uint32_t ssrc)
@@ -63,9 +145,15 @@ struct rtp_member* rtp_member_list_find(void* members, uint32_t ssrc)
 	struct rtp_member_list *p;
 	p = (struct rtp_member_list *)members;
 
+	if (p->index)
+	{
+		i = rtp_member_list_index_find(p, ssrc);
+		return i < 0 ? NULL : *rtp_member_list_at(p, p->index[i] - 1);
+	}
+
 	for(i = 0; i < p->count; i++)
 	{
-		s = i < N_SOURCE ? p->members[i] : p->ptr[i-N_SOURCE];
+		s = *rtp_member_list_at(p, i);
 		if(s->ssrc == ssrc)
 			return s;
 	}
@@ -74,6 +162,7 @@ struct rtp_member* rtp_member_list_find(void* members, uint32_t ssrc)
 
 int rtp_member_list_add(void* members, struct rtp_member* s)
 {
+	int slots;
 	struct rtp_member_list *p;
 	p = (struct rtp_member_list *)members;
 
@@ -82,19 +171,29 @@ int rtp_member_list_add(void* members, struct rtp_member* s)
 		if(p->count - N_SOURCE >= p->capacity)
 		{
 			void* ptr;
-			ptr = (struct rtp_member **)realloc(p->ptr, (p->capacity+8)*sizeof(struct rtp_member*));
+			ptr = (struct rtp_member **)realloc(p->ptr, (p->capacity * 2 + 8)*sizeof(struct rtp_member*));
 			if(!ptr)
 				return -ENOMEM;
 			p->ptr = ptr;
-			p->capacity += 8;
+			p->capacity = p->capacity * 2 + 8;
 		}
-		p->ptr[p->count - N_SOURCE] = s;
 	}
-	else
+
+	// keep load factor <= 0.5
+	if (p->count + 1 > N_INDEX_THRESHOLD && (p->count + 1) * 2 > p->slots)
 	{
-		p->members[p->count] = s;
+		for (slots = p->slots ? p->slots * 2 : 4 * N_INDEX_THRESHOLD; (p->count + 1) * 2 > slots; slots *= 2)
+		{
+		}
+
+		if (0 != rtp_member_list_index_rebuild(p, slots))
+			return -ENOMEM;
 	}
 
+	*rtp_member_list_at(p, p->count) = s;
+	if (p->index)
+		rtp_member_list_index_insert(p, s->ssrc, p->count);
+
 	rtp_member_addref(s);
 	p->count++;
 	return 0;
@@ -102,42 +201,98 @@ int rtp_member_list_add(void* members, struct rtp_member* s)
 
 int rtp_member_list_delete(void* members, uint32_t ssrc)
 {
-	int i;
-	struct rtp_member *s;
+	int i, slot;
+	struct rtp_member *s, *last;
 	struct rtp_member_list *p;
 	p = (struct rtp_member_list *)members;
 
-	for(i = 0; i < p->count; i++)
+	if (p->index)
 	{
-		s = i < N_SOURCE ? p->members[i] : p->ptr[i-N_SOURCE];
-		if(s->ssrc != ssrc)
-			continue;
-
-		if(i < N_SOURCE)
+		slot = rtp_member_list_index_find(p, ssrc);
+		if (slot < 0)
+			return -1; // NOT_FOUND
+		i = p->index[slot] - 1;
+		rtp_member_list_index_remove(p, slot);
+	}
+	else
+	{
+		for (i = 0; i < p->count; i++)
 		{
-			if(i+1 < N_SOURCE)
-			{
-				memmove(p->members + i, p->members+i+1, (N_SOURCE-i-1) * sizeof(struct rtp_member*));
-			}
-
-			if(p->count > N_SOURCE)
-			{
-				p->members[N_SOURCE-1] = p->ptr[0];
-				memmove(p->ptr, p->ptr + 1, (p->count-N_SOURCE-1) * sizeof(struct rtp_member*));
-			}
+			if ((*rtp_member_list_at(p, i))->ssrc == ssrc)
+				break;
 		}
-		else
+		if (i >= p->count)
+			return -1; // NOT_FOUND
+	}
+
+	// move the last member to the hole, O(1) but members order is changed
+	s = *rtp_member_list_at(p, i);
+	if (i + 1 < p->count)
+	{
+		last = *rtp_member_list_at(p, p->count - 1);
+		*rtp_member_list_at(p, i) = last;
+		if (p->index)
 		{
-			if(i + 1 < p->count)
-			{
-				memmove(p->ptr + i - N_SOURCE, p->ptr + i + 1 - N_SOURCE, (p->count-i-1) * sizeof(struct rtp_member*));
-			}
+			slot = rtp_member_list_index_find(p, last->ssrc);
+			assert(slot >= 0 && p->index[slot] == p->count);
+			p->index[slot] = i + 1;
 		}
+	}
 
+	rtp_member_release(s);
+	p->count--;
+	return 0;
+}
+
+#if defined(_DEBUG) || defined(DEBUG)
+#include <stdio.h>
+#include <time.h>
+void rtp_member_list_test(void)
+{
+	int i, j, n;
+	clock_t t0, t1;
+	void* members;
+	uint32_t ssrc[1000];
+	struct rtp_member* s;
+
+	members = rtp_member_list_create();
+	for (i = 0; i < sizeof(ssrc) / sizeof(ssrc[0]); i++)
+	{
+		// sequential(some SFU) and random SSRC
+		ssrc[i] = (i % 2) ? (uint32_t)rand() * 2654435761U : (uint32_t)i << 16;
+		s = rtp_member_create(ssrc[i]);
+		assert(!rtp_member_list_find(members, ssrc[i]));
+		assert(0 == rtp_member_list_add(members, s));
 		rtp_member_release(s);
-		p->count--;
-		return 0;
+	}
+	assert(rtp_member_list_count(members) == sizeof(ssrc) / sizeof(ssrc[0]));
+
+	t0 = clock();
+	for (n = 0, j = 0; j < 1000; j++)
+	{
+		for (i = 0; i < sizeof(ssrc) / sizeof(ssrc[0]); i++)
+			n += rtp_member_list_find(members, ssrc[i]) ? 1 : 0;
+	}
+	t1 = clock();
+	assert(n == 1000 * sizeof(ssrc) / sizeof(ssrc[0]));
+	printf("rtp_member_list_find: 1000 ssrc, %d lookups, %.1f ns/op\n", n, (t1 - t0) * 1e9 / CLOCKS_PER_SEC / n);
+
+	// delete even members
+	for (i = 0; i < sizeof(ssrc) / sizeof(ssrc[0]); i += 2)
+		assert(0 == rtp_member_list_delete(members, ssrc[i]));
+	assert(-1 == rtp_member_list_delete(members, ssrc[0]));
+	assert(rtp_member_list_count(members) == sizeof(ssrc) / sizeof(ssrc[0]) / 2);
+	for (i = 0; i < sizeof(ssrc) / sizeof(ssrc[0]); i++)
+	{
+		s = rtp_member_list_find(members, ssrc[i]);
+		assert((i % 2) ? (s && s->ssrc == ssrc[i]) : !s);
+	}
+	for (i = 0; i < rtp_member_list_count(members); i++)
+	{
+		s = rtp_member_list_get(members, i);
+		assert(s == rtp_member_list_find(members, s->ssrc));
 	}
 
-	return -1; // NOT_FOUND
+	rtp_member_list_destroy(members);
 }
+#endif
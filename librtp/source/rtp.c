@@ -8,6 +8,7 @@ enum {
 };
 
 double rtcp_interval(int members, int senders, double rtcp_bw, int we_sent, double avg_rtcp_size, int initial);
+double rtcp_interval_deterministic(int members, int senders, double rtcp_bw, double avg_rtcp_size);
 
 void* rtp_create(struct rtp_event_t *handler, void* param, uint32_t ssrc, uint32_t timestamp, int frequence, int bandwidth, int sender)
 {
@@ -89,8 +90,16 @@ int rtp_onreceived_rtcp(void* rtp, const void* rtcp, int bytes)
 int rtp_rtcp_report(void* rtp, void* data, int bytes)
 {
 	int n;
+	double td;
 	struct rtp_context *ctx = (struct rtp_context *)rtp;
 
+	// RFC3550 6.3.5 Timing Out an SSRC
+	// This check should be done at least once per RTCP transmission interval
+	td = rtcp_interval_deterministic(rtp_member_list_count(ctx->members),
+		rtp_member_list_count(ctx->senders) + ((RTP_SENDER == ctx->role) ? 1 : 0),
+		ctx->rtcp_bw, ctx->avg_rtcp_size);
+	rtcp_timeout(ctx, rtpclock(), (uint64_t)(td * 1000000));
+
 #pragma message("update we_sent flag")
 	// don't send packet in 2T
 	//ctx->role = RTP_RECEIVER
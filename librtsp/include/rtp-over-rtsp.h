@@ -21,6 +21,7 @@ struct rtp_over_rtsp_t
 	uint32_t ssrc[8];
 //#endif
 
+	/// @param[in] data point to rtp_over_rtsp input buffer(whole frame) or internal buffer(frame straddle reads), valid in callback only
 	void (*onrtp)(void* param, uint8_t channel, const void* data, uint16_t bytes);
 	void* param;
 };
@@ -15,11 +15,93 @@ struct aio_rtsp_handler_t
 
 	void (*onerror)(void* param, rtsp_server_t* rtsp, int code);
 	void (*onrtp)(void* param, uint8_t channel, const void* data, uint16_t bytes);
+	/// session destroyed, rtsp is invalid after return(optional)
+	void (*onclose)(void* param, rtsp_server_t* rtsp);
 };
 
 void* rtsp_server_listen(const char* ip, int port, struct aio_rtsp_handler_t* handler, void* param);
 int rtsp_server_unlisten(void* aio);
 
+/// Accept sharding with per-worker fanout threads: one listen socket(SO_REUSEPORT) and one
+/// fanout thread per worker. The kernel balances new connections between listeners, and a
+/// session is bound to the worker which accepted it(rtsp_transport_tcp_get_worker).
+/// Media fanout is handed off to the worker thread by rtsp_server_fanout_post, so the send
+/// queues of one worker are only fed by one thread. Without SO_REUSEPORT, one listener
+/// assigns workers round-robin.
+/// Socket I/O(RTSP requests, send completion) runs on the shared libaio worker pool, the
+/// fanout workers only own the publish path.
+typedef struct rtsp_server_fanout_t rtsp_server_fanout_t;
+
+/// @param[in] param rtsp_server_fanout_post param
+/// @param[in] worker worker index, [0, rtsp_server_fanout_count)
+/// @param[in] sessions worker registered sessions(rtsp_server_fanout_register), valid in the task only
+/// @param[in] count sessions count
+typedef void (*rtsp_server_fanout_task)(void* param, int worker, rtsp_server_t* sessions[], int count);
+
+/// @param[in] workers worker count, 0-cpu count
+/// @param[in] depth per worker task queue depth(round up to power of 2), 0-default(4096)
+/// @return NULL-error, other-fanout server
+rtsp_server_fanout_t* rtsp_server_fanout_create(const char* ip, int port, int workers, int depth, struct aio_rtsp_handler_t* handler, void* param);
+/// NOTICE: close all sessions(wait onclose) before destroy
+int rtsp_server_fanout_destroy(rtsp_server_fanout_t* fanout);
+
+/// @return worker count
+int rtsp_server_fanout_count(rtsp_server_fanout_t* fanout);
+
+/// Add session to the accepting worker session list, e.g. on PLAY
+/// @return 0-ok, other-error
+int rtsp_server_fanout_register(rtsp_server_fanout_t* fanout, rtsp_server_t* rtsp);
+
+/// Remove session from the worker session list, MUST call before the session is freed(aio_rtsp_handler_t.onclose)
+/// Wait for the running worker tasks, so don't call it in the fanout task.
+/// @return 0-ok, -ENOENT-not registered
+int rtsp_server_fanout_unregister(rtsp_server_fanout_t* fanout, rtsp_server_t* rtsp);
+
+/// Run task on the worker thread(thread-safe, no memory allocation)
+/// @param[in] worker worker index, see rtsp_transport_tcp_get_worker
+/// @return 0-ok, -ENOBUFS-worker queue full(slow consumer), other-error
+int rtsp_server_fanout_post(rtsp_server_fanout_t* fanout, int worker, rtsp_server_fanout_task task, void* param);
+
+/// Run task on every worker thread, e.g. publisher frame fanout
+/// @return posted worker count
+int rtsp_server_fanout_broadcast(rtsp_server_fanout_t* fanout, rtsp_server_fanout_task task, void* param);
+
+enum
+{
+	RTSP_TRANSPORT_TCP_FLAG_KEYFRAME = 0x01, // video key frame(first packet at least)
+};
+
+struct rtsp_transport_tcp_stats_t
+{
+	size_t bytes; // queued bytes(include sending)
+	int packets; // queued packets(include sending)
+	int delay; // oldest queued packet age in ms
+	uint64_t sent; // total sent bytes
+	uint64_t dropped; // total dropped bytes
+	uint64_t dropped_packets;
+};
+
+/// Send interleaved data by TCP session send queue(rtsp_server_listen only)
+/// Packets are coalesced into one vectored send. When the queue exceeds the high-water mark,
+/// queued interleaved packets are dropped, and video channels(have sent RTSP_TRANSPORT_TCP_FLAG_KEYFRAME)
+/// drop packets until the next key frame. RTSP replies are never dropped.
+/// @param[in] rtsp request handle
+/// @param[in] data interleaved binary data, $ + CHANNEL + LEN + RTP/RTCP packet
+/// @param[in] flags RTSP_TRANSPORT_TCP_FLAG_XXX
+/// @return 0-ok(sent, queued or dropped), other-error code
+int rtsp_transport_tcp_send(rtsp_server_t* rtsp, const void* data, size_t bytes, int flags);
+
+/// Set send queue high-water mark(default 4MB, 3000ms)
+/// @param[in] bytes max queued bytes
+/// @param[in] delay max oldest queued packet age in ms
+int rtsp_transport_tcp_set_limit(rtsp_server_t* rtsp, size_t bytes, int delay);
+
+/// @param[out] stats send queue backlog statistics
+int rtsp_transport_tcp_get_stats(rtsp_server_t* rtsp, struct rtsp_transport_tcp_stats_t* stats);
+
+/// @return >=0-accepting worker index(rtsp_server_fanout_create), -1-rtsp_server_listen session, other-error
+int rtsp_transport_tcp_get_worker(rtsp_server_t* rtsp);
+
 void* rtsp_transport_udp_create(const char* ip, int port, struct rtsp_handler_t* handler, void* param);
 void rtsp_transport_udp_destroy(void* transport);
 
@@ -43,6 +43,66 @@ static const uint8_t* rtp_over_rtsp_try_to_find_next_packet(struct rtp_over_rtsp
 }
 #endif
 
+#if defined(RTP_OVER_RTSP_TRY_TO_FIND_NEXT_PACKET)
+/// @param[in] data rtp packet, at least 12 bytes
+/// @return 0-ok, other-ssrc/version mismatch
+static int rtp_over_rtsp_check(struct rtp_over_rtsp_t* rtp, const uint8_t* data)
+{
+	uint32_t ssrc;
+	memcpy(&ssrc, data + 8, 4);
+
+	if (rtp->check)
+	{
+		if (rtp->channel >= sizeof(rtp->ssrc) / sizeof(rtp->ssrc[0])
+			|| ssrc != rtp->ssrc[rtp->channel]
+			|| RTP_VERSION != (*data >> 6))
+		{
+			return -1;
+		}
+
+		rtp->check = 0;
+	}
+	else if (rtp->channel < sizeof(rtp->ssrc) / sizeof(rtp->ssrc[0]) && 0 == rtp->ssrc[rtp->channel])
+	{
+		assert(RTP_VERSION == (*data >> 6));
+		//assert(0 == rtp->ssrc[rtp->channel] || ssrc == rtp->ssrc[rtp->channel]);
+		rtp->ssrc[rtp->channel] = ssrc;
+	}
+	return 0;
+}
+#endif
+
+/// whole interleaved frame in input buffer, callback without copy
+/// @return data if not a complete frame, other-next frame
+static const uint8_t* rtp_over_rtsp_fast(struct rtp_over_rtsp_t* rtp, const uint8_t* data, const uint8_t* end)
+{
+	uint16_t length;
+	if (end - data < 4 || '$' != data[0])
+		return data;
+
+	length = (uint16_t)((data[2] << 8) | data[3]);
+	if (end - data < 4 + (int)length)
+	{
+		// header in one step, payload straddle reads
+		rtp->channel = data[1];
+		rtp->length = length;
+		rtp->bytes = 0;
+		rtp->state = rtp_data;
+		return data + 4;
+	}
+
+	rtp->channel = data[1];
+	rtp->length = length;
+#if defined(RTP_OVER_RTSP_TRY_TO_FIND_NEXT_PACKET)
+	if (length >= 12 && 0 != rtp_over_rtsp_check(rtp, data + 4))
+		return rtp_over_rtsp_try_to_find_next_packet(rtp, data + 1, end);
+#endif
+
+	if (rtp->onrtp)
+		rtp->onrtp(rtp->param, rtp->channel, data + 4, length);
+	return data + 4 + length;
+}
+
 // 10.12 Embedded (Interleaved) Binary Data
 // Stream data such as RTP packets is encapsulated by an ASCII dollar sign(24 hexadecimal), 
 // followed by a one-byte channel identifier,
@@ -50,6 +110,15 @@ static const uint8_t* rtp_over_rtsp_try_to_find_next_packet(struct rtp_over_rtsp
 const uint8_t* rtp_over_rtsp(struct rtp_over_rtsp_t *rtp, const uint8_t* data, const uint8_t* end)
 {
 	int n;
+	const uint8_t* p;
+
+	if (rtp_start == rtp->state)
+	{
+		// only buffer frame straddle reads
+		p = rtp_over_rtsp_fast(rtp, data, end);
+		if (p != data)
+			return p;
+	}
 
 	for (n = 0; data < end; data++)
 	{
@@ -93,29 +162,10 @@ const uint8_t* rtp_over_rtsp(struct rtp_over_rtsp_t *rtp, const uint8_t* data, c
 			rtp->bytes += (uint16_t)n;
 
 #if defined(RTP_OVER_RTSP_TRY_TO_FIND_NEXT_PACKET)
-			if (rtp->bytes >= 12)
+			if (rtp->bytes >= 12 && rtp->bytes - n < 12 && 0 != rtp_over_rtsp_check(rtp, rtp->data))
 			{
-				uint32_t ssrc;
-				ssrc = *(uint32_t*)(rtp->data + 8);
-
-				if (rtp->check)
-				{
-					if (rtp->channel >= sizeof(rtp->ssrc) / sizeof(rtp->ssrc[0])
-						|| ssrc != rtp->ssrc[rtp->channel]
-						|| RTP_VERSION != (*rtp->data >> 6))
-					{
-						rtp->state = rtp_start;
-						return rtp_over_rtsp_try_to_find_next_packet(rtp, data, end);
-					}
-
-					rtp->check = 0;
-				}
-				else if(rtp->channel < sizeof(rtp->ssrc) / sizeof(rtp->ssrc[0]) && 0 == rtp->ssrc[rtp->channel])
-				{
-					assert(RTP_VERSION == (*rtp->data >> 6));
-					//assert(0 == rtp->ssrc[rtp->channel] || ssrc == rtp->ssrc[rtp->channel]);
-					rtp->ssrc[rtp->channel] = ssrc;
-				}
+				rtp->state = rtp_start;
+				return rtp_over_rtsp_try_to_find_next_packet(rtp, data, end);
 			}
 #endif
 
@@ -0,0 +1,366 @@
+// Accept sharding + per-worker fanout thread, socket I/O stays on the libaio pool(see rtsp-server-aio.h)
+
+#include "rtsp-server-aio.h"
+#include "aio-accept.h"
+#include "sockutil.h"
+#include "sys/sock.h"
+#include "sys/thread.h"
+#include "sys/event.h"
+#include "sys/locker.h"
+#include "sys/system.h"
+#include "sys/atomic.h"
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+
+#define FANOUT_MAX 256
+#define FANOUT_DEPTH 4096 // default per worker queue depth
+
+struct rtsp_server_fanout_task_t
+{
+	rtsp_server_fanout_task task;
+	void* param;
+};
+
+struct rtsp_server_fanout_worker_t
+{
+	struct rtsp_server_fanout_t* fanout;
+	int index;
+
+	socket_t socket; // SO_REUSEPORT listener, socket_invalid-shared listener
+	void* aio;
+
+	pthread_t thread;
+	event_t event;
+	locker_t locker;
+	unsigned int head; // read position
+	unsigned int tail; // write position
+	unsigned int depth; // power of 2
+	struct rtsp_server_fanout_task_t* tasks; // [depth]
+	struct rtsp_server_fanout_task_t* running; // [depth], owned by the worker thread
+
+	// registered sessions, the worker hold the locker when running tasks
+	locker_t slocker;
+	rtsp_server_t** sessions;
+	int count;
+	int capacity;
+};
+
+struct rtsp_server_fanout_t
+{
+	void* param;
+	struct aio_rtsp_handler_t handler;
+
+	volatile int running;
+	int reuseport; // 1-listener per worker, 0-shared listener
+	int32_t next; // round-robin worker(shared listener only), accept callbacks run on the libaio pool
+	int count;
+	struct rtsp_server_fanout_worker_t* workers[FANOUT_MAX];
+};
+
+extern int rtsp_transport_tcp_create(socket_t socket, const struct sockaddr* addr, socklen_t addrlen, struct aio_rtsp_handler_t* handler, void* param, int worker);
+
+static void rtsp_server_fanout_onaccept(void* param, int code, socket_t socket, const struct sockaddr* addr, socklen_t addrlen)
+{
+	int worker;
+	struct rtsp_server_fanout_t* fanout;
+	struct rtsp_server_fanout_worker_t* w;
+	w = (struct rtsp_server_fanout_worker_t*)param;
+	fanout = w->fanout;
+
+	if (0 == code)
+	{
+		// SO_REUSEPORT: session affinity to accepting listener
+		worker = fanout->reuseport ? w->index : (int)((uint32_t)atomic_increment32(&fanout->next) % (unsigned int)fanout->count);
+		rtsp_transport_tcp_create(socket, addr, addrlen, &fanout->handler, fanout->param, worker);
+	}
+}
+
+static socket_t rtsp_server_fanout_listen(const char* ip, int port, int reuseport)
+{
+	int on;
+	socket_t s;
+	socklen_t len;
+	struct sockaddr_storage ss;
+
+	if (0 != socket_addr_from(&ss, &len, ip && *ip ? ip : "0.0.0.0", (u_short)port))
+		return socket_invalid;
+
+	s = AF_INET6 == ss.ss_family ? socket_tcp_ipv6() : socket_tcp();
+	if (socket_invalid == s)
+		return socket_invalid;
+
+	on = 1;
+	socket_setreuseaddr(s, 1);
+#if defined(SO_REUSEPORT)
+	if (reuseport && 0 != setsockopt(s, SOL_SOCKET, SO_REUSEPORT, (const char*)&on, sizeof(on)))
+	{
+		socket_close(s);
+		return socket_invalid;
+	}
+#else
+	(void)reuseport, (void)on;
+#endif
+
+	if (0 != socket_bind(s, (struct sockaddr*)&ss, len) || 0 != socket_listen(s, SOMAXCONN))
+	{
+		socket_close(s);
+		return socket_invalid;
+	}
+	return s;
+}
+
+static int STDCALL rtsp_server_fanout_worker(void* param)
+{
+	int running;
+	unsigned int i, n;
+	struct rtsp_server_fanout_worker_t* w;
+	w = (struct rtsp_server_fanout_worker_t*)param;
+
+	do
+	{
+		// run the remain tasks on exit(release user resources)
+		running = w->fanout->running;
+		if (running)
+			event_timewait(&w->event, 1000);
+
+		// take all pending tasks, run without the queue lock
+		locker_lock(&w->locker);
+		for (n = 0; w->head != w->tail; w->head++)
+			memcpy(&w->running[n++], &w->tasks[w->head & (w->depth - 1)], sizeof(w->running[0]));
+		locker_unlock(&w->locker);
+
+		// unregister wait for the running tasks
+		locker_lock(&w->slocker);
+		for (i = 0; i < n; i++)
+			w->running[i].task(w->running[i].param, w->index, w->sessions, w->count);
+		locker_unlock(&w->slocker);
+	} while (running);
+	return 0;
+}
+
+static void rtsp_server_fanout_worker_destroy(struct rtsp_server_fanout_worker_t* w)
+{
+	if (w->aio)
+		aio_accept_stop(w->aio, NULL, NULL);
+	else if (socket_invalid != w->socket)
+		socket_close(w->socket);
+	assert(0 == w->count);
+	locker_destroy(&w->slocker);
+	locker_destroy(&w->locker);
+	event_destroy(&w->event);
+	free(w->sessions);
+	free(w->tasks);
+	free(w);
+}
+
+static struct rtsp_server_fanout_worker_t* rtsp_server_fanout_worker_create(struct rtsp_server_fanout_t* fanout, int index, socket_t socket, unsigned int depth)
+{
+	struct rtsp_server_fanout_worker_t* w;
+	w = (struct rtsp_server_fanout_worker_t*)calloc(1, sizeof(*w));
+	if (!w)
+		return NULL;
+
+	w->tasks = (struct rtsp_server_fanout_task_t*)malloc(sizeof(w->tasks[0]) * depth * 2);
+	if (!w->tasks)
+	{
+		free(w);
+		return NULL;
+	}
+
+	w->fanout = fanout;
+	w->index = index;
+	w->socket = socket;
+	w->depth = depth;
+	w->running = w->tasks + depth;
+	locker_create(&w->locker);
+	locker_create(&w->slocker);
+	event_create(&w->event);
+	if (0 != thread_create(&w->thread, rtsp_server_fanout_worker, w))
+	{
+		w->socket = socket_invalid; // don't close caller socket
+		rtsp_server_fanout_worker_destroy(w);
+		return NULL;
+	}
+	return w;
+}
+
+rtsp_server_fanout_t* rtsp_server_fanout_create(const char* ip, int port, int workers, int depth, struct aio_rtsp_handler_t* handler, void* param)
+{
+	int i;
+	unsigned int n;
+	socket_t socket;
+	struct rtsp_server_fanout_t* fanout;
+
+	workers = workers > 0 ? workers : system_getcpucount();
+	workers = workers < FANOUT_MAX ? workers : FANOUT_MAX;
+	depth = depth > 0 ? depth : FANOUT_DEPTH;
+	for (n = 1; n < (unsigned int)depth && n < 0x1000000; n <<= 1)
+		; // power of 2: head/tail wrap-around
+
+	fanout = (struct rtsp_server_fanout_t*)calloc(1, sizeof(*fanout));
+	if (!fanout)
+		return NULL;
+
+	fanout->param = param;
+	fanout->running = 1;
+	memcpy(&fanout->handler, handler, sizeof(fanout->handler));
+
+#if defined(SO_REUSEPORT)
+	fanout->reuseport = 1;
+#endif
+
+	for (i = 0; i < workers; i++)
+	{
+		socket = (fanout->reuseport || 0 == i) ? rtsp_server_fanout_listen(ip, port, fanout->reuseport) : socket_invalid;
+		if (socket_invalid == socket && (fanout->reuseport || 0 == i))
+			break;
+
+		fanout->workers[i] = rtsp_server_fanout_worker_create(fanout, i, socket, n);
+		if (!fanout->workers[i])
+		{
+			if (socket_invalid != socket)
+				socket_close(socket);
+			break;
+		}
+		fanout->count = i + 1;
+	}
+
+	// start accept after all workers ready
+	for (i = 0; i < fanout->count && fanout->count == workers; i++)
+	{
+		if (socket_invalid == fanout->workers[i]->socket)
+			continue;
+
+		fanout->workers[i]->aio = aio_accept_start(fanout->workers[i]->socket, rtsp_server_fanout_onaccept, fanout->workers[i]);
+		if (!fanout->workers[i]->aio)
+			break;
+	}
+
+	if (fanout->count != workers || i != workers)
+	{
+		rtsp_server_fanout_destroy(fanout);
+		return NULL;
+	}
+	return fanout;
+}
+
+int rtsp_server_fanout_destroy(rtsp_server_fanout_t* fanout)
+{
+	int i;
+	struct rtsp_server_fanout_worker_t* w;
+
+	fanout->running = 0;
+	for (i = 0; i < fanout->count; i++)
+	{
+		w = fanout->workers[i];
+		if (w->aio)
+		{
+			aio_accept_stop(w->aio, NULL, NULL);
+			w->aio = NULL;
+			w->socket = socket_invalid;
+		}
+		event_signal(&w->event);
+	}
+
+	for (i = 0; i < fanout->count; i++)
+	{
+		w = fanout->workers[i];
+		thread_destroy(w->thread);
+		rtsp_server_fanout_worker_destroy(w);
+	}
+
+	free(fanout);
+	return 0;
+}
+
+int rtsp_server_fanout_count(rtsp_server_fanout_t* fanout)
+{
+	return fanout->count;
+}
+
+int rtsp_server_fanout_register(rtsp_server_fanout_t* fanout, rtsp_server_t* rtsp)
+{
+	int worker;
+	void* ptr;
+	struct rtsp_server_fanout_worker_t* w;
+
+	worker = rtsp_transport_tcp_get_worker(rtsp);
+	if (worker < 0 || worker >= fanout->count)
+		return -EINVAL;
+
+	w = fanout->workers[worker];
+	locker_lock(&w->slocker);
+	if (w->count >= w->capacity)
+	{
+		ptr = realloc(w->sessions, sizeof(w->sessions[0]) * (w->capacity + 64));
+		if (!ptr)
+		{
+			locker_unlock(&w->slocker);
+			return -ENOMEM;
+		}
+		w->sessions = (rtsp_server_t**)ptr;
+		w->capacity += 64;
+	}
+	w->sessions[w->count++] = rtsp;
+	locker_unlock(&w->slocker);
+	return 0;
+}
+
+int rtsp_server_fanout_unregister(rtsp_server_fanout_t* fanout, rtsp_server_t* rtsp)
+{
+	int i, worker;
+	struct rtsp_server_fanout_worker_t* w;
+
+	worker = rtsp_transport_tcp_get_worker(rtsp);
+	if (worker < 0 || worker >= fanout->count)
+		return -EINVAL;
+
+	w = fanout->workers[worker];
+	locker_lock(&w->slocker);
+	for (i = 0; i < w->count; i++)
+	{
+		if (w->sessions[i] == rtsp)
+		{
+			w->sessions[i] = w->sessions[--w->count];
+			locker_unlock(&w->slocker);
+			return 0;
+		}
+	}
+	locker_unlock(&w->slocker);
+	return -ENOENT;
+}
+
+int rtsp_server_fanout_post(rtsp_server_fanout_t* fanout, int worker, rtsp_server_fanout_task task, void* param)
+{
+	struct rtsp_server_fanout_worker_t* w;
+	if (worker < 0 || worker >= fanout->count || !task)
+		return -EINVAL;
+
+	w = fanout->workers[worker];
+	locker_lock(&w->locker);
+	if (w->tail - w->head >= w->depth)
+	{
+		locker_unlock(&w->locker);
+		return -ENOBUFS;
+	}
+	w->tasks[w->tail & (w->depth - 1)].task = task;
+	w->tasks[w->tail & (w->depth - 1)].param = param;
+	w->tail++;
+	locker_unlock(&w->locker);
+
+	event_signal(&w->event);
+	return 0;
+}
+
+int rtsp_server_fanout_broadcast(rtsp_server_fanout_t* fanout, rtsp_server_fanout_task task, void* param)
+{
+	int i, n;
+	for (n = i = 0; i < fanout->count; i++)
+	{
+		if (0 == rtsp_server_fanout_post(fanout, i, task, param))
+			++n;
+	}
+	return n;
+}
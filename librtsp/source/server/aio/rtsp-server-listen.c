@@ -10,7 +10,7 @@ struct rtsp_server_listen_t
 	struct aio_rtsp_handler_t handler;
 };
 
-extern int rtsp_transport_tcp_create(socket_t socket, const struct sockaddr* addr, socklen_t addrlen, struct aio_rtsp_handler_t* handler, void* param);
+extern int rtsp_transport_tcp_create(socket_t socket, const struct sockaddr* addr, socklen_t addrlen, struct aio_rtsp_handler_t* handler, void* param, int worker);
 
 static void rtsp_server_onaccept(void* param, int code, socket_t socket, const struct sockaddr* addr, socklen_t addrlen)
 {
@@ -19,7 +19,7 @@ static void rtsp_server_onaccept(void* param, int code, socket_t socket, const s
 
 	if (0 == code)
 	{
-		rtsp_transport_tcp_create(socket, addr, addrlen, &p->handler, p->param);
+		rtsp_transport_tcp_create(socket, addr, addrlen, &p->handler, p->param, -1);
 	}
 	else
 	{
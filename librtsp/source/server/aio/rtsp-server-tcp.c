@@ -1,9 +1,12 @@
 #include "rtsp-server-aio.h"
+#include "../rtsp-server-internal.h"
 #include "aio-transport.h"
 #include "rtp-over-rtsp.h"
 #include "sys/sock.h"
 #include "sys/atomic.h"
+#include "sys/locker.h"
 #include "sys/system.h"
+#include "list.h"
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
@@ -12,6 +15,18 @@
 #define TIMEOUT_RECV 65000
 #define TIMEOUT_SEND 10000
 
+#define VEC 64 // packets per writev
+#define SEND_LIMIT_BYTES (4 * 1024 * 1024)
+#define SEND_LIMIT_DELAY 3000 // ms
+
+struct rtsp_send_packet_t
+{
+	struct list_head link;
+	uint64_t clock; // enqueue time(ms)
+	size_t size;
+	uint8_t data[1];
+};
+
 struct rtsp_session_t
 {
 	socket_t socket;
@@ -20,23 +35,40 @@ struct rtsp_session_t
 	int rtsp_need_more_data;
 	uint8_t buffer[4 * 1024];
 
+	// send queue, RTSP reply and interleaved data in order
+	locker_t locker;
+	struct list_head packets;
+	socket_bufvec_t vec[VEC];
+	int vecsize; // in-flight packets(list head), 0-idle
+	int code; // send error
+	size_t limit_bytes;
+	int limit_delay;
+	uint32_t video[8]; // channel bitmap, have sent key frame
+	uint32_t wait[8]; // channel bitmap, drop until next key frame
+	struct rtsp_transport_tcp_stats_t stats;
+
 	struct rtsp_server_t *rtsp;
 	struct sockaddr_storage addr;
 	socklen_t addrlen;
+	int worker; // fanout worker index, -1-none
 
 	void (*onerror)(void* param, rtsp_server_t* rtsp, int code);
+	void (*onclose)(void* param, rtsp_server_t* rtsp);
 	void (*onrtp)(void* param, uint8_t channel, const void* data, uint16_t bytes);
 	void* param;
 };
 
 static void rtsp_session_ondestroy(void* param)
 {
+	struct list_head *p, *n;
 	struct rtsp_session_t *session;
 	session = (struct rtsp_session_t *)param;
 
 	// user call rtsp_server_destroy
 	if (session->rtsp)
 	{
+		if (session->onclose)
+			session->onclose(session->param, session->rtsp);
 		rtsp_server_destroy(session->rtsp);
 		session->rtsp = NULL;
 	}
@@ -49,6 +81,12 @@ static void rtsp_session_ondestroy(void* param)
 		session->rtp.capacity = 0;
 	}
 
+	list_for_each_safe(p, n, &session->packets)
+	{
+		free(list_entry(p, struct rtsp_send_packet_t, link));
+	}
+	locker_destroy(&session->locker);
+
 #if defined(_DEBUG) || defined(DEBUG)
 	memset(session, 0xCC, sizeof(*session));
 #endif
@@ -105,30 +143,212 @@ static void rtsp_session_onrecv(void* param, int code, size_t bytes)
 	}
 }
 
+/// send queued packets if idle
+static int rtsp_session_flush(struct rtsp_session_t* session)
+{
+	int r;
+	struct list_head* p;
+	struct rtsp_send_packet_t* pkt;
+
+	locker_lock(&session->locker);
+	if (0 != session->vecsize /*sending*/ || list_empty(&session->packets) /*no more data*/ || 0 != session->code)
+	{
+		r = session->code;
+		locker_unlock(&session->locker);
+		return r;
+	}
+
+	// coalesce many interleaved packets into one writev
+	for (p = session->packets.next; session->vecsize < VEC && p != &session->packets; p = p->next)
+	{
+		pkt = list_entry(p, struct rtsp_send_packet_t, link);
+		socket_setbufvec(session->vec, session->vecsize++, pkt->data, pkt->size);
+	}
+	r = session->vecsize;
+	locker_unlock(&session->locker);
+
+	// vec/vecsize are owned by the in-flight send until onsend
+	r = aio_transport_send_v(session->aio, session->vec, r);
+	if (0 != r)
+	{
+		locker_lock(&session->locker);
+		session->vecsize = 0; // nothing in-flight
+		session->code = r;
+		locker_unlock(&session->locker);
+	}
+	return r;
+}
+
 static void rtsp_session_onsend(void* param, int code, size_t bytes)
 {
+	struct rtsp_send_packet_t* pkt;
 	struct rtsp_session_t *session;
 	session = (struct rtsp_session_t *)param;
-//	session->server->onsend(session, code, bytes);
+
+	if (0 == code)
+	{
+		locker_lock(&session->locker);
+		for (assert(session->vecsize > 0); session->vecsize > 0; --session->vecsize)
+		{
+			assert(!list_empty(&session->packets));
+			pkt = list_entry(session->packets.next, struct rtsp_send_packet_t, link);
+			list_remove(&pkt->link);
+			session->stats.bytes -= pkt->size;
+			session->stats.packets -= 1;
+			free(pkt);
+		}
+		session->stats.sent += bytes;
+		locker_unlock(&session->locker);
+
+		code = rtsp_session_flush(session); // send next
+	}
+
 	if (0 != code)
 	{
+		locker_lock(&session->locker);
+		session->code = code;
+		locker_unlock(&session->locker);
 		session->onerror(session->param, session->rtsp, code);
 		aio_transport_destroy(session->aio);
 	}
-	(void)bytes;
+}
+
+/// drop queued(not in-flight) interleaved packets, video channels wait for next key frame
+/// NOTICE: call with locker
+static void rtsp_session_drop(struct rtsp_session_t* session)
+{
+	int i;
+	uint8_t channel;
+	struct list_head *p, *n;
+	struct rtsp_send_packet_t* pkt;
+
+	i = 0;
+	list_for_each_safe(p, n, &session->packets)
+	{
+		pkt = list_entry(p, struct rtsp_send_packet_t, link);
+		if (i++ < session->vecsize || '$' != pkt->data[0] || pkt->size < 4)
+			continue; // in-flight or RTSP reply
+
+		channel = pkt->data[1];
+		if (session->video[channel / 32] & (1u << (channel % 32)))
+			session->wait[channel / 32] |= 1u << (channel % 32);
+
+		list_remove(&pkt->link);
+		session->stats.bytes -= pkt->size;
+		session->stats.packets -= 1;
+		session->stats.dropped += pkt->size;
+		session->stats.dropped_packets += 1;
+		free(pkt);
+	}
+}
+
+static int rtsp_session_enqueue(struct rtsp_session_t* session, const void* data, size_t bytes, int flags)
+{
+	uint8_t channel;
+	uint64_t clock;
+	struct rtsp_send_packet_t* pkt;
+
+	clock = system_clock();
+	locker_lock(&session->locker);
+	if (0 != session->code)
+	{
+		locker_unlock(&session->locker);
+		return -ENOTCONN;
+	}
+
+	if (bytes >= 4 && '$' == *(const uint8_t*)data)
+	{
+		channel = ((const uint8_t*)data)[1];
+		if (RTSP_TRANSPORT_TCP_FLAG_KEYFRAME & flags)
+			session->video[channel / 32] |= 1u << (channel % 32);
+
+		// high-water mark: backlog bytes or oldest packet age
+		if (!list_empty(&session->packets) && (session->stats.bytes + bytes > session->limit_bytes
+			|| clock > list_entry(session->packets.next, struct rtsp_send_packet_t, link)->clock + session->limit_delay))
+		{
+			rtsp_session_drop(session);
+		}
+
+		// drop first, then the key frame resume the channel
+		if (RTSP_TRANSPORT_TCP_FLAG_KEYFRAME & flags)
+			session->wait[channel / 32] &= ~(1u << (channel % 32));
+
+		if (session->wait[channel / 32] & (1u << (channel % 32)))
+		{
+			session->stats.dropped += bytes;
+			session->stats.dropped_packets += 1;
+			locker_unlock(&session->locker);
+			return 0;
+		}
+	}
+
+	pkt = (struct rtsp_send_packet_t*)malloc(sizeof(*pkt) + bytes);
+	if (!pkt)
+	{
+		locker_unlock(&session->locker);
+		return -ENOMEM;
+	}
+	pkt->clock = clock;
+	pkt->size = bytes;
+	memcpy(pkt->data, data, bytes);
+	list_insert_before(&pkt->link, &session->packets); // link to end
+	session->stats.bytes += bytes;
+	session->stats.packets += 1;
+	locker_unlock(&session->locker);
+
+	return rtsp_session_flush(session);
 }
 
 static int rtsp_session_send(void* ptr, const void* data, size_t bytes)
 {
-	struct rtsp_session_t *session;
-	session = (struct rtsp_session_t *)ptr;
-	//return aio_tcp_transport_send(session->aio, data, bytes);
+	return rtsp_session_enqueue((struct rtsp_session_t *)ptr, data, bytes, 0);
+}
+
+int rtsp_transport_tcp_send(rtsp_server_t* rtsp, const void* data, size_t bytes, int flags)
+{
+	if (rtsp->handler.send != rtsp_session_send)
+		return -EINVAL; // not aio tcp transport
+	return rtsp_session_enqueue((struct rtsp_session_t*)rtsp->sendparam, data, bytes, flags);
+}
+
+int rtsp_transport_tcp_set_limit(rtsp_server_t* rtsp, size_t bytes, int delay)
+{
+	struct rtsp_session_t* session;
+	if (rtsp->handler.send != rtsp_session_send)
+		return -EINVAL; // not aio tcp transport
 
-	// TODO: send multiple rtp packet once time
-	return bytes == socket_send(session->socket, data, bytes, 0) ? 0 : -1;
+	session = (struct rtsp_session_t*)rtsp->sendparam;
+	locker_lock(&session->locker);
+	session->limit_bytes = bytes;
+	session->limit_delay = delay;
+	locker_unlock(&session->locker);
+	return 0;
+}
+
+int rtsp_transport_tcp_get_stats(rtsp_server_t* rtsp, struct rtsp_transport_tcp_stats_t* stats)
+{
+	uint64_t clock;
+	struct rtsp_session_t* session;
+	if (rtsp->handler.send != rtsp_session_send)
+		return -EINVAL; // not aio tcp transport
+
+	clock = system_clock();
+	session = (struct rtsp_session_t*)rtsp->sendparam;
+	locker_lock(&session->locker);
+	memcpy(stats, &session->stats, sizeof(*stats));
+	stats->delay = list_empty(&session->packets) ? 0 : (int)(clock - list_entry(session->packets.next, struct rtsp_send_packet_t, link)->clock);
+	locker_unlock(&session->locker);
+	return 0;
+}
+
+int rtsp_transport_tcp_get_worker(rtsp_server_t* rtsp)
+{
+	if (rtsp->handler.send != rtsp_session_send)
+		return -EINVAL; // not aio tcp transport
+	return ((struct rtsp_session_t*)rtsp->sendparam)->worker;
 }
 
-int rtsp_transport_tcp_create(socket_t socket, const struct sockaddr* addr, socklen_t addrlen, struct aio_rtsp_handler_t* handler, void* param)
+int rtsp_transport_tcp_create(socket_t socket, const struct sockaddr* addr, socklen_t addrlen, struct aio_rtsp_handler_t* handler, void* param, int worker)
 {
 	char ip[65];
 	unsigned short port;
@@ -148,6 +368,11 @@ int rtsp_transport_tcp_create(socket_t socket, const struct sockaddr* addr, sock
 	if (!session) return -ENOMEM;
 
 	session->socket = socket;
+	session->worker = worker;
+	LIST_INIT_HEAD(&session->packets);
+	locker_create(&session->locker);
+	session->limit_bytes = SEND_LIMIT_BYTES;
+	session->limit_delay = SEND_LIMIT_DELAY;
 	socket_addr_to(addr, addrlen, ip, &port);
 	assert(addrlen <= sizeof(session->addr));
 	session->addrlen = addrlen < sizeof(session->addr) ? addrlen : sizeof(session->addr);
@@ -165,6 +390,7 @@ int rtsp_transport_tcp_create(socket_t socket, const struct sockaddr* addr, sock
 	
 	session->rtp.param = param;
 	session->rtp.onrtp = handler->onrtp;
+	session->onclose = handler->onclose;
 	aio_transport_set_timeout(session->aio, TIMEOUT_RECV, TIMEOUT_SEND);
 	if (0 != aio_transport_recv(session->aio, session->buffer, sizeof(session->buffer)))
 	{
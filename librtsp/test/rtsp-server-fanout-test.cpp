@@ -0,0 +1,354 @@
+// Loopback load generator for the fanout RTSP server(rtsp_server_fanout_create)
+// 1. N clients DESCRIBE/SETUP(RTP/AVP/TCP)/PLAY, report sessions/second
+// 2. publisher thread fanout frames to every worker, report CPU per stream
+#if defined(_DEBUG) || defined(DEBUG)
+#include "sys/sock.h"
+#include "sys/thread.h"
+#include "sys/system.h"
+#include "sys/atomic.h"
+#include "sockutil.h"
+#include "aio-worker.h"
+#include "rtsp-server.h"
+#include "rtsp-server-aio.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <vector>
+#if !defined(OS_WINDOWS)
+#include <time.h>
+#include <sys/resource.h>
+#endif
+
+#define N_AIO_THREAD 4
+#define N_CLIENT_THREAD 8
+#define N_SESSIONS 2000
+#define N_SECONDS 10
+#define RTSP_PORT 8555
+
+#define FRAME_PACKETS 4 // RTP packets per frame
+#define FRAME_INTERVAL 40 // ms, 25fps
+#define PACKET_SIZE 1400
+
+struct rtsp_fanout_frame_t
+{
+	int32_t ref;
+	int keyframe;
+	uint8_t data[FRAME_PACKETS][4 + PACKET_SIZE];
+};
+
+struct rtsp_fanout_client_t
+{
+	int index;
+	std::vector<socket_t> sockets;
+	int64_t bytes;
+	int64_t cpu; // receive thread cpu time(us)
+};
+
+static rtsp_server_fanout_t* s_fanout;
+static volatile int s_running;
+static int32_t s_session;
+static int32_t s_playing;
+
+static int64_t thread_cpu_time(void)
+{
+#if defined(OS_WINDOWS)
+	return 0;
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+	return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#endif
+}
+
+static int64_t process_cpu_time(void)
+{
+#if defined(OS_WINDOWS)
+	return 0;
+#else
+	struct rusage ru;
+	getrusage(RUSAGE_SELF, &ru);
+	return (int64_t)(ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1000000 + ru.ru_utime.tv_usec + ru.ru_stime.tv_usec;
+#endif
+}
+
+static void rtsp_fanout_onframe(void* param, int /*worker*/, rtsp_server_t* sessions[], int count)
+{
+	int i, j;
+	struct rtsp_fanout_frame_t* frame;
+	frame = (struct rtsp_fanout_frame_t*)param;
+
+	for (i = 0; i < count; i++)
+	{
+		for (j = 0; j < FRAME_PACKETS; j++)
+			rtsp_transport_tcp_send(sessions[i], frame->data[j], sizeof(frame->data[j]), (0 == j && frame->keyframe) ? RTSP_TRANSPORT_TCP_FLAG_KEYFRAME : 0);
+	}
+
+	if (0 == atomic_decrement32(&frame->ref))
+		free(frame);
+}
+
+static int STDCALL rtsp_fanout_publisher(void* /*param*/)
+{
+	int i, j, n, count;
+	uint16_t seq = 0;
+	uint32_t timestamp = 0;
+	struct rtsp_fanout_frame_t* frame;
+
+	count = rtsp_server_fanout_count(s_fanout);
+	for (i = 0; s_running; i++)
+	{
+		frame = (struct rtsp_fanout_frame_t*)malloc(sizeof(*frame));
+		frame->ref = count;
+		frame->keyframe = 0 == i % 50 ? 1 : 0;
+		for (j = 0; j < FRAME_PACKETS; j++)
+		{
+			memset(frame->data[j], 0, sizeof(frame->data[j]));
+			frame->data[j][0] = '$';
+			frame->data[j][1] = 0; // channel
+			frame->data[j][2] = (uint8_t)(PACKET_SIZE >> 8);
+			frame->data[j][3] = (uint8_t)PACKET_SIZE;
+			frame->data[j][4] = 0x80; // RTP v2
+			frame->data[j][5] = (uint8_t)(96 | (j + 1 == FRAME_PACKETS ? 0x80 : 0));
+			frame->data[j][6] = (uint8_t)(seq >> 8);
+			frame->data[j][7] = (uint8_t)seq++;
+			frame->data[j][8] = (uint8_t)(timestamp >> 24);
+			frame->data[j][9] = (uint8_t)(timestamp >> 16);
+			frame->data[j][10] = (uint8_t)(timestamp >> 8);
+			frame->data[j][11] = (uint8_t)timestamp;
+		}
+		timestamp += 90 * FRAME_INTERVAL;
+
+		// the publisher don't touch sessions, only hand off the frame to fanout workers
+		n = rtsp_server_fanout_broadcast(s_fanout, rtsp_fanout_onframe, frame);
+		for (; n < count; n++)
+		{
+			if (0 == atomic_decrement32(&frame->ref))
+				free(frame);
+		}
+		system_sleep(FRAME_INTERVAL);
+	}
+	return 0;
+}
+
+static int rtsp_fanout_ondescribe(void* /*ptr*/, rtsp_server_t* rtsp, const char* /*uri*/)
+{
+	static const char* sdp =
+		"v=0\n"
+		"o=- 0 0 IN IP4 127.0.0.1\n"
+		"s=fanout\n"
+		"c=IN IP4 0.0.0.0\n"
+		"t=0 0\n"
+		"a=range:npt=now-\n"
+		"a=control:*\n"
+		"m=video 0 RTP/AVP 96\n"
+		"a=rtpmap:96 H264/90000\n"
+		"a=control:track1\n";
+	return rtsp_server_reply_describe(rtsp, 200, sdp);
+}
+
+static int rtsp_fanout_onsetup(void* /*ptr*/, rtsp_server_t* rtsp, const char* /*uri*/, const char* /*session*/, const struct rtsp_header_transport_t /*transports*/[], size_t /*num*/)
+{
+	char session[32];
+	snprintf(session, sizeof(session), "%08X", (unsigned int)atomic_increment32(&s_session));
+	return rtsp_server_reply_setup(rtsp, 200, session, "RTP/AVP/TCP;unicast;interleaved=0-1");
+}
+
+static int rtsp_fanout_onplay(void* /*ptr*/, rtsp_server_t* rtsp, const char* /*uri*/, const char* /*session*/, const int64_t* /*npt*/, const double* /*scale*/)
+{
+	int r;
+	r = rtsp_server_reply_play(rtsp, 200, NULL, NULL, NULL);
+	// session affinity: register to the accepting worker, fanout by the worker thread only
+	if (0 == rtsp_server_fanout_register(s_fanout, rtsp))
+		atomic_increment32(&s_playing);
+	return r;
+}
+
+static int rtsp_fanout_onteardown(void* /*ptr*/, rtsp_server_t* rtsp, const char* /*uri*/, const char* /*session*/)
+{
+	return rtsp_server_reply_teardown(rtsp, 200);
+}
+
+static int rtsp_fanout_onclose(void* /*ptr2*/)
+{
+	return 0;
+}
+
+static void rtsp_fanout_onerror(void* /*param*/, rtsp_server_t* /*rtsp*/, int /*code*/)
+{
+}
+
+static void rtsp_fanout_onsessionclose(void* /*param*/, rtsp_server_t* rtsp)
+{
+	// the worker don't fanout to the session after unregister
+	if (0 == rtsp_server_fanout_unregister(s_fanout, rtsp))
+		atomic_decrement32(&s_playing);
+}
+
+static int rtsp_fanout_request(socket_t s, const char* req, char* session)
+{
+	int r, n, len;
+	const char* p;
+	char reply[2048];
+
+	if ((int)strlen(req) != socket_send_all_by_time(s, req, strlen(req), 0, 5000))
+		return -1;
+
+	for (n = 0; n + 1 < (int)sizeof(reply); n += r)
+	{
+		r = socket_recv_by_time(s, reply + n, sizeof(reply) - 1 - n, 0, 5000);
+		if (r <= 0)
+			return -1;
+		reply[n + r] = 0;
+
+		p = strstr(reply, "\r\n\r\n");
+		if (!p)
+			continue;
+
+		len = strstr(reply, "Content-Length:") ? atoi(strstr(reply, "Content-Length:") + 15) : 0;
+		if (n + r < (int)(p + 4 - reply) + len)
+			continue; // wait for sdp
+
+		if (session && (p = strstr(reply, "Session:")))
+			sscanf(p + 8, " %31[^;\r\n]", session);
+		return 0 == strncmp(reply, "RTSP/1.0 200", 12) ? 0 : -1;
+	}
+	return -1;
+}
+
+static int rtsp_fanout_connect(int id, socket_t* socket)
+{
+	char req[512];
+	char session[32];
+	socket_t s;
+
+	session[0] = 0;
+	s = socket_connect_host("127.0.0.1", RTSP_PORT, 5000);
+	if (socket_invalid == s)
+		return -1;
+
+	snprintf(req, sizeof(req), "DESCRIBE rtsp://127.0.0.1:%d/live/fanout RTSP/1.0\r\nCSeq: 1\r\nAccept: application/sdp\r\n\r\n", RTSP_PORT);
+	if (0 == rtsp_fanout_request(s, req, NULL))
+	{
+		snprintf(req, sizeof(req), "SETUP rtsp://127.0.0.1:%d/live/fanout/track1 RTSP/1.0\r\nCSeq: 2\r\nTransport: RTP/AVP/TCP;unicast;interleaved=0-1\r\n\r\n", RTSP_PORT);
+		if (0 == rtsp_fanout_request(s, req, session))
+		{
+			snprintf(req, sizeof(req), "PLAY rtsp://127.0.0.1:%d/live/fanout RTSP/1.0\r\nCSeq: 3\r\nSession: %s\r\nRange: npt=0.000-\r\n\r\n", RTSP_PORT, session);
+			if (0 == rtsp_fanout_request(s, req, NULL))
+			{
+				*socket = s;
+				return 0;
+			}
+		}
+	}
+
+	printf("rtsp_fanout_connect(%d) failed\n", id);
+	socket_close(s);
+	return -1;
+}
+
+static int STDCALL rtsp_fanout_client(void* param)
+{
+	int i, r;
+	int64_t cpu;
+	socket_t s;
+	char buffer[64 * 1024];
+	struct rtsp_fanout_client_t* client;
+	client = (struct rtsp_fanout_client_t*)param;
+
+	for (i = client->index; i < N_SESSIONS; i += N_CLIENT_THREAD)
+	{
+		if (0 == rtsp_fanout_connect(i, &s))
+			client->sockets.push_back(s);
+	}
+
+	// drain interleaved data
+	cpu = thread_cpu_time();
+	for (i = 0; i < (int)client->sockets.size(); i++)
+		socket_setnonblock(client->sockets[i], 1);
+	while (s_running)
+	{
+		for (i = 0; i < (int)client->sockets.size(); i++)
+		{
+			while ((r = socket_recv(client->sockets[i], buffer, sizeof(buffer), 0)) > 0)
+				client->bytes += r;
+		}
+		system_sleep(5);
+	}
+
+	client->cpu = thread_cpu_time() - cpu;
+	return 0;
+}
+
+extern "C" void rtsp_server_fanout_test(void)
+{
+	int i, playing;
+	uint64_t clock;
+	int64_t cpu, cpu0, bytes;
+	pthread_t publisher;
+	pthread_t threads[N_CLIENT_THREAD];
+	static struct rtsp_fanout_client_t clients[N_CLIENT_THREAD];
+
+	aio_worker_init(N_AIO_THREAD);
+
+	struct aio_rtsp_handler_t handler;
+	memset(&handler, 0, sizeof(handler));
+	handler.base.ondescribe = rtsp_fanout_ondescribe;
+	handler.base.onsetup = rtsp_fanout_onsetup;
+	handler.base.onplay = rtsp_fanout_onplay;
+	handler.base.onteardown = rtsp_fanout_onteardown;
+	handler.base.close = rtsp_fanout_onclose;
+	handler.onerror = rtsp_fanout_onerror;
+	handler.onclose = rtsp_fanout_onsessionclose;
+	s_fanout = rtsp_server_fanout_create("127.0.0.1", RTSP_PORT, 0, 0, &handler, NULL);
+	assert(s_fanout);
+
+	// 1. session setup rate
+	s_running = 1;
+	cpu0 = process_cpu_time();
+	clock = system_clock();
+	for (i = 0; i < N_CLIENT_THREAD; i++)
+	{
+		clients[i].index = i;
+		thread_create(&threads[i], rtsp_fanout_client, &clients[i]);
+	}
+	while (s_playing < N_SESSIONS && system_clock() < clock + 60 * 1000)
+		system_sleep(1);
+	clock = system_clock() - clock;
+	printf("rtsp fanout(%d workers): %d/%d sessions in %dms, %.1f sessions/s\n", rtsp_server_fanout_count(s_fanout), (int)s_playing, N_SESSIONS, (int)clock, s_playing * 1000.0 / (clock ? clock : 1));
+
+	// 2. steady-state fanout
+	cpu = process_cpu_time();
+	thread_create(&publisher, rtsp_fanout_publisher, NULL);
+	system_sleep(N_SECONDS * 1000);
+	playing = s_playing;
+	s_running = 0;
+	thread_destroy(publisher);
+	cpu = process_cpu_time() - cpu;
+
+	bytes = 0;
+	for (i = 0; i < N_CLIENT_THREAD; i++)
+	{
+		thread_destroy(threads[i]);
+		bytes += clients[i].bytes;
+		cpu -= clients[i].cpu; // exclude loopback client receive cost
+	}
+	printf("rtsp fanout: %d streams, %.1fMB/s, server cpu %.3f%% per stream, total cpu %.1fs\n", playing, bytes / 1024.0 / 1024 / N_SECONDS,
+		playing > 0 ? cpu * 100.0 / (N_SECONDS * 1000000.0) / playing : 0.0, (process_cpu_time() - cpu0) / 1000000.0);
+
+	// close sessions, wait for unregister, then stop fanout
+	for (i = 0; i < N_CLIENT_THREAD; i++)
+	{
+		while (!clients[i].sockets.empty())
+		{
+			socket_close(clients[i].sockets.back());
+			clients[i].sockets.pop_back();
+		}
+	}
+	for (clock = system_clock(); s_playing > 0 && system_clock() < clock + 10 * 1000; )
+		system_sleep(10);
+	assert(0 == s_playing);
+	rtsp_server_fanout_destroy(s_fanout);
+	aio_worker_clean(N_AIO_THREAD);
+}
+#endif
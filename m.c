@@ -0,0 +1,3 @@
+void rtmp_handshake_test(void);
+#include <stdio.h>
+int main(){rtmp_handshake_test(); printf("ok\n"); return 0;}
@@ -128,7 +128,12 @@ void usage(int argc, char const *argv[]){
     RE_REGISTER(name, "void " #name "(" # __VA_ARGS__ ")", t_##name)
 
 extern "C" DEF_FUN_VOID(amf0_test);
+extern "C" DEF_FUN_VOID(media_fanout_test);
+extern "C" DEF_FUN_VOID(media_gop_cache_test);
+extern "C" DEF_FUN_VOID(rtmp_handshake_test);
 extern "C" DEF_FUN_VOID(rtp_queue_test);
+extern "C" DEF_FUN_VOID(rtp_member_list_test);
+extern "C" DEF_FUN_VOID(rtcp_scheduler_test);
 extern "C" DEF_FUN_VOID(mpeg4_aac_test);
 extern "C" DEF_FUN_VOID(mpeg4_avc_test);
 extern "C" DEF_FUN_VOID(mpeg4_hevc_test);
@@ -138,6 +143,19 @@ extern "C" DEF_FUN_VOID(mp3_header_test);
 extern "C" DEF_FUN_VOID(opus_head_test);
 extern "C" DEF_FUN_VOID(flac_streaminfo_test);
 extern "C" DEF_FUN_VOID(h264_mp4toannexb_test);
+extern "C" DEF_FUN_VOID(dash_mpd_test);
+extern "C" DEF_FUN_VOID(dash_mpd_refresh_test);
+extern "C" DEF_FUN_VOID(flv_demuxer_test);
+extern "C" DEF_FUN_VOID(flv_muxer_test);
+extern "C" DEF_FUN_VOID(hls_aes_test);
+extern "C" DEF_FUN_VOID(mov_cenc_test);
+extern "C" DEF_FUN_VOID(hls_fmp4_flv_test);
+extern "C" DEF_FUN_VOID(hls_ladder_test);
+extern "C" DEF_FUN_VOID(hls_m3u8_test);
+extern "C" DEF_FUN_VOID(hls_media_part_test);
+extern "C" DEF_FUN_VOID(hls_playlist_refresh_test);
+extern "C" DEF_FUN_VOID(remux_test);
+extern "C" DEF_FUN_VOID(remux_batch_test);
 extern "C" DEF_FUN_VOID(sdp_h264_test);
 extern "C" DEF_FUN_VOID(sdp_h265_test);
 extern "C" DEF_FUN_VOID(sdp_a_fmtp_test);
@@ -155,6 +173,7 @@ extern "C" DEF_FUN_VOID(http_header_auth_test);
 
 extern "C" DEF_FUN_VOID(rtsp_example);
 extern "C" DEF_FUN_VOID(rtsp_push_server);
+extern "C" DEF_FUN_VOID(rtsp_server_fanout_test);
 extern "C" DEF_FUN_2PCHAR(rtsp_client_test, const char* host, const char* file);
 extern "C" DEF_FUN_3PCHAR(rtsp_client_test2, const char* url, const char* username, const char* password);
 DEF_FUN_INT_PCHAR_INT_INT_PCHAR(rstp_demuxer_test, int payload, const char* encoding, uint16_t seq, uint32_t ssrc, const char* rtpfile);
@@ -195,6 +214,7 @@ DEF_FUN_PCHAR_INT_PCHAR(mkv_writer_audio, const char* audio, int type, const cha
 
 DEF_FUN_PCHAR(mpeg_ts_dec_test, const char* file);
 DEF_FUN_PCHAR(mpeg_ts_test, const char* input);
+DEF_FUN_VOID(mpeg_ts_cbr_test);
 DEF_FUN_PCHAR(mpeg_ps_test, const char* input);
 DEF_FUN_PCHAR(mpeg_ps_2_flv_test, const char* ps);
 DEF_FUN_PCHAR(mov_2_mpeg_ps_test, const char* mp4);
@@ -221,6 +241,7 @@ DEF_FUN_PCHAR(rtmp_server_publish_aio_test, const char* flv);
 DEF_FUN_PCHAR_INT(rtmp_server_forward_aio_test, const char* ip, int port);
 DEF_FUN_PCHAR(rtmp_server_input_test, const char* file);
 DEF_FUN_PCHAR(rtmp_input_test, const char* file);
+DEF_FUN_VOID(rtmp_handshake_benchmark_test);
 
 extern "C" DEF_FUN_VOID(sip_header_test);
 extern "C" DEF_FUN_VOID(sip_agent_test);
@@ -249,7 +270,12 @@ int main(int argc, const char* argv[])
         printf("run default test\n");
         printf( "****************************************\n");
         RE_RUN_REG("amf0_test", argc, argv);
+        RE_RUN_REG("media_fanout_test", argc, argv);
+        RE_RUN_REG("media_gop_cache_test", argc, argv);
+        RE_RUN_REG("rtmp_handshake_test", argc, argv);
         RE_RUN_REG("rtp_queue_test", argc, argv);
+        RE_RUN_REG("rtp_member_list_test", argc, argv);
+        RE_RUN_REG("rtcp_scheduler_test", argc, argv);
         RE_RUN_REG("mpeg4_aac_test", argc, argv);
         RE_RUN_REG("mpeg4_avc_test", argc, argv);
         RE_RUN_REG("mpeg4_hevc_test", argc, argv);
@@ -259,6 +285,20 @@ int main(int argc, const char* argv[])
         RE_RUN_REG("opus_head_test", argc, argv);
         RE_RUN_REG("flac_streaminfo_test", argc, argv);
         RE_RUN_REG("h264_mp4toannexb_test", argc, argv);
+        RE_RUN_REG("mpeg_ts_cbr_test", argc, argv);
+        RE_RUN_REG("dash_mpd_test", argc, argv);
+        RE_RUN_REG("dash_mpd_refresh_test", argc, argv);
+        RE_RUN_REG("flv_demuxer_test", argc, argv);
+        RE_RUN_REG("flv_muxer_test", argc, argv);
+        RE_RUN_REG("hls_aes_test", argc, argv);
+        RE_RUN_REG("mov_cenc_test", argc, argv);
+        RE_RUN_REG("hls_fmp4_flv_test", argc, argv);
+        RE_RUN_REG("hls_ladder_test", argc, argv);
+        RE_RUN_REG("hls_m3u8_test", argc, argv);
+        RE_RUN_REG("hls_media_part_test", argc, argv);
+        RE_RUN_REG("hls_playlist_refresh_test", argc, argv);
+        RE_RUN_REG("remux_test", argc, argv);
+        RE_RUN_REG("remux_batch_test", argc, argv);
         RE_RUN_REG("sdp_test", argc, argv);
         RE_RUN_REG("sdp_h264_test", argc, argv);
         RE_RUN_REG("sdp_h265_test", argc, argv);
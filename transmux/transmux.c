@@ -0,0 +1,137 @@
+// Batch transmux: remux many files concurrently(stream copy, no decode/encode)
+// transmux [-j threads] [-m memory-MB] [-b block-KB] [-f format] [-o outdir] inputs...
+
+#include "remux-batch.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TRANSMUX_PATH 1024
+
+static const char* s_exts[] = { "", "mp4", "m4s", "mkv", "flv", "ts", "ps" }; // REMUX_FORMAT_XXX
+
+static void usage(void)
+{
+	printf("usage: transmux [-j threads] [-m memory-MB] [-b block-KB] [-f format] [-o outdir] inputs...\n");
+	printf("  -j threads    worker threads, default cpu count\n");
+	printf("  -m memory-MB  per-job memory limit(I/O blocks + remux buffers), default unlimited\n");
+	printf("  -b block-KB   file I/O block size, default 1024\n");
+	printf("  -f format     output format: mp4, m4s(fragmented mp4), mkv, flv, ts, ps, default mp4\n");
+	printf("  -o outdir     output directory, default input file directory\n");
+}
+
+// outdir/input-basename.ext
+static int transmux_output(char* output, size_t bytes, const char* input, const char* outdir, int format)
+{
+	int n;
+	const char* name;
+	const char* ext;
+
+	name = strrchr(input, '/');
+#if defined(_WIN32)
+	if (strrchr(input, '\\') > name)
+		name = strrchr(input, '\\');
+#endif
+	name = name ? name + 1 : input;
+	ext = strrchr(name, '.');
+	n = ext ? (int)(ext - name) : (int)strlen(name);
+
+	if (outdir)
+		n = snprintf(output, bytes, "%s/%.*s.%s", outdir, n, name, s_exts[format]);
+	else
+		n = snprintf(output, bytes, "%.*s%.*s.%s", (int)(name - input), input, n, name, s_exts[format]);
+	if (n < 0 || n >= (int)bytes)
+		return -1;
+	return 0 == strcmp(input, output) ? -1 : 0; // don't overwrite input
+}
+
+static void transmux_onprogress(void* param, const struct remux_batch_progress_t* progress)
+{
+	(void)param;
+	fprintf(stderr, "\r[%d/%d] running: %d, failed: %d, read: %.1f/%.1fMB, write: %.1fMB, %.1fMB/s   ",
+		progress->done, progress->jobs, progress->running, progress->failed,
+		progress->bytes_read / 1048576.0, progress->bytes_total / 1048576.0,
+		progress->bytes_written / 1048576.0, progress->mbps);
+}
+
+int main(int argc, char* argv[])
+{
+	int i, r, job;
+	int threads = 0;
+	int format = REMUX_FORMAT_MP4;
+	size_t memory = 0;
+	size_t block = 0;
+	const char* outdir = NULL;
+	const char** inputs;
+	char output[TRANSMUX_PATH];
+	remux_batch_t* batch;
+	struct remux_batch_result_t result;
+
+	for (i = 1; i < argc && '-' == argv[i][0]; i++)
+	{
+		if (0 == strcmp(argv[i], "-j") && i + 1 < argc)
+			threads = atoi(argv[++i]);
+		else if (0 == strcmp(argv[i], "-m") && i + 1 < argc)
+			memory = (size_t)atoi(argv[++i]) * 1024 * 1024;
+		else if (0 == strcmp(argv[i], "-b") && i + 1 < argc)
+			block = (size_t)atoi(argv[++i]) * 1024;
+		else if (0 == strcmp(argv[i], "-o") && i + 1 < argc)
+			outdir = argv[++i];
+		else if (0 == strcmp(argv[i], "-f") && i + 1 < argc)
+		{
+			snprintf(output, sizeof(output), ".%s", argv[++i]);
+			format = remux_format_from_name(output);
+		}
+		else
+			break;
+	}
+
+	if (i >= argc || format <= 0)
+	{
+		usage();
+		return -1;
+	}
+
+	batch = remux_batch_create(threads, memory, block);
+	if (!batch)
+	{
+		fprintf(stderr, "invalid memory limit/block size\n");
+		return -1;
+	}
+
+	inputs = (const char**)malloc(sizeof(inputs[0]) * argc);
+	for (job = 0; inputs && i < argc; i++)
+	{
+		if (0 != transmux_output(output, sizeof(output), argv[i], outdir, format) || remux_batch_add(batch, argv[i], 0, output, format) < 0)
+		{
+			fprintf(stderr, "%s: unknown input format or invalid output name\n", argv[i]);
+			continue;
+		}
+		inputs[job++] = argv[i];
+	}
+
+	r = remux_batch_run(batch, transmux_onprogress, NULL, 1000);
+	fprintf(stderr, "\n");
+	if (r < 0)
+	{
+		fprintf(stderr, "remux_batch_run failed: %d\n", r);
+		remux_batch_destroy(batch);
+		free(inputs);
+		return -1;
+	}
+
+	for (i = 0; i < job; i++)
+	{
+		remux_batch_get_result(batch, i, &result);
+		if (0 == result.code)
+			printf("%s: ok, %dms, packets: %llu, converted: %llu, dropped: %llu, out: %lluB, memory: %lluKB\n",
+				inputs[i], (int)result.elapsed, (unsigned long long)result.stats.packets, (unsigned long long)result.stats.converted,
+				(unsigned long long)result.stats.dropped, (unsigned long long)result.stats.bytes_out, (unsigned long long)(result.stats.memory / 1024));
+		else
+			printf("%s: failed(%d)\n", inputs[i], result.code);
+	}
+
+	remux_batch_destroy(batch);
+	free(inputs);
+	return r > 0 ? 1 : 0;
+}